@@ -0,0 +1,8 @@
+CREATE TABLE library_journal (
+  directory INTEGER NOT NULL,
+  path TEXT NOT NULL
+);
+
+CREATE UNIQUE INDEX idx_library_journal_path ON library_journal (path);
+
+UPDATE schema_version SET version=51;
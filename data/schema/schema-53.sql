@@ -0,0 +1,38 @@
+CREATE TABLE library_revision (
+  library_id TEXT NOT NULL,
+  revision INTEGER NOT NULL
+);
+
+INSERT INTO library_revision (library_id, revision)
+  VALUES (lower(hex(randomblob(16))), 0);
+
+CREATE TABLE library_changes (
+  song_id INTEGER PRIMARY KEY,
+  revision INTEGER NOT NULL,
+  deleted INTEGER NOT NULL DEFAULT 0
+);
+
+CREATE INDEX idx_library_changes_revision ON library_changes (revision);
+
+CREATE TRIGGER library_song_inserted AFTER INSERT ON songs
+BEGIN
+  UPDATE library_revision SET revision = revision + 1;
+  INSERT OR REPLACE INTO library_changes (song_id, revision, deleted)
+    SELECT NEW.ROWID, revision, 0 FROM library_revision;
+END;
+
+CREATE TRIGGER library_song_updated AFTER UPDATE ON songs
+BEGIN
+  UPDATE library_revision SET revision = revision + 1;
+  INSERT OR REPLACE INTO library_changes (song_id, revision, deleted)
+    SELECT NEW.ROWID, revision, 0 FROM library_revision;
+END;
+
+CREATE TRIGGER library_song_deleted AFTER DELETE ON songs
+BEGIN
+  UPDATE library_revision SET revision = revision + 1;
+  INSERT OR REPLACE INTO library_changes (song_id, revision, deleted)
+    SELECT OLD.ROWID, revision, 1 FROM library_revision;
+END;
+
+UPDATE schema_version SET version=53;
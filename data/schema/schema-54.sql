@@ -0,0 +1,3 @@
+ALTER TABLE library_journal ADD COLUMN changed INTEGER NOT NULL DEFAULT 0;
+
+UPDATE schema_version SET version=54;
@@ -0,0 +1,37 @@
+DROP TRIGGER library_song_inserted;
+
+DROP TRIGGER library_song_updated;
+
+DROP TRIGGER library_song_deleted;
+
+/* Changes are logged against the revision after the current one, so adding
+   many songs at once only makes one new revision.  GetRevision starts a new
+   revision when it finds changes logged against the next one. */
+CREATE TRIGGER library_song_inserted AFTER INSERT ON songs
+BEGIN
+  INSERT OR REPLACE INTO library_changes (song_id, revision, deleted)
+    SELECT NEW.ROWID, revision + 1, 0 FROM library_revision;
+END;
+
+/* Play counts, skip counts, ratings and scores change all the time, and
+   aren't worth sending a song again for. */
+CREATE TRIGGER library_song_updated AFTER UPDATE OF
+  title, album, artist, albumartist, composer, performer, grouping, track,
+  disc, bpm, year, originalyear, genre, comment, lyrics, compilation, length,
+  bitrate, samplerate, directory, filename, mtime, ctime, filesize, sampler,
+  art_automatic, art_manual, filetype, forced_compilation_on,
+  forced_compilation_off, effective_compilation, effective_albumartist,
+  effective_originalyear, beginning, cue_path, unavailable, etag
+  ON songs
+BEGIN
+  INSERT OR REPLACE INTO library_changes (song_id, revision, deleted)
+    SELECT NEW.ROWID, revision + 1, 0 FROM library_revision;
+END;
+
+CREATE TRIGGER library_song_deleted AFTER DELETE ON songs
+BEGIN
+  INSERT OR REPLACE INTO library_changes (song_id, revision, deleted)
+    SELECT OLD.ROWID, revision + 1, 1 FROM library_revision;
+END;
+
+UPDATE schema_version SET version=55;
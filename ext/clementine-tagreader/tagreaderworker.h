@@ -27,6 +27,10 @@ class TagReaderWorker : public AbstractMessageHandler<pb::tagreader::Message> {
  public:
   TagReaderWorker(QIODevice* socket, QObject* parent = NULL);
 
+  // Replies at least this big, like embedded art and cloud file data, are
+  // sent to Clementine through shared memory.
+  static const int kSharedMemoryThreshold;
+
  protected:
   void MessageArrived(const pb::tagreader::Message& message);
   void DeviceClosed();
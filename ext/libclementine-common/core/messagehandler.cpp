@@ -21,22 +21,53 @@
 #include "messagehandler.h"
 #include "core/logging.h"
 
+#include <atomic>
+
 #include <QAbstractSocket>
+#include <QCoreApplication>
 #include <QLocalSocket>
 
+namespace {
+
+// The top bits of a frame's length say what the frame contains.
+const quint32 kMessageFrame = 0;
+const quint32 kSharedMemoryFrame = 0x80000000;
+const quint32 kReleaseFrame = 0x40000000;
+const quint32 kFrameTypeMask = kSharedMemoryFrame | kReleaseFrame;
+
+}  // namespace
+
+struct _MessageHandlerBase::MetricCounters {
+  MetricCounters()
+      : messages_(0), shared_memory_messages_(0), bytes_(0), bytes_copied_(0) {}
+
+  std::atomic<int> messages_;
+  std::atomic<int> shared_memory_messages_;
+  std::atomic<qint64> bytes_;
+  std::atomic<qint64> bytes_copied_;
+};
+
 _MessageHandlerBase::_MessageHandlerBase(QIODevice* device, QObject* parent)
     : QObject(parent),
       device_(nullptr),
       flush_abstract_socket_(nullptr),
       flush_local_socket_(nullptr),
       reading_protobuf_(false),
+      frame_type_(kMessageFrame),
       expected_length_(0),
-      is_device_closed_(false) {
+      is_device_closed_(false),
+      shared_memory_threshold_(0),
+      next_shared_memory_id_(0) {
   if (device) {
     SetDevice(device);
   }
 }
 
+_MessageHandlerBase::~_MessageHandlerBase() {
+  FreeSharedMemory();
+  LogMetrics();
+}
+
 void _MessageHandlerBase::SetDevice(QIODevice* device) {
   device_ = device;
 
@@ -61,8 +92,11 @@ void _MessageHandlerBase::DeviceReadyRead() {
     if (!reading_protobuf_) {
       // Read the length of the next message
       QDataStream s(device_);
-      s >> expected_length_;
+      quint32 header = 0;
+      s >> header;
 
+      frame_type_ = header & kFrameTypeMask;
+      expected_length_ = header & ~kFrameTypeMask;
       reading_protobuf_ = true;
     }
 
@@ -71,8 +105,24 @@ void _MessageHandlerBase::DeviceReadyRead() {
 
     // Did we get everything?
     if (buffer_.size() == expected_length_) {
-      // Parse the message
-      if (!RawMessageArrived(buffer_.data())) {
+      bool ok = true;
+      switch (frame_type_) {
+        case kSharedMemoryFrame:
+          ok = ReadSharedMemoryFrame(buffer_.data());
+          break;
+
+        case kReleaseFrame:
+          // The other side has read a message we put in shared memory
+          delete shared_memory_.take(QString::fromUtf8(buffer_.data()));
+          break;
+
+        default:
+          // Parse the message
+          ok = RawMessageArrived(buffer_.data(), false);
+          break;
+      }
+
+      if (!ok) {
         qLog(Error) << "Malformed protobuf message";
         device_->close();
         return;
@@ -87,9 +137,81 @@ void _MessageHandlerBase::DeviceReadyRead() {
   }
 }
 
+bool _MessageHandlerBase::ReadSharedMemoryFrame(const QByteArray& data) {
+  // The frame contains the size of the message and the segment's name.
+  QDataStream s(data);
+  quint32 size = 0;
+  QString name;
+  s >> size >> name;
+  if (s.status() != QDataStream::Ok) return false;
+
+  // Opening the segment removes its name, so it can't be left behind if
+  // either process crashes from now on.
+  SharedMemorySegment memory;
+  if (!memory.Open(name)) {
+    qLog(Error) << "Couldn't open shared memory" << name
+                << memory.error_string();
+    return false;
+  }
+
+  // The message is parsed straight out of the segment.  The other side
+  // doesn't touch it again until we tell it we're done.
+  bool ret = false;
+  if (memory.size() >= int(size)) {
+    ret = RawMessageArrived(
+        QByteArray::fromRawData(static_cast<const char*>(memory.constData()),
+                                size),
+        true);
+  }
+
+  WriteFrame(kReleaseFrame, name.toUtf8());
+  return ret;
+}
+
+SharedMemorySegment* _MessageHandlerBase::CreateSharedMemory(int size) {
+  // Keep the name short - Mac OS X only allows 31 characters.
+  const QString name = QString("/clem-%1-%2")
+                           .arg(QCoreApplication::applicationPid())
+                           .arg(next_shared_memory_id_++);
+
+  SharedMemorySegment* memory = new SharedMemorySegment;
+  if (!memory->Create(name, size)) {
+    qLog(Warning) << "Couldn't create shared memory" << name
+                  << memory->error_string();
+    delete memory;
+    return nullptr;
+  }
+  return memory;
+}
+
+void _MessageHandlerBase::WriteSharedMemoryMessage(SharedMemorySegment* memory,
+                                                   int size) {
+  shared_memory_[memory->name()] = memory;
+
+  QByteArray data;
+  QDataStream s(&data, QIODevice::WriteOnly);
+  s << quint32(size) << memory->name();
+
+  WriteFrame(kSharedMemoryFrame, data);
+}
+
+void _MessageHandlerBase::FreeSharedMemory() {
+  // The other side might not have opened some of these
+  for (SharedMemorySegment* memory : shared_memory_) {
+    memory->Unlink();
+  }
+  qDeleteAll(shared_memory_);
+  shared_memory_.clear();
+}
+
 void _MessageHandlerBase::WriteMessage(const QByteArray& data) {
+  WriteFrame(kMessageFrame, data);
+}
+
+void _MessageHandlerBase::WriteFrame(quint32 frame_type,
+                                     const QByteArray& data) {
   QDataStream s(device_);
-  s << quint32(data.length());
+  s << quint32(frame_type | data.length());
   s.writeRawData(data.data(), data.length());
 
   // Sorry.
@@ -103,4 +225,47 @@ void _MessageHandlerBase::WriteMessage(const QByteArray& data) {
 void _MessageHandlerBase::DeviceClosed() {
   is_device_closed_ = true;
   AbortAll();
+
+  // Nobody will tell us they're finished with these now
+  FreeSharedMemory();
+}
+
+void _MessageHandlerBase::SetMessageTypeNames(const QStringList& names) {
+  message_type_names_ = names;
+  metric_counters_.reset(new MetricCounters[names.count()]);
+}
+
+void _MessageHandlerBase::RecordMetrics(int type, bool shared_memory,
+                                        int size, int copies) {
+  MetricCounters& counters = metric_counters_[type];
+  counters.messages_++;
+  if (shared_memory) counters.shared_memory_messages_++;
+  counters.bytes_ += size;
+  counters.bytes_copied_ += qint64(size) * copies;
+}
+
+_MessageHandlerBase::MetricsMap _MessageHandlerBase::metrics() const {
+  MetricsMap ret;
+  for (int i = 0; i < message_type_names_.count(); ++i) {
+    const MetricCounters& counters = metric_counters_[i];
+    if (!counters.messages_) continue;
+
+    Metrics& metrics = ret[message_type_names_[i]];
+    metrics.messages_ = counters.messages_;
+    metrics.shared_memory_messages_ = counters.shared_memory_messages_;
+    metrics.bytes_ = counters.bytes_;
+    metrics.bytes_copied_ = counters.bytes_copied_;
+  }
+  return ret;
+}
+
+void _MessageHandlerBase::LogMetrics() const {
+  const MetricsMap metrics = this->metrics();
+  for (MetricsMap::const_iterator it = metrics.begin(); it != metrics.end();
+       ++it) {
+    qLog(Debug) << it.key() << it->messages_ << "messages,"
+                << it->shared_memory_messages_ << "in shared memory,"
+                << it->bytes_ << "bytes," << it->bytes_copied_
+                << "bytes copied";
+  }
 }
@@ -21,16 +21,24 @@
 #ifndef MESSAGEHANDLER_H
 #define MESSAGEHANDLER_H
 
+#include <memory>
+#include <vector>
+
 #include <QBuffer>
 #include <QMap>
 #include <QMutex>
 #include <QMutexLocker>
 #include <QObject>
 #include <QSemaphore>
+#include <QStringList>
 #include <QThread>
 
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message.h>
+
 #include "core/logging.h"
 #include "core/messagereply.h"
+#include "core/sharedmemorysegment.h"
 
 class QAbstractSocket;
 class QIODevice;
@@ -42,6 +50,12 @@ class QLocalSocket;
 // Reads and writes uint32 length encoded protobufs to a socket.
 // This base QObject is separate from AbstractMessageHandler because moc can't
 // handle templated classes.  Use AbstractMessageHandler instead.
+//
+// Large messages can instead be written to a shared memory segment, in which
+// case only the segment's name is sent on the socket.  The top two bits of the
+// length say which kind of frame follows: a serialised message, the size and
+// name of a segment holding one, or the name of a segment the other side has
+// finished reading and that can be freed.
 class _MessageHandlerBase : public QObject {
   Q_OBJECT
 
@@ -49,21 +63,67 @@ class _MessageHandlerBase : public QObject {
   // device can be NULL, in which case you must call SetDevice before writing
   // any messages.
   _MessageHandlerBase(QIODevice* device, QObject* parent);
+  ~_MessageHandlerBase();
 
   void SetDevice(QIODevice* device);
 
   // After this is true, messages cannot be sent to the handler any more.
   bool is_device_closed() const { return is_device_closed_; }
 
+  // Messages of at least this many bytes sent with SendMessage go through
+  // shared memory.  0, the default, sends everything on the socket.  Messages
+  // in shared memory are always understood when they're received.
+  void SetSharedMemoryThreshold(int bytes) { shared_memory_threshold_ = bytes; }
+
+  // Counters for each kind of message, named after the field set in it.
+  // bytes_copied_ is how many bytes this handler copied to send or receive
+  // the messages, including serialising and parsing them.
+  struct Metrics {
+    Metrics()
+        : messages_(0), shared_memory_messages_(0), bytes_(0),
+          bytes_copied_(0) {}
+
+    int messages_;
+    int shared_memory_messages_;
+    qint64 bytes_;
+    qint64 bytes_copied_;
+  };
+  typedef QMap<QString, Metrics> MetricsMap;
+
+  MetricsMap metrics() const;
+  void LogMetrics() const;
+
+  // The number of segments sent that the other side hasn't finished with.
+  int shared_memory_in_use() const { return shared_memory_.count(); }
+
  protected slots:
   void WriteMessage(const QByteArray& data);
   void DeviceReadyRead();
   virtual void DeviceClosed();
 
  protected:
-  virtual bool RawMessageArrived(const QByteArray& data) = 0;
+  virtual bool RawMessageArrived(const QByteArray& data,
+                                 bool shared_memory) = 0;
   virtual void AbortAll() = 0;
 
+  // Returns a new segment of at least size bytes, or NULL if one couldn't be
+  // created.  Pass it to WriteSharedMemoryMessage after filling it in.
+  SharedMemorySegment* CreateSharedMemory(int size);
+  // Takes ownership of memory and sends its name.  It's freed when the other
+  // side says it's done with it.
+  void WriteSharedMemoryMessage(SharedMemorySegment* memory, int size);
+
+  // Names the message types that metrics are recorded for.  Must be called
+  // before RecordMetrics.
+  void SetMessageTypeNames(const QStringList& names);
+  // type is an index into the list of names.  May be called from any thread.
+  void RecordMetrics(int type, bool shared_memory, int size, int copies);
+
+ private:
+  void WriteFrame(quint32 frame_type, const QByteArray& data);
+  bool ReadSharedMemoryFrame(const QByteArray& data);
+  void FreeSharedMemory();
+
  protected:
   typedef bool (QAbstractSocket::*FlushAbstractSocket)();
   typedef bool (QLocalSocket::*FlushLocalSocket)();
@@ -73,10 +133,21 @@ class _MessageHandlerBase : public QObject {
   FlushLocalSocket flush_local_socket_;
 
   bool reading_protobuf_;
+  quint32 frame_type_;
   quint32 expected_length_;
   QBuffer buffer_;
 
   bool is_device_closed_;
+
+  int shared_memory_threshold_;
+  int next_shared_memory_id_;
+  QMap<QString, SharedMemorySegment*> shared_memory_;
+
+  // One set of counters for each message type.  They're updated without a
+  // lock since messages can be sent from any thread.
+  struct MetricCounters;
+  QStringList message_type_names_;
+  std::unique_ptr<MetricCounters[]> metric_counters_;
 };
 
 // Reads and writes uint32 length encoded MessageType messages to a socket.
@@ -113,29 +184,56 @@ class AbstractMessageHandler : public _MessageHandlerBase {
   virtual void MessageArrived(const MessageType& message) {}
 
   // _MessageHandlerBase
-  bool RawMessageArrived(const QByteArray& data);
+  bool RawMessageArrived(const QByteArray& data, bool shared_memory);
   void AbortAll();
 
  private:
+  // The sub-message fields of MessageType, one of which is set in each message
+  // to say what kind of message it is.  Worked out once for each MessageType.
+  static std::vector<const google::protobuf::FieldDescriptor*>
+      FindMessageTypeFields();
+  static const std::vector<const google::protobuf::FieldDescriptor*>&
+      MessageTypeFields();
+  static QStringList MessageTypeNames();
+  static int MessageTypeIndex(const MessageType& message);
+
   QMap<int, ReplyType*> pending_replies_;
 };
 
 template <typename MT>
 AbstractMessageHandler<MT>::AbstractMessageHandler(QIODevice* device,
                                                    QObject* parent)
-    : _MessageHandlerBase(device, parent) {}
+    : _MessageHandlerBase(device, parent) {
+  SetMessageTypeNames(MessageTypeNames());
+}
 
 template <typename MT>
 void AbstractMessageHandler<MT>::SendMessage(const MessageType& message) {
   Q_ASSERT(QThread::currentThread() == thread());
 
+  const int size = message.ByteSize();
+  if (shared_memory_threshold_ > 0 && size >= shared_memory_threshold_) {
+    SharedMemorySegment* memory = CreateSharedMemory(size);
+    if (memory) {
+      // Serialise straight into the segment
+      message.SerializeWithCachedSizesToArray(
+          static_cast<google::protobuf::uint8*>(memory->data()));
+      WriteSharedMemoryMessage(memory, size);
+      RecordMetrics(MessageTypeIndex(message), true, size, 1);
+      return;
+    }
+  }
+
+  // Serialised, copied into a QByteArray and copied into the socket
   std::string data = message.SerializeAsString();
   WriteMessage(QByteArray(data.data(), data.size()));
+  RecordMetrics(MessageTypeIndex(message), false, size, 3);
 }
 
 template <typename MT>
 void AbstractMessageHandler<MT>::SendMessageAsync(const MessageType& message) {
   std::string data = message.SerializeAsString();
+  RecordMetrics(MessageTypeIndex(message), false, data.size(), 3);
   metaObject()->invokeMethod(
       this, "WriteMessage", Qt::QueuedConnection,
       Q_ARG(QByteArray, QByteArray(data.data(), data.size())));
@@ -155,12 +253,17 @@ void AbstractMessageHandler<MT>::SendReply(const MessageType& request,
 }
 
 template <typename MT>
-bool AbstractMessageHandler<MT>::RawMessageArrived(const QByteArray& data) {
+bool AbstractMessageHandler<MT>::RawMessageArrived(const QByteArray& data,
+                                                   bool shared_memory) {
   MessageType message;
   if (!message.ParseFromArray(data.constData(), data.size())) {
     return false;
   }
 
+  // Messages from the socket were also copied out of it and into buffer_
+  RecordMetrics(MessageTypeIndex(message), shared_memory, data.size(),
+                shared_memory ? 1 : 3);
+
   ReplyType* reply = pending_replies_.take(message.id());
 
   if (reply) {
@@ -173,6 +276,53 @@ bool AbstractMessageHandler<MT>::RawMessageArrived(const QByteArray& data) {
   return true;
 }
 
+template <typename MT>
+std::vector<const google::protobuf::FieldDescriptor*>
+AbstractMessageHandler<MT>::FindMessageTypeFields() {
+  std::vector<const google::protobuf::FieldDescriptor*> ret;
+  const google::protobuf::Descriptor* descriptor = MT::descriptor();
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    const google::protobuf::FieldDescriptor* field = descriptor->field(i);
+    if (field->type() == google::protobuf::FieldDescriptor::TYPE_MESSAGE &&
+        !field->is_repeated()) {
+      ret.push_back(field);
+    }
+  }
+  return ret;
+}
+
+template <typename MT>
+const std::vector<const google::protobuf::FieldDescriptor*>&
+AbstractMessageHandler<MT>::MessageTypeFields() {
+  static const std::vector<const google::protobuf::FieldDescriptor*> sFields =
+      FindMessageTypeFields();
+  return sFields;
+}
+
+template <typename MT>
+QStringList AbstractMessageHandler<MT>::MessageTypeNames() {
+  QStringList ret;
+  for (const google::protobuf::FieldDescriptor* field : MessageTypeFields()) {
+    ret << QStringFromStdString(field->name());
+  }
+
+  // Messages with none of the fields set
+  ret << QStringFromStdString(MT::descriptor()->name());
+  return ret;
+}
+
+template <typename MT>
+int AbstractMessageHandler<MT>::MessageTypeIndex(const MessageType& message) {
+  const std::vector<const google::protobuf::FieldDescriptor*>& fields =
+      MessageTypeFields();
+  const google::protobuf::Reflection* reflection = message.GetReflection();
+
+  for (size_t i = 0; i < fields.size(); ++i) {
+    if (reflection->HasField(message, fields[i])) return i;
+  }
+  return fields.size();
+}
+
 template <typename MT>
 void AbstractMessageHandler<MT>::AbortAll() {
   for (ReplyType* reply : pending_replies_) {
@@ -0,0 +1,144 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+// Note: this file is licensed under the Apache License instead of GPL because
+// it is used by the Spotify blob which links against libspotify and is not GPL
+// compatible.
+
+#include "sharedmemorysegment.h"
+
+#ifndef Q_OS_WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+SharedMemorySegment::SharedMemorySegment() : data_(nullptr), size_(0) {}
+
+#ifndef Q_OS_WIN32
+
+SharedMemorySegment::~SharedMemorySegment() {
+  if (data_) munmap(data_, size_);
+}
+
+void SharedMemorySegment::SetError(const QString& message) {
+  error_string_ = message + ": " + QString::fromLocal8Bit(strerror(errno));
+}
+
+bool SharedMemorySegment::Create(const QString& name, int size) {
+  Q_ASSERT(!data_);
+  const QByteArray posix_name = name.toLocal8Bit();
+
+  const int fd =
+      shm_open(posix_name.constData(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd == -1) {
+    SetError("shm_open");
+    return false;
+  }
+
+  void* data = MAP_FAILED;
+  if (ftruncate(fd, size) == 0) {
+    data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  if (data == MAP_FAILED) {
+    SetError("mmap");
+    close(fd);
+    shm_unlink(posix_name.constData());
+    return false;
+  }
+  close(fd);
+
+  name_ = name;
+  data_ = data;
+  size_ = size;
+  return true;
+}
+
+bool SharedMemorySegment::Open(const QString& name) {
+  Q_ASSERT(!data_);
+  const QByteArray posix_name = name.toLocal8Bit();
+
+  const int fd = shm_open(posix_name.constData(), O_RDONLY, 0);
+  if (fd == -1) {
+    SetError("shm_open");
+    return false;
+  }
+
+  // Nobody else needs to find it now
+  shm_unlink(posix_name.constData());
+
+  struct stat info;
+  void* data = MAP_FAILED;
+  if (fstat(fd, &info) == 0 && info.st_size > 0) {
+    data = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  }
+  if (data == MAP_FAILED) {
+    SetError("mmap");
+    close(fd);
+    return false;
+  }
+  close(fd);
+
+  name_ = name;
+  data_ = data;
+  size_ = info.st_size;
+  return true;
+}
+
+void SharedMemorySegment::Unlink() {
+  if (!name_.isEmpty()) shm_unlink(name_.toLocal8Bit().constData());
+}
+
+#else  // Q_OS_WIN32
+
+SharedMemorySegment::~SharedMemorySegment() {}
+
+void SharedMemorySegment::SetError(const QString& message) {
+  error_string_ = message + ": " + memory_.errorString();
+}
+
+bool SharedMemorySegment::Create(const QString& name, int size) {
+  memory_.setKey(name);
+  if (!memory_.create(size)) {
+    SetError("create");
+    return false;
+  }
+
+  name_ = name;
+  data_ = memory_.data();
+  size_ = memory_.size();
+  return true;
+}
+
+bool SharedMemorySegment::Open(const QString& name) {
+  memory_.setKey(name);
+  if (!memory_.attach(QSharedMemory::ReadOnly)) {
+    SetError("attach");
+    return false;
+  }
+
+  name_ = name;
+  data_ = memory_.data();
+  size_ = memory_.size();
+  return true;
+}
+
+void SharedMemorySegment::Unlink() {}
+
+#endif  // Q_OS_WIN32
@@ -0,0 +1,75 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+// Note: this file is licensed under the Apache License instead of GPL because
+// it is used by the Spotify blob which links against libspotify and is not GPL
+// compatible.
+
+#ifndef SHAREDMEMORYSEGMENT_H
+#define SHAREDMEMORYSEGMENT_H
+
+#include <QString>
+
+#ifdef Q_OS_WIN32
+#include <QSharedMemory>
+#endif
+
+// A named block of memory that another process can map.
+//
+// On Unix this is a POSIX shared memory object.  Its name is removed as soon
+// as the reader has mapped it, and the memory itself goes away when both
+// processes have unmapped it, so a segment is never left behind by a process
+// that crashes after the segment has been read.  The writer should call
+// Unlink if the reader might never open the segment.
+//
+// On Windows the system frees a segment when the last handle to it is closed.
+class SharedMemorySegment {
+ public:
+  SharedMemorySegment();
+  ~SharedMemorySegment();
+
+  // Creates a new segment of size bytes and maps it read-write.
+  bool Create(const QString& name, int size);
+
+  // Maps an existing segment read-only and removes its name.
+  bool Open(const QString& name);
+
+  // Removes the segment's name so no one else can open it.  The memory stays
+  // mapped.
+  void Unlink();
+
+  const QString& name() const { return name_; }
+  void* data() { return data_; }
+  const void* constData() const { return data_; }
+  int size() const { return size_; }
+  const QString& error_string() const { return error_string_; }
+
+ private:
+  Q_DISABLE_COPY(SharedMemorySegment)
+
+  void SetError(const QString& message);
+
+  QString name_;
+  void* data_;
+  int size_;
+  QString error_string_;
+
+#ifdef Q_OS_WIN32
+  QSharedMemory memory_;
+#endif
+};
+
+#endif  // SHAREDMEMORYSEGMENT_H
@@ -30,6 +30,7 @@
 #include <QEvent>
 #include <QPainter>
 #include <QPaintEvent>
+#include <QThread>
 #include <QtDebug>
 
 #include "engines/enginebase.h"
@@ -73,11 +74,39 @@ Analyzer::Base::Base(QWidget* parent, uint scopeSize)
       barkband_table_(QList<uint>()),
       prev_color_index_(0),
       bands_(0),
-      psychedelic_enabled_(false) {}
+      psychedelic_enabled_(false),
+      worker_thread_(new QThread(this)),
+      worker_(new Worker(this)),
+      frame_requested_(false),
+      has_next_frame_(false) {
+  worker_->moveToThread(worker_thread_);
+  connect(worker_, SIGNAL(FrameComputed()), SLOT(FrameComputed()));
+  worker_thread_->start();
+}
+
+Analyzer::Base::~Base() {
+  StopAnalysis();
+  delete fht_;
+}
+
+void Analyzer::Base::StopAnalysis() {
+  if (!worker_) return;
+
+  worker_thread_->quit();
+  worker_thread_->wait();
+  delete worker_;
+  worker_ = nullptr;
+}
 
 void Analyzer::Base::hideEvent(QHideEvent*) { timer_.stop(); }
 
-void Analyzer::Base::showEvent(QShowEvent*) { timer_.start(timeout(), this); }
+void Analyzer::Base::showEvent(QShowEvent*) {
+  // Whatever was buffered while we were hidden is out of date now.
+  if (worker_) {
+    QMetaObject::invokeMethod(worker_, "ClearScope", Qt::QueuedConnection);
+  }
+  timer_.start(timeout(), this);
+}
 
 void Analyzer::Base::transform(Scope& scope) {
   // this is a standard transformation that should give
@@ -104,23 +133,16 @@ void Analyzer::Base::paintEvent(QPaintEvent* e) {
 
   switch (engine_->state()) {
     case Engine::Playing: {
-      const Engine::Scope& thescope = engine_->scope(timeout_);
-      int i = 0;
-
-      // convert to mono here - our built in analyzers need mono, but the
-      // engines provide interleaved pcm
-      for (uint x = 0; static_cast<int>(x) < fht_->size(); ++x) {
-        lastScope_[x] = static_cast<double>(thescope[i] + thescope[i + 1]) /
-                        (2 * (1 << 15));
-        i += 2;
+      {
+        QMutexLocker l(&next_frame_mutex_);
+        if (has_next_frame_) {
+          lastScope_.swap(next_frame_);
+          has_next_frame_ = false;
+        }
       }
 
       is_playing_ = true;
-      transform(lastScope_);
       analyze(p, lastScope_, new_frame_);
-
-      // scope.resize( fht_->size() );
-
       break;
     }
     case Engine::Paused:
@@ -143,6 +165,7 @@ int Analyzer::Base::resizeExponent(int exp) {
     exp = 9;
 
   if (exp != fht_->sizeExp()) {
+    QMutexLocker l(&transform_mutex_);
     delete fht_;
     fht_ = new FHT(exp);
   }
@@ -285,6 +308,53 @@ void Analyzer::Base::timerEvent(QTimerEvent* e) {
   QWidget::timerEvent(e);
   if (e->timerId() != timer_.timerId()) return;
 
+  if (worker_ && engine_ && engine_->state() == Engine::Playing) {
+    // Draw the frame when the analysis thread has finished it.  If it's still
+    // busy with the last one then skip this one.
+    if (!frame_requested_) {
+      frame_requested_ = true;
+      QMetaObject::invokeMethod(worker_, "ComputeFrame", Qt::QueuedConnection,
+                                Q_ARG(int, timeout_));
+    }
+    return;
+  }
+
   new_frame_ = true;
   update();
 }
+
+void Analyzer::Base::FrameComputed() {
+  frame_requested_ = false;
+  new_frame_ = true;
+  update();
+}
+
+void Analyzer::Base::ComputeFrame(int chunk_length) {
+  if (!engine_ || !engine_->ReadScope(chunk_length, &pcm_)) return;
+
+  QMutexLocker l(&transform_mutex_);
+
+  // convert to mono here - our built in analyzers need mono, but the
+  // engines provide interleaved pcm
+  work_frame_.resize(fht_->size());
+  for (int x = 0; x < fht_->size(); ++x) {
+    work_frame_[x] = static_cast<double>(pcm_[2 * x] + pcm_[2 * x + 1]) /
+                     (2 * (1 << 15));
+  }
+
+  transform(work_frame_);
+  l.unlock();
+
+  QMutexLocker frame_lock(&next_frame_mutex_);
+  work_frame_.swap(next_frame_);
+  has_next_frame_ = true;
+}
+
+void Analyzer::Worker::ComputeFrame(int chunk_length) {
+  analyzer_->ComputeFrame(chunk_length);
+  emit FrameComputed();
+}
+
+void Analyzer::Worker::ClearScope() {
+  if (analyzer_->engine_) analyzer_->engine_->ClearScope();
+}
@@ -34,7 +34,9 @@
 #include "engines/engine_fwd.h"
 #include <QPixmap>
 #include <QBasicTimer>
+#include <QMutex>
 #include <QWidget>
+#include <cstdint>
 #include <vector>
 
 #include <QGLWidget>
@@ -49,16 +51,25 @@
 class QEvent;
 class QPaintEvent;
 class QResizeEvent;
+class QThread;
 
 namespace Analyzer {
 
 typedef std::vector<float> Scope;
 
+class Worker;
+
+// The spectrum for each frame is calculated by transform() on a separate
+// analysis thread, so the GUI thread only has to draw it in analyze().
 class Base : public QWidget {
   Q_OBJECT
 
  public:
-  ~Base() { delete fht_; }
+  ~Base();
+
+  // Stops the analysis thread.  This must be called before a subclass is
+  // destroyed, since the thread calls its transform().
+  void StopAnalysis();
 
   uint timeout() const { return timeout_; }
 
@@ -91,6 +102,7 @@ class Base : public QWidget {
   void updateBandSize(const int);
   QColor getPsychedelicColor(const Scope&, const int, const int);
   virtual void init() {}
+  // Called on the analysis thread with transform_mutex_ locked.
   virtual void transform(Scope&);
   virtual void analyze(QPainter& p, const Scope&, bool new_frame) = 0;
   virtual void demo(QPainter& p);
@@ -105,6 +117,10 @@ class Base : public QWidget {
   EngineBase* engine_;
   Scope lastScope_;
 
+  // Held while transform() runs.  Lock it on the GUI thread before changing
+  // anything that transform() uses.
+  QMutex transform_mutex_;
+
   bool new_frame_;
   bool is_playing_;
 
@@ -113,6 +129,47 @@ class Base : public QWidget {
   int prev_color_index_;
   int bands_;
   bool psychedelic_enabled_;
+
+ private slots:
+  void FrameComputed();
+
+ private:
+  friend class Worker;
+
+  // Reads the next chunk of audio from the engine and transforms it into
+  // next_frame_.  Called on the analysis thread.
+  void ComputeFrame(int chunk_length);
+
+  QThread* worker_thread_;
+  Worker* worker_;
+  // True while the analysis thread is working on a frame.
+  bool frame_requested_;
+
+  // Only used on the analysis thread.
+  std::vector<int16_t> pcm_;
+  Scope work_frame_;
+
+  QMutex next_frame_mutex_;
+  Scope next_frame_;
+  bool has_next_frame_;
+};
+
+// Lives on the analysis thread and calls back into the analyzer there.
+class Worker : public QObject {
+  Q_OBJECT
+
+ public:
+  explicit Worker(Base* analyzer) : analyzer_(analyzer) {}
+
+ public slots:
+  void ComputeFrame(int chunk_length);
+  void ClearScope();
+
+signals:
+  void FrameComputed();
+
+ private:
+  Base* analyzer_;
 };
 
 void interpolate(const Scope&, Scope&);
@@ -104,6 +104,17 @@ AnalyzerContainer::AnalyzerContainer(QWidget* parent)
   Load();
 }
 
+AnalyzerContainer::~AnalyzerContainer() { DeleteAnalyzer(); }
+
+void AnalyzerContainer::DeleteAnalyzer() {
+  if (!current_analyzer_) return;
+
+  // The analyzer's thread has to be stopped while it's still a subclass.
+  current_analyzer_->StopAnalysis();
+  delete current_analyzer_;
+  current_analyzer_ = nullptr;
+}
+
 void AnalyzerContainer::SetActions(QAction* visualisation) {
   visualisation_action_ = visualisation;
   context_menu_->addAction(visualisation_action_);
@@ -145,8 +156,7 @@ void AnalyzerContainer::SetEngine(EngineBase* engine) {
 }
 
 void AnalyzerContainer::DisableAnalyzer() {
-  delete current_analyzer_;
-  current_analyzer_ = nullptr;
+  DeleteAnalyzer();
 
   Save();
 }
@@ -168,7 +178,7 @@ void AnalyzerContainer::ChangeAnalyzer(int id) {
     return;
   }
 
-  delete current_analyzer_;
+  DeleteAnalyzer();
   current_analyzer_ = qobject_cast<Analyzer::Base*>(instance);
   current_analyzer_->set_engine(engine_);
   // Even if it is not supposed to happen, I don't want to get a dbz error
@@ -35,6 +35,7 @@ class AnalyzerContainer : public QWidget {
 
  public:
   explicit AnalyzerContainer(QWidget* parent);
+  ~AnalyzerContainer();
   void SetEngine(EngineBase* engine);
   void SetActions(QAction* visualisation);
 
@@ -63,6 +64,7 @@ signals:
   static const int kSuperHighFramerate;
 
   void Load();
+  void DeleteAnalyzer();
   void Save();
   void SaveFramerate(int framerate);
   void SavePsychedelic();
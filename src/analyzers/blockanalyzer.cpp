@@ -83,7 +83,11 @@ void BlockAnalyzer::resizeEvent(QResizeEvent* e) {
   // this is the y-offset for drawing from the top of the widget
   y_ = (height() - (rows_ * (kHeight + 1)) + 2) / 2;
 
-  scope_.resize(columns_);
+  {
+    // transform() uses the size of scope_.
+    QMutexLocker l(&transform_mutex_);
+    scope_.resize(columns_);
+  }
 
   if (rows_ != oldRows) {
     barPixmap_ = QPixmap(kWidth, rows_ * (kHeight + 1));
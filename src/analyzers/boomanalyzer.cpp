@@ -71,7 +71,11 @@ void BoomAnalyzer::resizeEvent(QResizeEvent* e) {
       static_cast<uint>(static_cast<double>(width() + 1) / (kColumnWidth + 1)) +
           1,
       kMaxBandCount);
-  scope_.resize(bands_);
+  {
+    // transform() uses the size of scope_.
+    QMutexLocker l(&transform_mutex_);
+    scope_.resize(bands_);
+  }
 
   F_ = static_cast<double>(HEIGHT) / (log10(256) * 1.1 /*<- max. amplitude*/);
 
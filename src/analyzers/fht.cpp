@@ -23,8 +23,15 @@
 #include <math.h>
 #include <string.h>
 #include "fht.h"
-
-FHT::FHT(int n) : buf_(0), tab_(0), log_(0) {
+#include "fhtkernels.h"
+
+FHT::FHT(int n, Kernel kernel)
+    : buf_(0),
+      tab_(0),
+      log_(0),
+      kernel_(Kernel_Scalar),
+      kernels_(0),
+      twiddles_(0) {
   if (n < 3) {
     num_ = 0;
     exp2_ = -1;
@@ -37,12 +44,68 @@ FHT::FHT(int n) : buf_(0), tab_(0), log_(0) {
     tab_ = new float[num_ * 2];
     makeCasTable();
   }
+
+  if (kernel == Kernel_Best) kernel = BestKernel();
+  if (!IsKernelSupported(kernel)) kernel = Kernel_Scalar;
+  kernel_ = kernel;
+
+#ifdef HAVE_FHT_SIMD
+  switch (kernel_) {
+    case Kernel_SSE2:
+      kernels_ = &kFHTKernelsSSE2;
+      break;
+    case Kernel_AVX2:
+      kernels_ = &kFHTKernelsAVX2;
+      break;
+    default:
+      break;
+  }
+#endif
+
+  if (kernels_ && n > 3) makeTwiddles();
 }
 
 FHT::~FHT() {
   delete[] buf_;
   delete[] tab_;
   delete[] log_;
+  delete[] twiddles_;
+}
+
+FHT::Kernel FHT::BestKernel() {
+  if (IsKernelSupported(Kernel_AVX2)) return Kernel_AVX2;
+  if (IsKernelSupported(Kernel_SSE2)) return Kernel_SSE2;
+  return Kernel_Scalar;
+}
+
+bool FHT::IsKernelSupported(Kernel kernel) {
+  switch (kernel) {
+    case Kernel_Scalar:
+      return true;
+#ifdef HAVE_FHT_SIMD
+    case Kernel_SSE2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("sse2");
+    case Kernel_AVX2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2");
+#endif
+    default:
+      return false;
+  }
+}
+
+const char* FHT::KernelName(Kernel kernel) {
+  switch (kernel) {
+    case Kernel_Scalar:
+      return "scalar";
+    case Kernel_SSE2:
+      return "SSE2";
+    case Kernel_AVX2:
+      return "AVX2";
+    default:
+      return "best";
+  }
 }
 
 void FHT::makeCasTable(void) {
@@ -58,6 +121,21 @@ void FHT::makeCasTable(void) {
   }
 }
 
+void FHT::makeTwiddles() {
+  // Each level of the transform combines two halves of 8, 16, ... num_ / 2
+  // values, reading every (num_ / half)th cosine and sine from the cas table.
+  twiddles_ = new float[num_ * 2 - 16];
+  for (int half = 8; half < num_; half *= 2) {
+    float* costab = twiddles_ + 2 * (half - 8);
+    float* sintab = costab + half;
+    const int stride = num_ / half;
+    for (int i = 0; i < half; i++) {
+      costab[i] = tab_[i * stride];
+      sintab[i] = tab_[i * stride + 1];
+    }
+  }
+}
+
 float* FHT::copy(float* d, float* s) {
   return static_cast<float*>(memcpy(d, s, num_ * sizeof(float)));
 }
@@ -101,6 +179,10 @@ void FHT::logSpectrum(float* out, float* p) {
 void FHT::semiLogSpectrum(float* p) {
   float e;
   power2(p);
+  if (kernels_) {
+    kernels_->semi_log_spectrum(p, num_ / 2);
+    return;
+  }
   for (int i = 0; i < (num_ / 2); i++, p++) {
     e = 10.0 * log10(sqrt(*p * .5));
     *p = e < 0 ? 0 : e;
@@ -109,6 +191,10 @@ void FHT::semiLogSpectrum(float* p) {
 
 void FHT::spectrum(float* p) {
   power2(p);
+  if (kernels_) {
+    kernels_->spectrum(p, num_ / 2);
+    return;
+  }
   for (int i = 0; i < (num_ / 2); i++, p++)
     *p = static_cast<float>(sqrt(*p * .5));
 }
@@ -119,6 +205,12 @@ void FHT::power(float* p) {
 }
 
 void FHT::power2(float* p) {
+  if (kernels_) {
+    _transformSimd(p, num_, 0);
+    kernels_->power2(p, num_);
+    return;
+  }
+
   int i;
   float* q;
   _transform(p, num_, 0);
@@ -132,6 +224,8 @@ void FHT::power2(float* p) {
 void FHT::transform(float* p) {
   if (num_ == 8)
     transform8(p);
+  else if (kernels_)
+    _transformSimd(p, num_, 0);
   else
     _transform(p, num_, 0);
 }
@@ -203,3 +297,23 @@ void FHT::_transform(float* p, int n, int k) {
   }
   memcpy(p + k, buf_, sizeof(float) * n);
 }
+
+void FHT::_transformSimd(float* p, int n, int k) {
+  if (n == 8) {
+    transform8(p + k);
+    return;
+  }
+
+  const int ndiv2 = n / 2;
+
+  kernels_->split(p + k, buf_, buf_ + ndiv2, n);
+  memcpy(p + k, buf_, sizeof(float) * n);
+
+  _transformSimd(p, ndiv2, k);
+  _transformSimd(p, ndiv2, k + ndiv2);
+
+  const float* costab = twiddles_ + 2 * (ndiv2 - 8);
+  kernels_->butterfly(p + k, p + k + ndiv2, costab, costab + ndiv2, buf_,
+                      buf_ + ndiv2, ndiv2);
+  memcpy(p + k, buf_, sizeof(float) * n);
+}
@@ -23,6 +23,8 @@
 #ifndef ANALYZERS_FHT_H_
 #define ANALYZERS_FHT_H_
 
+struct FHTKernels;
+
 /**
  * Implementation of the Hartley Transform after Bracewell's discrete
  * algorithm. The algorithm is subject to US patent No. 4,646,256 (1987)
@@ -32,12 +34,36 @@
  * [1] Computer in Physics, Vol. 9, No. 4, Jul/Aug 1995 pp 373-379
  */
 class FHT {
+ public:
+  // The instruction sets that can be used for the transform and spectrum
+  // calculations.  The SIMD versions are only available on x86 processors
+  // that support them.
+  enum Kernel {
+    Kernel_Best = -1,
+    Kernel_Scalar = 0,
+    Kernel_SSE2,
+    Kernel_AVX2,
+  };
+
+  // Returns the fastest kernel that this processor supports.
+  static Kernel BestKernel();
+  static bool IsKernelSupported(Kernel kernel);
+  static const char* KernelName(Kernel kernel);
+
+ private:
   int exp2_;
   int num_;
   float* buf_;
   float* tab_;
   int* log_;
 
+  Kernel kernel_;
+  // nullptr when using the scalar kernel.
+  const FHTKernels* kernels_;
+  // The cas table rearranged so each level of the transform reads its cosine
+  // and sine values from two contiguous arrays.  Only used by SIMD kernels.
+  float* twiddles_;
+
   /**
    * Create a table of "cas" (cosine and sine) values.
    * Has only to be done in the constructor and saves from
@@ -49,18 +75,22 @@ class FHT {
    * Recursive in-place Hartley transform. For internal use only!
    */
   void _transform(float*, int, int);
+  void _transformSimd(float*, int, int);
+  void makeTwiddles();
 
  public:
   /**
   * Prepare transform for data sets with @f$2^n@f$ numbers, whereby @f$n@f$
   * should be at least 3. Values of more than 3 need a trigonometry table.
+  * If the kernel isn't supported the scalar one is used instead.
   * @see makeCasTable()
   */
-  explicit FHT(int);
+  explicit FHT(int, Kernel kernel = Kernel_Best);
 
   ~FHT();
   inline int sizeExp() const { return exp2_; }
   inline int size() const { return num_; }
+  inline Kernel kernel() const { return kernel_; }
   float* copy(float*, float*);
   float* clear(float*);
   void scale(float*, float);
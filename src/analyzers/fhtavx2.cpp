@@ -0,0 +1,166 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// This file is compiled with -mavx2.  Nothing in here may be called unless
+// FHT::IsKernelSupported(FHT::Kernel_AVX2) returns true.
+
+#include "fhtkernels.h"
+
+#include <math.h>
+#include <immintrin.h>
+
+namespace {
+
+// 10 * log10(sqrt(x)) == kDecibelsPerNeper * ln(x)
+const float kDecibelsPerNeper = 2.17147240951626;
+
+inline __m256 Reverse(__m256 v) {
+  return _mm256_permutevar8x32_ps(v, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+}
+
+// Natural logarithm of positive, normal values, using the polynomial from the
+// Cephes library.  Accurate to a few ulp, which is plenty for the analyzers.
+inline __m256 Log(__m256 x) {
+  // Split x into an exponent and a mantissa in [0.5, 1)
+  const __m256i bits = _mm256_castps_si256(x);
+  __m256 e = _mm256_cvtepi32_ps(
+      _mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(126)));
+  __m256 m = _mm256_or_ps(
+      _mm256_and_ps(x, _mm256_castsi256_ps(_mm256_set1_epi32(0x807fffff))),
+      _mm256_set1_ps(0.5f));
+
+  // Move the mantissa into [sqrt(0.5), sqrt(2)) - 1
+  const __m256 small = _mm256_cmp_ps(
+      m, _mm256_set1_ps(0.707106781186547524f), _CMP_LT_OQ);
+  const __m256 extra = _mm256_and_ps(m, small);
+  m = _mm256_sub_ps(m, _mm256_set1_ps(1.0f));
+  e = _mm256_sub_ps(e, _mm256_and_ps(_mm256_set1_ps(1.0f), small));
+  m = _mm256_add_ps(m, extra);
+
+  const __m256 z = _mm256_mul_ps(m, m);
+  __m256 y = _mm256_set1_ps(7.0376836292e-2f);
+  y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(-1.1514610310e-1f));
+  y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(1.1676998740e-1f));
+  y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(-1.2420140846e-1f));
+  y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(1.4249322787e-1f));
+  y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(-1.6668057665e-1f));
+  y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(2.0000714765e-1f));
+  y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(-2.4999993993e-1f));
+  y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(3.3333331174e-1f));
+  y = _mm256_mul_ps(_mm256_mul_ps(y, m), z);
+
+  y = _mm256_add_ps(y, _mm256_mul_ps(e, _mm256_set1_ps(-2.12194440e-4f)));
+  y = _mm256_sub_ps(y, _mm256_mul_ps(z, _mm256_set1_ps(0.5f)));
+  return _mm256_add_ps(_mm256_add_ps(m, y),
+                       _mm256_mul_ps(e, _mm256_set1_ps(0.693359375f)));
+}
+
+void Split(const float* in, float* even, float* odd, int n) {
+  int i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m256 a = _mm256_loadu_ps(in + i);
+    const __m256 b = _mm256_loadu_ps(in + i + 8);
+    // The shuffles work within each 128 bit lane, so the middle two 64 bit
+    // parts have to be swapped afterwards.
+    const __m256 e = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    const __m256 o = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+    _mm256_storeu_ps(even + i / 2,
+                     _mm256_castpd_ps(_mm256_permute4x64_pd(
+                         _mm256_castps_pd(e), _MM_SHUFFLE(3, 1, 2, 0))));
+    _mm256_storeu_ps(odd + i / 2,
+                     _mm256_castpd_ps(_mm256_permute4x64_pd(
+                         _mm256_castps_pd(o), _MM_SHUFFLE(3, 1, 2, 0))));
+  }
+  for (; i < n; i += 2) {
+    even[i / 2] = in[i];
+    odd[i / 2] = in[i + 1];
+  }
+}
+
+void Butterfly(const float* lo, const float* hi, const float* cos,
+               const float* sin, float* out_lo, float* out_hi, int half) {
+  float a = cos[0] * hi[0];
+  a += sin[0] * lo[0];
+  out_lo[0] = lo[0] + a;
+  out_hi[0] = lo[0] - a;
+
+  int i = 1;
+  for (; i + 8 <= half; i += 8) {
+    const __m256 partner = Reverse(_mm256_loadu_ps(hi + half - i - 7));
+    const __m256 v = _mm256_add_ps(
+        _mm256_mul_ps(_mm256_loadu_ps(cos + i), _mm256_loadu_ps(hi + i)),
+        _mm256_mul_ps(_mm256_loadu_ps(sin + i), partner));
+    const __m256 l = _mm256_loadu_ps(lo + i);
+    _mm256_storeu_ps(out_lo + i, _mm256_add_ps(l, v));
+    _mm256_storeu_ps(out_hi + i, _mm256_sub_ps(l, v));
+  }
+  for (; i < half; i++) {
+    a = cos[i] * hi[i];
+    a += sin[i] * hi[half - i];
+    out_lo[i] = lo[i] + a;
+    out_hi[i] = lo[i] - a;
+  }
+}
+
+void Power2(float* p, int num) {
+  const int half = num / 2;
+  p[0] = p[0] * p[0];
+  p[0] += p[0];
+
+  int i = 1;
+  for (; i + 8 <= half; i += 8) {
+    const __m256 x = _mm256_loadu_ps(p + i);
+    const __m256 y = Reverse(_mm256_loadu_ps(p + num - i - 7));
+    _mm256_storeu_ps(p + i,
+                     _mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)));
+  }
+  for (; i < half; i++) {
+    p[i] = (p[i] * p[i]) + (p[num - i] * p[num - i]);
+  }
+}
+
+void Spectrum(float* p, int count) {
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    _mm256_storeu_ps(p + i, _mm256_sqrt_ps(_mm256_mul_ps(
+                                _mm256_loadu_ps(p + i), _mm256_set1_ps(0.5f))));
+  }
+  for (; i < count; i++) {
+    p[i] = static_cast<float>(sqrt(p[i] * .5));
+  }
+}
+
+void SemiLogSpectrum(float* p, int count) {
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    // Anything below 1 gives a negative value, which is clamped to 0 anyway.
+    const __m256 x = _mm256_max_ps(
+        _mm256_mul_ps(_mm256_loadu_ps(p + i), _mm256_set1_ps(0.5f)),
+        _mm256_set1_ps(1.0f));
+    const __m256 e = _mm256_mul_ps(Log(x), _mm256_set1_ps(kDecibelsPerNeper));
+    _mm256_storeu_ps(p + i, _mm256_max_ps(e, _mm256_setzero_ps()));
+  }
+  for (; i < count; i++) {
+    const float e = 10.0 * log10(sqrt(p[i] * .5));
+    p[i] = e < 0 ? 0 : e;
+  }
+}
+
+}  // namespace
+
+const FHTKernels kFHTKernelsAVX2 = {Split, Butterfly, Power2, Spectrum,
+                                    SemiLogSpectrum};
@@ -0,0 +1,54 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ANALYZERS_FHTKERNELS_H_
+#define ANALYZERS_FHTKERNELS_H_
+
+#include "config.h"
+
+// The inner loops of FHT, implemented for one instruction set each.  Each
+// implementation lives in its own file so it can be compiled with the flags
+// for that instruction set, and FHT picks one at runtime.
+struct FHTKernels {
+  // Copies the even values of in to even and the odd values to odd.  n is the
+  // number of values in in.
+  void (*split)(const float* in, float* even, float* odd, int n);
+
+  // Combines two transformed halves of one level of the transform:
+  //   a = cos[i] * hi[i] + sin[i] * (i == 0 ? lo[0] : hi[half - i])
+  //   out_lo[i] = lo[i] + a
+  //   out_hi[i] = lo[i] - a
+  void (*butterfly)(const float* lo, const float* hi, const float* cos,
+                    const float* sin, float* out_lo, float* out_hi, int half);
+
+  // Turns a transformed data set of num values into num / 2 doubled power
+  // values: p[i] = p[i]^2 + p[num - i]^2, and p[0] = 2 * p[0]^2.
+  void (*power2)(float* p, int num);
+
+  // p[i] = sqrt(p[i] * 0.5)
+  void (*spectrum)(float* p, int count);
+
+  // p[i] = max(0, 10 * log10(sqrt(p[i] * 0.5)))
+  void (*semi_log_spectrum)(float* p, int count);
+};
+
+#ifdef HAVE_FHT_SIMD
+extern const FHTKernels kFHTKernelsSSE2;
+extern const FHTKernels kFHTKernelsAVX2;
+#endif
+
+#endif  // ANALYZERS_FHTKERNELS_H_
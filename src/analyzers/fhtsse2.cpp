@@ -0,0 +1,155 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// This file is compiled with -msse2.  Nothing in here may be called unless
+// FHT::IsKernelSupported(FHT::Kernel_SSE2) returns true.
+
+#include "fhtkernels.h"
+
+#include <math.h>
+#include <emmintrin.h>
+
+namespace {
+
+// 10 * log10(sqrt(x)) == kDecibelsPerNeper * ln(x)
+const float kDecibelsPerNeper = 2.17147240951626;
+
+inline __m128 Reverse(__m128 v) {
+  return _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 1, 2, 3));
+}
+
+// Natural logarithm of positive, normal values, using the polynomial from the
+// Cephes library.  Accurate to a few ulp, which is plenty for the analyzers.
+inline __m128 Log(__m128 x) {
+  // Split x into an exponent and a mantissa in [0.5, 1)
+  const __m128i bits = _mm_castps_si128(x);
+  __m128 e = _mm_cvtepi32_ps(
+      _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(126)));
+  __m128 m = _mm_or_ps(
+      _mm_and_ps(x, _mm_castsi128_ps(_mm_set1_epi32(0x807fffff))),
+      _mm_set1_ps(0.5f));
+
+  // Move the mantissa into [sqrt(0.5), sqrt(2)) - 1
+  const __m128 small = _mm_cmplt_ps(m, _mm_set1_ps(0.707106781186547524f));
+  const __m128 extra = _mm_and_ps(m, small);
+  m = _mm_sub_ps(m, _mm_set1_ps(1.0f));
+  e = _mm_sub_ps(e, _mm_and_ps(_mm_set1_ps(1.0f), small));
+  m = _mm_add_ps(m, extra);
+
+  const __m128 z = _mm_mul_ps(m, m);
+  __m128 y = _mm_set1_ps(7.0376836292e-2f);
+  y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(-1.1514610310e-1f));
+  y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(1.1676998740e-1f));
+  y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(-1.2420140846e-1f));
+  y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(1.4249322787e-1f));
+  y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(-1.6668057665e-1f));
+  y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(2.0000714765e-1f));
+  y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(-2.4999993993e-1f));
+  y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(3.3333331174e-1f));
+  y = _mm_mul_ps(_mm_mul_ps(y, m), z);
+
+  y = _mm_add_ps(y, _mm_mul_ps(e, _mm_set1_ps(-2.12194440e-4f)));
+  y = _mm_sub_ps(y, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+  return _mm_add_ps(_mm_add_ps(m, y), _mm_mul_ps(e, _mm_set1_ps(0.693359375f)));
+}
+
+void Split(const float* in, float* even, float* odd, int n) {
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m128 a = _mm_loadu_ps(in + i);
+    const __m128 b = _mm_loadu_ps(in + i + 4);
+    _mm_storeu_ps(even + i / 2, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(odd + i / 2, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+  }
+  for (; i < n; i += 2) {
+    even[i / 2] = in[i];
+    odd[i / 2] = in[i + 1];
+  }
+}
+
+void Butterfly(const float* lo, const float* hi, const float* cos,
+               const float* sin, float* out_lo, float* out_hi, int half) {
+  float a = cos[0] * hi[0];
+  a += sin[0] * lo[0];
+  out_lo[0] = lo[0] + a;
+  out_hi[0] = lo[0] - a;
+
+  int i = 1;
+  for (; i + 4 <= half; i += 4) {
+    const __m128 partner = Reverse(_mm_loadu_ps(hi + half - i - 3));
+    const __m128 v = _mm_add_ps(
+        _mm_mul_ps(_mm_loadu_ps(cos + i), _mm_loadu_ps(hi + i)),
+        _mm_mul_ps(_mm_loadu_ps(sin + i), partner));
+    const __m128 l = _mm_loadu_ps(lo + i);
+    _mm_storeu_ps(out_lo + i, _mm_add_ps(l, v));
+    _mm_storeu_ps(out_hi + i, _mm_sub_ps(l, v));
+  }
+  for (; i < half; i++) {
+    a = cos[i] * hi[i];
+    a += sin[i] * hi[half - i];
+    out_lo[i] = lo[i] + a;
+    out_hi[i] = lo[i] - a;
+  }
+}
+
+void Power2(float* p, int num) {
+  const int half = num / 2;
+  p[0] = p[0] * p[0];
+  p[0] += p[0];
+
+  int i = 1;
+  for (; i + 4 <= half; i += 4) {
+    const __m128 x = _mm_loadu_ps(p + i);
+    const __m128 y = Reverse(_mm_loadu_ps(p + num - i - 3));
+    _mm_storeu_ps(p + i, _mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)));
+  }
+  for (; i < half; i++) {
+    p[i] = (p[i] * p[i]) + (p[num - i] * p[num - i]);
+  }
+}
+
+void Spectrum(float* p, int count) {
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    _mm_storeu_ps(p + i, _mm_sqrt_ps(_mm_mul_ps(_mm_loadu_ps(p + i),
+                                                _mm_set1_ps(0.5f))));
+  }
+  for (; i < count; i++) {
+    p[i] = static_cast<float>(sqrt(p[i] * .5));
+  }
+}
+
+void SemiLogSpectrum(float* p, int count) {
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    // Anything below 1 gives a negative value, which is clamped to 0 anyway.
+    const __m128 x = _mm_max_ps(_mm_mul_ps(_mm_loadu_ps(p + i),
+                                           _mm_set1_ps(0.5f)),
+                                _mm_set1_ps(1.0f));
+    const __m128 e = _mm_mul_ps(Log(x), _mm_set1_ps(kDecibelsPerNeper));
+    _mm_storeu_ps(p + i, _mm_max_ps(e, _mm_setzero_ps()));
+  }
+  for (; i < count; i++) {
+    const float e = 10.0 * log10(sqrt(p[i] * .5));
+    p[i] = e < 0 ? 0 : e;
+  }
+}
+
+}  // namespace
+
+const FHTKernels kFHTKernelsSSE2 = {Split, Butterfly, Power2, Spectrum,
+                                    SemiLogSpectrum};
@@ -21,15 +21,21 @@
 */
 
 #include "application.h"
+
+#include <QTime>
+
 #include "appearance.h"
 #include "config.h"
 #include "database.h"
+#include "logging.h"
 #include "player.h"
+#include "stringpool.h"
 #include "tagreaderclient.h"
 #include "taskmanager.h"
 #include "covers/albumcoverloader.h"
 #include "covers/coverproviders.h"
 #include "covers/currentartloader.h"
+#include "covers/thumbnailstore.h"
 #include "devices/devicemanager.h"
 #include "internet/core/internetmodel.h"
 #include "globalsearch/globalsearch.h"
@@ -39,6 +45,7 @@
 #include "networkremote/networkremotehelper.h"
 #include "playlist/playlistbackend.h"
 #include "playlist/playlistmanager.h"
+#include "transcoder/transcoderscheduler.h"
 #include "internet/podcasts/gpoddersync.h"
 #include "internet/podcasts/podcastbackend.h"
 #include "internet/podcasts/podcastdeleter.h"
@@ -56,6 +63,32 @@
 
 bool Application::kIsPortable = false;
 
+namespace {
+
+// Logs how long each component took to create at startup.
+class StartupTrace {
+ public:
+  StartupTrace() {
+    total_.start();
+    time_.start();
+  }
+
+  void Mark(const char* component) {
+    qLog(Debug) << "Startup:" << component << "took" << time_.restart()
+                << "ms";
+  }
+
+  void Finish() {
+    qLog(Debug) << "Startup: all components took" << total_.elapsed() << "ms";
+  }
+
+ private:
+  QTime total_;
+  QTime time_;
+};
+
+}  // namespace
+
 Application::Application(QObject* parent)
     : QObject(parent),
       tag_reader_client_(nullptr),
@@ -66,6 +99,8 @@ Application::Application(QObject* parent)
       appearance_(nullptr),
       cover_providers_(nullptr),
       task_manager_(nullptr),
+      thumbnail_store_(nullptr),
+      transcoder_scheduler_(nullptr),
       player_(nullptr),
       playlist_manager_(nullptr),
       current_art_loader_(nullptr),
@@ -82,32 +117,48 @@ Application::Application(QObject* parent)
       network_remote_(nullptr),
       network_remote_helper_(nullptr),
       scrobbler_(nullptr) {
+  StartupTrace trace;
+
   tag_reader_client_ = new TagReaderClient(this);
   MoveToNewThread(tag_reader_client_);
   tag_reader_client_->Start();
+  trace.Mark("TagReaderClient");
 
   database_ = new Database(this, this);
   MoveToNewThread(database_);
+  trace.Mark("Database");
 
   album_cover_loader_ = new AlbumCoverLoader(this);
   MoveToNewThread(album_cover_loader_);
+  trace.Mark("AlbumCoverLoader");
 
   playlist_backend_ = new PlaylistBackend(this, this);
   MoveToThread(playlist_backend_, database_->thread());
 
   podcast_backend_ = new PodcastBackend(this, this);
   MoveToThread(podcast_backend_, database_->thread());
+  trace.Mark("Backends");
 
   appearance_ = new Appearance(this);
   cover_providers_ = new CoverProviders(this);
   task_manager_ = new TaskManager(this);
+  trace.Mark("Appearance, CoverProviders and TaskManager");
+  transcoder_scheduler_ = new TranscoderScheduler(task_manager_, this);
+  thumbnail_store_ = new ThumbnailStore(this, this);
+  trace.Mark("ThumbnailStore");
   player_ = new Player(this, this);
+  trace.Mark("Player");
   playlist_manager_ = new PlaylistManager(this, this);
+  trace.Mark("PlaylistManager");
   current_art_loader_ = new CurrentArtLoader(this, this);
   global_search_ = new GlobalSearch(this, this);
+  trace.Mark("CurrentArtLoader and GlobalSearch");
   internet_model_ = new InternetModel(this, this);
+  trace.Mark("InternetModel");
   library_ = new Library(this, this);
+  trace.Mark("Library");
   device_manager_ = new DeviceManager(this, this);
+  trace.Mark("DeviceManager");
   podcast_updater_ = new PodcastUpdater(this, this);
 
   podcast_deleter_ = new PodcastDeleter(this, this);
@@ -115,10 +166,12 @@ Application::Application(QObject* parent)
 
   podcast_downloader_ = new PodcastDownloader(this, this);
   gpodder_sync_ = new GPodderSync(this, this);
+  trace.Mark("Podcasts");
 
 #ifdef HAVE_MOODBAR
   moodbar_loader_ = new MoodbarLoader(this, this);
   moodbar_controller_ = new MoodbarController(this, this);
+  trace.Mark("Moodbar");
 #endif
 
   // Network Remote
@@ -131,17 +184,25 @@ Application::Application(QObject* parent)
   // to start the remote. Without the playlist manager clementine can
   // crash when a client connects before the manager is initialized!
   network_remote_helper_ = new NetworkRemoteHelper(this);
+  trace.Mark("NetworkRemote");
 
 #ifdef HAVE_LIBLASTFM
   scrobbler_ = new LastFMService(this, this);
+  trace.Mark("LastFMService");
 #endif  // HAVE_LIBLASTFM
 
   library_->Init();
+  trace.Mark("Library::Init");
+  trace.Finish();
 
   DoInAMinuteOrSo(database_, SLOT(DoBackup()));
 }
 
 Application::~Application() {
+  // Everything that holds songs is still alive, so this shows how much memory
+  // the string pool is saving for this library.
+  StringPool::Instance()->LogStats();
+
   // It's important that the device manager is deleted before the database.
   // Deleting the database deletes all objects that have been created in its
   // thread, including some device library backends.
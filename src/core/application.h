@@ -52,6 +52,8 @@ class PodcastUpdater;
 class Scrobbler;
 class TagReaderClient;
 class TaskManager;
+class ThumbnailStore;
+class TranscoderScheduler;
 
 class Application : public QObject {
   Q_OBJECT
@@ -76,6 +78,10 @@ class Application : public QObject {
   Appearance* appearance() const { return appearance_; }
   CoverProviders* cover_providers() const { return cover_providers_; }
   TaskManager* task_manager() const { return task_manager_; }
+  ThumbnailStore* thumbnail_store() const { return thumbnail_store_; }
+  TranscoderScheduler* transcoder_scheduler() const {
+    return transcoder_scheduler_;
+  }
   Player* player() const { return player_; }
   PlaylistManager* playlist_manager() const { return playlist_manager_; }
   CurrentArtLoader* current_art_loader() const { return current_art_loader_; }
@@ -122,6 +128,8 @@ class Application : public QObject {
   Appearance* appearance_;
   CoverProviders* cover_providers_;
   TaskManager* task_manager_;
+  ThumbnailStore* thumbnail_store_;
+  TranscoderScheduler* transcoder_scheduler_;
   Player* player_;
   PlaylistManager* playlist_manager_;
   CurrentArtLoader* current_art_loader_;
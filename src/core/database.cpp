@@ -43,12 +43,14 @@
 #include <QSqlQuery>
 #include <QtDebug>
 #include <QThread>
+#include <QTime>
 #include <QUrl>
 #include <QVariant>
 
 const char* Database::kDatabaseFilename = "clementine.db";
-const int Database::kSchemaVersion = 50;
+const int Database::kSchemaVersion = 55;
 const char* Database::kMagicAllSongsTables = "%allsongstables";
+const int Database::kSlowLockWaitMsec = 100;
 
 int Database::sNextConnectionId = 1;
 QMutex Database::sNextConnectionIdMutex;
@@ -212,6 +214,7 @@ Database::Database(Application* app, QObject* parent,
     : QObject(parent),
       app_(app),
       mutex_(QMutex::Recursive),
+      wal_(false),
       injected_database_name_(database_name),
       query_hash_(0),
       startup_schema_version_(-1) {
@@ -227,7 +230,74 @@ Database::Database(Application* app, QObject* parent,
       directory_ + "/jamendo.db", ":/schema/jamendo.sql", false);
 
   QMutexLocker l(&mutex_);
-  Connect();
+  QSqlDatabase db = Connect();
+  if (db.isOpen()) wal_ = EnableWal(db);
+}
+
+Database::~Database() { LogLockStatistics(); }
+
+bool Database::EnableWal(QSqlDatabase& db) {
+  // In-memory databases can't use a write-ahead log.
+  if (db.databaseName() == ":memory:") return false;
+
+  // This setting is stored in the database file, so every connection opened
+  // from now on will use it too.
+  QSqlQuery q("PRAGMA journal_mode = WAL", db);
+  if (CheckErrors(q) || !q.next()) return false;
+
+  const QString mode = q.value(0).toString();
+  if (mode.compare("wal", Qt::CaseInsensitive) != 0) {
+    qLog(Warning) << "Couldn't enable write-ahead logging, using" << mode
+                  << "journal mode instead";
+    return false;
+  }
+  return true;
+}
+
+void Database::Lock(const char* caller) {
+  if (mutex_.tryLock()) return;
+
+  QTime time;
+  time.start();
+  mutex_.lock();
+  const int msec = time.elapsed();
+
+  if (msec >= kSlowLockWaitMsec) {
+    qLog(Debug) << caller << "waited" << msec << "ms for the database lock";
+  }
+
+  QMutexLocker l(&lock_statistics_mutex_);
+  LockStatistics& stats = lock_statistics_[caller];
+  stats.waits++;
+  stats.total_msec += msec;
+  stats.max_msec = qMax(stats.max_msec, msec);
+}
+
+void Database::LogLockStatistics() {
+  QMutexLocker l(&lock_statistics_mutex_);
+  for (QMap<QString, LockStatistics>::const_iterator it =
+           lock_statistics_.constBegin();
+       it != lock_statistics_.constEnd(); ++it) {
+    qLog(Debug) << "Database lock:" << it.key() << "waited" << it->waits
+                << "times," << it->total_msec << "ms total," << it->max_msec
+                << "ms max";
+  }
+}
+
+Database::WriteLocker::WriteLocker(Database* db, const char* caller)
+    : db_(db) {
+  db_->Lock(caller);
+}
+
+Database::WriteLocker::~WriteLocker() { db_->mutex_.unlock(); }
+
+Database::ReadLocker::ReadLocker(Database* db, const char* caller)
+    : db_(db->is_wal() ? nullptr : db) {
+  if (db_) db_->Lock(caller);
+}
+
+Database::ReadLocker::~ReadLocker() {
+  if (db_) db_->mutex_.unlock();
 }
 
 QSqlDatabase Database::Connect() {
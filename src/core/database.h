@@ -49,6 +49,7 @@ class Database : public QObject {
  public:
   Database(Application* app, QObject* parent = nullptr,
            const QString& database_name = QString());
+  ~Database();
 
   struct AttachedDatabase {
     AttachedDatabase() {}
@@ -65,9 +66,42 @@ class Database : public QObject {
   static const char* kDatabaseFilename;
   static const char* kMagicAllSongsTables;
 
+  // Waits for the lock longer than this are logged as they happen.
+  static const int kSlowLockWaitMsec;
+
+  // Locks the database for writing for the lifetime of the object.  If the
+  // lock is contended, the time spent waiting for it is recorded against
+  // caller (usually Q_FUNC_INFO).
+  class WriteLocker {
+   public:
+    WriteLocker(Database* db, const char* caller);
+    ~WriteLocker();
+
+   private:
+    Q_DISABLE_COPY(WriteLocker)
+    Database* db_;
+  };
+
+  // Like WriteLocker, but only takes the lock if the database isn't in WAL
+  // mode.  In WAL mode each thread's connection reads from a consistent
+  // snapshot without blocking, or being blocked by, the writer.
+  class ReadLocker {
+   public:
+    ReadLocker(Database* db, const char* caller);
+    ~ReadLocker();
+
+   private:
+    Q_DISABLE_COPY(ReadLocker)
+    Database* db_;
+  };
+
   QSqlDatabase Connect();
   bool CheckErrors(const QSqlQuery& query);
   QMutex* Mutex() { return &mutex_; }
+  bool is_wal() const { return wal_; }
+
+  // Logs how long each caller has spent waiting for the lock.
+  void LogLockStatistics();
 
   void RecreateAttachedDb(const QString& database_name);
   void ExecSchemaCommands(QSqlDatabase& db, const QString& schema,
@@ -104,6 +138,9 @@ class Database : public QObject {
   bool IntegrityCheck(QSqlDatabase db);
   void BackupFile(const QString& filename);
   bool OpenDatabase(const QString& filename, sqlite3** connection) const;
+  bool EnableWal(QSqlDatabase& db);
+
+  void Lock(const char* caller);
 
   Application* app_;
 
@@ -113,6 +150,18 @@ class Database : public QObject {
   QString directory_;
   QMutex connect_mutex_;
   QMutex mutex_;
+  bool wal_;
+
+  struct LockStatistics {
+    LockStatistics() : waits(0), total_msec(0), max_msec(0) {}
+
+    int waits;
+    qint64 total_msec;
+    int max_msec;
+  };
+
+  QMutex lock_statistics_mutex_;
+  QMap<QString, LockStatistics> lock_statistics_;
 
   // This ID makes the QSqlDatabase name unique to the object as well as the
   // thread
@@ -0,0 +1,118 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "fileexistencechecker.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QMutex>
+#include <QRunnable>
+#include <QThreadPool>
+
+const int FileExistenceChecker::kMinFilesToList = 4;
+const int FileExistenceChecker::kMaxThreads = 4;
+
+namespace {
+
+class DirectoryCheck : public QRunnable {
+ public:
+  DirectoryCheck(const QString& path, const QStringList& names, QMutex* mutex,
+                 QSet<QString>* missing)
+      : path_(path), names_(names), mutex_(mutex), missing_(missing) {}
+
+  void run() {
+    QSet<QString> missing;
+
+    if (!QFileInfo(path_).isDir()) {
+      // Nothing in here exists.
+      for (const QString& name : names_) {
+        missing << Filename(name);
+      }
+    } else if (names_.count() < FileExistenceChecker::kMinFilesToList) {
+      for (const QString& name : names_) {
+        if (!QFile::exists(Filename(name))) missing << Filename(name);
+      }
+    } else {
+      const QSet<QString> entries =
+          QDir(path_).entryList(QDir::AllEntries | QDir::Hidden |
+                                QDir::System | QDir::NoDotAndDotDot).toSet();
+
+      for (const QString& name : names_) {
+        if (entries.contains(name)) continue;
+
+        // The name might be spelt differently on a case insensitive
+        // filesystem, so make sure before saying it's missing.
+        if (!QFile::exists(Filename(name))) missing << Filename(name);
+      }
+    }
+
+    QMutexLocker l(mutex_);
+    missing_->unite(missing);
+  }
+
+ private:
+  QString Filename(const QString& name) const { return path_ + "/" + name; }
+
+  QString path_;
+  QStringList names_;
+  QMutex* mutex_;
+  QSet<QString>* missing_;
+};
+
+}  // namespace
+
+QSet<QString> FileExistenceChecker::MissingFiles(const QStringList& filenames) {
+  QSet<QString> ret;
+
+  // Group the files by directory.  The results have to use the filenames
+  // exactly as they were given, so remember those too.
+  QMap<QString, QStringList> names_by_directory;
+  QMap<QString, QStringList> filenames_by_checked_name;
+  for (const QString& filename : filenames) {
+    if (filename.isEmpty()) {
+      ret << filename;
+      continue;
+    }
+
+    const QFileInfo info(filename);
+    const QString path = info.path();
+    const QString name = info.fileName();
+    names_by_directory[path] << name;
+    filenames_by_checked_name[path + "/" + name] << filename;
+  }
+
+  QMutex mutex;
+  QSet<QString> missing;
+
+  QThreadPool pool;
+  pool.setMaxThreadCount(kMaxThreads);
+  for (QMap<QString, QStringList>::const_iterator it =
+           names_by_directory.constBegin();
+       it != names_by_directory.constEnd(); ++it) {
+    pool.start(new DirectoryCheck(it.key(), it.value(), &mutex, &missing));
+  }
+  pool.waitForDone();
+
+  for (const QString& checked_name : missing) {
+    for (const QString& filename : filenames_by_checked_name[checked_name]) {
+      ret << filename;
+    }
+  }
+  return ret;
+}
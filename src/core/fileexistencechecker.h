@@ -0,0 +1,42 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CORE_FILEEXISTENCECHECKER_H_
+#define CORE_FILEEXISTENCECHECKER_H_
+
+#include <QSet>
+#include <QStringList>
+
+// Finds out which of a lot of files exist, without stat'ing each one.  The
+// files are grouped by directory and each directory is listed once, with a
+// few directories being listed at the same time.  This makes a big
+// difference on network filesystems, where every stat is a round trip.
+class FileExistenceChecker {
+ public:
+  // Directories with fewer files than this to check have their files stat'ed
+  // instead, because listing a big directory to find one file is slower.
+  static const int kMinFilesToList;
+
+  // The most directories that are checked at the same time.
+  static const int kMaxThreads;
+
+  // Returns the filenames that don't exist.  Blocks until every directory
+  // has been checked.
+  static QSet<QString> MissingFiles(const QStringList& filenames);
+};
+
+#endif  // CORE_FILEEXISTENCECHECKER_H_
@@ -62,6 +62,9 @@ Organise::Organise(TaskManager* task_manager,
       current_copy_progress_(0) {
   original_thread_ = thread();
 
+  // Our own task shows the transcoding progress
+  transcoder_->set_show_job_tasks(false);
+
   for (const NewSongInfo& song_info : songs_info) {
     tasks_pending_ << Task(song_info);
   }
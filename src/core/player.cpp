@@ -40,6 +40,7 @@
 #include "core/urlhandler.h"
 #include "engines/enginebase.h"
 #include "engines/gstengine.h"
+#include "internet/core/internetmodel.h"
 #include "library/librarybackend.h"
 #include "playlist/playlist.h"
 #include "playlist/playlistitem.h"
@@ -652,7 +653,16 @@ const UrlHandler* Player::HandlerForUrl(const QUrl& url) const {
   QMap<QString, UrlHandler*>::const_iterator it =
       url_handlers_.constFind(url.scheme());
   if (it == url_handlers_.constEnd()) {
-    return nullptr;
+    // The internet service that handles this scheme might not have been
+    // created yet.  Creating it registers its handler.
+    if (!app_->internet_model() ||
+        !app_->internet_model()->CreateServiceForUrlScheme(url.scheme())) {
+      return nullptr;
+    }
+    it = url_handlers_.constFind(url.scheme());
+    if (it == url_handlers_.constEnd()) {
+      return nullptr;
+    }
   }
   return *it;
 }
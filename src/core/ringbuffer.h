@@ -0,0 +1,124 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CORE_RINGBUFFER_H_
+#define CORE_RINGBUFFER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include <QtGlobal>
+
+// A fixed size FIFO that can be written to by one thread and read from by
+// another without any locking.  Write must only ever be called from one
+// thread at a time, and Available, Read, Skip and Clear from one other thread.
+template <typename T>
+class RingBuffer {
+ public:
+  // The capacity is rounded up to the next power of two.
+  explicit RingBuffer(int capacity);
+
+  int capacity() const { return data_.size(); }
+
+  // Appends count values to the buffer.  If there isn't room for all of them
+  // nothing is written and false is returned.
+  bool Write(const T* data, int count);
+
+  // The number of values that can be read.
+  int Available() const;
+
+  // Copies up to count values into data and removes them from the buffer.
+  // Returns the number of values read.
+  int Read(T* data, int count);
+
+  // Removes up to count values from the buffer without reading them.  Returns
+  // the number of values removed.
+  int Skip(int count);
+  void Clear() { Skip(Available()); }
+
+ private:
+  Q_DISABLE_COPY(RingBuffer)
+
+  static size_t RoundUpToPowerOfTwo(int n) {
+    size_t ret = 1;
+    while (ret < size_t(n)) ret <<= 1;
+    return ret;
+  }
+
+  std::vector<T> data_;
+  const size_t mask_;
+
+  // These only ever increase, and wrap around at the end of size_t.  Each is
+  // written by only one side and read by the other.
+  std::atomic<size_t> read_pos_;
+  std::atomic<size_t> write_pos_;
+};
+
+template <typename T>
+RingBuffer<T>::RingBuffer(int capacity)
+    : data_(RoundUpToPowerOfTwo(capacity)),
+      mask_(data_.size() - 1),
+      read_pos_(0),
+      write_pos_(0) {}
+
+template <typename T>
+bool RingBuffer<T>::Write(const T* data, int count) {
+  const size_t write_pos = write_pos_.load(std::memory_order_relaxed);
+  const size_t read_pos = read_pos_.load(std::memory_order_acquire);
+  if (count < 0 || size_t(count) > data_.size() - (write_pos - read_pos)) {
+    return false;
+  }
+
+  const size_t start = write_pos & mask_;
+  const size_t first = std::min(size_t(count), data_.size() - start);
+  std::copy(data, data + first, data_.begin() + start);
+  std::copy(data + first, data + count, data_.begin());
+
+  write_pos_.store(write_pos + count, std::memory_order_release);
+  return true;
+}
+
+template <typename T>
+int RingBuffer<T>::Available() const {
+  return write_pos_.load(std::memory_order_acquire) -
+         read_pos_.load(std::memory_order_relaxed);
+}
+
+template <typename T>
+int RingBuffer<T>::Read(T* data, int count) {
+  const size_t read_pos = read_pos_.load(std::memory_order_relaxed);
+  count = qBound(0, count, Available());
+
+  const size_t start = read_pos & mask_;
+  const size_t first = std::min(size_t(count), data_.size() - start);
+  std::copy(data_.begin() + start, data_.begin() + start + first, data);
+  std::copy(data_.begin(), data_.begin() + (count - first), data + first);
+
+  read_pos_.store(read_pos + count, std::memory_order_release);
+  return count;
+}
+
+template <typename T>
+int RingBuffer<T>::Skip(int count) {
+  count = qBound(0, count, Available());
+  read_pos_.fetch_add(count, std::memory_order_release);
+  return count;
+}
+
+#endif  // CORE_RINGBUFFER_H_
@@ -29,6 +29,7 @@
 #include "song.h"
 
 #include <algorithm>
+#include <atomic>
 
 #include <QCoreApplication>
 #include <QDir>
@@ -38,6 +39,7 @@
 #include <QSharedData>
 #include <QSqlQuery>
 #include <QTextCodec>
+#include <QThread>
 #include <QTime>
 #include <QVariant>
 #include <QtConcurrentRun>
@@ -65,6 +67,8 @@
 #include "core/logging.h"
 #include "core/messagehandler.h"
 #include "core/mpris_common.h"
+#include "core/sqlitequery.h"
+#include "core/stringpool.h"
 #include "core/timeconstants.h"
 #include "core/utilities.h"
 #include "covers/albumcoverloader.h"
@@ -141,6 +145,116 @@ const QString Song::kFtsUpdateSpec =
 const QString Song::kManuallyUnsetCover = "(unset)";
 const QString Song::kEmbeddedCover = "(embedded)";
 
+namespace {
+
+// Used for the fields that are usually the same for lots of songs.
+QString Intern(const QString& s) { return StringPool::Instance()->Intern(s); }
+
+QUrl PortableUrl(const QUrl& url) {
+  if (!Application::kIsPortable) return url;
+
+  QUrl base = QUrl::fromLocalFile(QCoreApplication::applicationDirPath() + "/");
+  return base.resolved(url);
+}
+
+// Songs loaded from the database keep their url encoded until it's first
+// used, because parsing it and working out the basefilename is a large part
+// of the time taken to load a song.  Songs are shared between threads, so the
+// first thread to use the url decodes it and any others wait for it to finish.
+// Everything else only happens to a Song::Private that isn't shared.
+class LazyUrl {
+ public:
+  LazyUrl() : state_(State_Decoded) {}
+
+  LazyUrl(const LazyUrl& other) : state_(State_Decoded) { *this = other; }
+
+  LazyUrl& operator=(const LazyUrl& other) {
+    if (this == &other) return *this;
+
+    other.Decode();
+    url_ = other.url_;
+    basefilename_ = other.basefilename_;
+    encoded_.clear();
+    state_.store(State_Decoded, std::memory_order_release);
+    return *this;
+  }
+
+  const QUrl& url() const {
+    Decode();
+    return url_;
+  }
+
+  const QString& basefilename() const {
+    Decode();
+    return basefilename_;
+  }
+
+  void set_url(const QUrl& url) {
+    Decode();
+    url_ = url;
+  }
+
+  void set_basefilename(const QString& basefilename) {
+    Decode();
+    basefilename_ = basefilename;
+  }
+
+  // Sets the url and the basefilename from the encoded url the first time
+  // either is used.
+  void SetEncoded(const QByteArray& encoded) {
+    url_ = QUrl();
+    basefilename_.clear();
+    encoded_ = encoded;
+    state_.store(State_Pending, std::memory_order_release);
+  }
+
+ private:
+  enum State { State_Decoded, State_Pending, State_Decoding };
+
+  void Decode() const {
+    if (state_.load(std::memory_order_acquire) == State_Decoded) return;
+
+    int expected = State_Pending;
+    if (state_.compare_exchange_strong(expected, State_Decoding,
+                                       std::memory_order_acquire)) {
+      url_ = PortableUrl(QUrl::fromEncoded(encoded_));
+      basefilename_ = QFileInfo(url_.toLocalFile()).fileName();
+      encoded_.clear();
+      state_.store(State_Decoded, std::memory_order_release);
+      return;
+    }
+
+    // Another thread is decoding it, which doesn't take long.
+    while (state_.load(std::memory_order_acquire) != State_Decoded) {
+      QThread::yieldCurrentThread();
+    }
+  }
+
+  mutable QUrl url_;
+  mutable QString basefilename_;
+  mutable QByteArray encoded_;
+  mutable std::atomic<int> state_;
+};
+
+// Reads the columns of a SqlRow the same way SqliteQuery does, so
+// Song::InitFromColumns can use either.
+class SqlRowColumns {
+ public:
+  explicit SqlRowColumns(const SqlRow& row) : row_(row) {}
+
+  bool IsNull(int column) const { return row_.value(column).isNull(); }
+  int Int(int column) const { return row_.value(column).toInt(); }
+  qint64 Int64(int column) const { return row_.value(column).toLongLong(); }
+  double Double(int column) const { return row_.value(column).toDouble(); }
+  QString Text(int column) const { return row_.value(column).toString(); }
+  QByteArray Utf8(int column) const { return Text(column).toUtf8(); }
+
+ private:
+  const SqlRow& row_;
+};
+
+}  // namespace
+
 struct Song::Private : public QSharedData {
   Private();
 
@@ -197,8 +311,7 @@ struct Song::Private : public QSharedData {
   int samplerate_;
 
   int directory_id_;
-  QUrl url_;
-  QString basefilename_;
+  LazyUrl url_;  // Also holds the basefilename
   int mtime_;
   int ctime_;
   int filesize_;
@@ -313,8 +426,10 @@ qint64 Song::length_nanosec() const { return d->end_ - d->beginning_; }
 int Song::bitrate() const { return d->bitrate_; }
 int Song::samplerate() const { return d->samplerate_; }
 int Song::directory_id() const { return d->directory_id_; }
-const QUrl& Song::url() const { return d->url_; }
-const QString& Song::basefilename() const { return d->basefilename_; }
+const QUrl& Song::url() const { return d->url_.url(); }
+const QString& Song::basefilename() const {
+  return d->url_.basefilename();
+}
 uint Song::mtime() const { return d->mtime_; }
 uint Song::ctime() const { return d->ctime_; }
 int Song::filesize() const { return d->filesize_; }
@@ -381,17 +496,11 @@ void Song::set_cue_path(const QString& v) { d->cue_path_ = v; }
 void Song::set_unavailable(bool v) { d->unavailable_ = v; }
 void Song::set_etag(const QString& etag) { d->etag_ = etag; }
 
-void Song::set_url(const QUrl& v) {
-  if (Application::kIsPortable) {
-    QUrl base =
-        QUrl::fromLocalFile(QCoreApplication::applicationDirPath() + "/");
-    d->url_ = base.resolved(v);
-  } else {
-    d->url_ = v;
-  }
-}
+void Song::set_url(const QUrl& v) { d->url_.set_url(PortableUrl(v)); }
 
-void Song::set_basefilename(const QString& v) { d->basefilename_ = v; }
+void Song::set_basefilename(const QString& v) {
+  d->url_.set_basefilename(v);
+}
 void Song::set_directory_id(int v) { d->directory_id_ = v; }
 
 QString Song::JoinSpec(const QString& table) {
@@ -497,19 +606,19 @@ void Song::InitFromProtobuf(const pb::tagreader::SongMetadata& pb) {
   d->init_from_file_ = true;
   d->valid_ = pb.valid();
   d->title_ = QStringFromStdString(pb.title());
-  d->album_ = QStringFromStdString(pb.album());
-  d->artist_ = QStringFromStdString(pb.artist());
-  d->albumartist_ = QStringFromStdString(pb.albumartist());
-  d->composer_ = QStringFromStdString(pb.composer());
-  d->performer_ = QStringFromStdString(pb.performer());
-  d->grouping_ = QStringFromStdString(pb.grouping());
+  d->album_ = Intern(QStringFromStdString(pb.album()));
+  d->artist_ = Intern(QStringFromStdString(pb.artist()));
+  d->albumartist_ = Intern(QStringFromStdString(pb.albumartist()));
+  d->composer_ = Intern(QStringFromStdString(pb.composer()));
+  d->performer_ = Intern(QStringFromStdString(pb.performer()));
+  d->grouping_ = Intern(QStringFromStdString(pb.grouping()));
   d->lyrics_ = QStringFromStdString(pb.lyrics());
   d->track_ = pb.track();
   d->disc_ = pb.disc();
   d->bpm_ = pb.bpm();
   d->year_ = pb.year();
   d->originalyear_ = pb.originalyear();
-  d->genre_ = QStringFromStdString(pb.genre());
+  d->genre_ = Intern(QStringFromStdString(pb.genre()));
   d->comment_ = QStringFromStdString(pb.comment());
   d->compilation_ = pb.compilation();
   d->playcount_ = pb.playcount();
@@ -520,7 +629,7 @@ void Song::InitFromProtobuf(const pb::tagreader::SongMetadata& pb) {
   d->bitrate_ = pb.bitrate();
   d->samplerate_ = pb.samplerate();
   set_url(QUrl::fromEncoded(QByteArray(pb.url().data(), pb.url().size())));
-  d->basefilename_ = QStringFromStdString(pb.basefilename());
+  d->url_.set_basefilename(QStringFromStdString(pb.basefilename()));
   d->mtime_ = pb.mtime();
   d->ctime_ = pb.ctime();
   d->filesize_ = pb.filesize();
@@ -529,7 +638,7 @@ void Song::InitFromProtobuf(const pb::tagreader::SongMetadata& pb) {
   d->etag_ = QStringFromStdString(pb.etag());
 
   if (pb.has_art_automatic()) {
-    d->art_automatic_ = QStringFromStdString(pb.art_automatic());
+    d->art_automatic_ = Intern(QStringFromStdString(pb.art_automatic()));
   }
 
   if (pb.has_rating()) {
@@ -540,7 +649,7 @@ void Song::InitFromProtobuf(const pb::tagreader::SongMetadata& pb) {
 }
 
 void Song::ToProtobuf(pb::tagreader::SongMetadata* pb) const {
-  const QByteArray url(d->url_.toEncoded());
+  const QByteArray url(d->url_.url().toEncoded());
 
   pb->set_valid(d->valid_);
   pb->set_title(DataCommaSizeFromQString(d->title_));
@@ -568,7 +677,7 @@ void Song::ToProtobuf(pb::tagreader::SongMetadata* pb) const {
   pb->set_bitrate(d->bitrate_);
   pb->set_samplerate(d->samplerate_);
   pb->set_url(url.constData(), url.size());
-  pb->set_basefilename(DataCommaSizeFromQString(d->basefilename_));
+  pb->set_basefilename(DataCommaSizeFromQString(d->url_.basefilename()));
   pb->set_mtime(d->mtime_);
   pb->set_ctime(d->ctime_);
   pb->set_filesize(d->filesize_);
@@ -578,71 +687,80 @@ void Song::ToProtobuf(pb::tagreader::SongMetadata* pb) const {
 }
 
 void Song::InitFromQuery(const SqlRow& q, bool reliable_metadata, int col) {
+  InitFromColumns(SqlRowColumns(q), reliable_metadata, col);
+}
+
+void Song::InitFromQuery(const SqliteQuery& q, bool reliable_metadata,
+                         int col) {
+  InitFromColumns(q, reliable_metadata, col);
+}
+
+template <typename Columns>
+void Song::InitFromColumns(const Columns& q, bool reliable_metadata, int col) {
   d->valid_ = true;
   d->init_from_file_ = reliable_metadata;
 
-#define tostr(n) (q.value(n).isNull() ? QString::null : q.value(n).toString())
-#define toint(n) (q.value(n).isNull() ? -1 : q.value(n).toInt())
-#define tolonglong(n) (q.value(n).isNull() ? -1 : q.value(n).toLongLong())
-#define tofloat(n) (q.value(n).isNull() ? -1 : q.value(n).toDouble())
+#define tostr(n) (q.IsNull(n) ? QString::null : q.Text(n))
+#define toint(n) (q.IsNull(n) ? -1 : q.Int(n))
+#define tolonglong(n) (q.IsNull(n) ? -1 : q.Int64(n))
+#define tofloat(n) (q.IsNull(n) ? -1 : q.Double(n))
 
   d->id_ = toint(col + 0);
   d->title_ = tostr(col + 1);
-  d->album_ = tostr(col + 2);
-  d->artist_ = tostr(col + 3);
-  d->albumartist_ = tostr(col + 4);
-  d->composer_ = tostr(col + 5);
+  d->album_ = Intern(tostr(col + 2));
+  d->artist_ = Intern(tostr(col + 3));
+  d->albumartist_ = Intern(tostr(col + 4));
+  d->composer_ = Intern(tostr(col + 5));
   d->track_ = toint(col + 6);
   d->disc_ = toint(col + 7);
   d->bpm_ = tofloat(col + 8);
   d->year_ = toint(col + 9);
   d->originalyear_ = toint(col + 41);
-  d->genre_ = tostr(col + 10);
+  d->genre_ = Intern(tostr(col + 10));
   d->comment_ = tostr(col + 11);
-  d->compilation_ = q.value(col + 12).toBool();
+  d->compilation_ = q.Int(col + 12);
 
   d->bitrate_ = toint(col + 13);
   d->samplerate_ = toint(col + 14);
 
   d->directory_id_ = toint(col + 15);
-  set_url(QUrl::fromEncoded(tostr(col + 16).toUtf8()));
-  d->basefilename_ = QFileInfo(d->url_.toLocalFile()).fileName();
+  // The url and basefilename are worked out when they're first used
+  d->url_.SetEncoded(q.Utf8(col + 16));
   d->mtime_ = toint(col + 17);
   d->ctime_ = toint(col + 18);
   d->filesize_ = toint(col + 19);
 
-  d->sampler_ = q.value(col + 20).toBool();
+  d->sampler_ = q.Int(col + 20);
 
-  d->art_automatic_ = q.value(col + 21).toString();
-  d->art_manual_ = q.value(col + 22).toString();
+  d->art_automatic_ = Intern(q.Text(col + 21));
+  d->art_manual_ = Intern(q.Text(col + 22));
 
-  d->filetype_ = FileType(q.value(col + 23).toInt());
-  d->playcount_ = q.value(col + 24).isNull() ? 0 : q.value(col + 24).toInt();
+  d->filetype_ = FileType(q.Int(col + 23));
+  d->playcount_ = q.IsNull(col + 24) ? 0 : q.Int(col + 24);
   d->lastplayed_ = toint(col + 25);
   d->rating_ = tofloat(col + 26);
 
-  d->forced_compilation_on_ = q.value(col + 27).toBool();
-  d->forced_compilation_off_ = q.value(col + 28).toBool();
+  d->forced_compilation_on_ = q.Int(col + 27);
+  d->forced_compilation_off_ = q.Int(col + 28);
 
   // effective_compilation = 29
 
-  d->skipcount_ = q.value(col + 30).isNull() ? 0 : q.value(col + 30).toInt();
-  d->score_ = q.value(col + 31).isNull() ? 0 : q.value(col + 31).toInt();
+  d->skipcount_ = q.IsNull(col + 30) ? 0 : q.Int(col + 30);
+  d->score_ = q.IsNull(col + 31) ? 0 : q.Int(col + 31);
 
   // do not move those statements - beginning must be initialized before
   // length is!
-  d->beginning_ =
-      q.value(col + 32).isNull() ? 0 : q.value(col + 32).toLongLong();
+  d->beginning_ = q.IsNull(col + 32) ? 0 : q.Int64(col + 32);
   set_length_nanosec(tolonglong(col + 33));
 
-  d->cue_path_ = tostr(col + 34);
-  d->unavailable_ = q.value(col + 35).toBool();
+  d->cue_path_ = Intern(tostr(col + 34));
+  d->unavailable_ = q.Int(col + 35);
 
   // effective_albumartist = 36
   // etag = 37
 
-  d->performer_ = tostr(col + 38);
-  d->grouping_ = tostr(col + 39);
+  d->performer_ = Intern(tostr(col + 38));
+  d->grouping_ = Intern(tostr(col + 39));
   d->lyrics_ = tostr(col + 40);
 
   InitArtManual();
@@ -660,7 +778,7 @@ void Song::InitFromFilePartial(const QString& filename) {
   // we rely on TagLib which seems to have the behavior (filename checks).
   // Someday, it would be nice to perform some magic tests everywhere.
   QFileInfo info(filename);
-  d->basefilename_ = info.fileName();
+  d->url_.set_basefilename(info.fileName());
   QString suffix = info.suffix().toLower();
   if (suffix == "mp3" || suffix == "ogg" || suffix == "flac" ||
       suffix == "mpc" || suffix == "m4a" || suffix == "aac" ||
@@ -703,16 +821,16 @@ void Song::InitFromItdb(const Itdb_Track* track, const QString& prefix) {
   d->valid_ = true;
 
   d->title_ = QString::fromUtf8(track->title);
-  d->album_ = QString::fromUtf8(track->album);
-  d->artist_ = QString::fromUtf8(track->artist);
-  d->albumartist_ = QString::fromUtf8(track->albumartist);
-  d->composer_ = QString::fromUtf8(track->composer);
-  d->grouping_ = QString::fromUtf8(track->grouping);
+  d->album_ = Intern(QString::fromUtf8(track->album));
+  d->artist_ = Intern(QString::fromUtf8(track->artist));
+  d->albumartist_ = Intern(QString::fromUtf8(track->albumartist));
+  d->composer_ = Intern(QString::fromUtf8(track->composer));
+  d->grouping_ = Intern(QString::fromUtf8(track->grouping));
   d->track_ = track->track_nr;
   d->disc_ = track->cd_nr;
   d->bpm_ = track->BPM;
   d->year_ = track->year;
-  d->genre_ = QString::fromUtf8(track->genre);
+  d->genre_ = Intern(QString::fromUtf8(track->genre));
   d->comment_ = QString::fromUtf8(track->comment);
   d->compilation_ = track->compilation;
   set_length_nanosec(track->tracklen * kNsecPerMsec);
@@ -736,7 +854,7 @@ void Song::InitFromItdb(const Itdb_Track* track, const QString& prefix) {
     set_url(QUrl::fromLocalFile(prefix + filename));
   }
 
-  d->basefilename_ = QFileInfo(filename).fileName();
+  d->url_.set_basefilename(QFileInfo(filename).fileName());
 }
 
 void Song::ToItdb(Itdb_Track* track) const {
@@ -774,12 +892,12 @@ void Song::InitFromMTP(const LIBMTP_track_t* track, const QString& host) {
   d->valid_ = true;
 
   d->title_ = QString::fromUtf8(track->title);
-  d->artist_ = QString::fromUtf8(track->artist);
-  d->album_ = QString::fromUtf8(track->album);
-  d->composer_ = QString::fromUtf8(track->composer);
-  d->genre_ = QString::fromUtf8(track->genre);
-  d->url_ = QUrl(QString("mtp://%1/%2").arg(host, track->item_id));
-  d->basefilename_ = QString::number(track->item_id);
+  d->artist_ = Intern(QString::fromUtf8(track->artist));
+  d->album_ = Intern(QString::fromUtf8(track->album));
+  d->composer_ = Intern(QString::fromUtf8(track->composer));
+  d->genre_ = Intern(QString::fromUtf8(track->genre));
+  d->url_.set_url(QUrl(QString("mtp://%1/%2").arg(host).arg(track->item_id)));
+  d->url_.set_basefilename(QString::number(track->item_id));
 
   d->track_ = track->tracknumber;
   set_length_nanosec(track->duration * kNsecPerMsec);
@@ -839,7 +957,7 @@ void Song::ToMTP(LIBMTP_track_t* track) const {
   track->title = strdup(d->title_.toUtf8().constData());
   track->date = nullptr;
 
-  track->filename = strdup(d->basefilename_.toUtf8().constData());
+  track->filename = strdup(d->url_.basefilename().toUtf8().constData());
 
   track->tracknumber = d->track_;
   track->duration = length_nanosec() / kNsecPerMsec;
@@ -882,7 +1000,7 @@ void Song::ToMTP(LIBMTP_track_t* track) const {
 #endif
 
 void Song::MergeFromSimpleMetaBundle(const Engine::SimpleMetaBundle& bundle) {
-  if (d->init_from_file_ || d->url_.scheme() == "file") {
+  if (d->init_from_file_ || d->url_.url().scheme() == "file") {
     // This Song was already loaded using taglib. Our tags are probably better
     // than the engine's.  Note: init_from_file_ is used for non-file:// URLs
     // when the metadata is known to be good, like from Jamendo.
@@ -902,91 +1020,106 @@ void Song::MergeFromSimpleMetaBundle(const Engine::SimpleMetaBundle& bundle) {
   if (!bundle.tracknr.isEmpty()) d->track_ = bundle.tracknr.toInt();
 }
 
-void Song::BindToQuery(QSqlQuery* query) const {
+QVariantList Song::ColumnValues() const {
+  QVariantList ret;
+
 #define strval(x) (x.isNull() ? "" : x)
 #define intval(x) (x <= 0 ? -1 : x)
 #define notnullintval(x) (x == -1 ? QVariant() : x)
 
-  // Remember to bind these in the same order as kBindSpec
+  // Remember to add these in the same order as kColumns
 
-  query->bindValue(":title", strval(d->title_));
-  query->bindValue(":album", strval(d->album_));
-  query->bindValue(":artist", strval(d->artist_));
-  query->bindValue(":albumartist", strval(d->albumartist_));
-  query->bindValue(":composer", strval(d->composer_));
-  query->bindValue(":track", intval(d->track_));
-  query->bindValue(":disc", intval(d->disc_));
-  query->bindValue(":bpm", intval(d->bpm_));
-  query->bindValue(":year", intval(d->year_));
-  query->bindValue(":genre", strval(d->genre_));
-  query->bindValue(":comment", strval(d->comment_));
-  query->bindValue(":compilation", d->compilation_ ? 1 : 0);
+  ret << strval(d->title_);
+  ret << strval(d->album_);
+  ret << strval(d->artist_);
+  ret << strval(d->albumartist_);
+  ret << strval(d->composer_);
+  ret << intval(d->track_);
+  ret << intval(d->disc_);
+  ret << intval(d->bpm_);
+  ret << intval(d->year_);
+  ret << strval(d->genre_);
+  ret << strval(d->comment_);
+  ret << (d->compilation_ ? 1 : 0);
 
-  query->bindValue(":bitrate", intval(d->bitrate_));
-  query->bindValue(":samplerate", intval(d->samplerate_));
+  ret << intval(d->bitrate_);
+  ret << intval(d->samplerate_);
 
-  query->bindValue(":directory", notnullintval(d->directory_id_));
+  ret << notnullintval(d->directory_id_);
 
   if (Application::kIsPortable &&
-      Utilities::UrlOnSameDriveAsClementine(d->url_)) {
-    query->bindValue(":filename", Utilities::GetRelativePathToClementineBin(
-                                      d->url_).toEncoded());
+      Utilities::UrlOnSameDriveAsClementine(d->url_.url())) {
+    ret << Utilities::GetRelativePathToClementineBin(d->url_.url()).toEncoded();
   } else {
-    query->bindValue(":filename", d->url_.toEncoded());
+    ret << d->url_.url().toEncoded();
   }
 
-  query->bindValue(":mtime", notnullintval(d->mtime_));
-  query->bindValue(":ctime", notnullintval(d->ctime_));
-  query->bindValue(":filesize", notnullintval(d->filesize_));
+  ret << notnullintval(d->mtime_);
+  ret << notnullintval(d->ctime_);
+  ret << notnullintval(d->filesize_);
 
-  query->bindValue(":sampler", d->sampler_ ? 1 : 0);
-  query->bindValue(":art_automatic", d->art_automatic_);
-  query->bindValue(":art_manual", d->art_manual_);
+  ret << (d->sampler_ ? 1 : 0);
+  ret << d->art_automatic_;
+  ret << d->art_manual_;
 
-  query->bindValue(":filetype", d->filetype_);
-  query->bindValue(":playcount", d->playcount_);
-  query->bindValue(":lastplayed", intval(d->lastplayed_));
-  query->bindValue(":rating", intval(d->rating_));
+  ret << d->filetype_;
+  ret << d->playcount_;
+  ret << intval(d->lastplayed_);
+  ret << intval(d->rating_);
 
-  query->bindValue(":forced_compilation_on", d->forced_compilation_on_ ? 1 : 0);
-  query->bindValue(":forced_compilation_off",
-                   d->forced_compilation_off_ ? 1 : 0);
+  ret << (d->forced_compilation_on_ ? 1 : 0);
+  ret << (d->forced_compilation_off_ ? 1 : 0);
 
-  query->bindValue(":effective_compilation", is_compilation() ? 1 : 0);
+  ret << (is_compilation() ? 1 : 0);
 
-  query->bindValue(":skipcount", d->skipcount_);
-  query->bindValue(":score", d->score_);
+  ret << d->skipcount_;
+  ret << d->score_;
 
-  query->bindValue(":beginning", d->beginning_);
-  query->bindValue(":length", intval(length_nanosec()));
+  ret << d->beginning_;
+  ret << intval(length_nanosec());
 
-  query->bindValue(":cue_path", d->cue_path_);
-  query->bindValue(":unavailable", d->unavailable_ ? 1 : 0);
-  query->bindValue(":effective_albumartist", this->effective_albumartist());
+  ret << d->cue_path_;
+  ret << (d->unavailable_ ? 1 : 0);
+  ret << this->effective_albumartist();
 
-  query->bindValue(":etag", strval(d->etag_));
+  ret << strval(d->etag_);
 
-  query->bindValue(":performer", strval(d->performer_));
-  query->bindValue(":grouping", strval(d->grouping_));
-  query->bindValue(":lyrics", strval(d->lyrics_));
-  query->bindValue(":originalyear", intval(d->originalyear_));
-  query->bindValue(":effective_originalyear", intval(this->effective_originalyear()));
+  ret << strval(d->performer_);
+  ret << strval(d->grouping_);
+  ret << strval(d->lyrics_);
+  ret << intval(d->originalyear_);
+  ret << intval(this->effective_originalyear());
 
 #undef intval
 #undef notnullintval
 #undef strval
+
+  return ret;
+}
+
+QVariantList Song::FtsColumnValues() const {
+  // Remember to add these in the same order as kFtsColumns
+  return QVariantList() << d->title_ << d->album_ << d->artist_
+                        << d->albumartist_ << d->composer_ << d->performer_
+                        << d->grouping_ << d->genre_ << d->comment_;
+}
+
+void Song::BindToQuery(QSqlQuery* query) const {
+  static const QStringList kBindNames = Utilities::Prepend(":", kColumns);
+
+  const QVariantList values = ColumnValues();
+  for (int i = 0; i < values.count(); ++i) {
+    query->bindValue(kBindNames[i], values[i]);
+  }
 }
 
 void Song::BindToFtsQuery(QSqlQuery* query) const {
-  query->bindValue(":ftstitle", d->title_);
-  query->bindValue(":ftsalbum", d->album_);
-  query->bindValue(":ftsartist", d->artist_);
-  query->bindValue(":ftsalbumartist", d->albumartist_);
-  query->bindValue(":ftscomposer", d->composer_);
-  query->bindValue(":ftsperformer", d->performer_);
-  query->bindValue(":ftsgrouping", d->grouping_);
-  query->bindValue(":ftsgenre", d->genre_);
-  query->bindValue(":ftscomment", d->comment_);
+  static const QStringList kBindNames = Utilities::Prepend(":", kFtsColumns);
+
+  const QVariantList values = FtsColumnValues();
+  for (int i = 0; i < values.count(); ++i) {
+    query->bindValue(kBindNames[i], values[i]);
+  }
 }
 
 #ifdef HAVE_LIBLASTFM
@@ -1025,8 +1158,8 @@ QString Song::PrettyRating() const {
 QString Song::PrettyTitle() const {
   QString title(d->title_);
 
-  if (title.isEmpty()) title = d->basefilename_;
-  if (title.isEmpty()) title = d->url_.toString();
+  if (title.isEmpty()) title = d->url_.basefilename();
+  if (title.isEmpty()) title = d->url_.url().toString();
 
   return title;
 }
@@ -1034,7 +1167,7 @@ QString Song::PrettyTitle() const {
 QString Song::PrettyTitleWithArtist() const {
   QString title(d->title_);
 
-  if (title.isEmpty()) title = d->basefilename_;
+  if (title.isEmpty()) title = d->url_.basefilename();
 
   if (!d->artist_.isEmpty()) title = d->artist_ + " - " + title;
 
@@ -1056,7 +1189,7 @@ QString Song::PrettyYear() const {
 QString Song::TitleWithCompilationArtist() const {
   QString title(d->title_);
 
-  if (title.isEmpty()) title = d->basefilename_;
+  if (title.isEmpty()) title = d->url_.basefilename();
 
   if (is_compilation() && !d->artist_.isEmpty() &&
       !d->artist_.toLower().contains("various"))
@@ -1089,7 +1222,7 @@ bool Song::IsMetadataEqual(const Song& other) const {
 }
 
 bool Song::IsEditable() const {
-  return d->valid_ && !d->url_.isEmpty() && !is_stream() &&
+  return d->valid_ && !d->url_.url().isEmpty() && !is_stream() &&
          d->filetype_ != Type_Unknown && !has_cue();
 }
 
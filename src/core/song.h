@@ -61,6 +61,7 @@ class Track;
 }
 #endif
 
+class SqliteQuery;
 class SqlRow;
 
 class Song {
@@ -118,6 +119,9 @@ class Song {
             qint64 beginning, qint64 end);
   void InitFromProtobuf(const pb::tagreader::SongMetadata& pb);
   void InitFromQuery(const SqlRow& query, bool reliable_metadata, int col = 0);
+  // Faster than the SqlRow version for loading lots of songs.
+  void InitFromQuery(const SqliteQuery& query, bool reliable_metadata,
+                     int col = 0);
   void InitFromFilePartial(
       const QString& filename);  // Just store the filename: incomplete but fast
   void InitArtManual();  // Check if there is already a art in the cache and
@@ -148,6 +152,10 @@ class Song {
   // Save
   void BindToQuery(QSqlQuery* query) const;
   void BindToFtsQuery(QSqlQuery* query) const;
+  // The values that BindToQuery and BindToFtsQuery bind, in the same order as
+  // kColumns and kFtsColumns.
+  QVariantList ColumnValues() const;
+  QVariantList FtsColumnValues() const;
 #ifdef HAVE_LIBLASTFM
   void ToLastFM(lastfm::Track* track, bool prefer_album_artist) const;
 #endif
@@ -307,6 +315,9 @@ class Song {
   Song& operator=(const Song& other);
 
  private:
+  template <typename Columns>
+  void InitFromColumns(const Columns& q, bool reliable_metadata, int col);
+
   struct Private;
   QSharedDataPointer<Private> d;
 };
@@ -0,0 +1,186 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "sqlitequery.h"
+
+#include <sqlite3.h>
+
+#include <QSqlDriver>
+
+#include "core/logging.h"
+
+SqliteQuery::SqliteQuery(const QString& sql, const QSqlDatabase& db)
+    : db_(Handle(db)),
+      stmt_(nullptr),
+      error_(SQLITE_OK),
+      next_bind_index_(1) {
+  if (!db_) {
+    error_ = SQLITE_MISUSE;
+    return;
+  }
+
+  const QByteArray utf8(sql.toUtf8());
+  error_ = sqlite3_prepare_v2(db_, utf8.constData(), utf8.size(), &stmt_,
+                              nullptr);
+}
+
+SqliteQuery::~SqliteQuery() {
+  // Harmless to call with a nullptr.
+  sqlite3_finalize(stmt_);
+}
+
+sqlite3* SqliteQuery::Handle(const QSqlDatabase& db) {
+  const QVariant handle = db.driver()->handle();
+  if (!handle.isValid() || qstrcmp(handle.typeName(), "sqlite3*") != 0) {
+    return nullptr;
+  }
+  return *static_cast<sqlite3* const*>(handle.constData());
+}
+
+void SqliteQuery::BindValue(const QString& placeholder, const QVariant& value) {
+  if (!stmt_) return;
+
+  const int index =
+      sqlite3_bind_parameter_index(stmt_, placeholder.toUtf8().constData());
+  if (index == 0) return;
+
+  Bind(index, value);
+}
+
+void SqliteQuery::AddBindValue(const QVariant& value) {
+  if (!stmt_) return;
+
+  Bind(next_bind_index_++, value);
+}
+
+void SqliteQuery::Bind(int index, const QVariant& value) {
+  if (value.isNull()) {
+    sqlite3_bind_null(stmt_, index);
+    return;
+  }
+
+  switch (value.type()) {
+    case QVariant::Bool:
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+      sqlite3_bind_int64(stmt_, index, value.toLongLong());
+      break;
+
+    case QVariant::Double:
+      sqlite3_bind_double(stmt_, index, value.toDouble());
+      break;
+
+    case QVariant::ByteArray: {
+      const QByteArray data(value.toByteArray());
+      sqlite3_bind_blob(stmt_, index, data.constData(), data.size(),
+                        SQLITE_TRANSIENT);
+      break;
+    }
+
+    default: {
+      const QByteArray utf8(value.toString().toUtf8());
+      sqlite3_bind_text(stmt_, index, utf8.constData(), utf8.size(),
+                        SQLITE_TRANSIENT);
+      break;
+    }
+  }
+}
+
+bool SqliteQuery::Exec() {
+  if (error_ != SQLITE_OK || !stmt_) {
+    qLog(Error) << "Couldn't prepare query:" << ErrorString();
+    return false;
+  }
+  return true;
+}
+
+bool SqliteQuery::Next() {
+  if (!stmt_) return false;
+
+  const int ret = sqlite3_step(stmt_);
+  if (ret == SQLITE_ROW) return true;
+
+  if (ret != SQLITE_DONE) {
+    error_ = ret;
+    qLog(Error) << "Query failed:" << ErrorString();
+  }
+  return false;
+}
+
+bool SqliteQuery::Run() {
+  if (!stmt_) return false;
+
+  const int ret = sqlite3_step(stmt_);
+  if (ret == SQLITE_DONE || ret == SQLITE_ROW) return true;
+
+  error_ = ret;
+  qLog(Error) << "Query failed:" << ErrorString();
+  return false;
+}
+
+void SqliteQuery::Reset() {
+  if (!stmt_) return;
+
+  sqlite3_reset(stmt_);
+  sqlite3_clear_bindings(stmt_);
+  next_bind_index_ = 1;
+}
+
+qint64 SqliteQuery::LastInsertId() const {
+  if (!db_) return -1;
+  return sqlite3_last_insert_rowid(db_);
+}
+
+QString SqliteQuery::ErrorString() const {
+  if (!db_) return "Not an SQLite database";
+  return QString::fromUtf8(sqlite3_errmsg(db_));
+}
+
+bool SqliteQuery::IsNull(int column) const {
+  return sqlite3_column_type(stmt_, column) == SQLITE_NULL;
+}
+
+int SqliteQuery::Int(int column) const {
+  return sqlite3_column_int(stmt_, column);
+}
+
+qint64 SqliteQuery::Int64(int column) const {
+  return sqlite3_column_int64(stmt_, column);
+}
+
+double SqliteQuery::Double(int column) const {
+  return sqlite3_column_double(stmt_, column);
+}
+
+QString SqliteQuery::Text(int column) const {
+  const char* text =
+      reinterpret_cast<const char*>(sqlite3_column_text(stmt_, column));
+  if (!text) return QString();
+
+  // sqlite3_column_bytes must be called after sqlite3_column_text.
+  return QString::fromUtf8(text, sqlite3_column_bytes(stmt_, column));
+}
+
+QByteArray SqliteQuery::Utf8(int column) const {
+  const char* text =
+      reinterpret_cast<const char*>(sqlite3_column_text(stmt_, column));
+  if (!text) return QByteArray();
+
+  return QByteArray(text, sqlite3_column_bytes(stmt_, column));
+}
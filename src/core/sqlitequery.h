@@ -0,0 +1,82 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CORE_SQLITEQUERY_H_
+#define CORE_SQLITEQUERY_H_
+
+#include <QByteArray>
+#include <QSqlDatabase>
+#include <QString>
+#include <QVariant>
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+// Runs a statement straight on the SQLite connection behind a QSqlDatabase.
+// Columns are read from SQLite as they're asked for, instead of the whole row
+// being converted to QVariants first like QSqlQuery does.  Text is decoded
+// from UTF-8 once, with no QVariant in between.
+//
+// Use this for queries that return lots of songs, with Song::InitFromQuery.
+// The usual Database locks still apply.
+class SqliteQuery {
+ public:
+  SqliteQuery(const QString& sql, const QSqlDatabase& db);
+  ~SqliteQuery();
+
+  // Binds a named parameter like ":id".  Must be called before Exec.
+  void BindValue(const QString& placeholder, const QVariant& value);
+  // Binds the next positional "?" parameter, like QSqlQuery::addBindValue.
+  void AddBindValue(const QVariant& value);
+
+  // Returns false and logs the error if the statement couldn't be prepared.
+  bool Exec();
+  // Moves to the next row.  Returns false when there are no more.
+  bool Next();
+
+  // Runs a statement that doesn't return rows, like an INSERT.  Returns false
+  // and logs the error if it failed.
+  bool Run();
+  // Lets the statement be run again with new values.  Clears the bindings.
+  void Reset();
+  // The ROWID of the last row inserted on this connection.
+  qint64 LastInsertId() const;
+
+  QString ErrorString() const;
+
+  // Values in the current row.  NULL is returned as 0 or an empty string.
+  bool IsNull(int column) const;
+  int Int(int column) const;
+  qint64 Int64(int column) const;
+  double Double(int column) const;
+  QString Text(int column) const;
+  // The column's text exactly as stored, without decoding it.
+  QByteArray Utf8(int column) const;
+
+ private:
+  Q_DISABLE_COPY(SqliteQuery)
+
+  static sqlite3* Handle(const QSqlDatabase& db);
+  void Bind(int index, const QVariant& value);
+
+  sqlite3* db_;
+  sqlite3_stmt* stmt_;
+  int error_;
+  int next_bind_index_;
+};
+
+#endif  // CORE_SQLITEQUERY_H_
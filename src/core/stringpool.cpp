@@ -0,0 +1,124 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "stringpool.h"
+
+#include "core/logging.h"
+
+const int StringPool::kDefaultGenerationSize = 128 * 1024;
+const int StringPool::kShardCount = 16;
+
+StringPool::StringPool(int generation_size)
+    : shard_generation_size_(qMax(1, generation_size / kShardCount)) {
+  for (int i = 0; i < kShardCount; ++i) {
+    shards_ << new Shard;
+  }
+}
+
+StringPool::~StringPool() { qDeleteAll(shards_); }
+
+StringPool* StringPool::Instance() {
+  // Never deleted, because songs can outlive everything else.
+  static StringPool* instance = new StringPool;
+  return instance;
+}
+
+qint64 StringPool::Bytes(const QString& s) {
+  // Roughly what QString allocates: a header and the characters.
+  return 4 * sizeof(int) + qint64(s.capacity() + 1) * sizeof(QChar);
+}
+
+int StringPool::References(const QString& s, int pool_copies) {
+  QString copy(s);
+  const int ref = copy.data_ptr()->ref;
+
+  // Static data isn't reference counted.
+  if (ref < 0) return 0;
+  return qMax(0, ref - pool_copies - 1);
+}
+
+void StringPool::AddStats(const QString& s, int pool_copies, Stats* stats) {
+  const qint64 bytes = Bytes(s);
+  const int references = References(s, pool_copies);
+
+  stats->strings_++;
+  stats->bytes_ += bytes;
+  stats->references_ += references;
+  if (references > 1) {
+    stats->bytes_saved_ += (references - 1) * bytes;
+  }
+}
+
+QString StringPool::Intern(const QString& s) {
+  if (s.isEmpty()) return s;
+
+  Shard* shard = shards_[qHash(s) % kShardCount];
+  QMutexLocker l(&shard->mutex_);
+  shard->lookups_++;
+
+  QString ret;
+  QSet<QString>::const_iterator it = shard->current_.constFind(s);
+  if (it != shard->current_.constEnd()) {
+    ret = *it;
+  } else {
+    it = shard->previous_.constFind(s);
+    if (it != shard->previous_.constEnd()) {
+      // Still in use - keep it for another generation.
+      ret = *it;
+    } else {
+      ret = s;
+    }
+
+    shard->current_.insert(ret);
+    if (shard->current_.count() >= shard_generation_size_) {
+      // Forget the strings that haven't been seen for a whole generation.
+      shard->previous_ = shard->current_;
+      shard->current_.clear();
+    }
+  }
+
+  return ret;
+}
+
+StringPool::Stats StringPool::stats() const {
+  Stats ret;
+
+  for (const Shard* shard : shards_) {
+    QMutexLocker l(&shard->mutex_);
+
+    // A string that's in both generations is held by the pool twice.
+    for (const QString& s : shard->current_) {
+      AddStats(s, shard->previous_.contains(s) ? 2 : 1, &ret);
+    }
+    for (const QString& s : shard->previous_) {
+      if (shard->current_.contains(s)) continue;
+      AddStats(s, 1, &ret);
+    }
+
+    ret.lookups_ += shard->lookups_;
+  }
+
+  return ret;
+}
+
+void StringPool::LogStats() const {
+  const Stats s = stats();
+  qLog(Debug) << "String pool:" << s.strings_ << "strings," << s.bytes_
+              << "bytes, shared by" << s.references_
+              << "strings in use, saving" << s.bytes_saved_ << "bytes now ("
+              << s.lookups_ << "lookups since startup)";
+}
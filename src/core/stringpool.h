@@ -0,0 +1,99 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CORE_STRINGPOOL_H_
+#define CORE_STRINGPOOL_H_
+
+#include <QMutex>
+#include <QSet>
+#include <QString>
+
+// Keeps one copy of each distinct string it's given, so that values that are
+// repeated across lots of songs (artists, albums, genres...) share the same
+// storage.  Safe to use from any thread.
+//
+// So that strings that are no longer used don't stay in the pool forever, the
+// pool only remembers the strings it has seen in the last two generations.
+// When the current generation is full the older one is forgotten, and a
+// string from it that's interned again later gets a new shared copy.
+class StringPool {
+ public:
+  // generation_size is roughly how many distinct strings make a generation.
+  explicit StringPool(int generation_size = kDefaultGenerationSize);
+  ~StringPool();
+
+  static const int kDefaultGenerationSize;
+
+  // The pool used by Song.
+  static StringPool* Instance();
+
+  // strings_, bytes_, references_ and bytes_saved_ describe the strings in
+  // the pool right now, so they go down again when songs are unloaded.
+  struct Stats {
+    Stats()
+        : strings_(0),
+          bytes_(0),
+          lookups_(0),
+          references_(0),
+          bytes_saved_(0) {}
+
+    int strings_;
+    // Memory used by the strings in the pool.
+    qint64 bytes_;
+    // How many strings have been interned since the pool was created.
+    qint64 lookups_;
+    // How many strings outside the pool share data with a string in it.
+    qint64 references_;
+    // Memory that strings outside the pool would use if each of them had its
+    // own copy.
+    qint64 bytes_saved_;
+  };
+
+  // Returns a string equal to s that shares its data with every other string
+  // equal to s that came out of the pool recently.
+  QString Intern(const QString& s);
+
+  Stats stats() const;
+  void LogStats() const;
+
+ private:
+  Q_DISABLE_COPY(StringPool)
+
+  // Strings are spread over a few independently locked sets so that threads
+  // loading songs at the same time don't wait for each other.
+  static const int kShardCount;
+
+  struct Shard {
+    Shard() : lookups_(0) {}
+
+    mutable QMutex mutex_;
+    QSet<QString> current_;
+    QSet<QString> previous_;
+
+    qint64 lookups_;
+  };
+
+  static qint64 Bytes(const QString& s);
+  // How many strings share s's data, not counting the pool's own copies.
+  static int References(const QString& s, int pool_copies);
+  static void AddStats(const QString& s, int pool_copies, Stats* stats);
+
+  const int shard_generation_size_;
+  QList<Shard*> shards_;
+};
+
+#endif  // CORE_STRINGPOOL_H_
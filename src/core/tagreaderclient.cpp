@@ -28,6 +28,7 @@
 #include <QUrl>
 
 const char* TagReaderClient::kWorkerExecutableName = "clementine-tagreader";
+const int TagReaderClient::kMaxFilesPerRequest = 64;
 TagReaderClient* TagReaderClient::sInstance = nullptr;
 
 TagReaderClient::TagReaderClient(QObject* parent)
@@ -57,6 +58,17 @@ TagReaderReply* TagReaderClient::ReadFile(const QString& filename) {
   return worker_pool_->SendMessageWithReply(&message);
 }
 
+TagReaderReply* TagReaderClient::ReadFiles(const QStringList& filenames) {
+  pb::tagreader::Message message;
+  pb::tagreader::ReadFilesRequest* req = message.mutable_read_files_request();
+
+  for (const QString& filename : filenames) {
+    req->add_filenames(DataCommaSizeFromQString(filename));
+  }
+
+  return worker_pool_->SendMessageWithReply(&message);
+}
+
 TagReaderReply* TagReaderClient::SaveFile(const QString& filename,
                                           const Song& metadata) {
   pb::tagreader::Message message;
@@ -151,6 +163,54 @@ void TagReaderClient::ReadFileBlocking(const QString& filename, Song* song) {
   reply->deleteLater();
 }
 
+QList<TagReaderReply*> TagReaderClient::ReadFilesSplit(
+    const QStringList& filenames) {
+  QList<TagReaderReply*> ret;
+  if (filenames.isEmpty()) return ret;
+
+  // Split the files evenly between the workers, but don't let any one request
+  // get too big.
+  const int chunk_size =
+      qBound(1, (filenames.count() + QThread::idealThreadCount() - 1) /
+                    QThread::idealThreadCount(),
+             kMaxFilesPerRequest);
+
+  for (int i = 0; i < filenames.count(); i += chunk_size) {
+    ret << ReadFiles(filenames.mid(i, chunk_size));
+  }
+  return ret;
+}
+
+SongList TagReaderClient::ReadFilesBlocking(const QStringList& filenames) {
+  Q_ASSERT(QThread::currentThread() != thread());
+
+  // Send all the requests before waiting for any of them.
+  return ReadFilesResult(ReadFilesSplit(filenames));
+}
+
+SongList TagReaderClient::ReadFilesResult(const QList<ReplyType*>& replies) {
+  SongList ret;
+
+  for (TagReaderReply* reply : replies) {
+    const int count =
+        reply->request_message().read_files_request().filenames_size();
+    const bool ok = reply->WaitForFinished();
+    const pb::tagreader::ReadFilesResponse& response =
+        reply->message().read_files_response();
+
+    for (int i = 0; i < count; ++i) {
+      Song song;
+      if (ok && i < response.metadata_size()) {
+        song.InitFromProtobuf(response.metadata(i));
+      }
+      ret << song;
+    }
+    reply->deleteLater();
+  }
+
+  return ret;
+}
+
 bool TagReaderClient::SaveFileBlocking(const QString& filename,
                                        const Song& metadata) {
   Q_ASSERT(QThread::currentThread() != thread());
@@ -42,9 +42,17 @@ class TagReaderClient : public QObject {
 
   static const char* kWorkerExecutableName;
 
+  // The largest number of files sent to a single worker in one ReadFiles
+  // request.
+  static const int kMaxFilesPerRequest;
+
   void Start();
 
   ReplyType* ReadFile(const QString& filename);
+  ReplyType* ReadFiles(const QStringList& filenames);
+  // Splits the files into several ReadFiles requests so that every worker
+  // gets some of them.  Pass the replies to ReadFilesResult.
+  QList<ReplyType*> ReadFilesSplit(const QStringList& filenames);
   ReplyType* SaveFile(const QString& filename, const Song& metadata);
   ReplyType* UpdateSongStatistics(const Song& metadata);
   ReplyType* UpdateSongRating(const Song& metadata);
@@ -58,6 +66,12 @@ class TagReaderClient : public QObject {
   // response.  These block the calling thread with a semaphore, and must NOT
   // be called from the TagReaderClient's thread.
   void ReadFileBlocking(const QString& filename, Song* song);
+  // Reads all the files, splitting them into several ReadFiles requests so
+  // that every worker gets some of them.  Returns one Song per filename, in
+  // the same order.  Songs that couldn't be read are invalid.
+  SongList ReadFilesBlocking(const QStringList& filenames);
+  // Waits for the replies returned by ReadFilesSplit and deletes them.
+  static SongList ReadFilesResult(const QList<ReplyType*>& replies);
   bool SaveFileBlocking(const QString& filename, const Song& metadata);
   bool UpdateSongStatisticsBlocking(const Song& metadata);
   bool UpdateSongRatingBlocking(const Song& metadata);
@@ -39,6 +39,17 @@ int TaskManager::StartTask(const QString& name) {
   return t.id;
 }
 
+void TaskManager::SetTaskName(int id, const QString& name) {
+  {
+    QMutexLocker l(&mutex_);
+    if (!tasks_.contains(id)) return;
+
+    tasks_[id].name = name;
+  }
+
+  emit TasksChanged();
+}
+
 QList<TaskManager::Task> TaskManager::GetTasks() {
   QList<TaskManager::Task> ret;
 
@@ -21,14 +21,19 @@
 
 #include "albumcoverloader.h"
 
+#include <functional>
+
 #include <QPainter>
 #include <QDir>
 #include <QCoreApplication>
+#include <QImageReader>
+#include <QThread>
 #include <QUrl>
 #include <QNetworkReply>
 
 #include "config.h"
 #include "core/closure.h"
+#include "core/concurrentrun.h"
 #include "core/logging.h"
 #include "core/network.h"
 #include "core/tagreaderclient.h"
@@ -41,7 +46,12 @@ AlbumCoverLoader::AlbumCoverLoader(QObject* parent)
       stop_requested_(false),
       next_id_(1),
       network_(new NetworkAccessManager(this)),
-      connected_spotify_(false) {}
+      decodes_in_flight_(0),
+      connected_spotify_(false) {
+  // Decoding is mostly CPU bound, but a few threads is enough to keep up with
+  // the views that show covers.
+  decode_pool_.setMaxThreadCount(qBound(1, QThread::idealThreadCount(), 4));
+}
 
 QString AlbumCoverLoader::ImageCacheDir() {
   return Utilities::GetConfigPath(Utilities::Path_AlbumCovers);
@@ -49,6 +59,7 @@ QString AlbumCoverLoader::ImageCacheDir() {
 
 void AlbumCoverLoader::CancelTask(quint64 id) {
   QMutexLocker l(&mutex_);
+  decoding_tasks_.remove(id);
   for (QQueue<Task>::iterator it = tasks_.begin(); it != tasks_.end(); ++it) {
     if (it->id == id) {
       tasks_.erase(it);
@@ -59,6 +70,9 @@ void AlbumCoverLoader::CancelTask(quint64 id) {
 
 void AlbumCoverLoader::CancelTasks(const QSet<quint64>& ids) {
   QMutexLocker l(&mutex_);
+  for (quint64 id : ids) {
+    decoding_tasks_.remove(id);
+  }
   for (QQueue<Task>::iterator it = tasks_.begin(); it != tasks_.end();) {
     if (ids.contains(it->id)) {
       it = tasks_.erase(it);
@@ -68,6 +82,45 @@ void AlbumCoverLoader::CancelTasks(const QSet<quint64>& ids) {
   }
 }
 
+void AlbumCoverLoader::SetTasksPriority(
+    const QSet<quint64>& ids, AlbumCoverLoaderOptions::Priority priority) {
+  QMutexLocker l(&mutex_);
+  QList<Task> moved;
+  for (QQueue<Task>::iterator it = tasks_.begin(); it != tasks_.end();) {
+    if (ids.contains(it->id) && it->options.priority_ != priority) {
+      moved << *it;
+      it = tasks_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  // Go backwards so the moved tasks stay in the same order.
+  for (int i = moved.count() - 1; i >= 0; --i) {
+    moved[i].options.priority_ = priority;
+    EnqueueTaskAtFront(moved[i]);
+  }
+}
+
+void AlbumCoverLoader::EnqueueTask(const Task& task) {
+  // Most tasks are added with the same priority as the ones before them, so
+  // search from the end.
+  int i = tasks_.count();
+  while (i > 0 && tasks_[i - 1].options.priority_ < task.options.priority_) {
+    --i;
+  }
+  tasks_.insert(i, task);
+}
+
+void AlbumCoverLoader::EnqueueTaskAtFront(const Task& task) {
+  int i = 0;
+  while (i < tasks_.count() &&
+         tasks_[i].options.priority_ > task.options.priority_) {
+    ++i;
+  }
+  tasks_.insert(i, task);
+}
+
 quint64 AlbumCoverLoader::LoadImageAsync(const AlbumCoverLoaderOptions& options,
                                          const QString& art_automatic,
                                          const QString& art_manual,
@@ -84,7 +137,7 @@ quint64 AlbumCoverLoader::LoadImageAsync(const AlbumCoverLoaderOptions& options,
   {
     QMutexLocker l(&mutex_);
     task.id = next_id_++;
-    tasks_.enqueue(task);
+    EnqueueTask(task);
   }
 
   metaObject()->invokeMethod(this, "ProcessTasks", Qt::QueuedConnection);
@@ -93,7 +146,10 @@ quint64 AlbumCoverLoader::LoadImageAsync(const AlbumCoverLoaderOptions& options,
 }
 
 void AlbumCoverLoader::ProcessTasks() {
-  while (!stop_requested_) {
+  // Leave the rest of the tasks in the queue until there's a thread free to
+  // decode them, so they can still be cancelled or reprioritised.
+  while (!stop_requested_ &&
+         decodes_in_flight_ < decode_pool_.maxThreadCount()) {
     // Get the next task
     Task task;
     {
@@ -157,14 +213,8 @@ AlbumCoverLoader::TryLoadResult AlbumCoverLoader::TryLoadImage(
   if (filename == Song::kManuallyUnsetCover)
     return TryLoadResult(false, true, task.options.default_output_image_);
 
-  if (filename == Song::kEmbeddedCover && !task.song_filename.isEmpty()) {
-    const QImage taglib_image =
-        TagReaderClient::Instance()->LoadEmbeddedArtBlocking(
-            task.song_filename);
-
-    if (!taglib_image.isNull())
-      return TryLoadResult(false, true,
-                           ScaleAndPad(task.options, taglib_image));
+  if (filename.isEmpty()) {
+    return TryLoadResult(false, false, task.options.default_output_image_);
   }
 
   if (filename.toLower().startsWith("http://") ||
@@ -178,7 +228,12 @@ AlbumCoverLoader::TryLoadResult AlbumCoverLoader::TryLoadImage(
     return TryLoadResult(true, false, QImage());
   } else if (filename.toLower().startsWith("spotify://image/")) {
     // HACK: we should add generic image URL handlers
-    SpotifyService* spotify = InternetModel::Service<SpotifyService>();
+    // Services can only be created in the main thread, so this only works
+    // once something else has created the Spotify service.
+    SpotifyService* spotify = InternetModel::ExistingService<SpotifyService>();
+    if (!spotify) {
+      return TryLoadResult(false, false, task.options.default_output_image_);
+    }
 
     if (!connected_spotify_) {
       connect(spotify, SIGNAL(ImageLoaded(QString, QImage)),
@@ -198,10 +253,93 @@ AlbumCoverLoader::TryLoadResult AlbumCoverLoader::TryLoadImage(
     return TryLoadResult(true, false, QImage());
   }
 
-  QImage image(filename);
-  return TryLoadResult(
-      false, !image.isNull(),
-      image.isNull() ? task.options.default_output_image_ : image);
+  if (filename == Song::kEmbeddedCover && task.song_filename.isEmpty()) {
+    return TryLoadResult(false, false, task.options.default_output_image_);
+  }
+
+  // It's a local file or embedded art.
+  StartDecoding(task, filename);
+  return TryLoadResult(true, false, QImage());
+}
+
+void AlbumCoverLoader::StartDecoding(const Task& task,
+                                     const QString& filename) {
+  {
+    QMutexLocker l(&mutex_);
+    decoding_tasks_[task.id] = task;
+  }
+  decodes_in_flight_++;
+
+  QFutureWatcher<QImage>* watcher = new QFutureWatcher<QImage>(this);
+  NewClosure(watcher, SIGNAL(finished()), this,
+             SLOT(ImageDecoded(QFutureWatcher<QImage>*, quint64)), watcher,
+             task.id);
+  watcher->setFuture(ConcurrentRun::Run<QImage>(
+      &decode_pool_,
+      std::bind(&AlbumCoverLoader::DecodeImage, task, filename)));
+}
+
+QImage AlbumCoverLoader::DecodeImage(const Task& task,
+                                     const QString& filename) {
+  if (filename == Song::kEmbeddedCover) {
+    return TagReaderClient::Instance()->LoadEmbeddedArtBlocking(
+        task.song_filename);
+  }
+
+  QImageReader reader(filename);
+  const QSize size = DecodeSize(task.options, reader.size());
+  if (size.isValid()) {
+    // The JPEG reader uses DCT scaling for this, so it never has to decode
+    // the whole image.
+    reader.setScaledSize(size);
+  }
+  return reader.read();
+}
+
+QSize AlbumCoverLoader::DecodeSize(const AlbumCoverLoaderOptions& options,
+                                   const QSize& image_size) {
+  if (!options.scale_output_image_ || options.keep_original_image_ ||
+      !image_size.isValid()) {
+    return QSize();
+  }
+
+  // Decode at twice the output size so ScaleAndPad's smooth scaling still has
+  // some detail to work with.
+  const int limit = options.desired_height_ * 2;
+  if (image_size.width() <= limit && image_size.height() <= limit) {
+    return QSize();
+  }
+  return image_size.scaled(limit, limit, Qt::KeepAspectRatio);
+}
+
+void AlbumCoverLoader::ImageDecoded(QFutureWatcher<QImage>* watcher,
+                                    quint64 id) {
+  watcher->deleteLater();
+  decodes_in_flight_--;
+
+  Task task;
+  bool cancelled = false;
+  {
+    QMutexLocker l(&mutex_);
+    if (decoding_tasks_.contains(id)) {
+      task = decoding_tasks_.take(id);
+    } else {
+      cancelled = true;
+    }
+  }
+
+  if (!cancelled) {
+    const QImage image = watcher->result();
+    if (!image.isNull()) {
+      QImage scaled = ScaleAndPad(task.options, image);
+      emit ImageLoaded(task.id, scaled);
+      emit ImageLoaded(task.id, scaled, image);
+    } else {
+      NextState(&task);
+    }
+  }
+
+  ProcessTasks();
 }
 
 void AlbumCoverLoader::SpotifyImageLoaded(const QString& id,
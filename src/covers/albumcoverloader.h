@@ -24,10 +24,12 @@
 #include "albumcoverloaderoptions.h"
 #include "core/song.h"
 
+#include <QFutureWatcher>
 #include <QImage>
 #include <QMutex>
 #include <QObject>
 #include <QQueue>
+#include <QThreadPool>
 #include <QUrl>
 
 class NetworkAccessManager;
@@ -51,9 +53,17 @@ class AlbumCoverLoader : public QObject {
                                  const QString& song_filename = QString(),
                                  const QImage& embedded_image = QImage());
 
+  // Cancelled tasks that haven't been decoded yet never are.  No ImageLoaded
+  // signal is emitted for them.
   void CancelTask(quint64 id);
   void CancelTasks(const QSet<quint64>& ids);
 
+  // Moves tasks that haven't been started yet to a different place in the
+  // queue.  They go in front of the tasks that already had that priority, so
+  // the tasks that were given it most recently are started first.
+  void SetTasksPriority(const QSet<quint64>& ids,
+                        AlbumCoverLoaderOptions::Priority priority);
+
   static QPixmap TryLoadPixmap(const QString& automatic, const QString& manual,
                                const QString& filename = QString());
   static QImage ScaleAndPad(const AlbumCoverLoaderOptions& options,
@@ -67,6 +77,7 @@ class AlbumCoverLoader : public QObject {
   void ProcessTasks();
   void RemoteFetchFinished(QNetworkReply* reply);
   void SpotifyImageLoaded(const QString& url, const QImage& image);
+  void ImageDecoded(QFutureWatcher<QImage>* watcher, quint64 id);
 
  protected:
   enum State { State_TryingManual, State_TryingAuto, };
@@ -94,20 +105,38 @@ class AlbumCoverLoader : public QObject {
     QImage image;
   };
 
+  // Adds a task to tasks_ after all the tasks with the same or a higher
+  // priority.  mutex_ must be locked.
+  void EnqueueTask(const Task& task);
+  // Adds a task to tasks_ before the other tasks with the same priority.
+  // mutex_ must be locked.
+  void EnqueueTaskAtFront(const Task& task);
+
   void ProcessTask(Task* task);
   void NextState(Task* task);
   TryLoadResult TryLoadImage(const Task& task);
 
+  // Loads local files and embedded art on decode_pool_.
+  void StartDecoding(const Task& task, const QString& filename);
+  static QImage DecodeImage(const Task& task, const QString& filename);
+  static QSize DecodeSize(const AlbumCoverLoaderOptions& options,
+                          const QSize& image_size);
+
   bool stop_requested_;
 
   QMutex mutex_;
   QQueue<Task> tasks_;
+  // Tasks being decoded, also protected by mutex_.
+  QMap<quint64, Task> decoding_tasks_;
   QMap<QNetworkReply*, Task> remote_tasks_;
   QMap<QString, Task> remote_spotify_tasks_;
   quint64 next_id_;
 
   NetworkAccessManager* network_;
 
+  QThreadPool decode_pool_;
+  int decodes_in_flight_;
+
   bool connected_spotify_;
 
   static const int kMaxRedirects = 3;
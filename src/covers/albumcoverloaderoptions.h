@@ -23,15 +23,32 @@
 #include <QImage>
 
 struct AlbumCoverLoaderOptions {
+  // Requests with a higher priority are started first.
+  enum Priority {
+    Priority_Background,
+    Priority_Normal,
+    Priority_Visible,
+    Priority_CurrentSong,
+  };
+
   AlbumCoverLoaderOptions()
       : desired_height_(120),
         scale_output_image_(true),
-        pad_output_image_(true) {}
+        pad_output_image_(true),
+        keep_original_image_(false),
+        priority_(Priority_Normal) {}
 
   int desired_height_;
   bool scale_output_image_;
   bool pad_output_image_;
   QImage default_output_image_;
+
+  // If this is false, large images that are going to be scaled down are
+  // decoded at a lower resolution to start with, and the "original" image
+  // passed to ImageLoaded is the one that was decoded.
+  bool keep_original_image_;
+
+  Priority priority_;
 };
 
 #endif  // COVERS_ALBUMCOVERLOADEROPTIONS_H_
@@ -35,6 +35,7 @@ CurrentArtLoader::CurrentArtLoader(Application* app, QObject* parent)
   options_.scale_output_image_ = false;
   options_.pad_output_image_ = false;
   options_.default_output_image_ = QImage(":nocover.png");
+  options_.priority_ = AlbumCoverLoaderOptions::Priority_CurrentSong;
 
   connect(app_->album_cover_loader(), SIGNAL(ImageLoaded(quint64, QImage)),
           SLOT(TempArtLoaded(quint64, QImage)));
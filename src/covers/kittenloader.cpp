@@ -97,7 +97,7 @@ void KittenLoader::KittensRetrieved(QNetworkReply* reply) {
     QUrl kitten_url = kitten_urls_.dequeue();
     task.art_manual = kitten_url.toString();
     task.state = State_TryingManual;
-    tasks_.enqueue(task);
+    EnqueueTask(task);
   }
 
   if (kitten_urls_.isEmpty()) {
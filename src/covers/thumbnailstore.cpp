@@ -0,0 +1,245 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "thumbnailstore.h"
+
+#include <string.h>
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QtConcurrentRun>
+
+#include "albumcoverloader.h"
+#include "thumbnailtilefile.h"
+#include "core/application.h"
+#include "core/closure.h"
+#include "core/logging.h"
+#include "core/song.h"
+#include "core/taskmanager.h"
+#include "core/utilities.h"
+
+const int ThumbnailStore::kSmallSize = 32;
+const int ThumbnailStore::kLargeSize = 120;
+const int ThumbnailStore::kSmallCapacity = 16384;  // Up to 64MB
+const int ThumbnailStore::kLargeCapacity = 1024;   // Up to ~56MB
+
+namespace {
+
+// The number of covers loaded at once when rebuilding the thumbnails.
+const int kRebuildMaxLoading = 8;
+
+quint64 KeyHash(const QString& key) {
+  const QByteArray md5 =
+      QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Md5);
+  quint64 ret;
+  memcpy(&ret, md5.constData(), sizeof(ret));
+  return ret;
+}
+
+}  // namespace
+
+ThumbnailStore::ThumbnailStore(Application* app, QObject* parent)
+    : QObject(parent),
+      app_(app),
+      rebuild_task_id_(-1),
+      rebuild_total_(0) {
+  const QString dir = Utilities::GetConfigPath(Utilities::Path_CacheRoot);
+  QDir().mkpath(dir);
+
+  // The library used to keep its icons as XPM files in a QNetworkDiskCache.
+  if (QFile::exists(dir + "/pixmapcache")) {
+    Utilities::RemoveRecursive(dir + "/pixmapcache");
+  }
+
+  files_[kSmallSize] = new ThumbnailTileFile(dir + "/thumbnails-32.bin",
+                                             kSmallSize, kSmallCapacity);
+  files_[kLargeSize] = new ThumbnailTileFile(dir + "/thumbnails-120.bin",
+                                             kLargeSize, kLargeCapacity);
+
+  connect(app_->album_cover_loader(), SIGNAL(ImageLoaded(quint64, QImage)),
+          SLOT(RebuildArtLoaded(quint64, QImage)));
+}
+
+ThumbnailStore::~ThumbnailStore() { qDeleteAll(files_); }
+
+QString ThumbnailStore::ArtKey(const QString& art_automatic,
+                               const QString& art_manual) {
+  return "art:" + art_automatic + "\n" + art_manual;
+}
+
+QString ThumbnailStore::ArtKey(const Song& song) {
+  return ArtKey(song.art_automatic(), song.art_manual());
+}
+
+qint64 ThumbnailStore::ArtStamp(const QString& art_automatic,
+                                const QString& art_manual,
+                                const QString& song_filename) {
+  // Follow the same order as AlbumCoverLoader.
+  QString filename;
+  if (!art_manual.isEmpty() && art_manual != Song::kManuallyUnsetCover) {
+    filename = art_manual;
+  } else if (art_automatic == Song::kEmbeddedCover) {
+    filename = song_filename;
+  } else {
+    filename = art_automatic;
+  }
+
+  if (filename.isEmpty() || filename.contains("://")) return 0;
+  return QFileInfo(filename).lastModified().toTime_t();
+}
+
+qint64 ThumbnailStore::ArtStamp(const Song& song) {
+  return ArtStamp(song.art_automatic(), song.art_manual(),
+                  song.url().toLocalFile());
+}
+
+ThumbnailTileFile* ThumbnailStore::FileForSize(int size) const {
+  ThumbnailTileFile* file = files_.value(size);
+  Q_ASSERT(file);
+  return file;
+}
+
+bool ThumbnailStore::Find(int size, const QString& key, qint64 stamp,
+                          QImage* image) {
+  return FileForSize(size)->Find(KeyHash(key), stamp, image);
+}
+
+void ThumbnailStore::Insert(int size, const QString& key, qint64 stamp,
+                            const QImage& image) {
+  if (image.isNull()) return;
+
+  QImage tile = image;
+  if (tile.width() != size || tile.height() != size) {
+    AlbumCoverLoaderOptions options;
+    options.desired_height_ = size;
+    tile = AlbumCoverLoader::ScaleAndPad(options, tile);
+  }
+  if (tile.format() != QImage::Format_ARGB32) {
+    tile = tile.convertToFormat(QImage::Format_ARGB32);
+  }
+
+  FileForSize(size)->Insert(KeyHash(key), stamp, tile);
+}
+
+void ThumbnailStore::Remove(int size, const QString& key) {
+  FileForSize(size)->Remove(KeyHash(key));
+}
+
+void ThumbnailStore::Clear(int size) { FileForSize(size)->Clear(); }
+
+LibraryBackend::AlbumList ThumbnailStore::AlbumsWithArt(
+    LibraryBackend* backend) {
+  LibraryBackend::AlbumList ret;
+  QSet<QString> seen_keys;
+
+  for (const LibraryBackend::Album& album : backend->GetAllAlbums()) {
+    if (album.art_automatic.isEmpty() &&
+        (album.art_manual.isEmpty() ||
+         album.art_manual == Song::kManuallyUnsetCover)) {
+      continue;
+    }
+
+    // Lots of albums can share the same art.
+    const QString key = ArtKey(album.art_automatic, album.art_manual);
+    if (seen_keys.contains(key)) continue;
+    seen_keys.insert(key);
+
+    ret << album;
+  }
+  return ret;
+}
+
+void ThumbnailStore::RebuildLibraryThumbnails() {
+  if (rebuild_task_id_ != -1) return;
+
+  rebuild_task_id_ =
+      app_->task_manager()->StartTask(tr("Rebuilding album cover thumbnails"));
+  rebuild_total_ = -1;
+
+  Clear(kSmallSize);
+  Clear(kLargeSize);
+
+  QFutureWatcher<LibraryBackend::AlbumList>* watcher =
+      new QFutureWatcher<LibraryBackend::AlbumList>(this);
+  NewClosure(watcher, SIGNAL(finished()), this,
+             SLOT(RebuildAlbumsFound(
+                 QFutureWatcher<LibraryBackend::AlbumList>*)),
+             watcher);
+  watcher->setFuture(QtConcurrent::run(&ThumbnailStore::AlbumsWithArt,
+                                       app_->library_backend()));
+}
+
+void ThumbnailStore::RebuildAlbumsFound(
+    QFutureWatcher<LibraryBackend::AlbumList>* watcher) {
+  watcher->deleteLater();
+
+  rebuild_queue_ = watcher->result();
+  rebuild_total_ = rebuild_queue_.count();
+
+  LoadNextRebuildArt();
+  UpdateRebuildProgress();
+}
+
+void ThumbnailStore::LoadNextRebuildArt() {
+  // Load the art at the large size and scale it down again for the small one,
+  // so each cover is only read once.
+  AlbumCoverLoaderOptions options;
+  options.desired_height_ = kLargeSize;
+  options.priority_ = AlbumCoverLoaderOptions::Priority_Background;
+
+  while (rebuild_loading_.count() < kRebuildMaxLoading &&
+         !rebuild_queue_.isEmpty()) {
+    const LibraryBackend::Album album = rebuild_queue_.takeFirst();
+    const quint64 id = app_->album_cover_loader()->LoadImageAsync(
+        options, album.art_automatic, album.art_manual,
+        album.first_url.toLocalFile());
+    rebuild_loading_[id] = album;
+  }
+}
+
+void ThumbnailStore::RebuildArtLoaded(quint64 id, const QImage& image) {
+  if (!rebuild_loading_.contains(id)) return;
+  const LibraryBackend::Album album = rebuild_loading_.take(id);
+
+  const QString key = ArtKey(album.art_automatic, album.art_manual);
+  const qint64 stamp = ArtStamp(album.art_automatic, album.art_manual,
+                                album.first_url.toLocalFile());
+  Insert(kLargeSize, key, stamp, image);
+  Insert(kSmallSize, key, stamp, image);
+
+  LoadNextRebuildArt();
+  UpdateRebuildProgress();
+}
+
+void ThumbnailStore::UpdateRebuildProgress() {
+  // Wait until the list of albums has been loaded.
+  if (rebuild_task_id_ == -1 || rebuild_total_ == -1) return;
+
+  const int remaining = rebuild_queue_.count() + rebuild_loading_.count();
+  if (remaining == 0) {
+    app_->task_manager()->SetTaskFinished(rebuild_task_id_);
+    rebuild_task_id_ = -1;
+    return;
+  }
+
+  app_->task_manager()->SetTaskProgress(
+      rebuild_task_id_, rebuild_total_ - remaining, rebuild_total_);
+}
@@ -0,0 +1,105 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef COVERS_THUMBNAILSTORE_H_
+#define COVERS_THUMBNAILSTORE_H_
+
+#include <QFutureWatcher>
+#include <QImage>
+#include <QMap>
+#include <QObject>
+
+#include "library/librarybackend.h"
+
+class Application;
+class Song;
+class ThumbnailTileFile;
+
+// A persistent cache of small, square album cover thumbnails.  Each thumbnail
+// size has its own ThumbnailTileFile of raw ARGB tiles that is memory-mapped,
+// so a lookup is a hash table probe and a memcpy rather than decoding an image.
+//
+// Thumbnails are identified by a string key and a stamp.  A lookup only
+// succeeds if the stamp matches the one the thumbnail was inserted with, so
+// callers use the modification time of the art file to invalidate old tiles.
+//
+// Must only be used from the GUI thread.
+class ThumbnailStore : public QObject {
+  Q_OBJECT
+
+ public:
+  explicit ThumbnailStore(Application* app, QObject* parent = nullptr);
+  ~ThumbnailStore();
+
+  // The sizes used by the library, global search and the cover manager.
+  static const int kSmallSize;
+  static const int kLargeSize;
+
+  // The number of tiles kept for each size.
+  static const int kSmallCapacity;
+  static const int kLargeCapacity;
+
+  // Identifies a cover by where the art is found, so that every album that
+  // uses the same art shares a thumbnail.
+  static QString ArtKey(const QString& art_automatic,
+                        const QString& art_manual);
+  static QString ArtKey(const Song& song);
+
+  // The modification time of the file the art would be loaded from, or 0 if
+  // it isn't a local file.
+  static qint64 ArtStamp(const QString& art_automatic,
+                         const QString& art_manual,
+                         const QString& song_filename = QString());
+  static qint64 ArtStamp(const Song& song);
+
+  // size must be kSmallSize or kLargeSize.  Images are scaled and padded to
+  // size x size when they're inserted.
+  bool Find(int size, const QString& key, qint64 stamp, QImage* image);
+  void Insert(int size, const QString& key, qint64 stamp, const QImage& image);
+  void Remove(int size, const QString& key);
+  void Clear(int size);
+
+ public slots:
+  // Throws away all the thumbnails and loads new ones for every album in the
+  // library.
+  void RebuildLibraryThumbnails();
+
+ private slots:
+  void RebuildAlbumsFound(
+      QFutureWatcher<LibraryBackend::AlbumList>* watcher);
+  void RebuildArtLoaded(quint64 id, const QImage& image);
+
+ private:
+  ThumbnailTileFile* FileForSize(int size) const;
+
+  void LoadNextRebuildArt();
+  void UpdateRebuildProgress();
+
+  static LibraryBackend::AlbumList AlbumsWithArt(LibraryBackend* backend);
+
+ private:
+  Application* app_;
+
+  QMap<int, ThumbnailTileFile*> files_;
+
+  int rebuild_task_id_;
+  int rebuild_total_;
+  LibraryBackend::AlbumList rebuild_queue_;
+  QMap<quint64, LibraryBackend::Album> rebuild_loading_;
+};
+
+#endif  // COVERS_THUMBNAILSTORE_H_
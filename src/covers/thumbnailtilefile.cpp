@@ -0,0 +1,280 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "thumbnailtilefile.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "core/logging.h"
+
+const int ThumbnailTileFile::kGrowTiles = 64;
+
+ThumbnailTileFile::ThumbnailTileFile(const QString& filename, int tile_size,
+                                     int capacity)
+    : file_(filename),
+      tile_size_(tile_size),
+      capacity_(capacity),
+      header_(nullptr),
+      entries_(nullptr),
+      tiles_(nullptr),
+      allocated_(0),
+      lru_prev_(capacity, -1),
+      lru_next_(capacity, -1),
+      lru_first_(-1),
+      lru_last_(-1) {
+  if (!Open()) {
+    qLog(Warning) << "Couldn't map thumbnail file" << filename
+                  << file_.errorString();
+    Unmap();
+    return;
+  }
+
+  LoadEntries();
+}
+
+ThumbnailTileFile::~ThumbnailTileFile() { Unmap(); }
+
+qint64 ThumbnailTileFile::TilesOffset() const {
+  // Start the tiles on a page boundary.
+  const qint64 table_size = sizeof(Header) + sizeof(Entry) * capacity_;
+  return (table_size + 4095) & ~qint64(4095);
+}
+
+bool ThumbnailTileFile::Open() {
+  if (!file_.open(QIODevice::ReadWrite)) return false;
+
+  // Start again with an empty file if it was written by something else.
+  const qint64 tiles_size = file_.size() - TilesOffset();
+  bool valid = tiles_size >= 0 && tiles_size % TileBytes() == 0 &&
+               tiles_size / TileBytes() <= capacity_;
+  if (valid) {
+    Header header;
+    valid = file_.read(reinterpret_cast<char*>(&header), sizeof(header)) ==
+                qint64(sizeof(header)) &&
+            header.magic == kMagic && header.version == kVersion &&
+            header.tile_size == quint32(tile_size_) &&
+            header.capacity == quint32(capacity_);
+  }
+
+  if (valid) return Resize(tiles_size / TileBytes());
+
+  // Truncating the file first zeroes the header and all the entries.
+  if (!file_.resize(0) || !Resize(0)) return false;
+
+  header_->magic = kMagic;
+  header_->version = kVersion;
+  header_->tile_size = tile_size_;
+  header_->capacity = capacity_;
+  return true;
+}
+
+bool ThumbnailTileFile::Resize(int allocated) {
+  Unmap();
+
+  const qint64 file_size = TilesOffset() + qint64(allocated) * TileBytes();
+  if (!file_.resize(file_size)) return false;
+
+  uchar* data = file_.map(0, file_size);
+  if (!data) return false;
+
+  header_ = reinterpret_cast<Header*>(data);
+  entries_ = reinterpret_cast<Entry*>(data + sizeof(Header));
+  tiles_ = data + TilesOffset();
+  allocated_ = allocated;
+  return true;
+}
+
+void ThumbnailTileFile::Unmap() {
+  if (header_) file_.unmap(reinterpret_cast<uchar*>(header_));
+
+  header_ = nullptr;
+  entries_ = nullptr;
+  tiles_ = nullptr;
+}
+
+void ThumbnailTileFile::LoadEntries() {
+  QList<QPair<quint32, int>> used;
+
+  for (int slot = 0; slot < capacity_; ++slot) {
+    Entry* entry = &entries_[slot];
+    if (!entry->last_used) {
+      if (slot < allocated_) free_slots_ << slot;
+      continue;
+    }
+
+    if (slot >= allocated_ || slots_.contains(entry->hash)) {
+      // The tile is past the end of the file, or is a duplicate left by a
+      // crash.
+      entry->last_used = 0;
+      if (slot < allocated_) free_slots_ << slot;
+      continue;
+    }
+
+    slots_[entry->hash] = slot;
+    used << qMakePair(entry->last_used, slot);
+  }
+
+  std::sort(used.begin(), used.end());
+  for (const QPair<quint32, int>& pair : used) {
+    Append(pair.second);
+  }
+}
+
+bool ThumbnailTileFile::Find(quint64 hash, qint64 stamp, QImage* image) {
+  if (!header_) return false;
+
+  QHash<quint64, int>::const_iterator it = slots_.constFind(hash);
+  if (it == slots_.constEnd()) return false;
+
+  const int slot = it.value();
+  Entry* entry = &entries_[slot];
+  if (entry->stamp != stamp) {
+    // The art has changed since this tile was made.
+    RemoveSlot(slot);
+    return false;
+  }
+
+  *image = QImage(tile_size_, tile_size_, QImage::Format_ARGB32);
+  memcpy(image->bits(), Tile(slot), TileBytes());
+  entry->last_used = ++header_->clock;
+
+  Unlink(slot);
+  Append(slot);
+  return true;
+}
+
+void ThumbnailTileFile::Insert(quint64 hash, qint64 stamp,
+                               const QImage& tile) {
+  if (!header_) return;
+
+  Q_ASSERT(tile.width() == tile_size_ && tile.height() == tile_size_);
+  Q_ASSERT(tile.format() == QImage::Format_ARGB32);
+
+  int slot = slots_.value(hash, -1);
+  if (slot == -1) {
+    slot = TakeSlot();
+    if (slot == -1) return;
+    slots_[hash] = slot;
+  } else {
+    Unlink(slot);
+  }
+
+  // Write the tile before the entry so a crash can't leave an entry pointing
+  // at half a tile.
+  Entry* entry = &entries_[slot];
+  entry->last_used = 0;
+  memcpy(Tile(slot), tile.constBits(), TileBytes());
+  entry->hash = hash;
+  entry->stamp = stamp;
+  entry->last_used = ++header_->clock;
+
+  Append(slot);
+}
+
+void ThumbnailTileFile::Remove(quint64 hash) {
+  if (!header_) return;
+
+  const int slot = slots_.value(hash, -1);
+  if (slot != -1) RemoveSlot(slot);
+}
+
+void ThumbnailTileFile::Clear() {
+  if (!header_) return;
+
+  header_->clock = 0;
+  memset(entries_, 0, sizeof(Entry) * capacity_);
+
+  slots_.clear();
+  free_slots_.clear();
+  lru_prev_.fill(-1);
+  lru_next_.fill(-1);
+  lru_first_ = -1;
+  lru_last_ = -1;
+
+  if (!Resize(0)) {
+    qLog(Warning) << "Couldn't shrink thumbnail file" << file_.fileName()
+                  << file_.errorString();
+    Unmap();
+  }
+}
+
+void ThumbnailTileFile::RemoveSlot(int slot) {
+  slots_.remove(entries_[slot].hash);
+  entries_[slot].last_used = 0;
+  free_slots_ << slot;
+  Unlink(slot);
+}
+
+int ThumbnailTileFile::TakeSlot() {
+  if (!free_slots_.isEmpty()) return free_slots_.takeLast();
+
+  if (allocated_ < capacity_) {
+    // Make room for some more tiles at the end of the file.
+    const int first_new = allocated_;
+    if (!Resize(qMin(capacity_, allocated_ + kGrowTiles))) {
+      qLog(Warning) << "Couldn't grow thumbnail file" << file_.fileName()
+                    << file_.errorString();
+      Unmap();
+      return -1;
+    }
+
+    for (int slot = allocated_ - 1; slot > first_new; --slot) {
+      free_slots_ << slot;
+    }
+    return first_new;
+  }
+
+  // The file is full - replace the tile that was used least recently.
+  const int oldest = lru_first_;
+  Unlink(oldest);
+  slots_.remove(entries_[oldest].hash);
+  return oldest;
+}
+
+void ThumbnailTileFile::Unlink(int slot) {
+  const int prev = lru_prev_[slot];
+  const int next = lru_next_[slot];
+
+  if (prev == -1) {
+    if (lru_first_ == slot) lru_first_ = next;
+  } else {
+    lru_next_[prev] = next;
+  }
+
+  if (next == -1) {
+    if (lru_last_ == slot) lru_last_ = prev;
+  } else {
+    lru_prev_[next] = prev;
+  }
+
+  lru_prev_[slot] = -1;
+  lru_next_[slot] = -1;
+}
+
+void ThumbnailTileFile::Append(int slot) {
+  lru_prev_[slot] = lru_last_;
+  lru_next_[slot] = -1;
+
+  if (lru_last_ == -1) {
+    lru_first_ = slot;
+  } else {
+    lru_next_[lru_last_] = slot;
+  }
+  lru_last_ = slot;
+}
@@ -0,0 +1,117 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef COVERS_THUMBNAILTILEFILE_H_
+#define COVERS_THUMBNAILTILEFILE_H_
+
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QVector>
+
+// One memory-mapped file of square tiles that are all the same size, used by
+// ThumbnailStore.  The file contains a header, a table of capacity entries and
+// then the tiles, each of which is tile_size * tile_size 32-bit ARGB pixels.
+// The file only grows to hold as many tiles as have been inserted, and once it
+// holds capacity tiles the least recently used one is replaced.
+class ThumbnailTileFile {
+ public:
+  ThumbnailTileFile(const QString& filename, int tile_size, int capacity);
+  ~ThumbnailTileFile();
+
+  // The number of tiles the file grows by when it's full.
+  static const int kGrowTiles;
+
+  // False if the file couldn't be opened or mapped, in which case nothing is
+  // ever found.
+  bool is_valid() const { return header_; }
+
+  int tile_size() const { return tile_size_; }
+  int capacity() const { return capacity_; }
+
+  // The number of tiles in the file and the number of them that are used.
+  int allocated_count() const { return allocated_; }
+  int count() const { return slots_.count(); }
+
+  bool Find(quint64 hash, qint64 stamp, QImage* image);
+  // tile must be tile_size x tile_size and in QImage::Format_ARGB32.
+  void Insert(quint64 hash, qint64 stamp, const QImage& tile);
+  void Remove(quint64 hash);
+  // Removes every tile and shrinks the file again.
+  void Clear();
+
+ private:
+  Q_DISABLE_COPY(ThumbnailTileFile)
+
+  static const quint32 kMagic = 0x43544e42;  // "CTNB"
+  static const quint32 kVersion = 2;
+
+  struct Header {
+    quint32 magic;
+    quint32 version;
+    quint32 tile_size;
+    quint32 capacity;
+    quint32 clock;
+    quint32 reserved;
+  };
+
+  struct Entry {
+    quint64 hash;
+    qint64 stamp;
+    // The value of the clock when this tile was last used, or 0 if the slot is
+    // empty.
+    quint32 last_used;
+    quint32 reserved;
+  };
+
+  qint64 TilesOffset() const;
+  int TileBytes() const { return tile_size_ * tile_size_ * 4; }
+  uchar* Tile(int slot) const { return tiles_ + qint64(slot) * TileBytes(); }
+
+  bool Open();
+  bool Resize(int allocated);
+  void Unmap();
+  void LoadEntries();
+
+  void RemoveSlot(int slot);
+  int TakeSlot();
+
+  // The slots that hold tiles are kept in a list from the least to the most
+  // recently used, so the tile to replace is always at the front.
+  void Unlink(int slot);
+  void Append(int slot);
+
+  QFile file_;
+  const int tile_size_;
+  const int capacity_;
+
+  Header* header_;
+  Entry* entries_;
+  uchar* tiles_;
+  int allocated_;
+
+  QHash<quint64, int> slots_;
+  QList<int> free_slots_;
+
+  QVector<int> lru_prev_;
+  QVector<int> lru_next_;
+  int lru_first_;
+  int lru_last_;
+};
+
+#endif  // COVERS_THUMBNAILTILEFILE_H_
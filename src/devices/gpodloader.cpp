@@ -81,11 +81,9 @@ void GPodLoader::LoadDatabase() {
     songs << song;
   }
 
-  // Need to remove all the existing songs in the database first
-  backend_->DeleteSongs(backend_->FindSongsInDirectory(1));
-
-  // Add the songs we've just loaded
-  backend_->AddOrUpdateSongs(songs);
+  // Only write the songs that changed since the device was last connected.
+  // Until then the device shows the songs from last time.
+  backend_->ReplaceSongsInDirectory(1, songs);
 
   moveToThread(original_thread_);
 
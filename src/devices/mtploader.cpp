@@ -19,9 +19,11 @@
 
 #include <libmtp.h>
 
+#include <QHash>
+
 #include "connecteddevice.h"
 #include "mtpconnection.h"
-#include "core/song.h"
+#include "core/qhash_qurl.h"
 #include "core/taskmanager.h"
 #include "library/librarybackend.h"
 
@@ -57,27 +59,105 @@ bool MtpLoader::TryLoad() {
     return false;
   }
 
+  // The songs that were on the device last time it was connected.  The
+  // device shows these until loading has finished.
+  const SongList cached_songs = backend_->FindSongsInDirectory(1);
+
   // Load the list of songs on the device
+  const SongList songs = cached_songs.isEmpty()
+                             ? LoadAllTracks(dev.device())
+                             : LoadChangedTracks(dev.device(), cached_songs);
+
+  // Only write the songs that changed
+  backend_->ReplaceSongsInDirectory(1, songs);
+
+  return true;
+}
+
+SongList MtpLoader::LoadAllTracks(LIBMTP_mtpdevice_t* device) {
   SongList songs;
   LIBMTP_track_t* tracks =
-      LIBMTP_Get_Tracklisting_With_Callback(dev.device(), nullptr, nullptr);
+      LIBMTP_Get_Tracklisting_With_Callback(device, nullptr, nullptr);
   while (tracks) {
     LIBMTP_track_t* track = tracks;
-
-    Song song;
-    song.InitFromMTP(track, url_.host());
-    song.set_directory_id(1);
-    songs << song;
+    songs << SongFromTrack(track);
 
     tracks = tracks->next;
     LIBMTP_destroy_track_t(track);
   }
+  return songs;
+}
+
+SongList MtpLoader::LoadChangedTracks(LIBMTP_mtpdevice_t* device,
+                                      const SongList& cached_songs) {
+  QHash<QUrl, Song> cached_songs_by_url;
+  for (const Song& song : cached_songs) {
+    cached_songs_by_url.insert(song.url(), song);
+  }
 
-  // Need to remove all the existing songs in the database first
-  backend_->DeleteSongs(backend_->FindSongsInDirectory(1));
+  // Listing the files is much quicker than listing the tracks because it
+  // doesn't fetch their tags.  A track that keeps its object ID, size and
+  // modification time is assumed to be the same as last time.
+  struct TrackFile {
+    quint32 item_id;
+    const Song* cached_song;
+  };
+  QList<TrackFile> track_files;
+  bool any_cached = false;
+
+  LIBMTP_file_t* files =
+      LIBMTP_Get_Filelisting_With_Callback(device, nullptr, nullptr);
+  while (files) {
+    LIBMTP_file_t* file = files;
+
+    if (LIBMTP_FILETYPE_IS_TRACK(file->filetype)) {
+      QHash<QUrl, Song>::const_iterator it =
+          cached_songs_by_url.constFind(TrackUrl(file->item_id));
+
+      TrackFile track_file;
+      track_file.item_id = file->item_id;
+      track_file.cached_song = nullptr;
+      if (it != cached_songs_by_url.constEnd()) {
+        any_cached = true;
+        if (it->filesize() == int(file->filesize) &&
+            it->mtime() == uint(file->modificationdate)) {
+          track_file.cached_song = &it.value();
+        }
+      }
+      track_files << track_file;
+    }
+
+    files = files->next;
+    LIBMTP_destroy_file_t(file);
+  }
 
-  // Add the songs we've just loaded
-  backend_->AddOrUpdateSongs(songs);
+  // Songs cached by older versions have urls without the object ID, so none
+  // of them match.  Listing all the tracks at once is quicker than fetching
+  // each one's tags separately.
+  if (!any_cached && !track_files.isEmpty()) {
+    return LoadAllTracks(device);
+  }
 
-  return true;
+  SongList songs;
+  for (const TrackFile& track_file : track_files) {
+    if (track_file.cached_song) {
+      songs << *track_file.cached_song;
+    } else if (LIBMTP_track_t* track =
+                   LIBMTP_Get_Trackmetadata(device, track_file.item_id)) {
+      songs << SongFromTrack(track);
+      LIBMTP_destroy_track_t(track);
+    }
+  }
+  return songs;
+}
+
+Song MtpLoader::SongFromTrack(const LIBMTP_track_t* track) const {
+  Song song;
+  song.InitFromMTP(track, url_.host());
+  song.set_directory_id(1);
+  return song;
+}
+
+QUrl MtpLoader::TrackUrl(quint32 item_id) const {
+  return QUrl(QString("mtp://%1/%2").arg(url_.host()).arg(item_id));
 }
@@ -23,6 +23,11 @@
 #include <QObject>
 #include <QUrl>
 
+#include "core/song.h"
+
+struct LIBMTP_mtpdevice_struct;
+struct LIBMTP_track_struct;
+
 class ConnectedDevice;
 class LibraryBackend;
 class TaskManager;
@@ -46,6 +51,18 @@ signals:
  private:
   bool TryLoad();
 
+  // Fetches the tags of every track on the device.  Slow.
+  SongList LoadAllTracks(LIBMTP_mtpdevice_struct* device);
+  // Only fetches the tags of tracks that weren't in cached_songs, or that
+  // have changed size or modification time since.  Falls back to
+  // LoadAllTracks if none of the cached songs are still on the device.
+  SongList LoadChangedTracks(LIBMTP_mtpdevice_struct* device,
+                             const SongList& cached_songs);
+
+  Song SongFromTrack(const LIBMTP_track_struct* track) const;
+  // The same url as Song::InitFromMTP gives the track.
+  QUrl TrackUrl(quint32 item_id) const;
+
  private:
   std::shared_ptr<ConnectedDevice> device_;
   QThread* original_thread_;
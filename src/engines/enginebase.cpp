@@ -32,14 +32,15 @@ Engine::Base::Base()
     : volume_(50),
       beginning_nanosec_(0),
       end_nanosec_(0),
-      scope_(kScopeSize),
       fadeout_enabled_(true),
       fadeout_duration_nanosec_(2 * kNsecPerSec),  // 2s
       crossfade_enabled_(true),
       autocrossfade_enabled_(false),
       crossfade_same_album_(false),
       next_background_stream_id_(0),
-      about_to_end_emitted_(false) {}
+      about_to_end_emitted_(false),
+      scope_buffer_(kScopeBufferSize),
+      scope_sample_rate_(0) {}
 
 Engine::Base::~Base() {}
 
@@ -56,6 +57,43 @@ bool Engine::Base::Load(const QUrl& url, TrackChangeFlags,
   return true;
 }
 
+void Engine::Base::WriteScope(const int16_t* data, int count,
+                              int sample_rate) {
+  // The buffer only supports one writer, and there's only a second one for a
+  // moment while a pipeline is being replaced.
+  if (!scope_write_mutex_.tryLock()) return;
+
+  scope_sample_rate_ = sample_rate;
+  scope_buffer_.Write(data, count);
+
+  scope_write_mutex_.unlock();
+}
+
+bool Engine::Base::ReadScope(int chunk_length, Scope* scope) {
+  const int sample_rate = scope_sample_rate_;
+  if (sample_rate <= 0) return false;
+
+  // Keep the samples in stereo pairs.
+  const int chunk_size =
+      qMax(kScopeSize, (sample_rate / 1000 * chunk_length) & ~1);
+  const int max_latency =
+      qMax(chunk_size, (sample_rate / 1000 * kScopeMaxLatencyMsec) & ~1);
+
+  int available = scope_buffer_.Available() & ~1;
+  if (available > max_latency) {
+    // The analyzer couldn't keep up - skip to the newest chunk.
+    scope_buffer_.Skip(available - chunk_size);
+    available = chunk_size;
+  }
+
+  if (available < kScopeSize) return false;
+
+  scope->resize(kScopeSize);
+  scope_buffer_.Read(scope->data(), kScopeSize);
+  scope_buffer_.Skip(qMin(available, chunk_size) - kScopeSize);
+  return true;
+}
+
 void Engine::Base::SetVolume(uint value) {
   volume_ = value;
 
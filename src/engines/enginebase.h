@@ -25,13 +25,16 @@
 #include <stdint.h>
 #include <sys/types.h>
 
+#include <atomic>
 #include <vector>
 
 #include <QList>
+#include <QMutex>
 #include <QObject>
 #include <QUrl>
 
 #include "engine_fwd.h"
+#include "core/ringbuffer.h"
 
 namespace Engine {
 
@@ -85,14 +88,28 @@ class Base : public QObject {
 
   // Simple accessors
   inline uint volume() const { return volume_; }
-  virtual const Scope& scope(int chunk_length) { return scope_; }
   bool is_fadeout_enabled() const { return fadeout_enabled_; }
   bool is_crossfade_enabled() const { return crossfade_enabled_; }
   bool is_autocrossfade_enabled() const { return autocrossfade_enabled_; }
   bool crossfade_same_album() const { return crossfade_same_album_; }
 
+  // Fills scope with the next kScopeSize samples of interleaved stereo audio
+  // for the analyzers, and skips past the rest of the next chunk_length msec.
+  // Returns false if not enough audio has arrived yet.  This is the reading
+  // side of the scope buffer, so it must only be called from one thread at a
+  // time - but that can be any thread.
+  bool ReadScope(int chunk_length, Scope* scope);
+  // Throws away any audio that hasn't been read from the scope buffer.  Must
+  // be called from the thread that calls ReadScope.
+  void ClearScope() { scope_buffer_.Clear(); }
+
   static const char* kSettingsGroup;
   static const int kScopeSize = 1024;
+  // The number of samples the scope buffer can hold.  Enough for at least a
+  // second of audio.
+  static const int kScopeBufferSize = 1 << 17;
+  // If the analyzers fall further behind the audio than this they skip ahead.
+  static const int kScopeMaxLatencyMsec = 250;
 
  public slots:
   virtual void ReloadSettings();
@@ -135,12 +152,17 @@ signals:
   static uint MakeVolumeLogarithmic(uint volume);
   void EmitAboutToEnd();
 
+  // Adds interleaved stereo samples to the scope buffer.  sample_rate is the
+  // number of values per second of audio (so twice the frame rate).  This can
+  // be called from any thread, but if two threads call it at once one of them
+  // will just drop its samples.
+  void WriteScope(const int16_t* data, int count, int sample_rate);
+
  protected:
   uint volume_;
   quint64 beginning_nanosec_;
   qint64 end_nanosec_;
   QUrl url_;
-  Scope scope_;
 
   bool fadeout_enabled_;
   qint64 fadeout_duration_nanosec_;
@@ -153,6 +175,11 @@ signals:
 
  private:
   bool about_to_end_emitted_;
+
+  RingBuffer<int16_t> scope_buffer_;
+  std::atomic<int> scope_sample_rate_;
+  QMutex scope_write_mutex_;
+
   Q_DISABLE_COPY(Base);
 };
 
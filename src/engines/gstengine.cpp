@@ -93,7 +93,6 @@ GstEngine::GstEngine(TaskManager* task_manager)
     : Engine::Base(),
       task_manager_(task_manager),
       buffering_task_id_(-1),
-      latest_buffer_(nullptr),
       equalizer_enabled_(false),
       stereo_balance_(0.0f),
       rg_enabled_(false),
@@ -109,8 +108,7 @@ GstEngine::GstEngine(TaskManager* task_manager)
       next_element_id_(0),
       is_fading_out_to_pause_(false),
       has_faded_out_(false),
-      scope_chunk_(0),
-      have_new_buffer_(false) {
+      current_pipeline_id_(-1) {
   seek_timer_->setSingleShot(true);
   seek_timer_->setInterval(kSeekDelayNanosec / kNsecPerMsec);
   connect(seek_timer_, SIGNAL(timeout()), SLOT(SeekNow()));
@@ -128,7 +126,7 @@ GstEngine::GstEngine(TaskManager* task_manager)
 GstEngine::~GstEngine() {
   EnsureInitialised();
 
-  current_pipeline_.reset();
+  SetCurrentPipeline(nullptr);
 
   qDeleteAll(device_finders_);
 
@@ -245,101 +243,34 @@ Engine::State GstEngine::state() const {
   }
 }
 
-void GstEngine::ConsumeBuffer(GstBuffer* buffer, int pipeline_id) {
-  // Schedule this to run in the GUI thread.  The buffer gets added to the
-  // queue and unreffed by UpdateScope.
-  if (!QMetaObject::invokeMethod(this, "AddBufferToScope",
-                                 Q_ARG(GstBuffer*, buffer),
-                                 Q_ARG(int, pipeline_id))) {
-    qLog(Warning) << "Failed to invoke AddBufferToScope on GstEngine";
-  }
-}
-
-void GstEngine::AddBufferToScope(GstBuffer* buf, int pipeline_id) {
-  if (!current_pipeline_ || current_pipeline_->id() != pipeline_id) {
-    gst_buffer_unref(buf);
-    return;
-  }
-
-  if (latest_buffer_ != nullptr) {
-    gst_buffer_unref(latest_buffer_);
-  }
-
-  latest_buffer_ = buf;
-  have_new_buffer_ = true;
+void GstEngine::SetCurrentPipeline(
+    const shared_ptr<GstEnginePipeline>& pipeline) {
+  current_pipeline_ = pipeline;
+  current_pipeline_id_ = pipeline ? pipeline->id() : -1;
 }
 
-const Engine::Scope& GstEngine::scope(int chunk_length) {
-  // the new buffer could have a different size
-  if (have_new_buffer_) {
-    if (latest_buffer_ != nullptr) {
-      scope_chunks_ = ceil(((double)GST_BUFFER_DURATION(latest_buffer_) /
-                            (double)(chunk_length * kNsecPerMsec)));
-    }
-
-    // if the buffer is shorter than the chunk length
-    if (scope_chunks_ <= 0) {
-      scope_chunks_ = 1;
+void GstEngine::ConsumeBuffer(GstBuffer* buffer, int pipeline_id) {
+  // This is called on the streaming thread, so the samples are copied
+  // straight into the scope buffer instead of going through the GUI thread.
+  // While crossfading or fading out both pipelines send buffers here, but
+  // only the current one should be drawn.
+  if (pipeline_id == current_pipeline_id_ &&
+      GST_CLOCK_TIME_IS_VALID(GST_BUFFER_DURATION(buffer)) &&
+      GST_BUFFER_DURATION(buffer) != 0) {
+    GstMapInfo map;
+    if (gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+      typedef Engine::Scope::value_type sample_type;
+      const int sample_rate =
+          map.size * kNsecPerSec /
+          (GST_BUFFER_DURATION(buffer) * sizeof(sample_type));
+
+      WriteScope(reinterpret_cast<const sample_type*>(map.data),
+                 map.size / sizeof(sample_type), sample_rate);
+      gst_buffer_unmap(buffer, &map);
     }
-
-    scope_chunk_ = 0;
-    have_new_buffer_ = false;
   }
 
-  if (latest_buffer_ != nullptr) {
-    UpdateScope(chunk_length);
-  }
-
-  return scope_;
-}
-
-void GstEngine::UpdateScope(int chunk_length) {
-  typedef Engine::Scope::value_type sample_type;
-
-  // prevent dbz or invalid chunk size
-  if (!GST_CLOCK_TIME_IS_VALID(GST_BUFFER_DURATION(latest_buffer_))) return;
-  if (GST_BUFFER_DURATION(latest_buffer_) == 0) return;
-
-  GstMapInfo map;
-  gst_buffer_map(latest_buffer_, &map, GST_MAP_READ);
-
-  // determine where to split the buffer
-  int chunk_density =
-      (map.size * kNsecPerMsec) / GST_BUFFER_DURATION(latest_buffer_);
-
-  int chunk_size = chunk_length * chunk_density;
-
-  // in case a buffer doesn't arrive in time
-  if (scope_chunk_ >= scope_chunks_) {
-    scope_chunk_ = 0;
-    return;
-  }
-
-  const sample_type* source = reinterpret_cast<sample_type*>(map.data);
-  sample_type* dest = scope_.data();
-  source += (chunk_size / sizeof(sample_type)) * scope_chunk_;
-
-  int bytes = 0;
-
-  // make sure we don't go beyond the end of the buffer
-  if (scope_chunk_ == scope_chunks_ - 1) {
-    bytes = qMin(static_cast<Engine::Scope::size_type>(
-                     map.size - (chunk_size * scope_chunk_)),
-                 scope_.size() * sizeof(sample_type));
-  } else {
-    bytes = qMin(static_cast<Engine::Scope::size_type>(chunk_size),
-                 scope_.size() * sizeof(sample_type));
-  }
-
-  scope_chunk_++;
-  memcpy(dest, source, bytes);
-
-  gst_buffer_unmap(latest_buffer_, &map);
-
-  if (scope_chunk_ == scope_chunks_) {
-    gst_buffer_unref(latest_buffer_);
-    latest_buffer_ = nullptr;
-  }
+  gst_buffer_unref(buffer);
 }
 
 void GstEngine::StartPreloading(const QUrl& url, bool force_stop_at_end,
@@ -403,7 +334,7 @@ bool GstEngine::Load(const QUrl& url, Engine::TrackChangeFlags change,
   if (crossfade) StartFadeout();
 
   BufferingFinished();
-  current_pipeline_ = pipeline;
+  SetCurrentPipeline(pipeline);
 
   SetVolume(volume_);
   SetEqualizerEnabled(equalizer_enabled_);
@@ -482,14 +413,14 @@ void GstEngine::PlayDone() {
     QUrl redirect_url = current_pipeline_->redirect_url();
     if (!redirect_url.isEmpty() && redirect_url != current_pipeline_->url()) {
       qLog(Info) << "Redirecting to" << redirect_url;
-      current_pipeline_ = CreatePipeline(redirect_url, end_nanosec_);
+      SetCurrentPipeline(CreatePipeline(redirect_url, end_nanosec_));
       Play(offset_nanosec);
       return;
     }
 
     // Failure - give up
     qLog(Warning) << "Could not set thread to PLAYING.";
-    current_pipeline_.reset();
+    SetCurrentPipeline(nullptr);
     BufferingFinished();
     return;
   }
@@ -525,7 +456,7 @@ void GstEngine::Stop(bool stop_after) {
 
   if (fadeout_enabled_ && current_pipeline_ && !stop_after) StartFadeout();
 
-  current_pipeline_.reset();
+  SetCurrentPipeline(nullptr);
   BufferingFinished();
   emit StateChanged(Engine::Empty);
 }
@@ -692,7 +623,7 @@ void GstEngine::HandlePipelineError(int pipeline_id, const QString& message,
 
   qLog(Warning) << "Gstreamer error:" << message;
 
-  current_pipeline_.reset();
+  SetCurrentPipeline(nullptr);
 
   BufferingFinished();
   emit StateChanged(Engine::Error);
@@ -720,7 +651,7 @@ void GstEngine::EndOfStreamReached(int pipeline_id, bool has_next_track) {
     return;
 
   if (!has_next_track) {
-    current_pipeline_.reset();
+    SetCurrentPipeline(nullptr);
     BufferingFinished();
   }
   emit TrackEnded();
@@ -879,6 +810,8 @@ int GstEngine::AddBackgroundStream(const QUrl& url) {
   if (!pipeline) {
     return -1;
   }
+  // Background streams shouldn't show up in the analyzer.
+  pipeline->RemoveBufferConsumer(this);
   pipeline->SetVolume(30);
   pipeline->SetNextUrl(url, 0, 0);
   return AddBackgroundStream(pipeline);
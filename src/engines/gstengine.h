@@ -22,6 +22,7 @@
 #ifndef AMAROK_GSTENGINE_H
 #define AMAROK_GSTENGINE_H
 
+#include <atomic>
 #include <memory>
 
 #include <gst/gst.h>
@@ -86,7 +87,6 @@ class GstEngine : public Engine::Base, public BufferConsumer {
   qint64 position_nanosec() const;
   qint64 length_nanosec() const;
   Engine::State state() const;
-  const Engine::Scope& scope(int chunk_length);
 
   OutputDetailsList GetOutputsList() const;
 
@@ -134,7 +134,6 @@ class GstEngine : public Engine::Base, public BufferConsumer {
   void HandlePipelineError(int pipeline_id, const QString& message, int domain,
                            int error_code);
   void NewMetaData(int pipeline_id, const Engine::SimpleMetaBundle& bundle);
-  void AddBufferToScope(GstBuffer* buf, int pipeline_id);
   void FadeoutFinished();
   void FadeoutPauseFinished();
   void SeekNow();
@@ -167,11 +166,10 @@ class GstEngine : public Engine::Base, public BufferConsumer {
   void StopTimers();
 
   std::shared_ptr<GstEnginePipeline> CreatePipeline();
+  void SetCurrentPipeline(const std::shared_ptr<GstEnginePipeline>& pipeline);
   std::shared_ptr<GstEnginePipeline> CreatePipeline(const QUrl& url,
                                                     qint64 end_nanosec);
 
-  void UpdateScope(int chunk_length);
-
   int AddBackgroundStream(std::shared_ptr<GstEnginePipeline> pipeline);
 
   static QUrl FixupUrl(const QUrl& url);
@@ -199,8 +197,6 @@ class GstEngine : public Engine::Base, public BufferConsumer {
 
   QList<BufferConsumer*> buffer_consumers_;
 
-  GstBuffer* latest_buffer_;
-
   bool equalizer_enabled_;
   int equalizer_preamp_;
   QList<int> equalizer_gains_;
@@ -234,9 +230,8 @@ class GstEngine : public Engine::Base, public BufferConsumer {
   bool is_fading_out_to_pause_;
   bool has_faded_out_;
 
-  int scope_chunk_;
-  bool have_new_buffer_;
-  int scope_chunks_;
+  // The id of current_pipeline_, or -1.  Read on the streaming thread.
+  std::atomic<int> current_pipeline_id_;
 
   QList<DeviceFinder*> device_finders_;
 
@@ -21,6 +21,7 @@
 #include "core/application.h"
 #include "core/logging.h"
 #include "covers/albumcoverloader.h"
+#include "covers/thumbnailstore.h"
 
 #include <QSettings>
 #include <QStringBuilder>
@@ -41,6 +42,7 @@ GlobalSearch::GlobalSearch(Application* app, QObject* parent)
   cover_loader_options_.desired_height_ = SearchProvider::kArtHeight;
   cover_loader_options_.pad_output_image_ = true;
   cover_loader_options_.scale_output_image_ = true;
+  cover_loader_options_.priority_ = AlbumCoverLoaderOptions::Priority_Visible;
 
   connect(app_->album_cover_loader(), SIGNAL(ImageLoaded(quint64, QImage)),
           SLOT(AlbumArtLoaded(quint64, QImage)));
@@ -206,9 +208,14 @@ int GlobalSearch::LoadArtAsync(const SearchProvider::Result& result) {
   }
 
   if (result.provider_->art_is_in_song_metadata()) {
+    CoverLoaderTask task;
+    task.id_ = id;
+    task.art_key_ = ThumbnailStore::ArtKey(result.metadata_);
+    task.art_stamp_ = ThumbnailStore::ArtStamp(result.metadata_);
+
     quint64 loader_id = app_->album_cover_loader()->LoadImageAsync(
         cover_loader_options_, result.metadata_);
-    cover_loader_tasks_[loader_id] = id;
+    cover_loader_tasks_[loader_id] = task;
   } else if (providers_.contains(result.provider_) &&
              result.provider_->wants_serialised_art()) {
     QueuedArt request;
@@ -245,9 +252,11 @@ void GlobalSearch::ArtLoadedSlot(int id, const QImage& image) {
 
 void GlobalSearch::AlbumArtLoaded(quint64 id, const QImage& image) {
   if (!cover_loader_tasks_.contains(id)) return;
-  int orig_id = cover_loader_tasks_.take(id);
+  const CoverLoaderTask task = cover_loader_tasks_.take(id);
 
-  HandleLoadedArt(orig_id, image, nullptr);
+  app_->thumbnail_store()->Insert(SearchProvider::kArtHeight, task.art_key_,
+                                  task.art_stamp_, image);
+  HandleLoadedArt(task.id_, image, nullptr);
 }
 
 void GlobalSearch::HandleLoadedArt(int id, const QImage& image,
@@ -268,7 +277,20 @@ void GlobalSearch::HandleLoadedArt(int id, const QImage& image,
 
 bool GlobalSearch::FindCachedPixmap(const SearchProvider::Result& result,
                                     QPixmap* pixmap) const {
-  return pixmap_cache_.find(result.pixmap_cache_key_, pixmap);
+  if (pixmap_cache_.find(result.pixmap_cache_key_, pixmap)) return true;
+
+  // Art from song metadata might have been loaded by the library already.
+  if (result.provider_->art_is_in_song_metadata()) {
+    const QString key = ThumbnailStore::ArtKey(result.metadata_);
+    const qint64 stamp = ThumbnailStore::ArtStamp(result.metadata_);
+    QImage image;
+    if (app_->thumbnail_store()->Find(SearchProvider::kArtHeight, key, stamp,
+                                      &image)) {
+      *pixmap = QPixmap::fromImage(image);
+      return true;
+    }
+  }
+  return false;
 }
 
 MimeData* GlobalSearch::LoadTracks(const SearchProvider::ResultList& results) {
@@ -107,6 +107,12 @@ signals:
     SearchProvider::Result result_;
   };
 
+  struct CoverLoaderTask {
+    int id_;
+    QString art_key_;
+    qint64 art_stamp_;
+  };
+
   struct ProviderData {
     QList<QueuedArt> queued_art_;
     bool enabled_;
@@ -124,9 +130,10 @@ signals:
   QPixmapCache pixmap_cache_;
   QMap<int, QString> pending_art_searches_;
 
-  // Used for providers with ArtIsInSongMetadata set.
+  // Used for providers with ArtIsInSongMetadata set.  Their art is also kept
+  // in the ThumbnailStore, where the library can find it too.
   AlbumCoverLoaderOptions cover_loader_options_;
-  QMap<quint64, int> cover_loader_tasks_;
+  QMap<quint64, CoverLoaderTask> cover_loader_tasks_;
 
   // Special search provider that's used for queries that look like URLs
   UrlSearchProvider* url_provider_;
@@ -17,7 +17,9 @@
 
 #include "globalsearch.h"
 #include "globalsearchsettingspage.h"
+#include "core/application.h"
 #include "core/logging.h"
+#include "internet/core/internetmodel.h"
 #include "ui/iconloader.h"
 #include "ui/settingsdialog.h"
 #include "ui_globalsearchsettingspage.h"
@@ -48,6 +50,10 @@ static bool CompareProviderId(SearchProvider* left, SearchProvider* right) {
 }
 
 void GlobalSearchSettingsPage::Load() {
+  // Internet services create their search providers, so make sure they all
+  // exist before listing them.
+  dialog()->app()->internet_model()->CreateAllServices();
+
   QSettings s;
   s.beginGroup(GlobalSearch::kSettingsGroup);
 
@@ -346,6 +346,7 @@ void GlobalSearchView::LazyLoadArt(const QModelIndex& proxy_index) {
   const QModelIndex source_index = front_proxy_->mapToSource(proxy_index);
   QStandardItem* item = front_model_->itemFromIndex(source_index);
   item->setData(true, GlobalSearchModel::Role_LazyLoadingArt);
+  QStandardItem* album_item = item;
 
   // Walk down the item's children until we find a track
   while (item->rowCount()) {
@@ -357,6 +358,13 @@ void GlobalSearchView::LazyLoadArt(const QModelIndex& proxy_index) {
       item->data(GlobalSearchModel::Role_Result)
           .value<SearchProvider::Result>();
 
+  // Maybe we have the art already.
+  QPixmap pixmap;
+  if (engine_->FindCachedPixmap(result, &pixmap)) {
+    album_item->setData(pixmap, Qt::DecorationRole);
+    return;
+  }
+
   // Load the art.
   int id = engine_->LoadArtAsync(result);
   art_requests_[id] = source_index;
@@ -0,0 +1,82 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ngramindex.h"
+
+#include <algorithm>
+#include <iterator>
+
+NGramIndex::NGramIndex() {}
+
+void NGramIndex::Clear() { postings_.clear(); }
+
+QList<NGramIndex::Trigram> NGramIndex::Trigrams(const QString& text) {
+  QList<Trigram> ret;
+  if (text.length() < 3) return ret;
+
+  // QString::contains with Qt::CaseInsensitive compares case folded
+  // characters.
+  const QString folded = text.toCaseFolded();
+  const ushort* data = folded.utf16();
+  for (int i = 0; i + 2 < folded.length(); ++i) {
+    ret << (Trigram(data[i]) << 32 | Trigram(data[i + 1]) << 16 | data[i + 2]);
+  }
+  return ret;
+}
+
+void NGramIndex::Add(int id, const QString& text) {
+  for (Trigram trigram : Trigrams(text)) {
+    QVector<int>& ids = postings_[trigram];
+    if (ids.isEmpty() || ids.last() != id) ids << id;
+  }
+}
+
+bool NGramIndex::Candidates(const QStringList& tokens,
+                            QVector<int>* candidates) const {
+  // Look up the posting list for every trigram in every token.  Each of them
+  // is a superset of the answer, so start with the shortest.
+  QList<const QVector<int>*> lists;
+  for (const QString& token : tokens) {
+    for (Trigram trigram : Trigrams(token)) {
+      QHash<Trigram, QVector<int>>::const_iterator it =
+          postings_.constFind(trigram);
+      if (it == postings_.constEnd()) {
+        // Nothing contains this token.
+        candidates->clear();
+        return true;
+      }
+      lists << &it.value();
+    }
+  }
+
+  if (lists.isEmpty()) return false;
+
+  std::sort(lists.begin(), lists.end(),
+            [](const QVector<int>* a, const QVector<int>* b) {
+    return a->count() < b->count();
+  });
+
+  *candidates = *lists[0];
+  for (int i = 1; i < lists.count() && !candidates->isEmpty(); ++i) {
+    QVector<int> intersection;
+    std::set_intersection(candidates->begin(), candidates->end(),
+                          lists[i]->begin(), lists[i]->end(),
+                          std::back_inserter(intersection));
+    *candidates = intersection;
+  }
+  return true;
+}
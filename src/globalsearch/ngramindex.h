@@ -0,0 +1,57 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GLOBALSEARCH_NGRAMINDEX_H_
+#define GLOBALSEARCH_NGRAMINDEX_H_
+
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+
+// An inverted index from every sequence of three characters to the documents
+// whose text contains it, for search providers that keep a list of items in
+// memory.  A document can only contain a search token if it contains every
+// trigram of that token, so the index gives a short list of candidates that
+// then have to be checked with QString::contains.  Matching is case
+// insensitive, like QString::contains with Qt::CaseInsensitive.
+//
+// Not thread safe - callers have to lock around it themselves.
+class NGramIndex {
+ public:
+  NGramIndex();
+
+  void Clear();
+
+  // Documents are identified by an id, and must be added in increasing order
+  // of id.  A document can be added more than once to index several pieces of
+  // text for it - a match in any of them makes the document a candidate.
+  void Add(int id, const QString& text);
+
+  // Finds the documents that might contain all of the tokens and puts their
+  // ids in candidates in increasing order.  Returns false if the tokens are
+  // all too short to be looked up, in which case every document has to be
+  // checked.
+  bool Candidates(const QStringList& tokens, QVector<int>* candidates) const;
+
+ private:
+  typedef quint64 Trigram;
+  static QList<Trigram> Trigrams(const QString& text);
+
+  QHash<Trigram, QVector<int>> postings_;
+};
+
+#endif  // GLOBALSEARCH_NGRAMINDEX_H_
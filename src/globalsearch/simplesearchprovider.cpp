@@ -60,13 +60,27 @@ SearchProvider::ResultList SimpleSearchProvider::Search(int id,
   ResultList ret;
   const QStringList tokens = TokenizeQuery(query);
 
+  // Safe words match every item, so they can't be used to look up candidates.
+  QStringList search_tokens;
+  for (const QString& token : tokens) {
+    if (!safe_words_.contains(token, Qt::CaseInsensitive)) {
+      search_tokens << token;
+    }
+  }
+
   QMutexLocker l(&items_mutex_);
-  for (const Item& item : items_) {
+
+  QVector<int> candidates;
+  const bool use_candidates = index_.Candidates(search_tokens, &candidates);
+  const int count = use_candidates ? candidates.count() : items_.count();
+
+  for (int i = 0; i < count; ++i) {
+    const Item& item = items_[use_candidates ? candidates[i] : i];
+
     bool matched = true;
-    for (const QString& token : tokens) {
+    for (const QString& token : search_tokens) {
       if (!item.keyword_.contains(token, Qt::CaseInsensitive) &&
-          !item.metadata_.title().contains(token, Qt::CaseInsensitive) &&
-          !safe_words_.contains(token, Qt::CaseInsensitive)) {
+          !item.metadata_.title().contains(token, Qt::CaseInsensitive)) {
         matched = false;
         break;
       }
@@ -88,8 +102,12 @@ SearchProvider::ResultList SimpleSearchProvider::Search(int id,
 void SimpleSearchProvider::SetItems(const ItemList& items) {
   QMutexLocker l(&items_mutex_);
   items_ = items;
-  for (ItemList::iterator it = items_.begin(); it != items_.end(); ++it) {
-    it->metadata_.set_filetype(Song::Type_Stream);
+  index_.Clear();
+  for (int i = 0; i < items_.count(); ++i) {
+    Item& item = items_[i];
+    item.metadata_.set_filetype(Song::Type_Stream);
+    index_.Add(i, item.keyword_);
+    index_.Add(i, item.metadata_.title());
   }
 }
 
@@ -18,6 +18,7 @@
 #ifndef SIMPLESEARCHPROVIDER_H
 #define SIMPLESEARCHPROVIDER_H
 
+#include "ngramindex.h"
 #include "searchprovider.h"
 
 class SimpleSearchProvider : public BlockingSearchProvider {
@@ -73,6 +74,9 @@ class SimpleSearchProvider : public BlockingSearchProvider {
 
   QMutex items_mutex_;
   ItemList items_;
+  // The keyword and title of every item, indexed by the item's position in
+  // items_.
+  NGramIndex index_;
 
   bool items_dirty_;
   bool has_searched_before_;
@@ -26,6 +26,9 @@
 #include "internet/core/internetmodel.h"
 
 #include <QMimeData>
+#include <QSettings>
+#include <QThread>
+#include <QTime>
 #include <QtDebug>
 
 #include "internet/digitally/digitallyimportedservicebase.h"
@@ -42,6 +45,7 @@
 #include "core/closure.h"
 #include "core/logging.h"
 #include "core/mergedproxymodel.h"
+#include "globalsearch/globalsearch.h"
 #include "internet/podcasts/podcastservice.h"
 #include "smartplaylists/generatormimedata.h"
 
@@ -72,6 +76,7 @@ using smart_playlists::GeneratorMimeData;
 using smart_playlists::GeneratorPtr;
 
 QMap<QString, InternetService*>* InternetModel::sServices = nullptr;
+InternetModel* InternetModel::sInstance = nullptr;
 
 const char* InternetModel::kSettingsGroup = "InternetModel";
 
@@ -83,48 +88,77 @@ InternetModel::InternetModel(Application* app, QObject* parent)
     sServices = new QMap<QString, InternetService*>;
   }
   Q_ASSERT(sServices->isEmpty());
+  sInstance = this;
 
   merged_model_->setSourceModel(this);
 
   AddService(new DigitallyImportedService(app, this));
-  AddService(new IcecastService(app, this));
-  AddService(new JamendoService(app, this));
   AddService(new JazzRadioService(app, this));
-  AddService(new MagnatuneService(app, this));
   AddService(new PodcastService(app, this));
   AddService(new RockRadioService(app, this));
   AddService(new SavedRadio(app, this));
   AddService(new RadioTunesService(app, this));
   AddService(new SomaFMService(app, this));
-  AddService(new SoundCloudService(app, this));
-  AddService(new SpotifyService(app, this));
-  AddService(new SubsonicService(app, this));
+
+  // Most people don't use these, so they're only created when they're needed.
+  RegisterService<IcecastService>(QIcon(":last.fm/icon_radio.png"),
+                                  QStringList(), "icecast", false);
+  RegisterService<JamendoService>(QIcon(":providers/jamendo.png"),
+                                  QStringList(), "jamendo", false);
+  RegisterService<MagnatuneService>(QIcon(":/providers/magnatune.png"),
+                                    QStringList() << "magnatune", "magnatune");
+  RegisterService<SoundCloudService>(QIcon(":providers/soundcloud.png"),
+                                     QStringList(), "soundcloud");
+  RegisterService<SpotifyService>(QIcon(":icons/22x22/spotify.png"),
+                                  QStringList() << "spotify", "spotify");
+  RegisterService<SubsonicService>(QIcon(":providers/subsonic.png"),
+                                   QStringList() << "subsonic", "subsonic");
 #ifdef HAVE_BOX
-  AddService(new BoxService(app, this));
+  RegisterService<BoxService>(QIcon(":/providers/box.png"),
+                              QStringList() << "box", "Box");
 #endif
 #ifdef HAVE_DROPBOX
-  AddService(new DropboxService(app, this));
+  RegisterService<DropboxService>(QIcon(":/providers/dropbox.png"),
+                                  QStringList() << "dropbox", "dropbox");
 #endif
 #ifdef HAVE_GOOGLE_DRIVE
-  AddService(new GoogleDriveService(app, this));
+  RegisterService<GoogleDriveService>(QIcon(":/providers/googledrive.png"),
+                                      QStringList() << "googledrive",
+                                      "google_drive");
 #endif
 #ifdef HAVE_SEAFILE
-  AddService(new SeafileService(app, this));
+  RegisterService<SeafileService>(QIcon(":/providers/seafile.png"),
+                                  QStringList() << "seafile", "Seafile");
 #endif
 #ifdef HAVE_SKYDRIVE
-  AddService(new SkydriveService(app, this));
+  RegisterService<SkydriveService>(QIcon(":providers/skydrive.png"),
+                                   QStringList() << "skydrive", "skydrive");
 #endif
 #ifdef HAVE_VK
-  AddService(new VkService(app, this));
+  RegisterService<VkService>(QIcon(":providers/vk.png"),
+                             QStringList() << VkService::kUrlScheme, "vk.com");
 #endif
 #ifdef HAVE_AMAZON_CLOUD_DRIVE
-  AddService(new AmazonCloudDrive(app, this));
+  RegisterService<AmazonCloudDrive>(
+      QIcon(":/providers/amazonclouddrive.png"),
+      QStringList() << "amazonclouddrive", "amazon_cloud_drive");
 #endif
 
   invisibleRootItem()->sortChildren(0, Qt::AscendingOrder);
   UpdateServices();
 }
 
+InternetModel::~InternetModel() {
+  sInstance = nullptr;
+
+  // Hidden placeholders aren't owned by the model
+  for (const QString& name : lazy_services_.keys()) {
+    if (!shown_services_[name].shown) {
+      delete shown_services_[name].item;
+    }
+  }
+}
+
 void InternetModel::AddService(InternetService* service) {
   QStandardItem* root = service->CreateRootItem();
   if (!root) {
@@ -136,15 +170,30 @@ void InternetModel::AddService(InternetService* service) {
   root->setData(Type_Service, Role_Type);
   root->setData(QVariant::fromValue(service), Role_Service);
 
-  invisibleRootItem()->appendRow(root);
-  qLog(Debug) << "Adding internet service:" << service->name();
-  sServices->insert(service->name(), service);
-
   ServiceItem service_item;
   service_item.item = root;
   service_item.shown = true;
 
-  shown_services_.insert(service, service_item);
+  if (shown_services_.contains(service->name())) {
+    // The service was created lazily, so its root item replaces the
+    // placeholder.
+    QStandardItem* placeholder = shown_services_[service->name()].item;
+    service_item.shown = shown_services_[service->name()].shown;
+    if (service_item.shown) {
+      const int row = placeholder->row();
+      invisibleRootItem()->removeRow(row);
+      invisibleRootItem()->insertRow(row, root);
+    } else {
+      delete placeholder;
+    }
+  } else {
+    invisibleRootItem()->appendRow(root);
+  }
+
+  qLog(Debug) << "Adding internet service:" << service->name();
+  sServices->insert(service->name(), service);
+
+  shown_services_.insert(service->name(), service_item);
 
   connect(service, SIGNAL(StreamError(QString)), SIGNAL(StreamError(QString)));
   connect(service, SIGNAL(StreamMetadataFound(QUrl, Song)),
@@ -160,6 +209,8 @@ void InternetModel::AddService(InternetService* service) {
   } else {
     service->ReloadSettings();
   }
+
+  emit ServiceAdded(service);
 }
 
 void InternetModel::RemoveService(InternetService* service) {
@@ -179,7 +230,7 @@ void InternetModel::RemoveService(InternetService* service) {
   sServices->remove(service->name());
 
   // Don't forget to delete from shown_services too
-  shown_services_.remove(service);
+  shown_services_.remove(service->name());
 
   // Disconnect the service
   disconnect(service, 0, this, 0);
@@ -192,9 +243,95 @@ void InternetModel::ServiceDeleted() {
 
 InternetService* InternetModel::ServiceByName(const QString& name) {
   if (sServices->contains(name)) return sServices->value(name);
+  if (sInstance && QThread::currentThread() == sInstance->thread()) {
+    return sInstance->CreateService(name);
+  }
   return nullptr;
 }
 
+InternetService* InternetModel::ExistingServiceByName(const QString& name) {
+  return sServices->value(name);
+}
+
+void InternetModel::RegisterService(
+    const QString& name, const QIcon& icon, const QStringList& url_schemes,
+    const QString& search_provider_id, bool search_enabled_by_default,
+    const std::function<InternetService*()>& factory) {
+  QStandardItem* placeholder = new QStandardItem(icon, name);
+  placeholder->setData(Type_Service, Role_Type);
+  placeholder->setData(true, Role_CanLazyLoad);
+  placeholder->setData(name, Role_LazyServiceName);
+  invisibleRootItem()->appendRow(placeholder);
+
+  ServiceItem service_item;
+  service_item.item = placeholder;
+  service_item.shown = true;
+  shown_services_.insert(name, service_item);
+
+  LazyService lazy_service;
+  lazy_service.url_schemes = url_schemes;
+  lazy_service.factory = factory;
+  lazy_services_.insert(name, lazy_service);
+
+  // The service's search provider has to exist if it's enabled.  This uses the
+  // same default as GlobalSearch::AddProvider when there's no saved setting.
+  QSettings s;
+  s.beginGroup(GlobalSearch::kSettingsGroup);
+  if (s.value("enabled_" + search_provider_id, search_enabled_by_default)
+          .toBool()) {
+    CreateService(name);
+  }
+}
+
+InternetService* InternetModel::CreateService(const QString& name) {
+  if (!lazy_services_.contains(name)) return nullptr;
+
+  if (QThread::currentThread() != thread()) {
+    qLog(Warning) << "Internet service" << name
+                  << "can only be created in the main thread";
+    return nullptr;
+  }
+
+  QTime time;
+  time.start();
+
+  LazyService lazy_service = lazy_services_.take(name);
+  InternetService* service = lazy_service.factory();
+  AddService(service);
+
+  qLog(Debug) << "Created internet service" << name << "in" << time.elapsed()
+              << "ms";
+  return service;
+}
+
+void InternetModel::CreateServiceForPlaceholder(const QString& name) {
+  if (!CreateService(name)) return;
+
+  // Expand the new root item, since that's what the user asked for
+  const ServiceItem& service_item = shown_services_[name];
+  if (service_item.shown) {
+    emit ScrollToIndex(
+        merged_model_->mapFromSource(service_item.item->index()));
+  }
+}
+
+InternetService* InternetModel::CreateServiceForUrlScheme(
+    const QString& scheme) {
+  for (auto it = lazy_services_.constBegin(); it != lazy_services_.constEnd();
+       ++it) {
+    if (it.value().url_schemes.contains(scheme)) {
+      return CreateService(it.key());
+    }
+  }
+  return nullptr;
+}
+
+void InternetModel::CreateAllServices() {
+  for (const QString& name : lazy_services_.keys()) {
+    CreateService(name);
+  }
+}
+
 InternetService* InternetModel::ServiceForItem(
     const QStandardItem* item) const {
   return ServiceForIndex(indexFromItem(item));
@@ -235,6 +372,14 @@ int InternetModel::rowCount(const QModelIndex& parent) const {
     if (service) {
       item->setData(false, Role_CanLazyLoad);
       service->LazyPopulate(item);
+    } else if (parent.data(Role_LazyServiceName).isValid()) {
+      // The service hasn't been created yet.  Its root item will replace this
+      // placeholder, which can't happen while the view is asking about it.
+      item->setData(false, Role_CanLazyLoad);
+      QMetaObject::invokeMethod(
+          const_cast<InternetModel*>(this), "CreateServiceForPlaceholder",
+          Qt::QueuedConnection,
+          Q_ARG(QString, parent.data(Role_LazyServiceName).toString()));
     }
   }
 
@@ -351,19 +496,17 @@ void InternetModel::UpdateServices() {
   QStringList keys = s.childKeys();
 
   for (const QString& service_name : keys) {
-    InternetService* internet_service = ServiceByName(service_name);
-    if (internet_service == nullptr) {
+    if (!shown_services_.contains(service_name)) {
       continue;
     }
     bool setting_val = s.value(service_name).toBool();
 
     // Only update if values are different
-    if (setting_val == true &&
-        shown_services_[internet_service].shown == false) {
-      ShowService(internet_service);
+    if (setting_val == true && shown_services_[service_name].shown == false) {
+      ShowService(service_name);
     } else if (setting_val == false &&
-               shown_services_[internet_service].shown == true) {
-      HideService(internet_service);
+               shown_services_[service_name].shown == true) {
+      HideService(service_name);
     }
   }
 
@@ -384,26 +527,19 @@ int InternetModel::FindItemPosition(const QString& text) {
   return a;
 }
 
-void InternetModel::ShowService(InternetService* service) {
-  if (shown_services_[service].shown != true) {
-    QStandardItem* item = shown_services_[service].item;
+void InternetModel::ShowService(const QString& name) {
+  if (shown_services_[name].shown != true) {
+    QStandardItem* item = shown_services_[name].item;
     int pos = FindItemPosition(item->text());
     invisibleRootItem()->insertRow(pos, item);
-    shown_services_[service].shown = true;
+    shown_services_[name].shown = true;
   }
 }
 
-void InternetModel::HideService(InternetService* service) {
-  // Find and remove the root item that this service created
-  for (int i = 0; i < invisibleRootItem()->rowCount(); ++i) {
-    QStandardItem* item = invisibleRootItem()->child(i);
-    if (!item ||
-        item->data(Role_Service).value<InternetService*>() == service) {
-      // Don't remove the standarditem behind the row
-      invisibleRootItem()->takeRow(i);
-      break;
-    }
+void InternetModel::HideService(const QString& name) {
+  if (shown_services_[name].shown == true) {
+    // Don't remove the standarditem behind the row
+    invisibleRootItem()->takeRow(shown_services_[name].item->row());
+    shown_services_[name].shown = false;
   }
-
-  shown_services_[service].shown = false;
 }
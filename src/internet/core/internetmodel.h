@@ -23,6 +23,10 @@
 #ifndef INTERNET_CORE_INTERNETMODEL_H_
 #define INTERNET_CORE_INTERNETMODEL_H_
 
+#include <functional>
+
+#include <QIcon>
+
 #include "core/song.h"
 #include "library/librarymodel.h"
 #include "playlist/playlistitem.h"
@@ -48,6 +52,7 @@ class InternetModel : public QStandardItemModel {
 
  public:
   explicit InternetModel(Application* app, QObject* parent = nullptr);
+  ~InternetModel();
 
   enum Role {
     // Services can use this role to distinguish between different types of
@@ -82,6 +87,10 @@ class InternetModel : public QStandardItemModel {
     // Setting this to true means that the item can be changed by user action
     // (e.g. changing remote playlists)
     Role_CanBeModified,
+
+    // This is set on the placeholder root item of a service that hasn't been
+    // created yet.  It contains the name of the service.
+    Role_LazyServiceName,
     RoleCount,
     Role_IsDivider = LibraryModel::Role_IsDivider,
   };
@@ -124,22 +133,56 @@ class InternetModel : public QStandardItemModel {
     bool shown;
   };
 
-  // Needs to be static for InternetPlaylistItem::restore
+  // Needs to be static for InternetPlaylistItem::restore.  If the service
+  // hasn't been created yet it's created now, but only when called from the
+  // main thread - from any other thread this returns nullptr instead.
   static InternetService* ServiceByName(const QString& name);
+  // Like ServiceByName, but never creates the service.
+  static InternetService* ExistingServiceByName(const QString& name);
   static const char* kSettingsGroup;
 
   template <typename T>
   static T* Service() {
     return static_cast<T*>(ServiceByName(T::kServiceName));
   }
+  template <typename T>
+  static T* ExistingService() {
+    return static_cast<T*>(ExistingServiceByName(T::kServiceName));
+  }
 
   // Add and remove services.  Ownership is not transferred and the service
   // is not reparented.  If the service is deleted it will be automatically
   // removed from the model.
   void AddService(InternetService* service);
   void RemoveService(InternetService* service);
-  void HideService(InternetService* service);
-  void ShowService(InternetService* service);
+  void HideService(const QString& name);
+  void ShowService(const QString& name);
+
+  // Registers a service that isn't created until it's needed: when its root
+  // item is expanded, when a URL with one of its url_schemes is played, or
+  // at startup if its search provider is enabled.  Until then the model
+  // contains a placeholder root item with the service's name and icon.
+  // search_enabled_by_default must match the provider's DisabledByDefault hint
+  // so the service is created on a fresh profile too.
+  template <typename T>
+  void RegisterService(const QIcon& icon, const QStringList& url_schemes,
+                       const QString& search_provider_id,
+                       bool search_enabled_by_default = true) {
+    RegisterService(T::kServiceName, icon, url_schemes, search_provider_id,
+                    search_enabled_by_default,
+                    [this]() { return new T(app_, this); });
+  }
+  void RegisterService(const QString& name, const QIcon& icon,
+                       const QStringList& url_schemes,
+                       const QString& search_provider_id,
+                       bool search_enabled_by_default,
+                       const std::function<InternetService*()>& factory);
+
+  // Creates the service that handles URLs with this scheme if it hasn't been
+  // created yet.  Returns nullptr if there wasn't one to create.
+  InternetService* CreateServiceForUrlScheme(const QString& scheme);
+  // Creates all the services that haven't been created yet.
+  void CreateAllServices();
   // Add or remove the services according to the setting file
   void UpdateServices();
   // Find the position where to insert this item. The list of services is
@@ -173,7 +216,8 @@ class InternetModel : public QStandardItemModel {
 
   const QModelIndex& current_index() const { return current_index_; }
   const QModelIndexList& selected_indexes() const { return selected_indexes_; }
-  const QMap<InternetService*, ServiceItem> shown_services() const {
+  // Keyed by service name.
+  const QMap<QString, ServiceItem> shown_services() const {
     return shown_services_;
   }
 
@@ -184,13 +228,28 @@ class InternetModel : public QStandardItemModel {
   void AddToPlaylist(QMimeData* data);
   void ScrollToIndex(const QModelIndex& index);
 
+  // Emitted when a service is added, including lazily registered services
+  // when they're created.
+  void ServiceAdded(InternetService* service);
+
  private slots:
   void ServiceDeleted();
+  void CreateServiceForPlaceholder(const QString& name);
+
+ private:
+  struct LazyService {
+    QStringList url_schemes;
+    std::function<InternetService*()> factory;
+  };
+
+  InternetService* CreateService(const QString& name);
 
  private:
-  QMap<InternetService*, ServiceItem> shown_services_;
+  QMap<QString, ServiceItem> shown_services_;
+  QMap<QString, LazyService> lazy_services_;
 
   static QMap<QString, InternetService*>* sServices;
+  static InternetModel* sInstance;
 
   Application* app_;
   MergedProxyModel* merged_model_;
@@ -28,7 +28,7 @@
 #include "internet/core/internetservice.h"
 #include "internet/core/internetmodel.h"
 #include "core/settingsprovider.h"
-#include "library/sqlrow.h"
+#include "core/sqlitequery.h"
 #include "playlist/playlistbackend.h"
 
 InternetPlaylistItem::InternetPlaylistItem(const QString& type)
@@ -43,12 +43,12 @@ InternetPlaylistItem::InternetPlaylistItem(InternetService* service,
   InitMetadata();
 }
 
-bool InternetPlaylistItem::InitFromQuery(const SqlRow& query) {
+bool InternetPlaylistItem::InitFromQuery(const SqliteQuery& query) {
   // The song tables gets joined first, plus one each for the song ROWIDs
   const int row =
       (Song::kColumns.count() + 1) * PlaylistBackend::kSongTableJoins;
 
-  service_name_ = query.value(row + 1).toString();
+  service_name_ = query.Text(row + 1);
 
   metadata_.InitFromQuery(query, false, (Song::kColumns.count() + 1) * 3);
   InitMetadata();
@@ -58,17 +58,18 @@ bool InternetPlaylistItem::InitFromQuery(const SqlRow& query) {
 
 InternetService* InternetPlaylistItem::service() const {
   InternetService* ret = InternetModel::ServiceByName(service_name_);
+  SetServiceIcon(ret);
+  return ret;
+}
 
-  if (ret && !set_service_icon_) {
-    const_cast<InternetPlaylistItem*>(this)->set_service_icon_ = true;
+void InternetPlaylistItem::SetServiceIcon(InternetService* service) const {
+  if (!service || set_service_icon_) return;
+  const_cast<InternetPlaylistItem*>(this)->set_service_icon_ = true;
 
-    QString icon = ret->Icon();
-    if (!icon.isEmpty()) {
-      const_cast<InternetPlaylistItem*>(this)->metadata_.set_art_manual(icon);
-    }
+  QString icon = service->Icon();
+  if (!icon.isEmpty()) {
+    const_cast<InternetPlaylistItem*>(this)->metadata_.set_art_manual(icon);
   }
-
-  return ret;
 }
 
 QVariant InternetPlaylistItem::DatabaseValue(DatabaseColumn column) const {
@@ -89,8 +90,9 @@ void InternetPlaylistItem::InitMetadata() {
 
 Song InternetPlaylistItem::Metadata() const {
   if (!set_service_icon_) {
-    // Get the icon if we don't have it already
-    service();
+    // Get the icon if we don't have it already.  This is called from other
+    // threads and for every restored item, so it mustn't create the service.
+    SetServiceIcon(InternetModel::ExistingServiceByName(service_name_));
   }
 
   if (HasTemporaryMetadata()) return temp_metadata_;
@@ -38,7 +38,7 @@ class InternetPlaylistItem : public PlaylistItem {
 
   QList<QAction*> actions();
 
-  bool InitFromQuery(const SqlRow& query);
+  bool InitFromQuery(const SqliteQuery& query);
 
   Song Metadata() const;
   QUrl Url() const;
@@ -49,7 +49,9 @@ class InternetPlaylistItem : public PlaylistItem {
 
  private:
   void InitMetadata();
+  // Returns nullptr if the service can't be created on this thread.
   InternetService* service() const;
+  void SetServiceIcon(InternetService* service) const;
 
  private:
   QString service_name_;
@@ -34,7 +34,7 @@ InternetShowSettingsPage::InternetShowSettingsPage(SettingsDialog* parent)
 }
 
 void InternetShowSettingsPage::Load() {
-  QMap<InternetService*, InternetModel::ServiceItem> shown_services =
+  QMap<QString, InternetModel::ServiceItem> shown_services =
       dialog()->app()->internet_model()->shown_services();
 
   ui_->sources->clear();
@@ -51,7 +51,7 @@ void InternetShowSettingsPage::Load() {
         service_it.value().shown == true ? Qt::Checked : Qt::Unchecked;
     item->setData(0, Qt::CheckStateRole, check_state);
     /* We have to store the constant name of the service */
-    item->setData(1, Qt::UserRole, service_it.key()->name());
+    item->setData(1, Qt::UserRole, service_it.key());
 
     ui_->sources->invisibleRootItem()->addChild(item);
   }
@@ -18,6 +18,7 @@
 */
 
 #include "jamendoplaylistitem.h"
+#include "core/sqlitequery.h"
 
 JamendoPlaylistItem::JamendoPlaylistItem(const QString& type)
     : LibraryPlaylistItem(type) {}
@@ -27,7 +28,7 @@ JamendoPlaylistItem::JamendoPlaylistItem(const Song& song)
   song_ = song;
 }
 
-bool JamendoPlaylistItem::InitFromQuery(const SqlRow& query) {
+bool JamendoPlaylistItem::InitFromQuery(const SqliteQuery& query) {
   // Rows from the songs tables come first
   song_.InitFromQuery(query, true, (Song::kColumns.count() + 1) * 2);
 
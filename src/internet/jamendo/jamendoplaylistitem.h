@@ -27,7 +27,7 @@ class JamendoPlaylistItem : public LibraryPlaylistItem {
   explicit JamendoPlaylistItem(const QString& type);
   explicit JamendoPlaylistItem(const Song& song);
 
-  bool InitFromQuery(const SqlRow& query);
+  bool InitFromQuery(const SqliteQuery& query);
 
   QUrl Url() const;
 };
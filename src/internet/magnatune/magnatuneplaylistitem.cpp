@@ -18,6 +18,7 @@
 */
 
 #include "magnatuneplaylistitem.h"
+#include "core/sqlitequery.h"
 #include "internet/core/internetmodel.h"
 
 MagnatunePlaylistItem::MagnatunePlaylistItem(const QString& type)
@@ -28,7 +29,7 @@ MagnatunePlaylistItem::MagnatunePlaylistItem(const Song& song)
   song_ = song;
 }
 
-bool MagnatunePlaylistItem::InitFromQuery(const SqlRow& query) {
+bool MagnatunePlaylistItem::InitFromQuery(const SqliteQuery& query) {
   // Rows from the songs tables come first
   song_.InitFromQuery(query, true, Song::kColumns.count() + 1);
 
@@ -27,7 +27,7 @@ class MagnatunePlaylistItem : public LibraryPlaylistItem {
   explicit MagnatunePlaylistItem(const QString& type);
   explicit MagnatunePlaylistItem(const Song& song);
 
-  bool InitFromQuery(const SqlRow& query);
+  bool InitFromQuery(const SqliteQuery& query);
 
   QUrl Url() const;
 };
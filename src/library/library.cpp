@@ -33,6 +33,7 @@ const char* Library::kSongsTable = "songs";
 const char* Library::kDirsTable = "directories";
 const char* Library::kSubdirsTable = "subdirectories";
 const char* Library::kFtsTable = "songs_fts";
+const char* Library::kJournalTable = "library_journal";
 
 Library::Library(Application* app, QObject* parent)
     : QObject(parent),
@@ -48,6 +49,7 @@ Library::Library(Application* app, QObject* parent)
 
   backend_->Init(app->database(), kSongsTable, kDirsTable, kSubdirsTable,
                  kFtsTable);
+  backend_->set_journal_table(kJournalTable);
 
   using smart_playlists::Generator;
   using smart_playlists::GeneratorPtr;
@@ -121,6 +123,7 @@ Library::Library(Application* app, QObject* parent)
 }
 
 Library::~Library() {
+  LibraryWatcher::SaveJournalState();
   watcher_->deleteLater();
   watcher_thread_->exit();
   watcher_thread_->wait(5000 /* five seconds */);
@@ -136,6 +139,7 @@ void Library::Init() {
 
   watcher_->set_backend(backend_);
   watcher_->set_task_manager(app_->task_manager());
+  watcher_->LoadJournalState();
 
   connect(backend_, SIGNAL(DirectoryDiscovered(Directory, SubdirectoryList)),
           watcher_, SLOT(AddDirectory(Directory, SubdirectoryList)));
@@ -157,6 +161,10 @@ void Library::Init() {
           SLOT(AddOrUpdateSubdirs(SubdirectoryList)));
   connect(watcher_, SIGNAL(SubdirsMTimeUpdated(SubdirectoryList)), backend_,
           SLOT(AddOrUpdateSubdirs(SubdirectoryList)));
+  connect(watcher_, SIGNAL(SubdirChanged(int, QString)), backend_,
+          SLOT(AddToJournal(int, QString)));
+  connect(watcher_, SIGNAL(SubdirsScanned(QStringList, qint64)), backend_,
+          SLOT(RemoveFromJournal(QStringList, qint64)));
   connect(watcher_, SIGNAL(CompilationsNeedUpdating()), backend_,
           SLOT(UpdateCompilations()));
   connect(app_->playlist_manager(), SIGNAL(CurrentSongChanged(Song)),
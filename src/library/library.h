@@ -43,6 +43,7 @@ class Library : public QObject {
   static const char* kDirsTable;
   static const char* kSubdirsTable;
   static const char* kFtsTable;
+  static const char* kJournalTable;
 
   void Init();
 
@@ -19,8 +19,10 @@
 #include "libraryquery.h"
 #include "sqlrow.h"
 #include "core/application.h"
+#include "core/qhash_qurl.h"
 #include "core/database.h"
 #include "core/scopedtransaction.h"
+#include "core/sqlitequery.h"
 #include "core/tagreaderclient.h"
 #include "core/utilities.h"
 #include "smartplaylists/search.h"
@@ -29,11 +31,17 @@
 #include <QDateTime>
 #include <QDir>
 #include <QFileInfo>
+#include <QHash>
 #include <QSettings>
+#include <QTime>
 #include <QVariant>
 #include <QtDebug>
 
+#include <limits>
+#include <memory>
+
 const char* LibraryBackend::kSettingsGroup = "LibraryBackend";
+const int LibraryBackend::kMaxBindValues = 999;
 
 const char* LibraryBackend::kNewScoreSql =
     "case when playcount <= 0 then (%1 * 100 + score) / 2"
@@ -43,6 +51,7 @@ const char* LibraryBackend::kNewScoreSql =
 
 LibraryBackend::LibraryBackend(QObject* parent)
     : LibraryBackendInterface(parent),
+      bulk_insert_enabled_(true),
       save_statistics_in_file_(false),
       save_ratings_in_file_(false) {}
 
@@ -96,7 +105,7 @@ void LibraryBackend::UpdateSongsRatingAsync(const QList<int>& ids,
 void LibraryBackend::LoadDirectories() {
   DirectoryList dirs = GetAllDirectories();
 
-  QMutexLocker l(db_->Mutex());
+  Database::ReadLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
 
   for (const Directory& dir : dirs) {
@@ -106,7 +115,7 @@ void LibraryBackend::LoadDirectories() {
 
 void LibraryBackend::ChangeDirPath(int id, const QString& old_path,
                                    const QString& new_path) {
-  QMutexLocker l(db_->Mutex());
+  Database::WriteLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
   ScopedTransaction t(&db);
 
@@ -151,7 +160,7 @@ void LibraryBackend::ChangeDirPath(int id, const QString& old_path,
 }
 
 DirectoryList LibraryBackend::GetAllDirectories() {
-  QMutexLocker l(db_->Mutex());
+  Database::ReadLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
 
   DirectoryList ret;
@@ -171,7 +180,7 @@ DirectoryList LibraryBackend::GetAllDirectories() {
 }
 
 SubdirectoryList LibraryBackend::SubdirsInDirectory(int id) {
-  QMutexLocker l(db_->Mutex());
+  Database::ReadLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db = db_->Connect();
   return SubdirsInDirectory(id, db);
 }
@@ -198,7 +207,7 @@ SubdirectoryList LibraryBackend::SubdirsInDirectory(int id, QSqlDatabase& db) {
 }
 
 void LibraryBackend::UpdateTotalSongCount() {
-  QMutexLocker l(db_->Mutex());
+  Database::ReadLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
 
   QSqlQuery q(QString("SELECT COUNT(*) FROM %1 WHERE unavailable = 0")
@@ -222,7 +231,7 @@ void LibraryBackend::AddDirectory(const QString& path) {
     qLog(Debug) << "db_path" << db_path;
   }
 
-  QMutexLocker l(db_->Mutex());
+  Database::WriteLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
 
   QSqlQuery q(QString(
@@ -241,7 +250,7 @@ void LibraryBackend::AddDirectory(const QString& path) {
 }
 
 void LibraryBackend::RemoveDirectory(const Directory& dir) {
-  QMutexLocker l(db_->Mutex());
+  Database::WriteLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
 
   // Remove songs first
@@ -256,6 +265,15 @@ void LibraryBackend::RemoveDirectory(const Directory& dir) {
   q.exec();
   if (db_->CheckErrors(q)) return;
 
+  if (!journal_table_.isEmpty()) {
+    q = QSqlQuery(
+        QString("DELETE FROM %1 WHERE directory = :id").arg(journal_table_),
+        db);
+    q.bindValue(":id", dir.id);
+    q.exec();
+    if (db_->CheckErrors(q)) return;
+  }
+
   // Now remove the directory itself
   q = QSqlQuery(QString("DELETE FROM %1 WHERE ROWID = :id").arg(dirs_table_),
                 db);
@@ -269,19 +287,18 @@ void LibraryBackend::RemoveDirectory(const Directory& dir) {
 }
 
 SongList LibraryBackend::FindSongsInDirectory(int id) {
-  QMutexLocker l(db_->Mutex());
+  Database::ReadLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
 
-  QSqlQuery q(
+  SqliteQuery q(
       QString("SELECT ROWID, " + Song::kColumnSpec +
               " FROM %1 WHERE directory = :directory").arg(songs_table_),
       db);
-  q.bindValue(":directory", id);
-  q.exec();
-  if (db_->CheckErrors(q)) return SongList();
+  q.BindValue(":directory", id);
+  if (!q.Exec()) return SongList();
 
   SongList ret;
-  while (q.next()) {
+  while (q.Next()) {
     Song song;
     song.InitFromQuery(q, true);
     ret << song;
@@ -290,7 +307,7 @@ SongList LibraryBackend::FindSongsInDirectory(int id) {
 }
 
 void LibraryBackend::AddOrUpdateSubdirs(const SubdirectoryList& subdirs) {
-  QMutexLocker l(db_->Mutex());
+  Database::WriteLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
   QSqlQuery find_query(
       QString(
@@ -345,8 +362,70 @@ void LibraryBackend::AddOrUpdateSubdirs(const SubdirectoryList& subdirs) {
   transaction.Commit();
 }
 
+QStringList LibraryBackend::JournalledSubdirs(int directory_id) {
+  QStringList ret;
+  if (journal_table_.isEmpty()) return ret;
+
+  Database::ReadLocker l(db_, Q_FUNC_INFO);
+  QSqlDatabase db(db_->Connect());
+
+  QSqlQuery q(
+      QString("SELECT path FROM %1 WHERE directory = :id").arg(journal_table_),
+      db);
+  q.bindValue(":id", directory_id);
+  q.exec();
+  if (db_->CheckErrors(q)) return ret;
+
+  while (q.next()) {
+    ret << q.value(0).toString();
+  }
+  return ret;
+}
+
+void LibraryBackend::AddToJournal(int directory_id, const QString& path) {
+  if (journal_table_.isEmpty()) return;
+
+  Database::WriteLocker l(db_, Q_FUNC_INFO);
+  QSqlDatabase db(db_->Connect());
+
+  // Replacing an existing row updates its timestamp, so a scan that started
+  // before this change won't remove it.
+  QSqlQuery q(QString("INSERT OR REPLACE INTO %1 (directory, path, changed)"
+                      " VALUES (:id, :path, :changed)").arg(journal_table_),
+              db);
+  q.bindValue(":id", directory_id);
+  q.bindValue(":path", path);
+  q.bindValue(":changed", QDateTime::currentMSecsSinceEpoch());
+  q.exec();
+  db_->CheckErrors(q);
+}
+
+void LibraryBackend::RemoveFromJournal(const QStringList& paths,
+                                       qint64 scan_started) {
+  if (journal_table_.isEmpty()) return;
+
+  Database::WriteLocker l(db_, Q_FUNC_INFO);
+  QSqlDatabase db(db_->Connect());
+
+  // Changes recorded after the scan started might not have been seen by it,
+  // so they have to stay in the journal.
+  QSqlQuery q(QString("DELETE FROM %1"
+                      " WHERE path = :path AND changed < :scan_started")
+                  .arg(journal_table_),
+              db);
+
+  ScopedTransaction transaction(&db);
+  for (const QString& path : paths) {
+    q.bindValue(":path", path);
+    q.bindValue(":scan_started", scan_started);
+    q.exec();
+    if (db_->CheckErrors(q)) return;
+  }
+  transaction.Commit();
+}
+
 void LibraryBackend::AddOrUpdateSongs(const SongList& songs) {
-  QMutexLocker l(db_->Mutex());
+  Database::WriteLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
 
   QSqlQuery check_dir(
@@ -373,6 +452,7 @@ void LibraryBackend::AddOrUpdateSongs(const SongList& songs) {
 
   SongList added_songs;
   SongList deleted_songs;
+  SongList new_songs;
 
   for (const Song& song : songs) {
     // Do a sanity check first - make sure the song's directory still exists
@@ -388,6 +468,10 @@ void LibraryBackend::AddOrUpdateSongs(const SongList& songs) {
 
     if (song.id() == -1) {
       // Create
+      if (bulk_insert_enabled_) {
+        new_songs << song;
+        continue;
+      }
 
       // Insert the row and create a new ID
       song.BindToQuery(&add_song);
@@ -427,6 +511,8 @@ void LibraryBackend::AddOrUpdateSongs(const SongList& songs) {
     }
   }
 
+  if (!new_songs.isEmpty()) added_songs << BulkInsertSongs(new_songs, db);
+
   transaction.Commit();
 
   if (!deleted_songs.isEmpty()) emit SongsDeleted(deleted_songs);
@@ -436,8 +522,191 @@ void LibraryBackend::AddOrUpdateSongs(const SongList& songs) {
   UpdateTotalSongCountAsync();
 }
 
+QString LibraryBackend::MultiRowInsertSql(const QString& table,
+                                          const QString& column_spec,
+                                          int columns, int rows) {
+  QStringList placeholders;
+  for (int i = 0; i < columns; ++i) placeholders << "?";
+  const QString row = "(" + placeholders.join(", ") + ")";
+
+  QStringList values;
+  for (int i = 0; i < rows; ++i) values << row;
+
+  return QString("INSERT INTO %1 (%2) VALUES %3")
+      .arg(table, column_spec, values.join(", "));
+}
+
+SongList LibraryBackend::BulkInsertSongs(const SongList& songs,
+                                         QSqlDatabase& db) {
+  QTime time;
+  time.start();
+
+  SqliteQuery max_id_query(
+      QString("SELECT max(ROWID) FROM %1").arg(songs_table_), db);
+  if (!max_id_query.Exec() || !max_id_query.Next()) return SongList();
+  const qint64 max_id = max_id_query.Int64(0);
+
+  // SQLite gives each new row the ROWID after the largest one in the table, so
+  // the rows added by one statement are numbered consecutively.  Once that
+  // would go past the largest ROWID it picks unused ones at random instead.
+  // Song IDs are ints, so if they won't fit the songs are given unused IDs
+  // one at a time.
+  SongList ret;
+  if (max_id + songs.count() <= std::numeric_limits<int>::max()) {
+    ret = InsertConsecutiveSongs(songs, db);
+  } else {
+    ret = InsertSongsWithIds(songs, UnusedSongIds(songs.count(), db), db);
+  }
+
+  // Now that all the songs are in, add them to the FTS index.
+  InsertFtsRows(ret, db);
+
+  const int msecs = qMax(1, time.elapsed());
+  qLog(Debug) << "Inserted" << ret.count() << "songs into" << songs_table_
+              << "in" << msecs << "ms -" << (ret.count() * 1000 / msecs)
+              << "rows/sec";
+
+  return ret;
+}
+
+SongList LibraryBackend::InsertConsecutiveSongs(const SongList& songs,
+                                                QSqlDatabase& db) {
+  const int columns = Song::kColumns.count();
+  const int songs_per_statement = qMax(1, kMaxBindValues / columns);
+
+  // Most statements insert the maximum number of rows, so prepare that once.
+  SqliteQuery add_songs(MultiRowInsertSql(songs_table_, Song::kColumnSpec,
+                                          columns, songs_per_statement),
+                        db);
+  if (!add_songs.Exec()) return SongList();
+
+  SongList ret;
+
+  for (int i = 0; i < songs.count(); i += songs_per_statement) {
+    const SongList chunk = songs.mid(i, songs_per_statement);
+
+    std::unique_ptr<SqliteQuery> partial_query;
+    SqliteQuery* q = &add_songs;
+    if (chunk.count() != songs_per_statement) {
+      partial_query.reset(new SqliteQuery(
+          MultiRowInsertSql(songs_table_, Song::kColumnSpec, columns,
+                            chunk.count()),
+          db));
+      if (!partial_query->Exec()) break;
+      q = partial_query.get();
+    }
+
+    q->Reset();
+    for (const Song& song : chunk) {
+      for (const QVariant& value : song.ColumnValues()) {
+        q->AddBindValue(value);
+      }
+    }
+    if (!q->Run()) continue;
+
+    // The rows were numbered consecutively, so we can work out every song's
+    // ID from the last one.
+    const int first_id = int(q->LastInsertId()) - chunk.count() + 1;
+    for (int j = 0; j < chunk.count(); ++j) {
+      Song copy(chunk[j]);
+      copy.set_id(first_id + j);
+      ret << copy;
+    }
+  }
+
+  return ret;
+}
+
+SongList LibraryBackend::InsertSongsWithIds(const SongList& songs,
+                                            const QList<int>& ids,
+                                            QSqlDatabase& db) {
+  SqliteQuery add_song(MultiRowInsertSql(songs_table_,
+                                         "ROWID, " + Song::kColumnSpec,
+                                         Song::kColumns.count() + 1, 1),
+                       db);
+  if (!add_song.Exec()) return SongList();
+
+  SongList ret;
+
+  for (int i = 0; i < songs.count() && i < ids.count(); ++i) {
+    add_song.Reset();
+    add_song.AddBindValue(ids[i]);
+    for (const QVariant& value : songs[i].ColumnValues()) {
+      add_song.AddBindValue(value);
+    }
+    if (!add_song.Run()) continue;
+
+    Song copy(songs[i]);
+    copy.set_id(ids[i]);
+    ret << copy;
+  }
+
+  return ret;
+}
+
+QList<int> LibraryBackend::UnusedSongIds(int count, QSqlDatabase& db) {
+  const qint64 kMaxId = std::numeric_limits<int>::max();
+  QList<int> ret;
+
+  SqliteQuery q(QString("SELECT ROWID FROM %1"
+                        " WHERE ROWID BETWEEN 1 AND %2 ORDER BY ROWID")
+                    .arg(songs_table_)
+                    .arg(kMaxId),
+                db);
+  if (!q.Exec()) return ret;
+
+  // Collect the gaps between the IDs that are used, and then the IDs after
+  // the last one.
+  qint64 next = 1;
+  while (ret.count() < count && q.Next()) {
+    const qint64 used = q.Int64(0);
+    for (; next < used && ret.count() < count; ++next) ret << int(next);
+    next = used + 1;
+  }
+  for (; next <= kMaxId && ret.count() < count; ++next) ret << int(next);
+
+  if (ret.count() < count) {
+    qLog(Error) << "No more song IDs left in" << songs_table_;
+  }
+  return ret;
+}
+
+void LibraryBackend::InsertFtsRows(const SongList& songs, QSqlDatabase& db) {
+  const int columns = Song::kFtsColumns.count() + 1;
+  const int songs_per_statement = qMax(1, kMaxBindValues / columns);
+  const QString column_spec = "ROWID, " + Song::kFtsColumnSpec;
+
+  SqliteQuery add_songs(MultiRowInsertSql(fts_table_, column_spec, columns,
+                                          songs_per_statement),
+                        db);
+  if (!add_songs.Exec()) return;
+
+  for (int i = 0; i < songs.count(); i += songs_per_statement) {
+    const SongList chunk = songs.mid(i, songs_per_statement);
+
+    std::unique_ptr<SqliteQuery> partial_query;
+    SqliteQuery* q = &add_songs;
+    if (chunk.count() != songs_per_statement) {
+      partial_query.reset(new SqliteQuery(
+          MultiRowInsertSql(fts_table_, column_spec, columns, chunk.count()),
+          db));
+      if (!partial_query->Exec()) return;
+      q = partial_query.get();
+    }
+
+    q->Reset();
+    for (const Song& song : chunk) {
+      q->AddBindValue(song.id());
+      for (const QVariant& value : song.FtsColumnValues()) {
+        q->AddBindValue(value);
+      }
+    }
+    q->Run();
+  }
+}
+
 void LibraryBackend::UpdateMTimesOnly(const SongList& songs) {
-  QMutexLocker l(db_->Mutex());
+  Database::WriteLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
 
   QSqlQuery q(QString("UPDATE %1 SET mtime = :mtime WHERE ROWID = :id")
@@ -455,7 +724,7 @@ void LibraryBackend::UpdateMTimesOnly(const SongList& songs) {
 }
 
 void LibraryBackend::DeleteSongs(const SongList& songs) {
-  QMutexLocker l(db_->Mutex());
+  Database::WriteLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
 
   QSqlQuery remove(
@@ -480,9 +749,56 @@ void LibraryBackend::DeleteSongs(const SongList& songs) {
   UpdateTotalSongCountAsync();
 }
 
+namespace {
+
+// Devices don't say whether a track's tags have changed, so compare
+// everything they give us.
+bool IsSameSong(const Song& a, const Song& b) {
+  return a.filesize() == b.filesize() && a.mtime() == b.mtime() &&
+         a.ctime() == b.ctime() && a.filetype() == b.filetype() &&
+         a.playcount() == b.playcount() && a.skipcount() == b.skipcount() &&
+         a.lastplayed() == b.lastplayed() && a.IsMetadataEqual(b);
+}
+
+}  // namespace
+
+void LibraryBackend::ReplaceSongsInDirectory(int directory_id,
+                                             const SongList& songs) {
+  QHash<QUrl, Song> old_songs;
+  SongList deleted_songs;
+  for (const Song& song : FindSongsInDirectory(directory_id)) {
+    if (old_songs.contains(song.url())) {
+      // Only one song can have each url.
+      deleted_songs << song;
+    } else {
+      old_songs.insert(song.url(), song);
+    }
+  }
+
+  SongList changed_songs;
+  for (const Song& song : songs) {
+    QHash<QUrl, Song>::iterator it = old_songs.find(song.url());
+    if (it == old_songs.end()) {
+      changed_songs << song;
+      continue;
+    }
+
+    if (!IsSameSong(*it, song)) {
+      Song copy(song);
+      copy.set_id(it->id());
+      changed_songs << copy;
+    }
+    old_songs.erase(it);
+  }
+  deleted_songs << old_songs.values();
+
+  if (!deleted_songs.isEmpty()) DeleteSongs(deleted_songs);
+  if (!changed_songs.isEmpty()) AddOrUpdateSongs(changed_songs);
+}
+
 void LibraryBackend::MarkSongsUnavailable(const SongList& songs,
                                           bool unavailable) {
-  QMutexLocker l(db_->Mutex());
+  Database::WriteLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
 
   QSqlQuery remove(QString("UPDATE %1 SET unavailable = %2 WHERE ROWID = :id")
@@ -508,7 +824,7 @@ QStringList LibraryBackend::GetAll(const QString& column,
   query.SetColumnSpec("DISTINCT " + column);
   query.AddCompilationRequirement(false);
 
-  QMutexLocker l(db_->Mutex());
+  Database::ReadLocker l(db_, Q_FUNC_INFO);
   if (!ExecQuery(&query)) return QStringList();
 
   QStringList ret;
@@ -528,7 +844,7 @@ QStringList LibraryBackend::GetAllArtistsWithAlbums(const QueryOptions& opt) {
   query.AddCompilationRequirement(false);
   query.AddWhere("album", "", "!=");
 
-  QMutexLocker l(db_->Mutex());
+  Database::ReadLocker l(db_, Q_FUNC_INFO);
   if (!ExecQuery(&query)) return QStringList();
 
   QStringList ret;
@@ -567,26 +883,31 @@ SongList LibraryBackend::GetSongs(const QString& artist, const QString& album,
 
 SongList LibraryBackend::ExecLibraryQuery(LibraryQuery* query) {
   query->SetColumnSpec("%songs_table.ROWID, " + Song::kColumnSpec);
-  QMutexLocker l(db_->Mutex());
-  if (!ExecQuery(query)) return SongList();
+  Database::ReadLocker l(db_, Q_FUNC_INFO);
+
+  SqliteQuery q(query->GetSql(songs_table_, fts_table_), db_->Connect());
+  for (const QVariant& value : query->bound_values()) {
+    q.AddBindValue(value);
+  }
+  if (!q.Exec()) return SongList();
 
   SongList ret;
-  while (query->Next()) {
+  while (q.Next()) {
     Song song;
-    song.InitFromQuery(*query, true);
+    song.InitFromQuery(q, true);
     ret << song;
   }
   return ret;
 }
 
 Song LibraryBackend::GetSongById(int id) {
-  QMutexLocker l(db_->Mutex());
+  Database::ReadLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
   return GetSongById(id, db);
 }
 
 SongList LibraryBackend::GetSongsById(const QList<int>& ids) {
-  QMutexLocker l(db_->Mutex());
+  Database::ReadLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
 
   QStringList str_ids;
@@ -598,7 +919,7 @@ SongList LibraryBackend::GetSongsById(const QList<int>& ids) {
 }
 
 SongList LibraryBackend::GetSongsById(const QStringList& ids) {
-  QMutexLocker l(db_->Mutex());
+  Database::ReadLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
 
   return GetSongsById(ids, db);
@@ -607,7 +928,7 @@ SongList LibraryBackend::GetSongsById(const QStringList& ids) {
 SongList LibraryBackend::GetSongsByForeignId(const QStringList& ids,
                                              const QString& table,
                                              const QString& column) {
-  QMutexLocker l(db_->Mutex());
+  Database::ReadLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
 
   QString in = ids.join(",");
@@ -702,7 +1023,7 @@ SongList LibraryBackend::GetCompilationSongs(const QString& album,
   query.AddCompilationRequirement(true);
   query.AddWhere("album", album);
 
-  QMutexLocker l(db_->Mutex());
+  Database::ReadLocker l(db_, Q_FUNC_INFO);
   if (!ExecQuery(&query)) return SongList();
 
   SongList ret;
@@ -715,7 +1036,7 @@ SongList LibraryBackend::GetCompilationSongs(const QString& album,
 }
 
 void LibraryBackend::UpdateCompilations() {
-  QMutexLocker l(db_->Mutex());
+  Database::WriteLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
 
   // Look for albums that have songs by more than one 'effective album artist'
@@ -847,7 +1168,7 @@ LibraryBackend::AlbumList LibraryBackend::GetAlbums(const QString& artist,
     query.AddWhere("artist", artist);
   }
 
-  QMutexLocker l(db_->Mutex());
+  Database::ReadLocker l(db_, Q_FUNC_INFO);
   if (!ExecQuery(&query)) return ret;
 
   QString last_album;
@@ -884,7 +1205,7 @@ LibraryBackend::Album LibraryBackend::GetAlbumArt(const QString& artist,
   query.AddWhere("artist", artist);
   query.AddWhere("album", album);
 
-  QMutexLocker l(db_->Mutex());
+  Database::ReadLocker l(db_, Q_FUNC_INFO);
   if (!ExecQuery(&query)) return ret;
 
   if (query.Next()) {
@@ -907,7 +1228,7 @@ void LibraryBackend::UpdateManualAlbumArtAsync(const QString& artist,
 void LibraryBackend::UpdateManualAlbumArt(const QString& artist,
                                           const QString& album,
                                           const QString& art) {
-  QMutexLocker l(db_->Mutex());
+  Database::WriteLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
 
   // Get the songs before they're updated
@@ -958,7 +1279,7 @@ void LibraryBackend::UpdateManualAlbumArt(const QString& artist,
 
 void LibraryBackend::ForceCompilation(const QString& album,
                                       const QList<QString>& artists, bool on) {
-  QMutexLocker l(db_->Mutex());
+  Database::WriteLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
   SongList deleted_songs, added_songs;
 
@@ -1017,7 +1338,7 @@ bool LibraryBackend::ExecQuery(LibraryQuery* q) {
 }
 
 SongList LibraryBackend::FindSongs(const smart_playlists::Search& search) {
-  QMutexLocker l(db_->Mutex());
+  Database::ReadLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
 
   // Build the query
@@ -1025,12 +1346,11 @@ SongList LibraryBackend::FindSongs(const smart_playlists::Search& search) {
 
   // Run the query
   SongList ret;
-  QSqlQuery query(sql, db);
-  query.exec();
-  if (db_->CheckErrors(query)) return ret;
+  SqliteQuery query(sql, db);
+  if (!query.Exec()) return ret;
 
   // Read the results
-  while (query.next()) {
+  while (query.Next()) {
     Song song;
     song.InitFromQuery(query, true);
     ret << song;
@@ -1046,10 +1366,37 @@ SongList LibraryBackend::GetAllSongs() {
       smart_playlists::SearchTerm::Field_Artist, -1));
 }
 
+void LibraryBackend::GetRevision(QString* library_id, qint64* revision) {
+  library_id->clear();
+  *revision = 0;
+
+  Database::WriteLocker l(db_, Q_FUNC_INFO);
+  QSqlDatabase db(db_->Connect());
+
+  // Changes are logged against the next revision.  If there are any, start a
+  // new revision so that they're included in the one we return and later
+  // changes aren't.
+  QSqlQuery update(db);
+  update.exec(
+      "UPDATE library_revision SET revision = revision + 1"
+      " WHERE EXISTS (SELECT 1 FROM library_changes"
+      "               WHERE library_changes.revision >"
+      "                     library_revision.revision)");
+  if (db_->CheckErrors(update)) return;
+
+  QSqlQuery q(db);
+  q.exec("SELECT library_id, revision FROM library_revision");
+  if (db_->CheckErrors(q)) return;
+  if (!q.next()) return;
+
+  *library_id = q.value(0).toString();
+  *revision = q.value(1).toLongLong();
+}
+
 void LibraryBackend::IncrementPlayCount(int id) {
   if (id == -1) return;
 
-  QMutexLocker l(db_->Mutex());
+  Database::WriteLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
 
   QSqlQuery q(QString(
@@ -1072,7 +1419,7 @@ void LibraryBackend::IncrementSkipCount(int id, float progress) {
   if (id == -1) return;
   progress = qBound(0.0f, progress, 1.0f);
 
-  QMutexLocker l(db_->Mutex());
+  Database::WriteLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
 
   QSqlQuery q(QString(
@@ -1092,7 +1439,7 @@ void LibraryBackend::IncrementSkipCount(int id, float progress) {
 void LibraryBackend::ResetStatistics(int id) {
   if (id == -1) return;
 
-  QMutexLocker l(db_->Mutex());
+  Database::WriteLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
 
   QSqlQuery q(QString(
@@ -1120,7 +1467,7 @@ void LibraryBackend::UpdateSongsRating(const QList<int>& id_list,
                                        float rating) {
   if (id_list.isEmpty()) return;
 
-  QMutexLocker l(db_->Mutex());
+  Database::WriteLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
 
   QStringList id_str_list;
@@ -1141,7 +1488,7 @@ void LibraryBackend::UpdateSongsRating(const QList<int>& id_list,
 
 void LibraryBackend::DeleteAll() {
   {
-    QMutexLocker l(db_->Mutex());
+    Database::WriteLocker l(db_, Q_FUNC_INFO);
     QSqlDatabase db(db_->Connect());
     ScopedTransaction t(&db);
 
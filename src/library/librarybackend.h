@@ -121,6 +121,10 @@ class LibraryBackend : public LibraryBackendInterface {
  public:
   static const char* kSettingsGroup;
 
+  // The largest number of values that can be bound to one SQLite statement.
+  // This is SQLITE_MAX_VARIABLE_NUMBER's default value.
+  static const int kMaxBindValues;
+
   Q_INVOKABLE LibraryBackend(QObject* parent = nullptr);
   void Init(Database* db, const QString& songs_table, const QString& dirs_table,
             const QString& subdirs_table, const QString& fts_table);
@@ -131,6 +135,17 @@ class LibraryBackend : public LibraryBackendInterface {
   QString dirs_table() const { return dirs_table_; }
   QString subdirs_table() const { return subdirs_table_; }
 
+  // The journal records subdirectories that changed on disk but haven't been
+  // scanned yet.  Backends without a journal table don't keep one.
+  void set_journal_table(const QString& table) { journal_table_ = table; }
+  QString journal_table() const { return journal_table_; }
+  QStringList JournalledSubdirs(int directory_id);
+
+  // When enabled (the default), AddOrUpdateSongs inserts new songs with
+  // multi-row INSERT statements and fills in the FTS index after all the songs
+  // have been added.
+  void set_bulk_insert_enabled(bool enabled) { bulk_insert_enabled_ = enabled; }
+
   // Get a list of directories in the library.  Emits DirectoriesDiscovered.
   void LoadDirectoriesAsync();
 
@@ -180,6 +195,12 @@ class LibraryBackend : public LibraryBackendInterface {
   SongList FindSongs(const smart_playlists::Search& search);
   SongList GetAllSongs();
 
+  // Returns the library's current revision.  Songs that have been added,
+  // deleted or retagged since the last call are in a new revision, changes to
+  // their statistics are not.  The library id is random and identifies this
+  // database, so that revisions from different libraries are never compared.
+  void GetRevision(QString* library_id, qint64* revision);
+
   void IncrementPlayCountAsync(int id);
   void IncrementSkipCountAsync(int id, float progress);
   void ResetStatisticsAsync(int id);
@@ -194,8 +215,17 @@ class LibraryBackend : public LibraryBackendInterface {
   void AddOrUpdateSongs(const SongList& songs);
   void UpdateMTimesOnly(const SongList& songs);
   void DeleteSongs(const SongList& songs);
+  // Makes the songs in the directory the same as the given songs, which are
+  // matched to the existing ones by url.  Only songs that were added, removed
+  // or changed are written.  Used by devices, which load every song they have
+  // each time they're connected.
+  void ReplaceSongsInDirectory(int directory_id, const SongList& songs);
   void MarkSongsUnavailable(const SongList& songs, bool unavailable = true);
   void AddOrUpdateSubdirs(const SubdirectoryList& subdirs);
+  void AddToJournal(int directory_id, const QString& path);
+  // Removes the subdirectories from the journal, unless they changed again
+  // after scan_started (in msecs since the epoch).
+  void RemoveFromJournal(const QStringList& paths, qint64 scan_started);
   void UpdateCompilations();
   void UpdateManualAlbumArt(const QString& artist, const QString& album,
                             const QString& art);
@@ -240,6 +270,22 @@ signals:
                       const QueryOptions& opt = QueryOptions());
   SubdirectoryList SubdirsInDirectory(int id, QSqlDatabase& db);
 
+  // Inserts new songs into the songs and FTS tables, several rows per
+  // statement.  Returns the songs that were added, with their new IDs.  Must
+  // be called with the database mutex held, inside a transaction.
+  SongList BulkInsertSongs(const SongList& songs, QSqlDatabase& db);
+  // Lets SQLite number the rows, which it does consecutively.
+  SongList InsertConsecutiveSongs(const SongList& songs, QSqlDatabase& db);
+  // Inserts the songs one at a time with the given IDs.
+  SongList InsertSongsWithIds(const SongList& songs, const QList<int>& ids,
+                              QSqlDatabase& db);
+  // The lowest IDs that aren't used by any song.
+  QList<int> UnusedSongIds(int count, QSqlDatabase& db);
+  void InsertFtsRows(const SongList& songs, QSqlDatabase& db);
+  static QString MultiRowInsertSql(const QString& table,
+                                   const QString& column_spec, int columns,
+                                   int rows);
+
   Song GetSongById(int id, QSqlDatabase& db);
   SongList GetSongsById(const QStringList& ids, QSqlDatabase& db);
 
@@ -249,6 +295,8 @@ signals:
   QString dirs_table_;
   QString subdirs_table_;
   QString fts_table_;
+  QString journal_table_;
+  bool bulk_insert_enabled_;
   bool save_statistics_in_file_;
   bool save_ratings_in_file_;
 };
@@ -21,10 +21,7 @@
 
 #include <QFuture>
 #include <QFutureWatcher>
-#include <QIODevice>
 #include <QMetaEnum>
-#include <QNetworkCacheMetaData>
-#include <QNetworkDiskCache>
 #include <QPixmapCache>
 #include <QSettings>
 #include <QStringList>
@@ -37,11 +34,12 @@
 #include "libraryview.h"
 #include "sqlrow.h"
 #include "core/application.h"
+#include "core/closure.h"
 #include "core/database.h"
 #include "core/logging.h"
 #include "core/taskmanager.h"
-#include "core/utilities.h"
 #include "covers/albumcoverloader.h"
+#include "covers/thumbnailstore.h"
 #include "playlist/songmimedata.h"
 #include "smartplaylists/generator.h"
 #include "smartplaylists/generatormimedata.h"
@@ -62,9 +60,10 @@ const char* LibraryModel::kSmartPlaylistsSettingsGroup =
     "SerialisedSmartPlaylists";
 const int LibraryModel::kSmartPlaylistsVersion = 4;
 const int LibraryModel::kPrettyCoverSize = 32;
-const qint64 LibraryModel::kIconCacheSize = 100000000;  //~100MB
 typedef QFuture<LibraryModel::QueryResult> RootQueryFuture;
 typedef QFutureWatcher<LibraryModel::QueryResult> RootQueryWatcher;
+typedef QFuture<LibraryModel::UpdateResults> UpdateQueryFuture;
+typedef QFutureWatcher<LibraryModel::UpdateResults> UpdateQueryWatcher;
 
 static bool IsArtistGroupBy(const LibraryModel::GroupBy by) {
   return by == LibraryModel::GroupBy_Artist ||
@@ -88,8 +87,9 @@ LibraryModel::LibraryModel(LibraryBackend* backend, Application* app,
       album_icon_(":/icons/22x22/x-clementine-album.png"),
       playlists_dir_icon_(IconLoader::Load("folder-sound")),
       playlist_icon_(":/icons/22x22/x-clementine-albums.png"),
-      icon_cache_(new QNetworkDiskCache(this)),
       init_task_id_(-1),
+      root_query_id_(0),
+      resetting_(false),
       use_pretty_covers_(false),
       show_dividers_(true) {
   root_->lazy_loaded = true;
@@ -101,14 +101,11 @@ LibraryModel::LibraryModel(LibraryBackend* backend, Application* app,
   cover_loader_options_.desired_height_ = kPrettyCoverSize;
   cover_loader_options_.pad_output_image_ = true;
   cover_loader_options_.scale_output_image_ = true;
+  cover_loader_options_.priority_ = AlbumCoverLoaderOptions::Priority_Visible;
 
   connect(app_->album_cover_loader(), SIGNAL(ImageLoaded(quint64, QImage)),
           SLOT(AlbumArtLoaded(quint64, QImage)));
 
-  icon_cache_->setCacheDirectory(
-      Utilities::GetConfigPath(Utilities::Path_CacheRoot) + "/pixmapcache");
-  icon_cache_->setMaximumCacheSize(LibraryModel::kIconCacheSize);
-
   no_cover_icon_ = QPixmap(":nocover.png")
                        .scaled(kPrettyCoverSize, kPrettyCoverSize,
                                Qt::KeepAspectRatio, Qt::SmoothTransformation);
@@ -163,13 +160,20 @@ void LibraryModel::Init(bool async) {
 }
 
 void LibraryModel::SongsDiscovered(const SongList& songs) {
+  // Songs that go in containers that have already been lazy loaded, grouped by
+  // container so each container gets one insert.
+  QMap<LibraryItem*, SongList> new_songs;
+  QSet<int> new_song_ids;
+
   for (const Song& song : songs) {
     // Sanity check to make sure we don't add songs that are outside the user's
     // filter
     if (!query_options_.Matches(song)) continue;
 
     // Hey, we've already got that one!
-    if (song_nodes_.contains(song.id())) continue;
+    if (song_nodes_.contains(song.id()) || new_song_ids.contains(song.id())) {
+      continue;
+    }
 
     // Before we can add each song we need to make sure the required container
     // items already exist in the tree.  These depend on which "group by"
@@ -259,8 +263,22 @@ void LibraryModel::SongsDiscovered(const SongList& songs) {
 
     // We've gone all the way down to the deepest level and everything was
     // already lazy loaded, so now we have to create the song in the container.
-    song_nodes_[song.id()] =
-        ItemFromSong(GroupBy_None, true, false, container, song, -1);
+    new_songs[container] << song;
+    new_song_ids << song.id();
+  }
+
+  for (QMap<LibraryItem*, SongList>::const_iterator it = new_songs.constBegin();
+       it != new_songs.constEnd(); ++it) {
+    LibraryItem* container = it.key();
+    const int first_row = container->children.count();
+
+    beginInsertRows(ItemToIndex(container), first_row,
+                    first_row + it.value().count() - 1);
+    for (const Song& song : it.value()) {
+      song_nodes_[song.id()] =
+          ItemFromSong(GroupBy_None, false, false, container, song, -1);
+    }
+    endInsertRows();
   }
 }
 
@@ -458,12 +476,13 @@ void LibraryModel::SongsDeleted(const SongList& songs) {
   }
 }
 
-QString LibraryModel::AlbumIconPixmapCacheKey(const QModelIndex& index) const {
+QString LibraryModel::AlbumIconCacheKey(const LibraryItem* item) const {
+  // Use the keys of the containers rather than their display text - they're
+  // already in memory and don't need formatting.
   QStringList path;
-  QModelIndex index_copy(index);
-  while (index_copy.isValid()) {
-    path.prepend(index_copy.data().toString());
-    index_copy = index_copy.parent();
+  for (; item && item != root_; item = item->parent) {
+    path.prepend(QString::number(group_by_[item->container_level]) + ":" +
+                 item->key);
   }
 
   return "libraryart:" + path.join("/");
@@ -474,34 +493,42 @@ QVariant LibraryModel::AlbumIcon(const QModelIndex& index) {
   if (!item) return no_cover_icon_;
 
   // Check the cache for a pixmap we already loaded.
-  const QString cache_key = AlbumIconPixmapCacheKey(index);
+  const QString cache_key = AlbumIconCacheKey(item);
   QPixmap cached_pixmap;
   if (QPixmapCache::find(cache_key, &cached_pixmap)) {
     return cached_pixmap;
   }
 
-  // Try to load it from the disk cache
-  std::unique_ptr<QIODevice> cache(icon_cache_->data(QUrl(cache_key)));
-  if (cache) {
-    QImage cached_pixmap;
-    if (cached_pixmap.load(cache.get(), "XPM")) {
-      QPixmapCache::insert(cache_key, QPixmap::fromImage(cached_pixmap));
-      return QPixmap::fromImage(cached_pixmap);
-    }
-  }
-
   // Maybe we're loading a pixmap already?
   if (pending_cache_keys_.contains(cache_key)) {
     return no_cover_icon_;
   }
 
-  // No art is cached and we're not loading it already.  Load art for the first
-  // Song in the album.
+  // Look for art for the first Song in the album in the thumbnail store -
+  // another album or the global search might have used it already.  The
+  // thumbnails are keyed by the art rather than by this item so that they're
+  // stamped with the art file's modification time and go stale when it
+  // changes.
   SongList songs = GetChildSongs(index);
   if (!songs.isEmpty()) {
+    PendingArt pending;
+    pending.item = item;
+    pending.cache_key = cache_key;
+    pending.art_key = ThumbnailStore::ArtKey(songs.first());
+    pending.art_stamp = ThumbnailStore::ArtStamp(songs.first());
+
+    QImage cached_image;
+    if (app_->thumbnail_store()->Find(ThumbnailStore::kSmallSize,
+                                      pending.art_key, pending.art_stamp,
+                                      &cached_image)) {
+      cached_pixmap = QPixmap::fromImage(cached_image);
+      QPixmapCache::insert(cache_key, cached_pixmap);
+      return cached_pixmap;
+    }
+
     const quint64 id = app_->album_cover_loader()->LoadImageAsync(
         cover_loader_options_, songs.first());
-    pending_art_[id] = ItemAndCacheKey(item, cache_key);
+    pending_art_[id] = pending;
     pending_cache_keys_.insert(cache_key);
   }
 
@@ -509,35 +536,23 @@ QVariant LibraryModel::AlbumIcon(const QModelIndex& index) {
 }
 
 void LibraryModel::AlbumArtLoaded(quint64 id, const QImage& image) {
-  ItemAndCacheKey item_and_cache_key = pending_art_.take(id);
-  LibraryItem* item = item_and_cache_key.first;
-  const QString& cache_key = item_and_cache_key.second;
-  if (!item) return;
+  const PendingArt pending = pending_art_.take(id);
+  if (!pending.item) return;
 
-  pending_cache_keys_.remove(cache_key);
+  pending_cache_keys_.remove(pending.cache_key);
 
   // Insert this image in the cache.
   if (image.isNull()) {
     // Set the no_cover image so we don't continually try to load art.
-    QPixmapCache::insert(cache_key, no_cover_icon_);
+    QPixmapCache::insert(pending.cache_key, no_cover_icon_);
   } else {
-    QPixmapCache::insert(cache_key, QPixmap::fromImage(image));
-  }
+    QPixmapCache::insert(pending.cache_key, QPixmap::fromImage(image));
 
-  // if not already in the disk cache
-  std::unique_ptr<QIODevice> cached_img(icon_cache_->data(QUrl(cache_key)));
-  if (!cached_img) {
-    QNetworkCacheMetaData item_metadata;
-    item_metadata.setSaveToDisk(true);
-    item_metadata.setUrl(QUrl(cache_key));
-    QIODevice* cache = icon_cache_->prepare(item_metadata);
-    if (cache) {
-      image.save(cache, "XPM");
-      icon_cache_->insert(cache);
-    }
+    app_->thumbnail_store()->Insert(ThumbnailStore::kSmallSize,
+                                    pending.art_key, pending.art_stamp, image);
   }
 
-  const QModelIndex index = ItemToIndex(item);
+  const QModelIndex index = ItemToIndex(pending.item);
   emit dataChanged(index, index);
 }
 
@@ -652,23 +667,22 @@ bool LibraryModel::HasCompilations(const LibraryQuery& query) {
   q.AddCompilationRequirement(true);
   q.SetLimit(1);
 
-  QMutexLocker l(backend_->db()->Mutex());
+  Database::ReadLocker l(backend_->db(), Q_FUNC_INFO);
   if (!backend_->ExecQuery(&q)) return false;
 
   return q.Next();
 }
 
-LibraryModel::QueryResult LibraryModel::RunQuery(LibraryItem* parent) {
-  QueryResult result;
-
+LibraryQuery LibraryModel::ChildQuery(LibraryItem* parent,
+                                      GroupBy* child_type) {
   // Information about what we want the children to be
   int child_level = parent == root_ ? 0 : parent->container_level + 1;
-  GroupBy child_type = child_level >= 3 ? GroupBy_None : group_by_[child_level];
+  *child_type = child_level >= 3 ? GroupBy_None : group_by_[child_level];
 
   // Initialise the query.  child_type says what type of thing we want (artists,
   // songs, etc.)
   LibraryQuery q(query_options_);
-  InitQuery(child_type, &q);
+  InitQuery(*child_type, &q);
 
   // Walk up through the item's parents adding filters as necessary
   LibraryItem* p = parent;
@@ -676,6 +690,19 @@ LibraryModel::QueryResult LibraryModel::RunQuery(LibraryItem* parent) {
     FilterQuery(group_by_[p->container_level], p, &q);
     p = p->parent;
   }
+  return q;
+}
+
+LibraryModel::QueryResult LibraryModel::RunQuery(LibraryItem* parent) {
+  GroupBy child_type;
+  const LibraryQuery q = ChildQuery(parent, &child_type);
+  return RunQuery(child_type, q);
+}
+
+LibraryModel::QueryResult LibraryModel::RunQuery(GroupBy child_type,
+                                                 const LibraryQuery& query) {
+  QueryResult result;
+  LibraryQuery q = query;
 
   // Artists GroupBy is special - we don't want compilation albums appearing
   if (IsArtistGroupBy(child_type)) {
@@ -688,8 +715,15 @@ LibraryModel::QueryResult LibraryModel::RunQuery(LibraryItem* parent) {
     q.AddCompilationRequirement(false);
   }
 
+  // Songs are decoded straight from SQLite.  The other queries only return a
+  // column or two, so they're kept as rows.
+  if (child_type == GroupBy_None) {
+    result.songs = backend_->ExecLibraryQuery(&q);
+    return result;
+  }
+
   // Execute the query
-  QMutexLocker l(backend_->db()->Mutex());
+  Database::ReadLocker l(backend_->db(), Q_FUNC_INFO);
   if (!backend_->ExecQuery(&q)) return result;
 
   while (q.Next()) {
@@ -716,10 +750,13 @@ void LibraryModel::PostQuery(LibraryItem* parent,
                                       parent, row, child_level);
 
     // Save a pointer to it for later
-    if (child_type == GroupBy_None)
-      song_nodes_[item->metadata.id()] = item;
-    else
-      container_nodes_[child_level][item->key] = item;
+    container_nodes_[child_level][item->key] = item;
+  }
+
+  for (const Song& song : result.songs) {
+    LibraryItem* item = ItemFromSong(GroupBy_None, signal, child_level == 0,
+                                     parent, song, child_level);
+    song_nodes_[song.id()] = item;
   }
 }
 
@@ -732,19 +769,28 @@ void LibraryModel::LazyPopulate(LibraryItem* parent, bool signal) {
 }
 
 void LibraryModel::ResetAsync() {
+  resetting_ = true;
+
   RootQueryFuture future =
       QtConcurrent::run(this, &LibraryModel::RunQuery, root_);
   RootQueryWatcher* watcher = new RootQueryWatcher(this);
   watcher->setFuture(future);
 
-  connect(watcher, SIGNAL(finished()), SLOT(ResetAsyncQueryFinished()));
+  NewClosure(watcher, SIGNAL(finished()), this,
+             SLOT(ResetAsyncQueryFinished(
+                 QFutureWatcher<LibraryModel::QueryResult>*, int)),
+             watcher, ++root_query_id_);
 }
 
-void LibraryModel::ResetAsyncQueryFinished() {
-  RootQueryWatcher* watcher = static_cast<RootQueryWatcher*>(sender());
+void LibraryModel::ResetAsyncQueryFinished(RootQueryWatcher* watcher,
+                                           int query_id) {
   const struct QueryResult result = watcher->result();
   watcher->deleteLater();
 
+  // Another query was started after this one, so this result is out of date.
+  if (query_id != root_query_id_) return;
+  resetting_ = false;
+
   BeginReset();
   root_->lazy_loaded = true;
 
@@ -758,6 +804,255 @@ void LibraryModel::ResetAsyncQueryFinished() {
   endResetModel();
 }
 
+void LibraryModel::AddUpdateQueries(LibraryItem* parent,
+                                    QList<ContainerQuery>* queries) {
+  ContainerQuery query;
+  query.item = parent;
+  query.key = parent->key;
+  query.query = ChildQuery(parent, &query.child_type);
+  *queries << query;
+
+  for (LibraryItem* child : parent->children) {
+    if (child->type == LibraryItem::Type_Container && child->lazy_loaded) {
+      AddUpdateQueries(child, queries);
+    }
+  }
+}
+
+LibraryModel::UpdateResults LibraryModel::RunUpdateQueries(
+    const QList<ContainerQuery>& queries) {
+  UpdateResults results;
+  for (const ContainerQuery& query : queries) {
+    UpdateResult& result = results[query.item];
+    result.key = query.key;
+    result.result = RunQuery(query.child_type, query.query);
+  }
+  return results;
+}
+
+void LibraryModel::Update() {
+  QList<ContainerQuery> queries;
+  AddUpdateQueries(root_, &queries);
+  ApplyUpdate(RunUpdateQueries(queries));
+}
+
+void LibraryModel::UpdateAsync() {
+  // If the tree is about to be replaced anyway it's no use updating it - the
+  // new one might even be grouped differently.
+  if (resetting_) {
+    ResetAsync();
+    return;
+  }
+
+  // The queries are made here, where it's safe to look at the items, and
+  // they're all run in the background.
+  QList<ContainerQuery> queries;
+  AddUpdateQueries(root_, &queries);
+
+  UpdateQueryFuture future =
+      QtConcurrent::run(this, &LibraryModel::RunUpdateQueries, queries);
+  UpdateQueryWatcher* watcher = new UpdateQueryWatcher(this);
+  watcher->setFuture(future);
+
+  NewClosure(watcher, SIGNAL(finished()), this,
+             SLOT(UpdateAsyncQueryFinished(
+                 QFutureWatcher<LibraryModel::UpdateResults>*, int)),
+             watcher, ++root_query_id_);
+}
+
+void LibraryModel::UpdateAsyncQueryFinished(UpdateQueryWatcher* watcher,
+                                            int query_id) {
+  const UpdateResults results = watcher->result();
+  watcher->deleteLater();
+
+  if (query_id != root_query_id_) return;
+
+  ApplyUpdate(results);
+}
+
+void LibraryModel::ApplyUpdate(const UpdateResults& results) {
+  UpdateChildren(root_, results[root_].result, results);
+
+  // Remove the dividers that don't have anything under them any more.  New
+  // ones were created along with their first item.
+  if (show_dividers_) {
+    QSet<QString> divider_keys;
+    for (LibraryItem* node : root_->children) {
+      if (node->type == LibraryItem::Type_Divider ||
+          node->type == LibraryItem::Type_PlaylistContainer ||
+          IsCompilationArtistNode(node)) {
+        continue;
+      }
+      divider_keys << DividerKey(group_by_[0], node);
+    }
+
+    for (const QString& divider_key : divider_nodes_.keys()) {
+      if (!divider_keys.contains(divider_key)) {
+        RemoveItem(divider_nodes_.take(divider_key));
+      }
+    }
+  }
+
+  // Smart playlists are only shown when there's no filter.
+  const bool show_smart_playlists =
+      show_smart_playlists_ && query_options_.filter().isEmpty();
+  if (smart_playlist_node_ && !show_smart_playlists) {
+    RemoveItem(smart_playlist_node_);
+  } else if (!smart_playlist_node_ && show_smart_playlists) {
+    beginInsertRows(QModelIndex(), root_->children.count(),
+                    root_->children.count());
+    CreateSmartPlaylists();
+    endInsertRows();
+  }
+}
+
+QString LibraryModel::ChildKey(GroupBy type, const SqlRow& row) const {
+  LibraryItem item(LibraryItem::Type_Container);
+  ItemDataFromQuery(type, row, &item);
+  return item.key;
+}
+
+void LibraryModel::UpdateChildren(LibraryItem* parent,
+                                  const QueryResult& result,
+                                  const UpdateResults& results) {
+  // Information about what we want the children to be
+  const int child_level = parent == root_ ? 0 : parent->container_level + 1;
+  const GroupBy child_type =
+      child_level >= 3 ? GroupBy_None : group_by_[child_level];
+
+  // Find out which of the rows are in the tree already
+  QHash<QString, LibraryItem*> existing;
+  for (LibraryItem* child : parent->children) {
+    if (child->type == LibraryItem::Type_Song) {
+      existing[QString::number(child->metadata.id())] = child;
+    } else if (child->type == LibraryItem::Type_Container &&
+               !IsCompilationArtistNode(child)) {
+      existing[child->key] = child;
+    }
+  }
+
+  QSet<LibraryItem*> kept;
+  QList<const SqlRow*> new_rows;
+  for (const SqlRow& row : result.rows) {
+    LibraryItem* child = existing.value(ChildKey(child_type, row));
+    if (child) {
+      kept << child;
+    } else {
+      new_rows << &row;
+    }
+  }
+  QList<const Song*> new_songs;
+  for (const Song& song : result.songs) {
+    LibraryItem* child = existing.value(QString::number(song.id()));
+    if (child) {
+      kept << child;
+    } else {
+      new_songs << &song;
+    }
+  }
+
+  // Remove the children that aren't in the result.  Go backwards so the
+  // children we haven't looked at yet keep their rows.
+  for (int i = parent->children.count() - 1; i >= 0; --i) {
+    LibraryItem* child = parent->children[i];
+    switch (child->type) {
+      case LibraryItem::Type_Song:
+      case LibraryItem::Type_Container:
+        if (IsCompilationArtistNode(child) ? !result.create_va
+                                           : !kept.contains(child)) {
+          RemoveItem(child);
+        }
+        break;
+
+      case LibraryItem::Type_LoadingIndicator:
+        RemoveItem(child);
+        break;
+
+      default:
+        // Dividers and smart playlists are dealt with by the caller.
+        break;
+    }
+  }
+
+  // Add the new ones
+  if (result.create_va && !parent->compilation_artist_node_) {
+    CreateCompilationArtistNode(true, parent);
+  }
+
+  for (const SqlRow* row : new_rows) {
+    LibraryItem* item = ItemFromQuery(child_type, true, child_level == 0,
+                                      parent, *row, child_level);
+    container_nodes_[child_level][item->key] = item;
+  }
+
+  for (const Song* song : new_songs) {
+    LibraryItem* item = ItemFromSong(GroupBy_None, true, child_level == 0,
+                                     parent, *song, child_level);
+    song_nodes_[song->id()] = item;
+  }
+
+  // The filter might have changed what's inside the children that were kept.
+  // The new ones and the ones that haven't been loaded yet will be queried
+  // with the new filter when they're expanded, and so were the ones that were
+  // loaded after the update started.
+  QList<LibraryItem*> loaded_children;
+  for (LibraryItem* child : parent->children) {
+    if (child->type != LibraryItem::Type_Container || !child->lazy_loaded) {
+      continue;
+    }
+    UpdateResults::const_iterator it = results.constFind(child);
+    if (it != results.constEnd() && it->key == child->key) {
+      loaded_children << child;
+    }
+  }
+  for (LibraryItem* child : loaded_children) {
+    UpdateChildren(child, results[child].result, results);
+  }
+}
+
+void LibraryModel::RemoveItem(LibraryItem* item) {
+  LibraryItem* parent = item->parent;
+  if (IsCompilationArtistNode(item)) parent->compilation_artist_node_ = nullptr;
+  if (item == smart_playlist_node_) smart_playlist_node_ = nullptr;
+
+  QSet<const LibraryItem*> forgotten;
+  ForgetItem(item, &forgotten);
+
+  // Don't try to give art that's still loading to an item that's gone.
+  QMap<quint64, PendingArt>::iterator it = pending_art_.begin();
+  while (it != pending_art_.end()) {
+    if (forgotten.contains(it->item)) {
+      pending_cache_keys_.remove(it->cache_key);
+      it = pending_art_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  beginRemoveRows(ItemToIndex(parent), item->row, item->row);
+  parent->Delete(item->row);
+  endRemoveRows();
+}
+
+void LibraryModel::ForgetItem(LibraryItem* item,
+                              QSet<const LibraryItem*>* forgotten) {
+  for (LibraryItem* child : item->children) {
+    ForgetItem(child, forgotten);
+  }
+  forgotten->insert(item);
+
+  if (item->type == LibraryItem::Type_Song) {
+    if (song_nodes_.value(item->metadata.id()) == item) {
+      song_nodes_.remove(item->metadata.id());
+    }
+  } else if (item->type == LibraryItem::Type_Container &&
+             item->container_level >= 0 && item->container_level < 3) {
+    QMap<QString, LibraryItem*>& nodes =
+        container_nodes_[item->container_level];
+    if (nodes.value(item->key) == item) nodes.remove(item->key);
+  }
+}
+
 void LibraryModel::BeginReset() {
   beginResetModel();
   delete root_;
@@ -767,6 +1062,7 @@ void LibraryModel::BeginReset() {
   container_nodes_[2].clear();
   divider_nodes_.clear();
   pending_art_.clear();
+  pending_cache_keys_.clear();
   smart_playlist_node_ = nullptr;
 
   root_ = new LibraryItem(this);
@@ -932,6 +1228,13 @@ LibraryItem* LibraryModel::ItemFromQuery(GroupBy type, bool signal,
                                          LibraryItem* parent, const SqlRow& row,
                                          int container_level) {
   LibraryItem* item = InitItem(type, signal, parent, container_level);
+  ItemDataFromQuery(type, row, item);
+  FinishItem(type, signal, create_divider, parent, item);
+  return item;
+}
+
+void LibraryModel::ItemDataFromQuery(GroupBy type, const SqlRow& row,
+                                     LibraryItem* item) {
   int year = 0;
   int effective_originalyear = 0;
   int bitrate = 0;
@@ -1012,9 +1315,6 @@ LibraryItem* LibraryModel::ItemFromQuery(GroupBy type, bool signal,
       item->sort_text = SortTextForSong(item->metadata);
       break;
   }
-
-  FinishItem(type, signal, create_divider, parent, item);
-  return item;
 }
 
 LibraryItem* LibraryModel::ItemFromSong(GroupBy type, bool signal,
@@ -1290,17 +1590,20 @@ SongList LibraryModel::GetChildSongs(const QModelIndex& index) const {
 
 void LibraryModel::SetFilterAge(int age) {
   query_options_.set_max_age(age);
-  ResetAsync();
+  UpdateAsync();
 }
 
-void LibraryModel::SetFilterText(const QString& text) {
+void LibraryModel::SetFilterText(const QString& text, bool async) {
   query_options_.set_filter(text);
-  ResetAsync();
+  if (async)
+    UpdateAsync();
+  else
+    Update();
 }
 
 void LibraryModel::SetFilterQueryMode(QueryOptions::QueryMode query_mode) {
   query_options_.set_query_mode(query_mode);
-  ResetAsync();
+  UpdateAsync();
 }
 
 bool LibraryModel::canFetchMore(const QModelIndex& parent) const {
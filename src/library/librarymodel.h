@@ -19,8 +19,9 @@
 #define LIBRARYMODEL_H
 
 #include <QAbstractItemModel>
+#include <QFutureWatcher>
+#include <QHash>
 #include <QIcon>
-#include <QNetworkDiskCache>
 
 #include "libraryitem.h"
 #include "libraryquery.h"
@@ -57,7 +58,6 @@ class LibraryModel : public SimpleTreeModel<LibraryItem> {
   static const char* kSmartPlaylistsArray;
   static const int kSmartPlaylistsVersion;
   static const int kPrettyCoverSize;
-  static const qint64 kIconCacheSize;
 
   enum Role {
     Role_Type = Qt::UserRole + 1,
@@ -110,10 +110,21 @@ class LibraryModel : public SimpleTreeModel<LibraryItem> {
   struct QueryResult {
     QueryResult() : create_va(false) {}
 
+    // Containers are returned as rows, and songs as songs.
     SqlRowList rows;
+    SongList songs;
     bool create_va;
   };
 
+  // UpdateAsync queries the children of every container that has been lazy
+  // loaded, and keeps the results by container.  The container's key is kept
+  // too, to check the results are for the same container when they're used.
+  struct UpdateResult {
+    QString key;
+    QueryResult result;
+  };
+  typedef QHash<const LibraryItem*, UpdateResult> UpdateResults;
+
   LibraryBackend* backend() const { return backend_; }
   LibraryDirectoryModel* directory_model() const { return dir_model_; }
 
@@ -175,7 +186,7 @@ signals:
 
  public slots:
   void SetFilterAge(int age);
-  void SetFilterText(const QString& text);
+  void SetFilterText(const QString& text, bool async = true);
   void SetFilterQueryMode(QueryOptions::QueryMode query_mode);
 
   void SetGroupBy(const LibraryModel::Grouping& g);
@@ -183,6 +194,11 @@ signals:
   void Reset();
   void ResetAsync();
 
+  // Like Reset and ResetAsync, but instead of building a new tree they add
+  // and remove items in the existing one to make it match the current filter.
+  void Update();
+  void UpdateAsync();
+
  protected:
   void LazyPopulate(LibraryItem* item) { LazyPopulate(item, true); }
   void LazyPopulate(LibraryItem* item, bool signal);
@@ -194,8 +210,11 @@ signals:
   void SongsSlightlyChanged(const SongList& songs);
   void TotalSongCountUpdatedSlot(int count);
 
-  // Called after ResetAsync
-  void ResetAsyncQueryFinished();
+  // Called after ResetAsync and UpdateAsync
+  void ResetAsyncQueryFinished(
+      QFutureWatcher<LibraryModel::QueryResult>* watcher, int query_id);
+  void UpdateAsyncQueryFinished(
+      QFutureWatcher<LibraryModel::UpdateResults>* watcher, int query_id);
 
   void AlbumArtLoaded(quint64 id, const QImage& image);
 
@@ -204,12 +223,41 @@ signals:
   // This gets called a lot when filtering the playlist, so it's nice to be
   // able to do it in a background thread.
   QueryResult RunQuery(LibraryItem* parent);
+  QueryResult RunQuery(GroupBy child_type, const LibraryQuery& query);
   void PostQuery(LibraryItem* parent, const QueryResult& result, bool signal);
+  // Returns the query for the children of parent.  This looks at parent and
+  // the items above it, so it has to be called in the model's thread unless
+  // parent is the root.
+  LibraryQuery ChildQuery(LibraryItem* parent, GroupBy* child_type);
 
   bool HasCompilations(const LibraryQuery& query);
 
   void BeginReset();
 
+  // The queries for parent's children and for those of every lazy loaded
+  // container below it.  They're made in the model's thread and run in the
+  // background by RunUpdateQueries.
+  struct ContainerQuery {
+    const LibraryItem* item;
+    QString key;
+    GroupBy child_type;
+    LibraryQuery query;
+  };
+  void AddUpdateQueries(LibraryItem* parent, QList<ContainerQuery>* queries);
+  UpdateResults RunUpdateQueries(const QList<ContainerQuery>& queries);
+  void ApplyUpdate(const UpdateResults& results);
+
+  // Makes the children of parent match the result of a query, by removing the
+  // items that aren't in the result and adding the ones that are new.  Does
+  // the same to every child that was kept and has a result in results.
+  void UpdateChildren(LibraryItem* parent, const QueryResult& result,
+                      const UpdateResults& results);
+  QString ChildKey(GroupBy type, const SqlRow& row) const;
+
+  // Removes an item and everything below it from the model.
+  void RemoveItem(LibraryItem* item);
+  void ForgetItem(LibraryItem* item, QSet<const LibraryItem*>* forgotten);
+
   // Functions for working with queries and creating items.
   // When the model is reset or when a node is lazy-loaded the Library
   // constructs a database query to populate the items.  Filters are added
@@ -226,6 +274,8 @@ signals:
   LibraryItem* ItemFromSong(GroupBy type, bool signal, bool create_divider,
                             LibraryItem* parent, const Song& s,
                             int container_level);
+  static void ItemDataFromQuery(GroupBy type, const SqlRow& row,
+                                LibraryItem* item);
 
   // The "Various Artists" node is an annoying special case.
   LibraryItem* CreateCompilationArtistNode(bool signal, LibraryItem* parent);
@@ -246,7 +296,7 @@ signals:
   QString DividerDisplayText(GroupBy type, const QString& key) const;
 
   // Helpers
-  QString AlbumIconPixmapCacheKey(const QModelIndex& index) const;
+  QString AlbumIconCacheKey(const LibraryItem* item) const;
   QVariant AlbumIcon(const QModelIndex& index);
   QVariant data(const LibraryItem* item, int role) const;
   bool CompareItems(const LibraryItem* a, const LibraryItem* b) const;
@@ -284,17 +334,26 @@ signals:
   QIcon playlists_dir_icon_;
   QIcon playlist_icon_;
 
-  QNetworkDiskCache* icon_cache_;
-
   int init_task_id_;
 
+  // Incremented every time a query for the root is started, so the results of
+  // older queries can be ignored.
+  int root_query_id_;
+  bool resetting_;
+
   bool use_pretty_covers_;
   bool show_dividers_;
 
   AlbumCoverLoaderOptions cover_loader_options_;
 
-  typedef QPair<LibraryItem*, QString> ItemAndCacheKey;
-  QMap<quint64, ItemAndCacheKey> pending_art_;
+  struct PendingArt {
+    PendingArt() : item(nullptr), art_stamp(0) {}
+    LibraryItem* item;
+    QString cache_key;
+    QString art_key;
+    qint64 art_stamp;
+  };
+  QMap<quint64, PendingArt> pending_art_;
   QSet<QString> pending_cache_keys_;
 };
 
@@ -16,6 +16,7 @@
 */
 
 #include "libraryplaylistitem.h"
+#include "core/sqlitequery.h"
 #include "core/tagreaderclient.h"
 
 #include <QSettings>
@@ -33,7 +34,7 @@ void LibraryPlaylistItem::Reload() {
                                                 &song_);
 }
 
-bool LibraryPlaylistItem::InitFromQuery(const SqlRow& query) {
+bool LibraryPlaylistItem::InitFromQuery(const SqliteQuery& query) {
   // Rows from the songs tables come first
   song_.InitFromQuery(query, true);
 
@@ -26,7 +26,7 @@ class LibraryPlaylistItem : public PlaylistItem {
   LibraryPlaylistItem(const QString& type);
   LibraryPlaylistItem(const Song& song);
 
-  bool InitFromQuery(const SqlRow& query);
+  bool InitFromQuery(const SqliteQuery& query);
   void Reload();
 
   Song Metadata() const;
@@ -94,7 +94,7 @@ LibraryQuery::LibraryQuery(const QueryOptions& options)
   }
 }
 
-QString LibraryQuery::GetInnerQuery() {
+QString LibraryQuery::GetInnerQuery() const {
   return duplicates_only_
              ? QString(
                    " INNER JOIN (select * from duplicated_songs) dsongs        "
@@ -138,8 +138,8 @@ void LibraryQuery::AddCompilationRequirement(bool compilation) {
                         .arg(compilation ? 1 : 0);
 }
 
-QSqlQuery LibraryQuery::Exec(QSqlDatabase db, const QString& songs_table,
-                             const QString& fts_table) {
+QString LibraryQuery::GetSql(const QString& songs_table,
+                             const QString& fts_table) const {
   QString sql;
 
   if (join_with_fts_) {
@@ -165,8 +165,12 @@ QSqlQuery LibraryQuery::Exec(QSqlDatabase db, const QString& songs_table,
   sql.replace("%songs_table", songs_table);
   sql.replace("%fts_table_noprefix", fts_table.section('.', -1, -1));
   sql.replace("%fts_table", fts_table);
+  return sql;
+}
 
-  query_ = QSqlQuery(sql, db);
+QSqlQuery LibraryQuery::Exec(QSqlDatabase db, const QString& songs_table,
+                             const QString& fts_table) {
+  query_ = QSqlQuery(GetSql(songs_table, fts_table), db);
 
   // Bind values
   for (const QVariant& value : bound_values_) {
@@ -88,13 +88,17 @@ class LibraryQuery {
 
   QSqlQuery Exec(QSqlDatabase db, const QString& songs_table,
                  const QString& fts_table);
+  // The statement and the values for its "?" placeholders, for running the
+  // query some other way than with Exec.
+  QString GetSql(const QString& songs_table, const QString& fts_table) const;
+  const QVariantList& bound_values() const { return bound_values_; }
   bool Next();
   QVariant Value(int column) const;
 
   operator const QSqlQuery&() const { return query_; }
 
  private:
-  QString GetInnerQuery();
+  QString GetInnerQuery() const;
 
   bool include_unavailable_;
   bool join_with_fts_;
@@ -25,6 +25,7 @@
 #include "ui_librarysettingspage.h"
 #include "core/application.h"
 #include "core/utilities.h"
+#include "covers/thumbnailstore.h"
 #include "playlist/playlistdelegates.h"
 #include "ui/iconloader.h"
 #include "ui/settingsdialog.h"
@@ -52,6 +53,8 @@ LibrarySettingsPage::LibrarySettingsPage(SettingsDialog* dialog)
   connect(ui_->remove, SIGNAL(clicked()), SLOT(Remove()));
   connect(ui_->sync_stats_button, SIGNAL(clicked()),
           SLOT(WriteAllSongsStatisticsToFiles()));
+  connect(ui_->rebuild_thumbnails, SIGNAL(clicked()),
+          dialog->app()->thumbnail_store(), SLOT(RebuildLibraryThumbnails()));
 }
 
 LibrarySettingsPage::~LibrarySettingsPage() { delete ui_; }
@@ -93,6 +96,8 @@ void LibrarySettingsPage::Save() {
   s.beginGroup(LibraryWatcher::kSettingsGroup);
   s.setValue("startup_scan", ui_->startup_scan->isChecked());
   s.setValue("monitor", ui_->monitor->isChecked());
+  s.setValue("scan_threads", ui_->scan_threads->value());
+  s.setValue("change_journal", ui_->change_journal->isChecked());
 
   QString filter_text = ui_->cover_art_patterns->text();
   QStringList filters = filter_text.split(',', QString::SkipEmptyParts);
@@ -133,6 +138,8 @@ void LibrarySettingsPage::Load() {
   s.beginGroup(LibraryWatcher::kSettingsGroup);
   ui_->startup_scan->setChecked(s.value("startup_scan", true).toBool());
   ui_->monitor->setChecked(s.value("monitor", true).toBool());
+  ui_->scan_threads->setValue(s.value("scan_threads", 1).toInt());
+  ui_->change_journal->setChecked(s.value("change_journal", false).toBool());
 
   QStringList filters =
       s.value("cover_art_patterns", QStringList() << "front"
@@ -18,6 +18,7 @@
 #include "librarywatcher.h"
 
 #include "librarybackend.h"
+#include "core/concurrentrun.h"
 #include "core/filesystemwatcherinterface.h"
 #include "core/logging.h"
 #include "core/tagreaderclient.h"
@@ -31,6 +32,8 @@
 #include <QThread>
 #include <QDateTime>
 #include <QHash>
+#include <QPair>
+#include <QQueue>
 #include <QSet>
 #include <QSettings>
 #include <QTimer>
@@ -46,6 +49,8 @@
 QStringList LibraryWatcher::sValidImages;
 
 const char* LibraryWatcher::kSettingsGroup = "LibraryWatcher";
+const int LibraryWatcher::kParallelScanBatchSize = 100;
+const int LibraryWatcher::kJournalMaxAgeDays = 7;
 
 LibraryWatcher::LibraryWatcher(QObject* parent)
     : QObject(parent),
@@ -55,6 +60,8 @@ LibraryWatcher::LibraryWatcher(QObject* parent)
       stop_requested_(false),
       scan_on_startup_(true),
       monitor_(true),
+      scan_threads_(1),
+      use_journal_(false),
       rescan_timer_(new QTimer(this)),
       rescan_paused_(false),
       total_watches_(0),
@@ -82,6 +89,7 @@ LibraryWatcher::ScanTransaction::ScanTransaction(LibraryWatcher* watcher,
       dir_(dir),
       incremental_(incremental),
       ignores_mtime_(ignores_mtime),
+      started_(QDateTime::currentMSecsSinceEpoch()),
       watcher_(watcher),
       cached_songs_dirty_(true),
       known_subdirs_dirty_(true) {
@@ -99,6 +107,12 @@ LibraryWatcher::ScanTransaction::~ScanTransaction() {
   // If we're stopping then don't commit the transaction
   if (watcher_->stop_requested_) return;
 
+  CommitPending();
+
+  watcher_->task_manager_->SetTaskFinished(task_id_);
+}
+
+void LibraryWatcher::ScanTransaction::CommitPending() {
   if (!new_songs.isEmpty()) emit watcher_->NewOrUpdatedSongs(new_songs);
 
   if (!touched_songs.isEmpty()) emit watcher_->SongsMTimeUpdated(touched_songs);
@@ -112,7 +126,14 @@ LibraryWatcher::ScanTransaction::~ScanTransaction() {
   if (!touched_subdirs.isEmpty())
     emit watcher_->SubdirsMTimeUpdated(touched_subdirs);
 
-  watcher_->task_manager_->SetTaskFinished(task_id_);
+  if (!watcher_->backend_->journal_table().isEmpty() &&
+      (!new_subdirs.isEmpty() || !touched_subdirs.isEmpty())) {
+    // These subdirectories have been scanned so they're not dirty any more
+    QStringList paths;
+    for (const Subdirectory& subdir : new_subdirs) paths << subdir.path;
+    for (const Subdirectory& subdir : touched_subdirs) paths << subdir.path;
+    emit watcher_->SubdirsScanned(paths, started_);
+  }
 
   if (watcher_->monitor_) {
     // Watch the new subdirectories
@@ -120,6 +141,13 @@ LibraryWatcher::ScanTransaction::~ScanTransaction() {
       watcher_->AddWatch(watcher_->watched_dirs_[dir_], subdir.path);
     }
   }
+
+  new_songs.clear();
+  touched_songs.clear();
+  deleted_songs.clear();
+  readded_songs.clear();
+  new_subdirs.clear();
+  touched_subdirs.clear();
 }
 
 void LibraryWatcher::ScanTransaction::AddToProgress(int n) {
@@ -195,19 +223,27 @@ void LibraryWatcher::AddDirectory(const Directory& dir,
     ScanTransaction transaction(this, dir.id, false);
     transaction.SetKnownSubdirs(subdirs);
     transaction.AddToProgressMax(1);
-    ScanSubdirectory(dir.path, Subdirectory(), &transaction);
+
+    Subdirectory root;
+    root.path = dir.path;
+    ScanSubdirectories(SubdirectoryList() << root, &transaction);
   } else {
     // We can do an incremental scan - looking at the mtimes of each
     // subdirectory and only rescan if the directory has changed.
     ScanTransaction transaction(this, dir.id, true);
     transaction.SetKnownSubdirs(subdirs);
-    transaction.AddToProgressMax(subdirs.count());
-    for (const Subdirectory& subdir : subdirs) {
+    if (scan_on_startup_) {
+      const SubdirectoryList subdirs_to_scan = SubdirsToScan(dir, subdirs);
+      transaction.AddToProgressMax(subdirs_to_scan.count());
+      ScanSubdirectories(subdirs_to_scan, &transaction);
       if (stop_requested_) return;
+      SetJournalComplete(dir.id, true);
+    }
 
-      if (scan_on_startup_) ScanSubdirectory(subdir.path, subdir, &transaction);
-
-      if (monitor_) AddWatch(dir, subdir.path);
+    if (monitor_) {
+      for (const Subdirectory& subdir : subdirs) {
+        AddWatch(dir, subdir.path);
+      }
     }
   }
 
@@ -218,39 +254,154 @@ void LibraryWatcher::ScanSubdirectory(const QString& path,
                                       const Subdirectory& subdir,
                                       ScanTransaction* t,
                                       bool force_noincremental) {
+  const bool incremental =
+      !t->ignores_mtime() && !force_noincremental && t->is_incremental();
+  const DirectoryListing listing =
+      ListDirectory(path, subdir.mtime, incremental, WatchedPaths());
+
+  PendingDirectory pending;
+  const SubdirectoryList children =
+      ScanDirectoryListing(path, subdir, listing, t, &pending);
+  FinishDirectory(&pending, t);
+
+  for (const Subdirectory& child : children) {
+    if (stop_requested_) return;
+    ScanSubdirectory(child.path, child, t, true);
+  }
+}
+
+void LibraryWatcher::ScanSubdirectories(const SubdirectoryList& subdirs,
+                                        ScanTransaction* t,
+                                        bool force_noincremental) {
+  if (scan_threads_ > 1) {
+    ScanSubdirectoriesParallel(subdirs, t, force_noincremental);
+    return;
+  }
+
+  for (const Subdirectory& subdir : subdirs) {
+    if (stop_requested_) return;
+    ScanSubdirectory(subdir.path, subdir, t, force_noincremental);
+  }
+}
+
+void LibraryWatcher::ScanSubdirectoriesParallel(const SubdirectoryList& subdirs,
+                                                ScanTransaction* t,
+                                                bool force_noincremental) {
+  struct Job {
+    Subdirectory subdir;
+    QFuture<DirectoryListing> listing;
+  };
+
+  const QStringList watched_paths = WatchedPaths();
+  const bool incremental = !t->ignores_mtime() && t->is_incremental();
+
+  // Subdirectories that still need to be listed, and how they should be
+  // listed.  New subdirectories found during the scan are always listed
+  // non-incrementally.
+  QQueue<QPair<Subdirectory, bool>> queue;
+  for (const Subdirectory& subdir : subdirs) {
+    queue.enqueue(qMakePair(subdir, incremental && !force_noincremental));
+  }
+
+  // Keep a few more directories in flight than there are threads so the pool
+  // never runs dry while this thread is busy reading tags.
+  const int max_in_flight = scan_threads_ * 2;
+  QQueue<Job> in_flight;
+  int directories_since_commit = 0;
+
+  // Directories whose tags are being read.  Waiting for the oldest one only
+  // once a few more have been sent keeps every tagreader worker busy, even
+  // when each directory only holds a handful of files.
+  QQueue<PendingDirectory*> reading;
+
+  forever {
+    while (!queue.isEmpty() && in_flight.count() < max_in_flight) {
+      const QPair<Subdirectory, bool> next = queue.dequeue();
+
+      Job job;
+      job.subdir = next.first;
+      job.listing = ConcurrentRun::Run<DirectoryListing>(
+          &scan_thread_pool_,
+          std::bind(&LibraryWatcher::ListDirectory, next.first.path,
+                    next.first.mtime, next.second, watched_paths));
+      in_flight.enqueue(job);
+    }
+
+    if (stop_requested_) break;
+
+    if (in_flight.isEmpty() || reading.count() >= scan_threads_) {
+      // Finish a directory before listing any more, so the songs found so far
+      // get committed.
+      if (reading.isEmpty()) break;
+
+      PendingDirectory* pending = reading.dequeue();
+      FinishDirectory(pending, t);
+      delete pending;
+
+      if (++directories_since_commit >= kParallelScanBatchSize) {
+        t->CommitPending();
+        directories_since_commit = 0;
+      }
+      continue;
+    }
+
+    Job job = in_flight.dequeue();
+    const DirectoryListing listing = job.listing.result();
+
+    PendingDirectory* pending = new PendingDirectory;
+    for (const Subdirectory& child : ScanDirectoryListing(
+             job.subdir.path, job.subdir, listing, t, pending)) {
+      queue.enqueue(qMakePair(child, false));
+    }
+    reading.enqueue(pending);
+  }
+
+  // Wait for the tags that have already been requested.  FinishDirectory
+  // throws them away if the scan was stopped.
+  while (!reading.isEmpty()) {
+    PendingDirectory* pending = reading.dequeue();
+    FinishDirectory(pending, t);
+    delete pending;
+  }
+
+  // Don't return while listings are still using the thread pool.
+  for (Job& job : in_flight) {
+    job.listing.waitForFinished();
+  }
+}
+
+QStringList LibraryWatcher::WatchedPaths() const {
+  QStringList ret;
+  for (const Directory& dir : watched_dirs_) {
+    ret << dir.path;
+  }
+  return ret;
+}
+
+LibraryWatcher::DirectoryListing LibraryWatcher::ListDirectory(
+    const QString& path, uint known_mtime, bool incremental,
+    const QStringList& watched_paths) {
+  DirectoryListing ret;
   QFileInfo path_info(path);
 
   // Do not scan symlinked dirs that are already in collection
   if (path_info.isSymLink()) {
     QString real_path = path_info.symLinkTarget();
-    for (const Directory& dir : watched_dirs_) {
-      if (real_path.startsWith(dir.path)) {
-        t->AddToProgress(1);
-        return;
+    for (const QString& watched_path : watched_paths) {
+      if (real_path.startsWith(watched_path)) {
+        ret.skip = true;
+        return ret;
       }
     }
   }
 
-  if (!t->ignores_mtime() && !force_noincremental && t->is_incremental() &&
-      subdir.mtime == path_info.lastModified().toTime_t()) {
-    // The directory hasn't changed since last time
-    t->AddToProgress(1);
-    return;
-  }
-
-  QMap<QString, QStringList> album_art;
-  QStringList files_on_disk;
-  SubdirectoryList my_new_subdirs;
+  ret.exists = path_info.exists();
+  ret.mtime = ret.exists ? path_info.lastModified().toTime_t() : 0;
 
-  // If a directory is moved then only its parent gets a changed notification,
-  // so we need to look and see if any of our children don't exist any more.
-  // If one has been removed, "rescan" it to get the deleted songs
-  SubdirectoryList previous_subdirs = t->GetImmediateSubdirs(path);
-  for (const Subdirectory& subdir : previous_subdirs) {
-    if (!QFile::exists(subdir.path) && subdir.path != path) {
-      t->AddToProgressMax(1);
-      ScanSubdirectory(subdir.path, subdir, t, true);
-    }
+  if (incremental && known_mtime == path_info.lastModified().toTime_t()) {
+    // The directory hasn't changed since last time
+    ret.skip = true;
+    return ret;
   }
 
   // First we "quickly" get a list of the files in the directory that we
@@ -260,42 +411,74 @@ void LibraryWatcher::ScanSubdirectory(const QString& path,
   QDirIterator it(
       path, QDir::Dirs | QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot);
   while (it.hasNext()) {
-    if (stop_requested_) return;
-
     QString child(it.next());
     QFileInfo child_info(child);
 
     if (child_info.isDir()) {
-      if (!child_info.isHidden() && !t->HasSeenSubdir(child)) {
-        // We haven't seen this subdirectory before - add it to a list and
-        // later we'll tell the backend about it and scan it.
-        Subdirectory new_subdir;
-        new_subdir.directory_id = -1;
-        new_subdir.path = child;
-        new_subdir.mtime = child_info.lastModified().toTime_t();
-        my_new_subdirs << new_subdir;
+      if (!child_info.isHidden()) {
+        Subdirectory child_dir;
+        child_dir.directory_id = -1;
+        child_dir.path = child;
+        child_dir.mtime = child_info.lastModified().toTime_t();
+        ret.child_dirs << child_dir;
       }
     } else {
       QString ext_part(ExtensionPart(child));
       QString dir_part(DirectoryPart(child));
 
       if (sValidImages.contains(ext_part))
-        album_art[dir_part] << child;
+        ret.album_art[dir_part] << child;
       else if (!child_info.isHidden())
-        files_on_disk << child;
+        ret.files_on_disk << child;
+    }
+  }
+
+  return ret;
+}
+
+SubdirectoryList LibraryWatcher::ScanDirectoryListing(
+    const QString& path, const Subdirectory& subdir,
+    const DirectoryListing& listing, ScanTransaction* t,
+    PendingDirectory* pending) {
+  SubdirectoryList next_subdirs;
+
+  if (listing.skip) {
+    t->AddToProgress(1);
+    return next_subdirs;
+  }
+
+  QMap<QString, QStringList> album_art = listing.album_art;
+  QStringList files_on_disk = listing.files_on_disk;
+  SubdirectoryList my_new_subdirs;
+
+  // If a directory is moved then only its parent gets a changed notification,
+  // so we need to look and see if any of our children don't exist any more.
+  // If one has been removed, "rescan" it to get the deleted songs
+  SubdirectoryList previous_subdirs = t->GetImmediateSubdirs(path);
+  for (const Subdirectory& subdir : previous_subdirs) {
+    if (!QFile::exists(subdir.path) && subdir.path != path) {
+      t->AddToProgressMax(1);
+      next_subdirs << subdir;
     }
   }
 
-  if (stop_requested_) return;
+  for (const Subdirectory& child_dir : listing.child_dirs) {
+    // We haven't seen this subdirectory before - add it to a list and
+    // later we'll tell the backend about it and scan it.
+    if (!t->HasSeenSubdir(child_dir.path)) my_new_subdirs << child_dir;
+  }
+
+  if (stop_requested_) return SubdirectoryList();
 
   // Ask the database for a list of files in this directory
   SongList songs_in_db = t->FindSongsInSubdirectory(path);
 
   QSet<QString> cues_processed;
+  QList<PendingRead>& pending_reads = pending->reads;
 
   // Now compare the list from the database with the list of files on disk
   for (const QString& file : files_on_disk) {
-    if (stop_requested_) return;
+    if (stop_requested_) return SubdirectoryList();
 
     // associated cue
     QString matching_cue = NoExtensionPart(file) + ".cue";
@@ -347,8 +530,12 @@ void LibraryWatcher::ScanSubdirectory(const QString& path,
           UpdateCueAssociatedSongs(file, path, matching_cue, image, t);
           // if no cue or it's about to lose it...
         } else {
-          UpdateNonCueAssociatedSong(file, matching_song, image, cue_deleted,
-                                     t);
+          PendingRead pending;
+          pending.file = file;
+          pending.image = image;
+          pending.matching_song = matching_song;
+          pending.cue_deleted = cue_deleted;
+          pending_reads << pending;
         }
       }
 
@@ -357,8 +544,16 @@ void LibraryWatcher::ScanSubdirectory(const QString& path,
 
     } else {
       // The song is on disk but not in the DB
-      SongList song_list =
-          ScanNewFile(file, path, matching_cue, &cues_processed);
+      QStringList files_to_read;
+      SongList song_list = ScanNewFile(file, path, matching_cue,
+                                       &cues_processed, &files_to_read);
+
+      for (const QString& file_to_read : files_to_read) {
+        PendingRead pending;
+        pending.file = file_to_read;
+        pending.image = ImageForSong(file_to_read, album_art);
+        pending_reads << pending;
+      }
 
       if (song_list.isEmpty()) {
         continue;
@@ -377,6 +572,17 @@ void LibraryWatcher::ScanSubdirectory(const QString& path,
     }
   }
 
+  // Ask for the tags of all the new and changed files in this directory at
+  // once.  FinishDirectory waits for them.
+  if (!pending_reads.isEmpty()) {
+    QStringList files_to_read;
+    for (const PendingRead& read : pending_reads) {
+      files_to_read << read.file;
+    }
+    pending->replies =
+        TagReaderClient::Instance()->ReadFilesSplit(files_to_read);
+  }
+
   // Look for deleted songs
   for (const Song& song : songs_in_db) {
     if (!song.is_unavailable() &&
@@ -386,26 +592,54 @@ void LibraryWatcher::ScanSubdirectory(const QString& path,
     }
   }
 
+  // FinishDirectory adds this subdir to the new or touched list once its songs
+  // have been added, so its mtime is never committed before them.
+  pending->scanned = true;
+  pending->is_new = subdir.directory_id == -1;
+  pending->subdir.directory_id = t->dir();
+  pending->subdir.mtime = listing.mtime;
+  pending->subdir.path = path;
+
+  // The new subdirs that we found need to be scanned too
+  t->AddToProgressMax(my_new_subdirs.count());
+  next_subdirs << my_new_subdirs;
+
+  return next_subdirs;
+}
+
+void LibraryWatcher::FinishDirectory(PendingDirectory* pending,
+                                     ScanTransaction* t) {
+  const SongList songs_on_disk =
+      TagReaderClient::ReadFilesResult(pending->replies);
+  pending->replies.clear();
+
+  if (!pending->scanned || stop_requested_) return;
+
+  for (int i = 0; i < pending->reads.count(); ++i) {
+    const PendingRead& read = pending->reads[i];
+    Song song_on_disk = songs_on_disk[i];
+
+    if (read.matching_song.is_valid()) {
+      UpdateNonCueAssociatedSong(read.file, read.matching_song, read.image,
+                                 read.cue_deleted, song_on_disk, t);
+    } else if (song_on_disk.is_valid()) {
+      qLog(Debug) << read.file << "created";
+
+      song_on_disk.set_directory_id(t->dir());
+      if (song_on_disk.art_automatic().isEmpty())
+        song_on_disk.set_art_automatic(read.image);
+
+      t->new_songs << song_on_disk;
+    }
+  }
+
   // Add this subdir to the new or touched list
-  Subdirectory updated_subdir;
-  updated_subdir.directory_id = t->dir();
-  updated_subdir.mtime =
-      path_info.exists() ? path_info.lastModified().toTime_t() : 0;
-  updated_subdir.path = path;
-
-  if (subdir.directory_id == -1)
-    t->new_subdirs << updated_subdir;
+  if (pending->is_new)
+    t->new_subdirs << pending->subdir;
   else
-    t->touched_subdirs << updated_subdir;
+    t->touched_subdirs << pending->subdir;
 
   t->AddToProgress(1);
-
-  // Recurse into the new subdirs that we found
-  t->AddToProgressMax(my_new_subdirs.count());
-  for (const Subdirectory& my_new_subdir : my_new_subdirs) {
-    if (stop_requested_) return;
-    ScanSubdirectory(my_new_subdir.path, my_new_subdir, t, true);
-  }
 }
 
 void LibraryWatcher::UpdateCueAssociatedSongs(const QString& file,
@@ -452,6 +686,7 @@ void LibraryWatcher::UpdateNonCueAssociatedSong(const QString& file,
                                                 const Song& matching_song,
                                                 const QString& image,
                                                 bool cue_deleted,
+                                                const Song& song_on_disk,
                                                 ScanTransaction* t) {
   // if a cue got deleted, we turn it's first section into the new
   // 'raw' (cueless) song and we just remove the rest of the sections
@@ -465,18 +700,17 @@ void LibraryWatcher::UpdateNonCueAssociatedSong(const QString& file,
     }
   }
 
-  Song song_on_disk;
-  song_on_disk.set_directory_id(t->dir());
-  TagReaderClient::Instance()->ReadFileBlocking(file, &song_on_disk);
-
   if (song_on_disk.is_valid()) {
-    PreserveUserSetData(file, image, matching_song, &song_on_disk, t);
+    Song song = song_on_disk;
+    song.set_directory_id(t->dir());
+    PreserveUserSetData(file, image, matching_song, &song, t);
   }
 }
 
 SongList LibraryWatcher::ScanNewFile(const QString& file, const QString& path,
                                      const QString& matching_cue,
-                                     QSet<QString>* cues_processed) {
+                                     QSet<QString>* cues_processed,
+                                     QStringList* files_to_read) {
   SongList song_list;
 
   uint matching_cue_mtime = GetMtimeForCue(matching_cue);
@@ -503,14 +737,9 @@ SongList LibraryWatcher::ScanNewFile(const QString& file, const QString& path,
       *cues_processed << matching_cue;
     }
 
-    // it's a normal media file
+    // it's a normal media file - the caller will read it later
   } else {
-    Song song;
-    TagReaderClient::Instance()->ReadFileBlocking(file, &song);
-
-    if (song.is_valid()) {
-      song_list << song;
-    }
+    *files_to_read << file;
   }
 
   return song_list;
@@ -574,6 +803,7 @@ void LibraryWatcher::AddWatch(const Directory& dir, const QString& path) {
 void LibraryWatcher::RemoveDirectory(const Directory& dir) {
   rescan_queue_.remove(dir.id);
   watched_dirs_.remove(dir.id);
+  SetJournalComplete(dir.id, false);
 
   // Stop watching the directory's subdirectories
   for (const QString& subdir_path : subdir_mapping_.keys(dir)) {
@@ -606,6 +836,8 @@ void LibraryWatcher::DirectoryChanged(const QString& subdir) {
   qLog(Debug) << "Subdir" << subdir << "changed under directory" << dir.path
               << "id" << dir.id;
 
+  if (IsJournalEnabled()) emit SubdirChanged(dir.id, subdir);
+
   // Queue the subdir for rescanning
   if (!rescan_queue_[dir.id].contains(subdir)) rescan_queue_[dir.id] << subdir;
 
@@ -704,6 +936,9 @@ void LibraryWatcher::ReloadSettings() {
   s.beginGroup(kSettingsGroup);
   scan_on_startup_ = s.value("startup_scan", true).toBool();
   monitor_ = s.value("monitor", true).toBool();
+  scan_threads_ = qMax(1, s.value("scan_threads", 1).toInt());
+  scan_thread_pool_.setMaxThreadCount(scan_threads_);
+  use_journal_ = s.value("change_journal", false).toBool();
 
   best_image_filters_.clear();
   QStringList filters =
@@ -714,6 +949,13 @@ void LibraryWatcher::ReloadSettings() {
     if (!s.isEmpty()) best_image_filters_ << s;
   }
 
+  if (!IsJournalEnabled() && !journalled_dirs_.isEmpty()) {
+    // Changes aren't being recorded any more, so the journal can't be trusted
+    // until the next full scan.
+    journalled_dirs_.clear();
+    s.setValue("journal_directories", QVariantList());
+  }
+
   if (!monitor_ && was_monitoring_before) {
     fs_watcher_->Clear();
   } else if (monitor_ && !was_monitoring_before) {
@@ -753,14 +995,102 @@ void LibraryWatcher::PerformScan(bool incremental, bool ignore_mtimes) {
   for (const Directory& dir : watched_dirs_.values()) {
     ScanTransaction transaction(this, dir.id, incremental, ignore_mtimes);
     SubdirectoryList subdirs(transaction.GetAllSubdirs());
+    if (incremental) subdirs = SubdirsToScan(dir, subdirs);
     transaction.AddToProgressMax(subdirs.count());
 
-    for (const Subdirectory& subdir : subdirs) {
-      if (stop_requested_) return;
+    ScanSubdirectories(subdirs, &transaction);
+    if (stop_requested_) return;
+    SetJournalComplete(dir.id, true);
+  }
+
+  emit CompilationsNeedUpdating();
+}
+
+bool LibraryWatcher::IsJournalEnabled() const {
+  return use_journal_ && monitor_ && backend_ &&
+         !backend_->journal_table().isEmpty();
+}
+
+void LibraryWatcher::LoadJournalState() {
+  QSettings s;
+  s.beginGroup(kSettingsGroup);
 
-      ScanSubdirectory(subdir.path, subdir, &transaction);
+  const QDateTime saved_at = s.value("journal_saved_at").toDateTime();
+  const QVariantList dirs = s.value("journal_directories").toList();
+
+  // Forget the timestamp straight away, so if we crash the journal won't be
+  // trusted next time.
+  s.remove("journal_saved_at");
+
+  if (!IsJournalEnabled() || !saved_at.isValid() ||
+      saved_at.daysTo(QDateTime::currentDateTime()) > kJournalMaxAgeDays) {
+    return;
+  }
+
+  for (const QVariant& dir : dirs) {
+    journalled_dirs_.insert(dir.toInt());
+  }
+  qLog(Debug) << "Using the change journal for" << journalled_dirs_.count()
+              << "directories";
+}
+
+void LibraryWatcher::SaveJournalState() {
+  QSettings s;
+  s.beginGroup(kSettingsGroup);
+  s.setValue("journal_saved_at", QDateTime::currentDateTime());
+}
+
+SubdirectoryList LibraryWatcher::SubdirsToScan(
+    const Directory& dir, const SubdirectoryList& all_subdirs) {
+  if (!IsJournalEnabled() || !journalled_dirs_.contains(dir.id)) {
+    return all_subdirs;
+  }
+
+  // Only visit the subdirectories that are known to have changed - their
+  // mtime is set to 0 so they're always scanned.  The others aren't looked at
+  // on disk at all, so changes made while Clementine wasn't running are only
+  // found by a full rescan.  The root is cheap to check though, and catches
+  // folders that were added to the top of the library.
+  QSet<QString> journalled = backend_->JournalledSubdirs(dir.id).toSet();
+
+  SubdirectoryList ret;
+  for (const Subdirectory& subdir : all_subdirs) {
+    if (journalled.remove(subdir.path)) {
+      Subdirectory changed = subdir;
+      changed.mtime = 0;
+      ret << changed;
+    } else if (subdir.path == dir.path &&
+               QFileInfo(subdir.path).lastModified().toTime_t() !=
+                   subdir.mtime) {
+      ret << subdir;
     }
   }
 
-  emit CompilationsNeedUpdating();
+  for (const QString& path : journalled) {
+    Subdirectory subdir;
+    subdir.directory_id = dir.id;
+    subdir.mtime = 0;
+    subdir.path = path;
+    ret << subdir;
+  }
+  return ret;
+}
+
+void LibraryWatcher::SetJournalComplete(int dir, bool complete) {
+  if (complete == journalled_dirs_.contains(dir)) return;
+  if (complete && !IsJournalEnabled()) return;
+
+  if (complete)
+    journalled_dirs_.insert(dir);
+  else
+    journalled_dirs_.remove(dir);
+
+  QVariantList dirs;
+  for (int id : journalled_dirs_) {
+    dirs << id;
+  }
+
+  QSettings s;
+  s.beginGroup(kSettingsGroup);
+  s.setValue("journal_directories", dirs);
 }
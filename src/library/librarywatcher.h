@@ -20,11 +20,14 @@
 
 #include "directory.h"
 #include "core/song.h"
+#include "core/tagreaderclient.h"
 
 #include <QHash>
 #include <QObject>
 #include <QStringList>
 #include <QMap>
+#include <QSet>
+#include <QThreadPool>
 
 class QFileSystemWatcher;
 class QTimer;
@@ -42,6 +45,13 @@ class LibraryWatcher : public QObject {
 
   static const char* kSettingsGroup;
 
+  // When scanning in parallel, the results are sent to the backend after this
+  // many subdirectories have been scanned.
+  static const int kParallelScanBatchSize;
+
+  // The change journal isn't trusted if Clementine hasn't run for this long.
+  static const int kJournalMaxAgeDays;
+
   void set_backend(LibraryBackend* backend) { backend_ = backend; }
   void set_task_manager(TaskManager* task_manager) {
     task_manager_ = task_manager;
@@ -57,6 +67,17 @@ class LibraryWatcher : public QObject {
 
   void Stop() { stop_requested_ = true; }
 
+  // The change journal lets incremental scans skip directories that haven't
+  // changed without listing them.  While monitoring, every changed
+  // subdirectory is added to the journal, and it's removed again once it has
+  // been scanned.  Other subdirectories are skipped without looking at them
+  // on disk, except for the root of the directory.  LoadJournalState must be
+  // called before the directories are added, and SaveJournalState when
+  // Clementine exits cleanly - if it isn't called the journal is ignored next
+  // time.
+  void LoadJournalState();
+  static void SaveJournalState();
+
 signals:
   void NewOrUpdatedSongs(const SongList& songs);
   void SongsMTimeUpdated(const SongList& songs);
@@ -64,6 +85,8 @@ signals:
   void SongsReadded(const SongList& songs, bool unavailable = false);
   void SubdirsDiscovered(const SubdirectoryList& subdirs);
   void SubdirsMTimeUpdated(const SubdirectoryList& subdirs);
+  void SubdirChanged(int directory_id, const QString& path);
+  void SubdirsScanned(const QStringList& paths, qint64 scan_started);
   void CompilationsNeedUpdating();
 
   void ScanStarted(int task_id);
@@ -99,6 +122,10 @@ signals:
     void AddToProgress(int n = 1);
     void AddToProgressMax(int n);
 
+    // Sends everything found so far to the backend and clears the lists.
+    // Called by the destructor, and periodically during long parallel scans.
+    void CommitPending();
+
     int dir() const { return dir_; }
     bool is_incremental() const { return incremental_; }
     bool ignores_mtime() const { return ignores_mtime_; }
@@ -127,6 +154,9 @@ signals:
     // the last scan. Also, since it's ignoring mtimes on folders too,
     // it will go as deep in the folder hierarchy as it's possible.
     bool ignores_mtime_;
+    // When the transaction was created, in msecs since the epoch.  Changes
+    // journalled after this are kept in the journal.
+    qint64 started_;
 
     LibraryWatcher* watcher_;
 
@@ -146,6 +176,50 @@ signals:
                         ScanTransaction* t, bool force_noincremental = false);
 
  private:
+  // The contents of a directory on disk.  Creating one only touches the
+  // filesystem, so it can be done on any thread.
+  struct DirectoryListing {
+    DirectoryListing() : skip(false), exists(false), mtime(0) {}
+
+    // True if the directory doesn't need to be scanned, either because it
+    // hasn't changed or because it's a symlink to somewhere in the library.
+    bool skip;
+    bool exists;
+    uint mtime;
+
+    QStringList files_on_disk;
+    QMap<QString, QStringList> album_art;
+    // Non-hidden child directories, with their mtimes.
+    SubdirectoryList child_dirs;
+  };
+
+  // A file found by ScanSubdirectory whose tags need to be read.  All the
+  // pending reads for a subdirectory are sent to the tagreader together.
+  struct PendingRead {
+    PendingRead() : cue_deleted(false) {}
+
+    QString file;
+    QString image;
+    // Invalid if the file isn't in the library yet.
+    Song matching_song;
+    bool cue_deleted;
+  };
+
+  // A directory that has been compared with the library but whose tags are
+  // still being read.  FinishDirectory adds the songs and records the
+  // subdirectory once the tagreader has replied.
+  struct PendingDirectory {
+    PendingDirectory() : scanned(false), is_new(false) {}
+
+    // False if the directory was skipped or the scan was stopped.
+    bool scanned;
+    bool is_new;
+    Subdirectory subdir;
+
+    QList<PendingRead> reads;
+    QList<TagReaderReply*> replies;
+  };
+
   static bool FindSongByPath(const SongList& list, const QString& path,
                              Song* out);
   inline static QString NoExtensionPart(const QString& fileName);
@@ -158,16 +232,55 @@ signals:
   uint GetMtimeForCue(const QString& cue_path);
   void PerformScan(bool incremental, bool ignore_mtimes);
 
+  // Lists the contents of path.  If incremental is true and the directory's
+  // mtime is still known_mtime then the listing is skipped.  watched_paths are
+  // the roots of the library, symlinks pointing inside them are skipped too.
+  static DirectoryListing ListDirectory(const QString& path, uint known_mtime,
+                                        bool incremental,
+                                        const QStringList& watched_paths);
+  // Compares a directory listing with the library and adds the differences to
+  // the transaction.  The tags of new and changed files are requested but not
+  // waited for - pass pending to FinishDirectory to add those songs.  Returns
+  // the subdirectories that have to be scanned next: ones that are new, and
+  // ones that have disappeared from disk.
+  SubdirectoryList ScanDirectoryListing(const QString& path,
+                                        const Subdirectory& subdir,
+                                        const DirectoryListing& listing,
+                                        ScanTransaction* t,
+                                        PendingDirectory* pending);
+  // Waits for the tags requested by ScanDirectoryListing, adds the songs to
+  // the transaction and records the subdirectory as scanned.
+  void FinishDirectory(PendingDirectory* pending, ScanTransaction* t);
+  // Scans each of the subdirectories and everything new below them.  If
+  // parallel scanning is enabled the directories are listed on the scan thread
+  // pool while this thread compares the results with the library, and the
+  // tags of several directories are read at once.
+  void ScanSubdirectories(const SubdirectoryList& subdirs, ScanTransaction* t,
+                          bool force_noincremental = false);
+  void ScanSubdirectoriesParallel(const SubdirectoryList& subdirs,
+                                  ScanTransaction* t, bool force_noincremental);
+  QStringList WatchedPaths() const;
+
+  bool IsJournalEnabled() const;
+  // Returns the subdirectories of dir that are in the change journal, and its
+  // root if that has a different mtime, if the journal can be trusted for that
+  // dir.  Otherwise returns all_subdirs.
+  SubdirectoryList SubdirsToScan(const Directory& dir,
+                                 const SubdirectoryList& all_subdirs);
+  // Records that the journal is complete for dir after it has been scanned.
+  void SetJournalComplete(int dir, bool complete);
+
   // Updates the sections of a cue associated and altered (according to mtime)
   // media file during a scan.
   void UpdateCueAssociatedSongs(const QString& file, const QString& path,
                                 const QString& matching_cue,
                                 const QString& image, ScanTransaction* t);
   // Updates a single non-cue associated and altered (according to mtime) song
-  // during a scan.
+  // during a scan.  song_on_disk contains the tags that were read from file.
   void UpdateNonCueAssociatedSong(const QString& file,
                                   const Song& matching_song,
                                   const QString& image, bool cue_deleted,
+                                  const Song& song_on_disk,
                                   ScanTransaction* t);
   // Updates a new song with some metadata taken from it's equivalent old
   // song (for example rating and score).
@@ -178,9 +291,12 @@ signals:
   // library.
   // It may result in a multiple files added to the library when the media file
   // has many sections (like a CUE related media file).
+  // Plain media files aren't read here, they're added to files_to_read instead
+  // so their tags can be read in one batch.
   SongList ScanNewFile(const QString& file, const QString& path,
                        const QString& matching_cue,
-                       QSet<QString>* cues_processed);
+                       QSet<QString>* cues_processed,
+                       QStringList* files_to_read);
 
  private:
   LibraryBackend* backend_;
@@ -201,6 +317,16 @@ signals:
   bool scan_on_startup_;
   bool monitor_;
 
+  // The number of directories that are listed at the same time during a scan.
+  // 1 disables parallel scanning.
+  int scan_threads_;
+  QThreadPool scan_thread_pool_;
+
+  bool use_journal_;
+  // Directories whose journal contains every change since they were last
+  // fully scanned.
+  QSet<int> journalled_dirs_;
+
   QMap<int, Directory> watched_dirs_;
   QTimer* rescan_timer_;
   QMap<int, QStringList>
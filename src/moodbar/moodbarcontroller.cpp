@@ -35,7 +35,8 @@ void MoodbarController::CurrentSongChanged(const Song& song) {
   QByteArray data;
   MoodbarPipeline* pipeline = nullptr;
   const MoodbarLoader::Result result =
-      app_->moodbar_loader()->Load(song.url(), &data, &pipeline);
+      app_->moodbar_loader()->Load(song.url(), &data, &pipeline,
+                                   MoodbarLoader::Priority_CurrentSong);
 
   switch (result) {
     case MoodbarLoader::CannotLoad:
@@ -23,26 +23,34 @@
 #include <QDir>
 #include <QFileInfo>
 #include <QNetworkDiskCache>
+#include <QSettings>
 #include <QTimer>
 #include <QThread>
 #include <QUrl>
+#include <QtConcurrentRun>
 
 #include "moodbarpipeline.h"
 #include "core/application.h"
 #include "core/closure.h"
 #include "core/logging.h"
 #include "core/qhash_qurl.h"
+#include "core/taskmanager.h"
 #include "core/utilities.h"
+#include "library/librarybackend.h"
 
 #ifdef Q_OS_WIN32
 #include <windows.h>
 #endif
 
+const char* MoodbarLoader::kSettingsGroup = "Moodbar";
+
 MoodbarLoader::MoodbarLoader(Application* app, QObject* parent)
     : QObject(parent),
+      app_(app),
       cache_(new QNetworkDiskCache(this)),
-      thread_(new QThread(this)),
-      kMaxActiveRequests(qMax(1, QThread::idealThreadCount() / 2)),
+      max_active_requests_(DefaultMaxActiveRequests()),
+      precompute_task_id_(-1),
+      precompute_total_(0),
       save_alongside_originals_(false),
       disable_moodbar_calculation_(false) {
   cache_->setCacheDirectory(
@@ -55,17 +63,34 @@ MoodbarLoader::MoodbarLoader(Application* app, QObject* parent)
 }
 
 MoodbarLoader::~MoodbarLoader() {
-  thread_->quit();
-  thread_->wait(1000);
+  for (QThread* thread : threads_) {
+    thread->quit();
+  }
+  for (QThread* thread : threads_) {
+    thread->wait(1000);
+  }
+}
+
+int MoodbarLoader::DefaultMaxActiveRequests() {
+  return qMax(1, QThread::idealThreadCount() / 2);
 }
 
 void MoodbarLoader::ReloadSettings() {
   QSettings s;
-  s.beginGroup("Moodbar");
+  s.beginGroup(kSettingsGroup);
   save_alongside_originals_ =
       s.value("save_alongside_originals", false).toBool();
 
   disable_moodbar_calculation_ = !s.value("calculate", true).toBool();
+  max_active_requests_ =
+      qMax(1, s.value("threads", DefaultMaxActiveRequests()).toInt());
+
+  // Stop looking for library songs that need moodbars.  The ones being
+  // generated already are allowed to finish.
+  if (disable_moodbar_calculation_ && is_precomputing()) {
+    FinishPrecompute();
+  }
+
   MaybeTakeNextRequest();
 }
 
@@ -82,14 +107,33 @@ QStringList MoodbarLoader::MoodFilenames(const QString& song_filename) {
                        << dir_path + "/" + mood_filename;
 }
 
+bool MoodbarLoader::MoodFileExists(const QString& song_filename) {
+  for (const QString& possible_mood_file : MoodFilenames(song_filename)) {
+    if (QFile::exists(possible_mood_file)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 MoodbarLoader::Result MoodbarLoader::Load(const QUrl& url, QByteArray* data,
-                                          MoodbarPipeline** async_pipeline) {
+                                          MoodbarPipeline** async_pipeline,
+                                          Priority priority) {
   if (url.scheme() != "file") {
     return CannotLoad;
   }
 
   // Are we in the middle of loading this moodbar already?
   if (requests_.contains(url)) {
+    // Move it up the queue if it's more important now.
+    const Priority old_priority = request_priorities_[url];
+    if (!active_requests_.contains(url) &&
+        priority >= old_priority) {
+      queued_requests_[old_priority].removeAll(url);
+      queued_requests_[priority] << url;
+      request_priorities_[url] = priority;
+    }
+
     *async_pipeline = requests_[url];
     return WillLoadAsync;
   }
@@ -116,36 +160,166 @@ MoodbarLoader::Result MoodbarLoader::Load(const QUrl& url, QByteArray* data,
     }
   }
 
-  if (!thread_->isRunning()) thread_->start(QThread::IdlePriority);
-
   // There was no existing file, analyze the audio file and create one.
+  MoodbarPipeline* pipeline = CreateRequest(url, priority);
+
+  MaybeTakeNextRequest();
+
+  *async_pipeline = pipeline;
+  return WillLoadAsync;
+}
+
+MoodbarPipeline* MoodbarLoader::CreateRequest(const QUrl& url,
+                                              Priority priority) {
   MoodbarPipeline* pipeline = new MoodbarPipeline(url);
-  pipeline->moveToThread(thread_);
   NewClosure(pipeline, SIGNAL(Finished(bool)), this,
              SLOT(RequestFinished(MoodbarPipeline*, QUrl)), pipeline, url);
 
   requests_[url] = pipeline;
-  queued_requests_ << url;
+  request_priorities_[url] = priority;
+  queued_requests_[priority] << url;
+  return pipeline;
+}
 
-  MaybeTakeNextRequest();
+QUrl MoodbarLoader::TakeNextQueuedRequest() {
+  for (int priority = PriorityCount - 1; priority >= 0; --priority) {
+    QList<QUrl>& queue = queued_requests_[priority];
+    if (queue.isEmpty()) continue;
 
-  *async_pipeline = pipeline;
-  return WillLoadAsync;
+    // The newest visible rows are the ones the user is looking at now.
+    return priority == Priority_Visible ? queue.takeLast() : queue.takeFirst();
+  }
+
+  // Nothing else to do - find a library file that needs a moodbar.  These
+  // were checked for existing moodbars in the background already.
+  while (!precompute_files_.isEmpty()) {
+    const QUrl url = QUrl::fromLocalFile(precompute_files_.takeFirst());
+    if (requests_.contains(url)) continue;
+
+    CreateRequest(url, Priority_Library);
+    return queued_requests_[Priority_Library].takeFirst();
+  }
+
+  return QUrl();
+}
+
+QThread* MoodbarLoader::NextThread() {
+  QThread* least_busy = nullptr;
+  for (QThread* thread : threads_) {
+    if (!least_busy ||
+        thread_requests_[thread] < thread_requests_[least_busy]) {
+      least_busy = thread;
+    }
+  }
+
+  if (least_busy && thread_requests_[least_busy] == 0) return least_busy;
+
+  if (threads_.count() < max_active_requests_) {
+    QThread* thread = new QThread(this);
+    thread->start(QThread::IdlePriority);
+    threads_ << thread;
+    return thread;
+  }
+
+  return least_busy;
 }
 
 void MoodbarLoader::MaybeTakeNextRequest() {
   Q_ASSERT(QThread::currentThread() == qApp->thread());
 
-  if (active_requests_.count() >= kMaxActiveRequests ||
-      queued_requests_.isEmpty() || disable_moodbar_calculation_) {
+  while (active_requests_.count() < max_active_requests_ &&
+         !disable_moodbar_calculation_) {
+    const QUrl url = TakeNextQueuedRequest();
+    if (url.isEmpty()) break;
+
+    active_requests_ << url;
+
+    QThread* thread = NextThread();
+    thread_requests_[thread]++;
+    request_threads_[url] = thread;
+
+    MoodbarPipeline* pipeline = requests_[url];
+    pipeline->moveToThread(thread);
+
+    qLog(Info) << "Creating moodbar data for" << url.toLocalFile();
+    QMetaObject::invokeMethod(pipeline, "Start", Qt::QueuedConnection);
+  }
+
+  UpdatePrecomputeProgress();
+}
+
+void MoodbarLoader::PrecomputeLibrary() {
+  if (precompute_task_id_ != -1 || disable_moodbar_calculation_) return;
+
+  precompute_task_id_ =
+      app_->task_manager()->StartTask(tr("Generating moodbars"));
+  precompute_total_ = -1;
+
+  QFutureWatcher<QStringList>* watcher = new QFutureWatcher<QStringList>(this);
+  NewClosure(watcher, SIGNAL(finished()), this,
+             SLOT(PrecomputeFilesFound(QFutureWatcher<QStringList>*)),
+             watcher);
+  watcher->setFuture(QtConcurrent::run(&MoodbarLoader::FilesWithoutMoodbars,
+                                       app_->library_backend(),
+                                       cache_->cacheDirectory()));
+}
+
+QStringList MoodbarLoader::FilesWithoutMoodbars(
+    LibraryBackend* backend, const QString& cache_directory) {
+  // Our own cache object, since the loader's is only used on the GUI thread.
+  // This one only reads from the cache.
+  QNetworkDiskCache cache;
+  cache.setCacheDirectory(cache_directory);
+
+  QStringList ret;
+  for (const Song& song : backend->GetAllSongs()) {
+    if (song.url().scheme() != "file") continue;
+
+    const QString filename = song.url().toLocalFile();
+    if (!MoodFileExists(filename) && !cache.metaData(song.url()).isValid()) {
+      ret << filename;
+    }
+  }
+  ret.removeDuplicates();
+  return ret;
+}
+
+void MoodbarLoader::PrecomputeFilesFound(
+    QFutureWatcher<QStringList>* watcher) {
+  watcher->deleteLater();
+
+  // Calculation might have been disabled while the files were found.
+  if (!is_precomputing()) return;
+
+  precompute_files_ = watcher->result();
+  precompute_total_ = precompute_files_.count();
+  qLog(Info) << precompute_total_ << "songs in the library might need moodbars";
+
+  MaybeTakeNextRequest();
+}
+
+void MoodbarLoader::UpdatePrecomputeProgress() {
+  // Wait until the list of files has been loaded.
+  if (precompute_task_id_ == -1 || precompute_total_ == -1) return;
+
+  const int remaining = precompute_files_.count() +
+                        request_priorities_.keys(Priority_Library).count();
+  if (remaining == 0) {
+    FinishPrecompute();
     return;
   }
 
-  const QUrl url = queued_requests_.takeFirst();
-  active_requests_ << url;
+  app_->task_manager()->SetTaskProgress(
+      precompute_task_id_, precompute_total_ - remaining, precompute_total_);
+}
+
+void MoodbarLoader::FinishPrecompute() {
+  app_->task_manager()->SetTaskFinished(precompute_task_id_);
+  precompute_task_id_ = -1;
+  precompute_total_ = 0;
+  precompute_files_.clear();
 
-  qLog(Info) << "Creating moodbar data for" << url.toLocalFile();
-  QMetaObject::invokeMethod(requests_[url], "Start", Qt::QueuedConnection);
+  emit PrecomputeFinished();
 }
 
 void MoodbarLoader::RequestFinished(MoodbarPipeline* request, const QUrl& url) {
@@ -188,8 +362,12 @@ void MoodbarLoader::RequestFinished(MoodbarPipeline* request, const QUrl& url) {
 
   // Remove the request from the active list and delete it
   requests_.remove(url);
+  request_priorities_.remove(url);
   active_requests_.remove(url);
 
+  QThread* thread = request_threads_.take(url);
+  if (thread) thread_requests_[thread]--;
+
   QTimer::singleShot(1000, request, SLOT(deleteLater()));
 
   MaybeTakeNextRequest();
@@ -18,14 +18,17 @@
 #ifndef MOODBARLOADER_H
 #define MOODBARLOADER_H
 
+#include <QFutureWatcher>
 #include <QMap>
 #include <QObject>
 #include <QSet>
+#include <QStringList>
 
 class QNetworkDiskCache;
 class QUrl;
 
 class Application;
+class LibraryBackend;
 class MoodbarPipeline;
 
 class MoodbarLoader : public QObject {
@@ -35,6 +38,24 @@ class MoodbarLoader : public QObject {
   MoodbarLoader(Application* app, QObject* parent = nullptr);
   ~MoodbarLoader();
 
+  static const char* kSettingsGroup;
+
+  // The default number of moodbars that are generated at the same time.
+  static int DefaultMaxActiveRequests();
+
+  // Moodbars are generated in order of priority, highest first.
+  enum Priority {
+    // Songs in the library that don't have a moodbar yet.
+    Priority_Library = 0,
+    // Songs in playlist rows that are visible on screen.  The most recently
+    // requested of these are generated first.
+    Priority_Visible,
+    // The song that's playing now.
+    Priority_CurrentSong,
+
+    PriorityCount
+  };
+
   enum Result {
     // The URL isn't a local file or the moodbar plugin was not available -
     // moodbar data can never be loaded.
@@ -49,7 +70,22 @@ class MoodbarLoader : public QObject {
   };
 
   Result Load(const QUrl& url, QByteArray* data,
-              MoodbarPipeline** async_pipeline);
+              MoodbarPipeline** async_pipeline,
+              Priority priority = Priority_Visible);
+
+  // True between PrecomputeLibrary being called and PrecomputeFinished.
+  bool is_precomputing() const { return precompute_task_id_ != -1; }
+
+ public slots:
+  // Generates moodbars for every song in the library that doesn't have one
+  // yet.  They're only worked on when there's nothing more important to do,
+  // and progress is shown in the TaskManager.
+  void PrecomputeLibrary();
+
+signals:
+  // Emitted when PrecomputeLibrary has finished, or has been stopped because
+  // moodbar calculation was disabled.
+  void PrecomputeFinished();
 
  private slots:
   void ReloadSettings();
@@ -57,19 +93,45 @@ class MoodbarLoader : public QObject {
   void RequestFinished(MoodbarPipeline* request, const QUrl& filename);
   void MaybeTakeNextRequest();
 
+  void PrecomputeFilesFound(QFutureWatcher<QStringList>* watcher);
+
  private:
   static QStringList MoodFilenames(const QString& song_filename);
+  static bool MoodFileExists(const QString& song_filename);
+  static QStringList FilesWithoutMoodbars(LibraryBackend* backend,
+                                          const QString& cache_directory);
+
+  MoodbarPipeline* CreateRequest(const QUrl& url, Priority priority);
+  // Returns the next request to start, or an empty URL if there isn't one.
+  QUrl TakeNextQueuedRequest();
+  QThread* NextThread();
+  void UpdatePrecomputeProgress();
+  void FinishPrecompute();
 
  private:
+  Application* app_;
   QNetworkDiskCache* cache_;
-  QThread* thread_;
 
-  const int kMaxActiveRequests;
+  // Pipelines are spread over these threads, one is added for each request
+  // that can be active at once.  Each request goes to an idle thread if there
+  // is one, or else the one with the fewest requests.
+  QList<QThread*> threads_;
+  QMap<QThread*, int> thread_requests_;
+  QMap<QUrl, QThread*> request_threads_;
+
+  int max_active_requests_;
 
   QMap<QUrl, MoodbarPipeline*> requests_;
-  QList<QUrl> queued_requests_;
+  QList<QUrl> queued_requests_[PriorityCount];
+  QMap<QUrl, Priority> request_priorities_;
   QSet<QUrl> active_requests_;
 
+  // Library files that still have to be looked at by PrecomputeLibrary.
+  // Requests are only created for these when they're about to be started.
+  QStringList precompute_files_;
+  int precompute_task_id_;
+  int precompute_total_;
+
   bool save_alongside_originals_;
   bool disable_moodbar_calculation_;
 };
@@ -165,11 +165,19 @@ void IncomingDataParser::Parse(const pb::remote::Message& msg) {
       client->song_sender()->SendSongs(msg.request_download_songs());
       break;
     case pb::remote::SONG_OFFER_RESPONSE:
-      client->song_sender()->ResponseSongOffer(msg.response_song_offer().accepted());
+      client->song_sender()->ResponseSongOffer(
+          msg.response_song_offer().accepted(),
+          msg.response_song_offer().offset());
       break;
     case pb::remote::GET_LIBRARY:
       emit SendLibrary(client);
       break;
+    case pb::remote::GET_LIBRARY_CHANGES:
+      emit SendLibraryChanges(
+          client,
+          QStringFromStdString(msg.request_library_changes().library_id()),
+          msg.request_library_changes().revision());
+      break;
     case pb::remote::RATE_SONG:
       RateSong(msg);
       break;
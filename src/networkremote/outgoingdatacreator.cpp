@@ -436,7 +436,10 @@ void OutgoingDataCreator::SendPlaylistSongs(int id) {
 
   // Send all songs
   int index = 0;
-  SongList song_list = playlist->GetAllSongs();
+  // Playlists that haven't been shown yet aren't loaded.
+  SongList song_list = playlist->is_restored()
+                           ? playlist->GetAllSongs()
+                           : app_->playlist_backend()->GetPlaylistSongs(id);
   QListIterator<Song> it(song_list);
   QImage null_img;
   while (it.hasNext()) {
@@ -594,6 +597,71 @@ void OutgoingDataCreator::SendLyrics(int id,
 }
 
 void OutgoingDataCreator::SendLibrary(RemoteClient* client) {
+  pb::remote::Message msg;
+  msg.set_type(pb::remote::LIBRARY_CHUNK);
+
+  SendLibraryExport(
+      client,
+      QStringList() << "create table songs_export.songs as SELECT * FROM songs "
+                       "where unavailable = 0;",
+      &msg);
+}
+
+void OutgoingDataCreator::SendLibraryChanges(RemoteClient* client,
+                                             const QString& library_id,
+                                             qint64 revision) {
+  // Read the revision before exporting anything.  A song that changes while
+  // we're exporting will be sent again next time, which is harmless.
+  QString current_library_id;
+  qint64 current_revision = 0;
+  app_->library_backend()->GetRevision(&current_library_id, &current_revision);
+
+  const bool incremental = !library_id.isEmpty() &&
+                           library_id == current_library_id &&
+                           revision >= 0 && revision <= current_revision;
+
+  pb::remote::Message msg;
+  msg.set_type(pb::remote::LIBRARY_CHUNK);
+  pb::remote::ResponseLibraryChunk* chunk =
+      msg.mutable_response_library_chunk();
+  chunk->set_incremental(incremental);
+  chunk->set_library_id(DataCommaSizeFromQString(current_library_id));
+  chunk->set_revision(current_revision);
+
+  QStringList queries;
+  if (incremental) {
+    const QString since = QString::number(revision);
+    queries << "create table songs_export.songs as"
+               " SELECT songs.ROWID AS song_id, songs.* FROM songs"
+               " JOIN library_changes"
+               "   ON library_changes.song_id = songs.ROWID"
+               "  AND library_changes.revision > " + since +
+               " where songs.unavailable = 0;"
+            << "create table songs_export.deleted_songs as"
+               " SELECT song_id FROM library_changes"
+               " WHERE revision > " + since + " AND deleted = 1"
+               " UNION"
+               " SELECT songs.ROWID FROM songs"
+               " JOIN library_changes"
+               "   ON library_changes.song_id = songs.ROWID"
+               "  AND library_changes.revision > " + since +
+               " WHERE songs.unavailable = 1;";
+  } else {
+    queries << "create table songs_export.songs as"
+               " SELECT songs.ROWID AS song_id, songs.* FROM songs"
+               " where unavailable = 0;";
+  }
+
+  qLog(Debug) << "Sending library" << current_library_id << "revision"
+              << current_revision << (incremental ? "since" : "from scratch")
+              << revision;
+
+  SendLibraryExport(client, queries, &msg);
+}
+
+void OutgoingDataCreator::SendLibraryExport(RemoteClient* client,
+                                            const QStringList& queries,
+                                            pb::remote::Message* msg) {
   // Get a temporary file name
   QString temp_file_name = Utilities::GetTemporaryFileName();
 
@@ -603,13 +671,15 @@ void OutgoingDataCreator::SendLibrary(RemoteClient* client) {
 
   app_->database()->AttachDatabaseOnDbConnection("songs_export", adb, db);
 
-  // Copy the content of the song table to this temporary database
-  QSqlQuery q(QString(
-                  "create table songs_export.songs as SELECT * FROM songs "
-                  "where unavailable = 0;"),
-              db);
-
-  if (app_->database()->CheckErrors(q)) return;
+  // Copy the requested songs to this temporary database
+  for (const QString& query : queries) {
+    QSqlQuery q(query, db);
+    if (app_->database()->CheckErrors(q)) {
+      app_->database()->DetachDatabase("songs_export");
+      QFile::remove(temp_file_name);
+      return;
+    }
+  }
 
   // Detach the database
   app_->database()->DetachDatabase("songs_export");
@@ -624,10 +694,8 @@ void OutgoingDataCreator::SendLibrary(RemoteClient* client) {
   file.open(QIODevice::ReadOnly);
 
   QByteArray data;
-  pb::remote::Message msg;
   pb::remote::ResponseLibraryChunk* chunk =
-      msg.mutable_response_library_chunk();
-  msg.set_type(pb::remote::LIBRARY_CHUNK);
+      msg->mutable_response_library_chunk();
 
   // Calculate the number of chunks
   int chunk_count = qRound((file.size() / kFileChunkSize) + 0.5);
@@ -645,10 +713,10 @@ void OutgoingDataCreator::SendLibrary(RemoteClient* client) {
     chunk->set_file_hash(sha1.data(), sha1.size());
 
     // Send data directly to the client
-    client->SendData(&msg);
+    client->SendData(msg);
 
-    // Clear working data
-    chunk->Clear();
+    // Clear working data.  The revision fields are the same in every chunk.
+    chunk->clear_data();
     data.clear();
 
     chunk_number++;
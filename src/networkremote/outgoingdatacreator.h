@@ -78,6 +78,8 @@ class OutgoingDataCreator : public QObject {
   void GetLyrics();
   void SendLyrics(int id, const SongInfoFetcher::Result& result);
   void SendLibrary(RemoteClient* client);
+  void SendLibraryChanges(RemoteClient* client, const QString& library_id,
+                          qint64 revision);
   void EnableKittens(bool aww);
   void SendKitten(const QImage& kitten);
 
@@ -106,6 +108,10 @@ class OutgoingDataCreator : public QObject {
   QMap<int, GlobalSearchRequest> global_search_result_map_;
 
   void SendDataToClients(pb::remote::Message* msg);
+  // Runs each query with the export database attached as songs_export, then
+  // sends the database to the client in chunks of msg.
+  void SendLibraryExport(RemoteClient* client, const QStringList& queries,
+                         pb::remote::Message* msg);
   void SetEngineState(pb::remote::ResponseClementineInfo* msg);
   void CheckEnabledProviders();
   SongInfoProvider* ProviderByName(const QString& name) const;
@@ -35,6 +35,7 @@ RemoteClient::RemoteClient(Application* app, QTcpSocket* client)
 
   // Connect to the slot IncomingData when receiving data
   connect(client, SIGNAL(readyRead()), this, SLOT(IncomingData()));
+  connect(client, SIGNAL(bytesWritten(qint64)), SIGNAL(BytesWritten(qint64)));
 
   // Check if we use auth code
   QSettings s;
@@ -187,4 +188,14 @@ void RemoteClient::SendData(pb::remote::Message* msg) {
   }
 }
 
+void RemoteClient::SendRawData(const char* data, qint64 size) {
+  if (!authenticated_) return;
+
+  if (client_->state() == QTcpSocket::ConnectedState) {
+    client_->write(data, size);
+  } else {
+    client_->close();
+  }
+}
+
 QAbstractSocket::SocketState RemoteClient::State() { return client_->state(); }
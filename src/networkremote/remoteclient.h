@@ -18,6 +18,11 @@ class RemoteClient : public QObject {
 
   // This method checks if client is authenticated before sending the data
   void SendData(pb::remote::Message* msg);
+  // Writes bytes to the socket without any framing.  Used to send file data
+  // after a message that announces it.
+  void SendRawData(const char* data, qint64 size);
+  // The number of bytes that are waiting to be written to the socket.
+  qint64 BytesToWrite() const { return client_->bytesToWrite(); }
   QAbstractSocket::SocketState State();
   void setDownloader(bool downloader);
   bool isDownloader() { return downloader_; }
@@ -30,6 +35,7 @@ class RemoteClient : public QObject {
 
 signals:
   void Parse(const pb::remote::Message& msg);
+  void BytesWritten(qint64 bytes);
 
  private:
   void ParseMessage(const QByteArray& data);
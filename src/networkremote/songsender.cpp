@@ -25,14 +25,21 @@
 #include "core/logging.h"
 #include "core/utilities.h"
 #include "library/librarybackend.h"
+#include "playlist/playlistbackend.h"
 #include "playlist/playlistitem.h"
 
 const quint32 SongSender::kFileChunkSize = 100000;  // in Bytes
+const qint64 SongSender::kStreamBufferSize = 512 * 1024;  // in Bytes
 
 SongSender::SongSender(Application* app, RemoteClient* client)
     : app_(app),
       client_(client),
-      transcoder_(new Transcoder(this)) {
+      transcoder_(new Transcoder(this)),
+      raw_data_(false),
+      stream_transcoded_(false),
+      stream_chunk_count_(0),
+      stream_chunk_number_(0),
+      stream_hash_(QCryptographicHash::Sha1) {
   QSettings s;
   s.beginGroup(NetworkRemote::kSettingsGroup);
 
@@ -49,9 +56,13 @@ SongSender::SongSender(Application* app, RemoteClient* client)
   }
   qLog(Debug) << "Transcoder preset" << transcoder_preset_.codec_mimetype_;
 
+  // Someone is waiting for these on their phone
+  transcoder_->set_priority(TranscoderScheduler::Priority_Interactive);
+
   connect(transcoder_, SIGNAL(JobComplete(QString, QString, bool)),
           SLOT(TranscodeJobComplete(QString, QString, bool)));
   connect(transcoder_, SIGNAL(AllJobsComplete()), SLOT(StartTransfer()));
+  connect(client_, SIGNAL(BytesWritten(qint64)), SLOT(StreamNextChunks()));
 
   total_transcode_ = 0;
 }
@@ -61,6 +72,7 @@ SongSender::~SongSender() {
           SLOT(TranscodeJobComplete(QString, QString, bool)));
   disconnect(transcoder_, SIGNAL(AllJobsComplete()), this, SLOT(StartTransfer()));
   transcoder_->Cancel();
+  CloseStream();
 }
 
 void SongSender::SendSongs(const pb::remote::RequestDownloadSongs& request) {
@@ -69,6 +81,8 @@ void SongSender::SendSongs(const pb::remote::RequestDownloadSongs& request) {
     current_song = app_->player()->GetCurrentItem()->Metadata();
   }
 
+  raw_data_ = request.raw_data();
+
   switch (request.download_item()) {
     case pb::remote::CurrentItem: {
       if (current_song.is_valid()) {
@@ -152,8 +166,9 @@ void SongSender::StartTransfer() {
   // Send total file size & file count
   SendTotalFileSize();
 
-  // Send first file
-  OfferNextSong();
+  // Send first file.  If we're still streaming one the next is offered when
+  // it's finished.
+  if (!stream_file_) OfferNextSong();
 }
 
 void SongSender::SendTotalFileSize() {
@@ -210,19 +225,42 @@ void SongSender::OfferNextSong() {
   client_->SendData(&msg);
 }
 
-void SongSender::ResponseSongOffer(bool accepted) {
-  if (download_queue_.isEmpty()) return;
+void SongSender::ResponseSongOffer(bool accepted, qint64 offset) {
+  if (download_queue_.isEmpty() || stream_file_) return;
 
   // Get the item and send the single song
   DownloadItem item = download_queue_.dequeue();
-  if (accepted)
-    SendSingleSong(item);
+  if (accepted) {
+    if (raw_data_) {
+      // The next song is offered when the stream is finished
+      StartStream(item, offset);
+      return;
+    }
+    SendSingleSong(item, offset);
+  }
 
   // And offer the next song
   OfferNextSong();
 }
 
-void SongSender::SendSingleSong(DownloadItem download_item) {
+void SongSender::CreateFileMetadata(const DownloadItem& item,
+                                    bool is_transcoded, qint64 file_size,
+                                    pb::remote::SongMetadata* song_metadata) {
+  int i = app_->playlist_manager()->active()->current_row();
+  OutgoingDataCreator::CreateSong(item.song_, QImage(), i, song_metadata);
+
+  // if the file was transcoded, we have to change the filename and filesize
+  if (is_transcoded) {
+    song_metadata->set_file_size(file_size);
+    QString basefilename = item.song_.basefilename();
+    QFileInfo info(basefilename);
+    basefilename.replace("." + info.suffix(),
+                         "." + transcoder_preset_.extension_);
+    song_metadata->set_filename(DataCommaSizeFromQString(basefilename));
+  }
+}
+
+void SongSender::SendSingleSong(DownloadItem download_item, qint64 offset) {
   // Only local files!!!
   if (!(download_item.song_.url().scheme() == "file")) return;
 
@@ -241,6 +279,7 @@ void SongSender::SendSingleSong(DownloadItem download_item) {
   qLog(Debug) << "sha1 for file" << local_file << "=" << sha1;
 
   file.open(QIODevice::ReadOnly);
+  file.seek(qBound(qint64(0), offset, file.size()));
 
   QByteArray data;
   pb::remote::Message msg;
@@ -248,13 +287,13 @@ void SongSender::SendSingleSong(DownloadItem download_item) {
       msg.mutable_response_song_file_chunk();
   msg.set_type(pb::remote::SONG_FILE_CHUNK);
 
-  QImage null_image;
-
   // Calculate the number of chunks
-  int chunk_count = qRound((file.size() / kFileChunkSize) + 0.5);
+  int chunk_count = qRound(((file.size() - file.pos()) / kFileChunkSize) + 0.5);
   int chunk_number = 1;
 
   while (!file.atEnd()) {
+    chunk->set_offset(file.pos());
+
     // Read file chunk
     data = file.read(kFileChunkSize);
 
@@ -270,20 +309,8 @@ void SongSender::SendSingleSong(DownloadItem download_item) {
     // On the first chunk send the metadata, so the client knows
     // what file it receives.
     if (chunk_number == 1) {
-      int i = app_->playlist_manager()->active()->current_row();
-      pb::remote::SongMetadata* song_metadata =
-          msg.mutable_response_song_file_chunk()->mutable_song_metadata();
-      OutgoingDataCreator::CreateSong(download_item.song_, null_image, i,song_metadata);
-
-      // if the file was transcoded, we have to change the filename and filesize
-      if (is_transcoded) {
-        song_metadata->set_file_size(file.size());
-        QString basefilename = download_item.song_.basefilename();
-        QFileInfo info(basefilename);
-        basefilename.replace("." + info.suffix(),
-                             "." + transcoder_preset_.extension_);
-        song_metadata->set_filename(DataCommaSizeFromQString(basefilename));
-      }
+      CreateFileMetadata(download_item, is_transcoded, file.size(),
+                         chunk->mutable_song_metadata());
     }
 
     // Send data directly to the client
@@ -304,6 +331,135 @@ void SongSender::SendSingleSong(DownloadItem download_item) {
   }
 }
 
+void SongSender::StartStream(const DownloadItem& item, qint64 offset) {
+  // Only local files!!!
+  if (item.song_.url().scheme() != "file") {
+    OfferNextSong();
+    return;
+  }
+
+  QString local_file = item.song_.url().toLocalFile();
+  stream_transcoded_ = transcoder_map_.contains(local_file);
+
+  if (stream_transcoded_) {
+    local_file = transcoder_map_.take(local_file);
+  }
+
+  stream_file_.reset(new QFile(local_file));
+  if (!stream_file_->open(QIODevice::ReadOnly)) {
+    qLog(Warning) << "Couldn't open" << local_file;
+    CloseStream();
+    OfferNextSong();
+    return;
+  }
+
+  stream_item_ = item;
+  stream_hash_.reset();
+  offset = qBound(qint64(0), offset, stream_file_->size());
+
+  // The hash is of the whole file, so read the part the client already has.
+  while (stream_file_->pos() < offset) {
+    if (ReadStreamChunk(offset - stream_file_->pos()) <= 0) {
+      qLog(Warning) << "Couldn't read" << local_file;
+      CloseStream();
+      OfferNextSong();
+      return;
+    }
+  }
+
+  // One chunk for each block of data and a last one with the hash
+  stream_chunk_count_ =
+      qRound(((stream_file_->size() - offset) / kFileChunkSize) + 0.5) + 1;
+  stream_chunk_number_ = 1;
+
+  qLog(Debug) << "Streaming" << local_file << "from" << offset;
+
+  StreamNextChunks();
+}
+
+qint64 SongSender::ReadStreamChunk(qint64 max_size) {
+  // The buffer is reused for every chunk, and the socket copies what we write
+  // into its own buffer, so the file data is never copied anywhere else.
+  if (stream_buffer_.size() < int(kFileChunkSize)) {
+    stream_buffer_.resize(kFileChunkSize);
+  }
+
+  const qint64 ret = stream_file_->read(stream_buffer_.data(),
+                                        qMin(max_size, qint64(kFileChunkSize)));
+  if (ret > 0) {
+    stream_hash_.addData(stream_buffer_.constData(), ret);
+  }
+  return ret;
+}
+
+void SongSender::StreamNextChunks() {
+  if (!stream_file_) return;
+
+  if (client_->State() != QAbstractSocket::ConnectedState) {
+    CloseStream();
+    return;
+  }
+
+  // Only read more of the file once the socket has written most of what we
+  // gave it last time.  We're called again whenever it writes something.
+  while (client_->BytesToWrite() < kStreamBufferSize) {
+    pb::remote::Message msg;
+    msg.set_type(pb::remote::SONG_FILE_CHUNK);
+    pb::remote::ResponseSongFileChunk* chunk =
+        msg.mutable_response_song_file_chunk();
+
+    chunk->set_chunk_count(stream_chunk_count_);
+    chunk->set_chunk_number(stream_chunk_number_);
+    chunk->set_file_count(stream_item_.song_count_);
+    chunk->set_file_number(stream_item_.song_no_);
+    chunk->set_size(stream_file_->size());
+    chunk->set_offset(stream_file_->pos());
+
+    // On the first chunk send the metadata, so the client knows
+    // what file it receives.
+    if (stream_chunk_number_ == 1) {
+      CreateFileMetadata(stream_item_, stream_transcoded_,
+                         stream_file_->size(), chunk->mutable_song_metadata());
+    }
+
+    if (stream_file_->atEnd()) {
+      // The last chunk has the hash of the file and no data
+      const QByteArray sha1 = stream_hash_.result().toHex();
+      chunk->set_raw_data_size(0);
+      chunk->set_file_hash(sha1.data(), sha1.size());
+      client_->SendData(&msg);
+
+      CloseStream();
+      OfferNextSong();
+      return;
+    }
+
+    const qint64 size = ReadStreamChunk(kFileChunkSize);
+    if (size <= 0) {
+      qLog(Warning) << "Couldn't read" << stream_file_->fileName();
+      CloseStream();
+      OfferNextSong();
+      return;
+    }
+
+    chunk->set_raw_data_size(size);
+    client_->SendData(&msg);
+    client_->SendRawData(stream_buffer_.constData(), size);
+
+    stream_chunk_number_++;
+  }
+}
+
+void SongSender::CloseStream() {
+  if (!stream_file_) return;
+
+  // If the file was transcoded, delete the temporary one
+  if (stream_transcoded_) {
+    stream_file_->remove();
+  }
+  stream_file_.reset();
+}
+
 void SongSender::SendAlbum(const Song& song) {
   // No streams!
   if (song.url().scheme() != "file") return;
@@ -322,7 +478,11 @@ void SongSender::SendPlaylist(int playlist_id) {
     qLog(Info) << "Could not find playlist with id = " << playlist_id;
     return;
   }
-  SongList song_list = playlist->GetAllSongs();
+  // Playlists that haven't been shown yet aren't loaded.
+  SongList song_list =
+      playlist->is_restored()
+          ? playlist->GetAllSongs()
+          : app_->playlist_backend()->GetPlaylistSongs(playlist_id);
 
   // Count the local songs
   int count = 0;
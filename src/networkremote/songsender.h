@@ -1,6 +1,10 @@
 #ifndef SONGSENDER_H
 #define SONGSENDER_H
 
+#include <memory>
+
+#include <QCryptographicHash>
+#include <QFile>
 #include <QMap>
 #include <QQueue>
 #include <QUrl>
@@ -18,6 +22,7 @@ struct DownloadItem {
   Song song_;
   int song_no_;
   int song_count_;
+  DownloadItem() : song_no_(0), song_count_(0) {}
   DownloadItem(Song s, int no, int count)
     : song_(s), song_no_(no), song_count_(count) {}
 };
@@ -29,14 +34,18 @@ class SongSender : public QObject {
   ~SongSender();
 
   static const quint32 kFileChunkSize;
+  // When streaming raw data, no more of the file is read while this many
+  // bytes are still waiting to be written to the socket.
+  static const qint64 kStreamBufferSize;
 
  public slots:
   void SendSongs(const pb::remote::RequestDownloadSongs& request);
-  void ResponseSongOffer(bool accepted);
+  void ResponseSongOffer(bool accepted, qint64 offset = 0);
 
  private slots:
   void TranscodeJobComplete(const QString& input, const QString& output, bool success);
   void StartTransfer();
+  void StreamNextChunks();
 
  private:
   Application* app_;
@@ -50,7 +59,23 @@ class SongSender : public QObject {
   QMap<QString, QString> transcoder_map_;
   int total_transcode_;
 
-  void SendSingleSong(DownloadItem download_item);
+  // The file being streamed when the client asked for raw data.
+  bool raw_data_;
+  std::unique_ptr<QFile> stream_file_;
+  DownloadItem stream_item_;
+  bool stream_transcoded_;
+  int stream_chunk_count_;
+  int stream_chunk_number_;
+  QCryptographicHash stream_hash_;
+  QByteArray stream_buffer_;
+
+  void SendSingleSong(DownloadItem download_item, qint64 offset);
+  void StartStream(const DownloadItem& item, qint64 offset);
+  qint64 ReadStreamChunk(qint64 max_size);
+  void CloseStream();
+  void CreateFileMetadata(const DownloadItem& item, bool is_transcoded,
+                          qint64 file_size,
+                          pb::remote::SongMetadata* song_metadata);
   void SendAlbum(const Song& song);
   void SendPlaylist(int playlist_id);
   void SendUrls(const pb::remote::RequestDownloadSongs& request);
@@ -27,6 +27,7 @@
 #include <QCoreApplication>
 #include <QDirIterator>
 #include <QFileInfo>
+#include <QHash>
 #include <QLinkedList>
 #include <QMimeData>
 #include <QMutableListIterator>
@@ -38,6 +39,7 @@
 #include "playlistbackend.h"
 #include "playlistfilter.h"
 #include "playlistitemmimedata.h"
+#include "playlistsorter.h"
 #include "playlistundocommands.h"
 #include "playlistview.h"
 #include "queue.h"
@@ -46,6 +48,7 @@
 #include "songplaylistitem.h"
 #include "core/application.h"
 #include "core/closure.h"
+#include "core/fileexistencechecker.h"
 #include "core/logging.h"
 #include "core/modelfuturewatcher.h"
 #include "core/qhash_qurl.h"
@@ -95,6 +98,9 @@ const char* Playlist::kWriteMetadata = "write_metadata";
 const int Playlist::kUndoStackSize = 20;
 const int Playlist::kUndoItemLimit = 500;
 
+const int Playlist::kRestoreFirstPageSize = 200;
+const int Playlist::kRestorePageSize = 5000;
+
 const qint64 Playlist::kMinScrobblePointNsecs = 31ll * kNsecPerSec;
 const qint64 Playlist::kMaxScrobblePointNsecs = 240ll * kNsecPerSec;
 
@@ -102,7 +108,9 @@ Playlist::Playlist(PlaylistBackend* backend, TaskManager* task_manager,
                    LibraryBackend* library, int id, const QString& special_type,
                    bool favorite, QObject* parent)
     : QAbstractListModel(parent),
+      restore_state_(backend ? Restore_NotStarted : Restore_Finished),
       is_loading_(false),
+      changed_while_restoring_(false),
       proxy_(new PlaylistFilter(this)),
       queue_(new Queue(this)),
       backend_(backend),
@@ -110,6 +118,9 @@ Playlist::Playlist(PlaylistBackend* backend, TaskManager* task_manager,
       library_(library),
       id_(id),
       favorite_(favorite),
+      last_restored_position_(-1),
+      restore_page_limit_(0),
+      restore_watcher_(nullptr),
       current_is_paused_(false),
       current_virtual_index_(-1),
       is_shuffled_(false),
@@ -127,7 +138,9 @@ Playlist::Playlist(PlaylistBackend* backend, TaskManager* task_manager,
   connect(this, SIGNAL(rowsRemoved(const QModelIndex&, int, int)),
           SIGNAL(PlaylistChanged()));
 
-  Restore();
+  // Anything that changes the playlist before it's been looked at needs the
+  // rest of the items to be there too.
+  connect(this, SIGNAL(PlaylistChanged()), SLOT(Restore()));
 
   proxy_->setSourceModel(this);
   queue_->setSourceModel(this);
@@ -269,7 +282,8 @@ QVariant Playlist::data(const QModelIndex& index, int role) const {
       PlaylistItemPtr item = items_[index.row()];
       Song song = item->Metadata();
 
-      // Don't forget to change Playlist::CompareItems when adding new columns
+      // Don't forget to change Playlist::CompareItems and
+      // PlaylistSorter::MakeKey when adding new columns
       switch (index.column()) {
         case Column_Title:
           return song.PrettyTitle();
@@ -879,7 +893,9 @@ void Playlist::MoveItemWithoutUndo(int source, int dest) {
 
 void Playlist::MoveItemsWithoutUndo(const QList<int>& source_rows, int pos) {
   layoutAboutToBeChanged();
+  BeginDelta();
   PlaylistItemList moved_items;
+  QList<qint64> moved_positions;
 
   if (pos < 0) {
     pos = items_.count();
@@ -891,6 +907,7 @@ void Playlist::MoveItemsWithoutUndo(const QList<int>& source_rows, int pos) {
   int start = pos;
   for (int source_row : source_rows) {
     moved_items << items_.takeAt(source_row - offset);
+    moved_positions << positions_.takeAt(source_row - offset);
     if (pos > source_row) {
       start--;
     }
@@ -898,9 +915,17 @@ void Playlist::MoveItemsWithoutUndo(const QList<int>& source_rows, int pos) {
   }
 
   // Put the items back in
+  QList<int> moved_rows;
   for (int i = start; i < start + moved_items.count(); ++i) {
     moved_items[i - start]->RemoveForegroundColor(kDynamicHistoryPriority);
     items_.insert(i, moved_items[i - start]);
+    positions_.insert(i, moved_positions[i - start]);
+    moved_rows << i;
+  }
+
+  AssignPositions(moved_rows);
+  for (int i = 0; i < moved_rows.count(); ++i) {
+    RecordMove(moved_positions[i], positions_[moved_rows[i]]);
   }
 
   // Update persistent indexes
@@ -929,7 +954,9 @@ void Playlist::MoveItemsWithoutUndo(const QList<int>& source_rows, int pos) {
 
 void Playlist::MoveItemsWithoutUndo(int start, const QList<int>& dest_rows) {
   layoutAboutToBeChanged();
+  BeginDelta();
   PlaylistItemList moved_items;
+  QList<qint64> moved_positions;
 
   int pos = start;
   for (int dest_row : dest_rows) {
@@ -941,16 +968,24 @@ void Playlist::MoveItemsWithoutUndo(int start, const QList<int>& dest_rows) {
   }
 
   // Take the items out of the list first
-  for (int i = 0; i < dest_rows.count(); i++)
+  for (int i = 0; i < dest_rows.count(); i++) {
     moved_items << items_.takeAt(start);
+    moved_positions << positions_.takeAt(start);
+  }
 
   // Put the items back in
   int offset = 0;
   for (int dest_row : dest_rows) {
     items_.insert(dest_row, moved_items[offset]);
+    positions_.insert(dest_row, moved_positions[offset]);
     offset++;
   }
 
+  AssignPositions(dest_rows);
+  for (int i = 0; i < dest_rows.count(); ++i) {
+    RecordMove(moved_positions[i], positions_[dest_rows[i]]);
+  }
+
   // Update persistent indexes
   for (const QModelIndex& pidx : persistentIndexList()) {
     if (pidx.row() >= start && pidx.row() < start + dest_rows.count()) {
@@ -980,6 +1015,9 @@ void Playlist::InsertItems(const PlaylistItemList& itemsIn, int pos,
                            bool play_now, bool enqueue) {
   if (itemsIn.isEmpty()) return;
 
+  // The items have to go after the ones that haven't been loaded yet.
+  RestoreNow();
+
   PlaylistItemList items = itemsIn;
 
   // exercise vetoes
@@ -1044,10 +1082,15 @@ void Playlist::InsertItemsWithoutUndo(const PlaylistItemList& items, int pos,
   const int start = pos == -1 ? items_.count() : pos;
   const int end = start + items.count() - 1;
 
+  BeginDelta();
+  QList<int> inserted_rows;
+
   beginInsertRows(QModelIndex(), start, end);
   for (int i = start; i <= end; ++i) {
     PlaylistItemPtr item = items[i - start];
     items_.insert(i, item);
+    positions_.insert(i, 0);
+    inserted_rows << i;
     virtual_items_ << virtual_items_.count();
 
     if (item->type() == "Library") {
@@ -1065,6 +1108,11 @@ void Playlist::InsertItemsWithoutUndo(const PlaylistItemList& items, int pos,
   }
   endInsertRows();
 
+  AssignPositions(inserted_rows);
+  for (int row : inserted_rows) {
+    RecordInsert(row);
+  }
+
   if (enqueue) {
     QModelIndexList indexes;
     for (int i = start; i <= end; ++i) {
@@ -1152,6 +1200,8 @@ void Playlist::UpdateItems(const SongList& songs) {
   QLinkedList<Song> songs_list;
   for (const Song& song : songs) songs_list.append(song);
 
+  BeginDelta();
+
   for (int i = 0; i < items_.size(); i++) {
     // Update current items list
     QMutableLinkedListIterator<Song> it(songs_list);
@@ -1172,6 +1222,8 @@ void Playlist::UpdateItems(const SongList& songs) {
           new_item = PlaylistItemPtr(new SongPlaylistItem(song));
         }
         items_[i] = new_item;
+        RecordRemove(positions_[i]);
+        RecordInsert(i);
         emit dataChanged(index(i, 0), index(i, ColumnCount - 1));
         // Also update undo actions
         for (int i = 0; i < undo_stack_->count(); i++) {
@@ -1402,18 +1454,13 @@ void Playlist::sort(int column, Qt::SortOrder order) {
   if (dynamic_playlist_ && current_item_index_.isValid())
     begin += current_item_index_.row() + 1;
 
+  QList<int> columns;
+  columns << column;
   if (column == Column_Album) {
     // When sorting by album, also take into account discs and tracks.
-    qStableSort(begin, new_items.end(), std::bind(&Playlist::CompareItems,
-                                                  Column_Track, order, _1, _2));
-    qStableSort(begin, new_items.end(),
-                std::bind(&Playlist::CompareItems, Column_Disc, order, _1, _2));
-    qStableSort(begin, new_items.end(), std::bind(&Playlist::CompareItems,
-                                                  Column_Album, order, _1, _2));
-  } else {
-    qStableSort(begin, new_items.end(),
-                std::bind(&Playlist::CompareItems, column, order, _1, _2));
+    columns << Column_Disc << Column_Track;
   }
+  PlaylistSorter(columns, order).Sort(begin, new_items.end());
 
   undo_stack_->push(
       new PlaylistUndoCommands::SortItems(this, column, order, new_items));
@@ -1425,6 +1472,20 @@ void Playlist::ReOrderWithoutUndo(const PlaylistItemList& new_items) {
   PlaylistItemList old_items = items_;
   items_ = new_items;
 
+  // Give the items new positions in their new order
+  BeginDelta();
+  QHash<const PlaylistItem*, QList<qint64>> old_positions;
+  for (int i = 0; i < old_items.length(); ++i) {
+    old_positions[old_items[i].get()] << positions_[i];
+  }
+  for (int i = 0; i < new_items.length(); ++i) {
+    const qint64 old_position = old_positions[new_items[i].get()].takeFirst();
+    positions_[i] = (i + 1) * PlaylistBackend::kPositionGap;
+    if (old_position != positions_[i]) {
+      RecordMove(old_position, positions_[i]);
+    }
+  }
+
   QMap<const PlaylistItem*, int> new_rows;
   for (int i = 0; i < new_items.length(); ++i) {
     new_rows[new_items[i].get()] = i;
@@ -1461,50 +1522,229 @@ void Playlist::SetCurrentIsPaused(bool paused) {
 void Playlist::Save() const {
   if (!backend_ || is_loading_) return;
 
-  backend_->SavePlaylistAsync(id_, items_, last_played_row(),
+  if (restore_state_ != Restore_Finished) {
+    // The whole playlist is written once it's been restored.
+    changed_while_restoring_ = true;
+    return;
+  }
+
+  PlaylistDelta delta = pending_delta_;
+  pending_delta_ = PlaylistDelta();
+
+  if (delta.clear) {
+    // Write the whole playlist again
+    delta.removed.clear();
+    delta.moved.clear();
+    delta.inserted.clear();
+    for (int i = 0; i < items_.count(); ++i) {
+      delta.inserted << qMakePair(positions_[i], items_[i]);
+    }
+  }
+
+  backend_->SavePlaylistAsync(id_, delta, last_played_row(),
                               dynamic_playlist_);
 }
 
+void Playlist::BeginDelta() {
+  if (!pending_delta_.IsEmpty()) {
+    pending_delta_.clear = true;
+  }
+}
+
+void Playlist::RecordInsert(int row) {
+  if (pending_delta_.clear) return;
+  pending_delta_.inserted << qMakePair(positions_[row], items_[row]);
+}
+
+void Playlist::RecordRemove(qint64 position) {
+  if (pending_delta_.clear) return;
+  pending_delta_.removed << position;
+}
+
+void Playlist::RecordMove(qint64 old_position, qint64 new_position) {
+  if (pending_delta_.clear || old_position == new_position) return;
+  pending_delta_.moved << qMakePair(old_position, new_position);
+}
+
+void Playlist::AssignPositions(const QList<int>& rows_in) {
+  QList<int> rows = rows_in;
+  qSort(rows);
+
+  int i = 0;
+  while (i < rows.count()) {
+    // Find a run of consecutive rows.  The rows either side of it keep their
+    // positions, so the run has to fit between them.
+    int j = i + 1;
+    while (j < rows.count() && rows[j] == rows[j - 1] + 1) ++j;
+
+    const int first = rows[i];
+    const int count = j - i;
+    const qint64 before = first == 0 ? 0 : positions_[first - 1];
+    const qint64 after =
+        first + count >= positions_.count()
+            ? before + (count + 1) * PlaylistBackend::kPositionGap
+            : positions_[first + count];
+
+    const qint64 step = (after - before) / (count + 1);
+    if (step == 0) {
+      RenumberPositions();
+      return;
+    }
+
+    for (int k = 0; k < count; ++k) {
+      positions_[first + k] = before + (k + 1) * step;
+    }
+    i = j;
+  }
+}
+
+void Playlist::RenumberPositions() {
+  for (int i = 0; i < positions_.count(); ++i) {
+    positions_[i] = (i + 1) * PlaylistBackend::kPositionGap;
+  }
+  pending_delta_.clear = true;
+}
+
 namespace {
 typedef QFutureWatcher<QList<PlaylistItemPtr>> PlaylistItemFutureWatcher;
 }
 
 void Playlist::Restore() {
-  if (!backend_) return;
+  if (!backend_ || restore_state_ != Restore_NotStarted) return;
+  restore_state_ = Restore_Loading;
 
-  items_.clear();
-  virtual_items_.clear();
-  library_items_by_id_.clear();
+  last_restored_item_.reset();
+  last_restored_position_ = -1;
+  restored_deleted_positions_.clear();
+
+  LoadNextRestorePage(kRestoreFirstPageSize);
+}
 
-  QFuture<QList<PlaylistItemPtr>> future =
-      QtConcurrent::run(backend_, &PlaylistBackend::GetPlaylistItems, id_);
-  PlaylistItemFutureWatcher* watcher = new PlaylistItemFutureWatcher(this);
-  watcher->setFuture(future);
-  connect(watcher, SIGNAL(finished()), SLOT(ItemsLoaded()));
+void Playlist::LoadNextRestorePage(int limit) {
+  restore_page_limit_ = limit;
+  restored_positions_.clear();
+  QFuture<QList<PlaylistItemPtr>> future = QtConcurrent::run(
+      backend_, &PlaylistBackend::GetPlaylistItems, id_, &restored_positions_,
+      last_restored_position_, limit);
+  restore_watcher_ = new PlaylistItemFutureWatcher(this);
+  restore_watcher_->setFuture(future);
+  connect(restore_watcher_, SIGNAL(finished()), SLOT(ItemsLoaded()));
 }
 
 void Playlist::ItemsLoaded() {
-  PlaylistItemFutureWatcher* watcher =
-      static_cast<PlaylistItemFutureWatcher*>(sender());
+  PlaylistItemFutureWatcher* watcher = restore_watcher_;
+  restore_watcher_ = nullptr;
   watcher->deleteLater();
 
-  PlaylistItemList items = watcher->future().result();
+  if (AddRestoredPage(watcher->future().result())) {
+    RestoreComplete();
+  } else {
+    LoadNextRestorePage(kRestorePageSize);
+  }
+}
+
+void Playlist::RestoreNow() {
+  if (!backend_ || restore_state_ == Restore_Finished) return;
+
+  if (restore_state_ == Restore_NotStarted) {
+    restore_state_ = Restore_Loading;
+    last_restored_item_.reset();
+    last_restored_position_ = -1;
+    restored_deleted_positions_.clear();
+  } else if (restore_watcher_) {
+    // Take the page that's being loaded in the background instead of waiting
+    // for ItemsLoaded.
+    PlaylistItemFutureWatcher* watcher = restore_watcher_;
+    restore_watcher_ = nullptr;
+    watcher->disconnect(this);
+    watcher->deleteLater();
+
+    if (AddRestoredPage(watcher->future().result())) {
+      RestoreComplete();
+      return;
+    }
+  }
+
+  forever {
+    restore_page_limit_ = kRestorePageSize;
+    restored_positions_.clear();
+    PlaylistItemList items =
+        backend_->GetPlaylistItems(id_, &restored_positions_,
+                                   last_restored_position_, kRestorePageSize);
+    if (AddRestoredPage(items)) break;
+  }
+  RestoreComplete();
+}
+
+bool Playlist::AddRestoredPage(PlaylistItemList items) {
+  QList<qint64> positions = restored_positions_;
+  restored_positions_.clear();
+
+  const bool last_page = items.count() < restore_page_limit_;
+  if (!positions.isEmpty()) {
+    last_restored_position_ = positions.last();
+  }
 
   // backend returns empty elements for library items which it couldn't
   // match (because they got deleted); we don't need those
   QMutableListIterator<PlaylistItemPtr> it(items);
+  QMutableListIterator<qint64> position_it(positions);
   while (it.hasNext()) {
     PlaylistItemPtr item = it.next();
+    const qint64 position = position_it.next();
 
     if (item->IsLocalLibraryItem() && item->Metadata().url().isEmpty()) {
       it.remove();
+      position_it.remove();
+      restored_deleted_positions_ << position;
     }
   }
 
+  // The page goes after the items restored so far, which might not be at the
+  // end if something was added to the playlist in the meantime.
+  int row = 0;
+  if (last_restored_item_) {
+    row = items_.indexOf(last_restored_item_) + 1;
+    if (row == 0) row = items_.count();
+  }
+
+  // Restoring the playlist isn't something the user can undo.  If they've
+  // already added items after this page the rows in their undo steps would be
+  // wrong, so those steps are dropped.
+  if (row < items_.count()) undo_stack_->clear();
+
   is_loading_ = true;
-  InsertItems(items, 0);
+  InsertItemsWithoutUndo(items, row);
   is_loading_ = false;
 
+  // The items are in the database already, so they keep the positions they
+  // were saved with.
+  for (int i = 0; i < items.count(); ++i) {
+    positions_[row + i] = positions[i];
+  }
+  if (!items.isEmpty()) {
+    last_restored_item_ = items.last();
+  }
+
+  return last_page;
+}
+
+void Playlist::RestoreComplete() {
+  restore_state_ = Restore_Finished;
+  last_restored_item_.reset();
+
+  pending_delta_ = PlaylistDelta();
+  if (changed_while_restoring_) {
+    changed_while_restoring_ = false;
+    RenumberPositions();
+  } else {
+    pending_delta_.removed = restored_deleted_positions_;
+  }
+  restored_deleted_positions_.clear();
+  if (!pending_delta_.IsEmpty()) {
+    Save();
+  }
+
   PlaylistBackend::Playlist p = backend_->GetPlaylist(id_);
 
   // the newly loaded list of items might be shorter than it was before so
@@ -1547,6 +1787,8 @@ void Playlist::ItemsLoaded() {
 static bool DescendingIntLessThan(int a, int b) { return a > b; }
 
 void Playlist::RemoveItemsWithoutUndo(const QList<int>& indicesIn) {
+  RestoreNow();
+
   // Sort the indices descending because removing elements 'backwards'
   // is easier - indices don't 'move' in the process.
   QList<int> indices = indicesIn;
@@ -1620,9 +1862,12 @@ PlaylistItemList Playlist::RemoveItemsWithoutUndo(int row, int count) {
   beginRemoveRows(QModelIndex(), row, row + count - 1);
 
   // Remove items
+  BeginDelta();
+
   PlaylistItemList ret;
   for (int i = 0; i < count; ++i) {
     PlaylistItemPtr item(items_.takeAt(row));
+    RecordRemove(positions_.takeAt(row));
     ret << item;
 
     if (item->type() == "Library") {
@@ -1828,10 +2073,14 @@ void Playlist::RemoveItemsNotInQueue() {
 }
 
 void Playlist::ReloadItems(const QList<int>& rows) {
+  BeginDelta();
+
   for (int row : rows) {
     PlaylistItemPtr item = item_at(row);
 
     item->Reload();
+    RecordRemove(positions_[row]);
+    RecordInsert(row);
 
     if (row == current_row()) {
       InformOfCurrentSongChange();
@@ -2072,15 +2321,50 @@ void Playlist::InformOfCurrentSongChange() {
   }
 }
 
+QSet<QString> Playlist::MissingFiles(const PlaylistItemList& items) const {
+  QStringList filenames;
+  QMap<int, QString> library_filenames;
+
+  for (PlaylistItemPtr item : items) {
+    const Song& song = item->Metadata();
+    if (song.is_stream()) continue;
+
+    const QString filename = song.url().toLocalFile();
+    if (library_ && item->IsLocalLibraryItem() && song.id() != -1) {
+      library_filenames[song.id()] = filename;
+    } else {
+      filenames << filename;
+    }
+  }
+
+  // The library watcher already knows which library songs are unavailable,
+  // so there's no need to look for them again.  Songs that have gone from the
+  // library since the playlist was loaded are checked like any other file.
+  QSet<QString> missing;
+  if (!library_filenames.isEmpty()) {
+    for (const Song& song : library_->GetSongsById(library_filenames.keys())) {
+      if (song.is_unavailable()) {
+        missing << library_filenames[song.id()];
+      }
+      library_filenames.remove(song.id());
+    }
+    filenames << library_filenames.values();
+  }
+
+  return missing.unite(FileExistenceChecker::MissingFiles(filenames));
+}
+
 void Playlist::InvalidateDeletedSongs() {
   QList<int> invalidated_rows;
+  const PlaylistItemList items = items_;
+  const QSet<QString> missing = MissingFiles(items);
 
-  for (int row = 0; row < items_.count(); ++row) {
-    PlaylistItemPtr item = items_[row];
+  for (int row = 0; row < items.count(); ++row) {
+    PlaylistItemPtr item = items[row];
     Song song = item->Metadata();
 
     if (!song.is_stream()) {
-      bool exists = QFile::exists(song.url().toLocalFile());
+      bool exists = !missing.contains(song.url().toLocalFile());
 
       if (!exists && !item->HasForegroundColor(kInvalidSongPriority)) {
         // gray out the song if it's not there
@@ -2098,12 +2382,13 @@ void Playlist::InvalidateDeletedSongs() {
 
 void Playlist::RemoveDeletedSongs() {
   QList<int> rows_to_remove;
+  const QSet<QString> missing = MissingFiles(items_);
 
   for (int row = 0; row < items_.count(); ++row) {
     PlaylistItemPtr item = items_[row];
     Song song = item->Metadata();
 
-    if (!song.is_stream() && !QFile::exists(song.url().toLocalFile())) {
+    if (!song.is_stream() && missing.contains(song.url().toLocalFile())) {
       rows_to_remove.append(row);
     }
   }
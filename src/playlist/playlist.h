@@ -20,7 +20,9 @@
 
 #include <QAbstractItemModel>
 #include <QList>
+#include <QSet>
 
+#include "playlistdelta.h"
 #include "playlistitem.h"
 #include "playlistsequence.h"
 #include "core/tagreaderclient.h"
@@ -38,6 +40,9 @@ class TaskManager;
 class QSortFilterProxyModel;
 class QUndoStack;
 
+template <typename T>
+class QFutureWatcher;
+
 namespace PlaylistUndoCommands {
 class InsertItems;
 class RemoveItems;
@@ -161,6 +166,11 @@ class Playlist : public QAbstractListModel {
   static const int kUndoStackSize;
   static const int kUndoItemLimit;
 
+  // Restoring a playlist loads a small first page of items so they can be
+  // shown straight away, and then the rest in bigger pages.
+  static const int kRestoreFirstPageSize;
+  static const int kRestorePageSize;
+
   static const qint64 kMinScrobblePointNsecs;
   static const qint64 kMaxScrobblePointNsecs;
 
@@ -176,7 +186,9 @@ class Playlist : public QAbstractListModel {
 
   // Persistence
   void Save() const;
-  void Restore();
+  // False until every item has been loaded from the database.  Restore has to
+  // be called first.
+  bool is_restored() const { return restore_state_ == Restore_Finished; }
 
   // Accessors
   QSortFilterProxyModel* proxy() const;
@@ -233,6 +245,11 @@ class Playlist : public QAbstractListModel {
   void set_have_incremented_playcount() { have_incremented_playcount_ = true; }
   void UpdateScrobblePoint(qint64 seek_point_nanosec = 0);
 
+  // Loads every item that hasn't been restored yet before returning.  This
+  // happens before items are added to or removed from the playlist by
+  // something other than its view, which might not have loaded it.
+  void RestoreNow();
+
   // Changing the playlist
   void InsertItems(const PlaylistItemList& items, int pos = -1,
                    bool play_now = false, bool enqueue = false);
@@ -307,6 +324,10 @@ class Playlist : public QAbstractListModel {
                   const QModelIndex& parent = QModelIndex());
 
  public slots:
+  // Playlists aren't loaded until they're first needed.  This starts loading
+  // the items in the background, if that hasn't happened already.
+  void Restore();
+
   void set_current_row(int index, bool is_stopping = false);
   void Paused();
   void Playing();
@@ -371,6 +392,9 @@ signals:
 
   void InsertDynamicItems(int count);
 
+  // The local files of the items that don't exist any more.
+  QSet<QString> MissingFiles(const PlaylistItemList& items) const;
+
   // Modify the playlist without changing the undo stack.  These are used by
   // our friends in PlaylistUndoCommands
   void InsertItemsWithoutUndo(const PlaylistItemList& items, int pos,
@@ -381,6 +405,20 @@ signals:
   void MoveItemsWithoutUndo(int start, const QList<int>& dest_rows);
   void ReOrderWithoutUndo(const PlaylistItemList& new_items);
 
+  // Changes made by the functions above are recorded in pending_delta_ so
+  // Save() only has to write the rows that changed.  BeginDelta must be
+  // called before each edit is recorded: edits can only be combined in one
+  // delta when they were made without saving in between, and if that happens
+  // the whole playlist is written instead.
+  void BeginDelta();
+  void RecordInsert(int row);
+  void RecordRemove(qint64 position);
+  void RecordMove(qint64 old_position, qint64 new_position);
+  // Gives new positions to the given rows that fit between their neighbours,
+  // renumbering the whole playlist if there isn't room.
+  void AssignPositions(const QList<int>& rows);
+  void RenumberPositions();
+
   void RemoveItemsNotInQueue();
 
   // Removes rows with given indices from this playlist.
@@ -398,7 +436,21 @@ signals:
   void SongInsertVetoListenerDestroyed();
 
  private:
+  enum RestoreState { Restore_NotStarted, Restore_Loading, Restore_Finished };
+
+  void LoadNextRestorePage(int limit);
+  // Inserts a page of restored items.  Returns true if it was the last one.
+  bool AddRestoredPage(PlaylistItemList items);
+  void RestoreComplete();
+
+ private:
+  RestoreState restore_state_;
+  // True while restored items are being inserted.
   bool is_loading_;
+  // Set if the playlist was changed while it was being restored, because the
+  // items that were loaded later have to be renumbered to fit around the
+  // changes.
+  mutable bool changed_while_restoring_;
   PlaylistFilter* proxy_;
   Queue* queue_;
 
@@ -412,6 +464,23 @@ signals:
   bool favorite_;
 
   PlaylistItemList items_;
+  // The position of each item in the playlist_items table, in the same order
+  // as items_.
+  QList<qint64> positions_;
+  mutable PlaylistDelta pending_delta_;
+  // Filled by the backend when a page of the playlist is restored.
+  QList<qint64> restored_positions_;
+  // The last item and position restored so far.  The next page is loaded
+  // after that position and inserted after that item.
+  PlaylistItemPtr last_restored_item_;
+  qint64 last_restored_position_;
+  // The number of items asked for in the page being loaded.  Fewer than that
+  // means it's the last one.
+  int restore_page_limit_;
+  // Loads the next page in the background.  Null if nothing is being loaded.
+  QFutureWatcher<PlaylistItemList>* restore_watcher_;
+  // Library items that have been deleted since the playlist was saved.
+  QList<qint64> restored_deleted_positions_;
   QList<int> virtual_items_;  // Contains the indices into items_ in the order
                               // that they will be played.
   // A map of library ID to playlist item - for fast lookups when library
@@ -31,8 +31,8 @@
 #include "core/logging.h"
 #include "core/scopedtransaction.h"
 #include "core/song.h"
+#include "core/sqlitequery.h"
 #include "library/librarybackend.h"
-#include "library/sqlrow.h"
 #include "playlist/songplaylistitem.h"
 #include "playlistparsers/cueparser.h"
 #include "smartplaylists/generator.h"
@@ -43,10 +43,14 @@ using std::shared_ptr;
 using smart_playlists::GeneratorPtr;
 
 const int PlaylistBackend::kSongTableJoins = 4;
+const qint64 PlaylistBackend::kPositionGap = 1 << 20;
 
 PlaylistBackend::PlaylistBackend(Application* app, QObject* parent)
     : QObject(parent), app_(app), db_(app_->database()) {}
 
+PlaylistBackend::PlaylistBackend(Database* db, QObject* parent)
+    : QObject(parent), app_(nullptr), db_(db) {}
+
 PlaylistBackend::PlaylistList PlaylistBackend::GetAllPlaylists() {
   return GetPlaylists(GetPlaylists_All);
 }
@@ -61,7 +65,7 @@ PlaylistBackend::PlaylistList PlaylistBackend::GetAllFavoritePlaylists() {
 
 PlaylistBackend::PlaylistList PlaylistBackend::GetPlaylists(
     GetPlaylistsFlags flags) {
-  QMutexLocker l(db_->Mutex());
+  Database::ReadLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
 
   PlaylistList ret;
@@ -107,7 +111,7 @@ PlaylistBackend::PlaylistList PlaylistBackend::GetPlaylists(
 }
 
 PlaylistBackend::Playlist PlaylistBackend::GetPlaylist(int id) {
-  QMutexLocker l(db_->Mutex());
+  Database::ReadLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
 
   QSqlQuery q(
@@ -137,10 +141,8 @@ PlaylistBackend::Playlist PlaylistBackend::GetPlaylist(int id) {
   return p;
 }
 
-QSqlQuery PlaylistBackend::GetPlaylistRows(int playlist) {
-  QMutexLocker l(db_->Mutex());
-  QSqlDatabase db(db_->Connect());
-
+QString PlaylistBackend::GetPlaylistRowsSql(qint64 after_position,
+                                            int limit) const {
   QString query = "SELECT songs.ROWID, " + Song::JoinSpec("songs") +
                   ","
                   "       magnatune_songs.ROWID, " +
@@ -152,7 +154,7 @@ QSqlQuery PlaylistBackend::GetPlaylistRows(int playlist) {
                   "       p.ROWID, " +
                   Song::JoinSpec("p") +
                   ","
-                  "       p.type, p.radio_service"
+                  "       p.type, p.radio_service, p.position"
                   " FROM playlist_items AS p"
                   " LEFT JOIN songs"
                   "    ON p.library_id = songs.ROWID"
@@ -161,66 +163,66 @@ QSqlQuery PlaylistBackend::GetPlaylistRows(int playlist) {
                   " LEFT JOIN jamendo.songs AS jamendo_songs"
                   "    ON p.library_id = jamendo_songs.ROWID"
                   " WHERE p.playlist = :playlist";
-  QSqlQuery q(db);
-  // Forward iterations only may be faster
-  q.setForwardOnly(true);
-  q.prepare(query);
-  q.bindValue(":playlist", playlist);
-  q.exec();
-
-  return q;
+  if (after_position != -1) query += " AND p.position > :after_position";
+  query += " ORDER BY p.position";
+  if (limit != -1) query += " LIMIT :limit";
+  return query;
 }
 
-QList<PlaylistItemPtr> PlaylistBackend::GetPlaylistItems(int playlist) {
-  QSqlQuery q = GetPlaylistRows(playlist);
-  // Note that as this only accesses the query, not the db, we don't need the
-  // mutex.
-  if (db_->CheckErrors(q)) return QList<PlaylistItemPtr>();
+QList<PlaylistItemPtr> PlaylistBackend::GetPlaylistItems(
+    int playlist, QList<qint64>* positions, qint64 after_position, int limit) {
+  // The position comes after the type and radio_service columns
+  const int position_column =
+      (Song::kColumns.count() + 1) * kSongTableJoins + 2;
+
+  // Each row has four copies of the song columns, so they're read straight
+  // from SQLite instead of being copied into an SqlRow first.
+  QList<PlaylistItemPtr> playlistitems;
+  {
+    Database::ReadLocker l(db_, Q_FUNC_INFO);
+    SqliteQuery q(GetPlaylistRowsSql(after_position, limit), db_->Connect());
+    q.BindValue(":playlist", playlist);
+    if (after_position != -1) q.BindValue(":after_position", after_position);
+    if (limit != -1) q.BindValue(":limit", limit);
+    if (!q.Exec()) return QList<PlaylistItemPtr>();
+
+    while (q.Next()) {
+      playlistitems << NewPlaylistItemFromQuery(q);
+      if (positions) {
+        *positions << q.Int64(position_column);
+      }
+    }
+  }
 
+  // CUE sheets might have to be parsed and files reloaded, so that's done
+  // after the database has been unlocked.
   // it's probable that we'll have a few songs associated with the
   // same CUE so we're caching results of parsing CUEs
   std::shared_ptr<NewSongFromQueryState> state_ptr(new NewSongFromQueryState());
-  QList<PlaylistItemPtr> playlistitems;
-  while (q.next()) {
-    playlistitems << NewPlaylistItemFromQuery(SqlRow(q), state_ptr);
+  for (PlaylistItemPtr& item : playlistitems) {
+    if (item) item = RestoreCueData(item, state_ptr);
   }
   return playlistitems;
 }
 
 QList<Song> PlaylistBackend::GetPlaylistSongs(int playlist) {
-  QSqlQuery q = GetPlaylistRows(playlist);
-  // Note that as this only accesses the query, not the db, we don't need the
-  // mutex.
-  if (db_->CheckErrors(q)) return QList<Song>();
-
-  // it's probable that we'll have a few songs associated with the
-  // same CUE so we're caching results of parsing CUEs
-  std::shared_ptr<NewSongFromQueryState> state_ptr(new NewSongFromQueryState());
   QList<Song> songs;
-  while (q.next()) {
-    songs << NewSongFromQuery(SqlRow(q), state_ptr);
+  for (PlaylistItemPtr item : GetPlaylistItems(playlist)) {
+    if (item) songs << item->Metadata();
   }
   return songs;
 }
 
 PlaylistItemPtr PlaylistBackend::NewPlaylistItemFromQuery(
-    const SqlRow& row, std::shared_ptr<NewSongFromQueryState> state) {
+    const SqliteQuery& query) {
   // The song tables get joined first, plus one each for the song ROWIDs
   const int playlist_row = (Song::kColumns.count() + 1) * kSongTableJoins;
 
-  PlaylistItemPtr item(
-      PlaylistItem::NewFromType(row.value(playlist_row).toString()));
+  PlaylistItemPtr item(PlaylistItem::NewFromType(query.Text(playlist_row)));
   if (item) {
-    item->InitFromQuery(row);
-    return RestoreCueData(item, state);
-  } else {
-    return item;
+    item->InitFromQuery(query);
   }
-}
-
-Song PlaylistBackend::NewSongFromQuery(
-    const SqlRow& row, std::shared_ptr<NewSongFromQueryState> state) {
-  return NewPlaylistItemFromQuery(row, state)->Metadata();
+  return item;
 }
 
 // If song had a CUE and the CUE still exists, the metadata from it will
@@ -229,7 +231,7 @@ PlaylistItemPtr PlaylistBackend::RestoreCueData(
     PlaylistItemPtr item, std::shared_ptr<NewSongFromQueryState> state) {
   // we need library to run a CueParser; also, this method applies only to
   // file-type PlaylistItems
-  if (item->type() != "File") {
+  if (item->type() != "File" || !app_) {
     return item;
   }
   CueParser cue_parser(app_->library_backend());
@@ -278,28 +280,55 @@ PlaylistItemPtr PlaylistBackend::RestoreCueData(
 }
 
 void PlaylistBackend::SavePlaylistAsync(int playlist,
-                                        const PlaylistItemList& items,
+                                        const PlaylistDelta& delta,
                                         int last_played, GeneratorPtr dynamic) {
   metaObject()->invokeMethod(
-      this, "SavePlaylist", Qt::QueuedConnection, Q_ARG(int, playlist),
-      Q_ARG(PlaylistItemList, items), Q_ARG(int, last_played),
+      this, "SavePlaylistDelta", Qt::QueuedConnection, Q_ARG(int, playlist),
+      Q_ARG(PlaylistDelta, delta), Q_ARG(int, last_played),
       Q_ARG(smart_playlists::GeneratorPtr, dynamic));
 }
 
 void PlaylistBackend::SavePlaylist(int playlist, const PlaylistItemList& items,
                                    int last_played, GeneratorPtr dynamic) {
-  QMutexLocker l(db_->Mutex());
+  PlaylistDelta delta;
+  delta.clear = true;
+  for (int i = 0; i < items.count(); ++i) {
+    delta.inserted << qMakePair((i + 1) * kPositionGap, items[i]);
+  }
+
+  SavePlaylistDelta(playlist, delta, last_played, dynamic);
+}
+
+void PlaylistBackend::SavePlaylistDelta(int playlist,
+                                        const PlaylistDelta& delta,
+                                        int last_played, GeneratorPtr dynamic) {
+  Database::WriteLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
 
-  qLog(Debug) << "Saving playlist" << playlist;
+  qLog(Debug) << "Saving playlist" << playlist << "-" << delta.removed.count()
+              << "removed," << delta.moved.count() << "moved,"
+              << delta.inserted.count() << "inserted";
 
   QSqlQuery clear("DELETE FROM playlist_items WHERE playlist = :playlist", db);
+  QSqlQuery remove(
+      "DELETE FROM playlist_items"
+      " WHERE playlist = :playlist AND position = :position",
+      db);
+  QSqlQuery move(
+      "UPDATE playlist_items SET position = :new_position"
+      " WHERE playlist = :playlist AND position = :position",
+      db);
+  QSqlQuery finish_moves(
+      "UPDATE playlist_items SET position = -position - 1"
+      " WHERE playlist = :playlist AND position < 0",
+      db);
   QSqlQuery insert(
       "INSERT INTO playlist_items"
-      " (playlist, type, library_id, radio_service, " +
+      " (playlist, position, type, library_id, radio_service, " +
           Song::kColumnSpec +
           ")"
-          " VALUES (:playlist, :type, :library_id, :radio_service, " +
+          " VALUES (:playlist, :position, :type, :library_id,"
+          "         :radio_service, " +
           Song::kBindSpec + ")",
       db);
   QSqlQuery update(
@@ -314,14 +343,41 @@ void PlaylistBackend::SavePlaylist(int playlist, const PlaylistItemList& items,
   ScopedTransaction transaction(&db);
 
   // Clear the existing items in the playlist
-  clear.bindValue(":playlist", playlist);
-  clear.exec();
-  if (db_->CheckErrors(clear)) return;
+  if (delta.clear) {
+    clear.bindValue(":playlist", playlist);
+    clear.exec();
+    if (db_->CheckErrors(clear)) return;
+  }
+
+  for (qint64 position : delta.removed) {
+    remove.bindValue(":playlist", playlist);
+    remove.bindValue(":position", position);
+    remove.exec();
+    if (db_->CheckErrors(remove)) return;
+  }
+
+  // An item's new position might still belong to another item that hasn't
+  // been moved yet, so the items are moved to negative positions first and
+  // then flipped back all at once.
+  if (!delta.moved.isEmpty()) {
+    for (const QPair<qint64, qint64>& moved : delta.moved) {
+      move.bindValue(":new_position", -moved.second - 1);
+      move.bindValue(":playlist", playlist);
+      move.bindValue(":position", moved.first);
+      move.exec();
+      if (db_->CheckErrors(move)) return;
+    }
+
+    finish_moves.bindValue(":playlist", playlist);
+    finish_moves.exec();
+    if (db_->CheckErrors(finish_moves)) return;
+  }
 
   // Save the new ones
-  for (PlaylistItemPtr item : items) {
+  for (const QPair<qint64, PlaylistItemPtr>& inserted : delta.inserted) {
     insert.bindValue(":playlist", playlist);
-    item->BindToQuery(&insert);
+    insert.bindValue(":position", inserted.first);
+    inserted.second->BindToQuery(&insert);
 
     insert.exec();
     db_->CheckErrors(insert);
@@ -347,7 +403,7 @@ void PlaylistBackend::SavePlaylist(int playlist, const PlaylistItemList& items,
 
 int PlaylistBackend::CreatePlaylist(const QString& name,
                                     const QString& special_type) {
-  QMutexLocker l(db_->Mutex());
+  Database::WriteLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
 
   QSqlQuery q(
@@ -363,7 +419,7 @@ int PlaylistBackend::CreatePlaylist(const QString& name,
 }
 
 void PlaylistBackend::RemovePlaylist(int id) {
-  QMutexLocker l(db_->Mutex());
+  Database::WriteLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
   QSqlQuery delete_playlist("DELETE FROM playlists WHERE ROWID=:id", db);
   QSqlQuery delete_items("DELETE FROM playlist_items WHERE playlist=:id", db);
@@ -383,7 +439,7 @@ void PlaylistBackend::RemovePlaylist(int id) {
 }
 
 void PlaylistBackend::RenamePlaylist(int id, const QString& new_name) {
-  QMutexLocker l(db_->Mutex());
+  Database::WriteLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
   QSqlQuery q("UPDATE playlists SET name=:name WHERE ROWID=:id", db);
   q.bindValue(":name", new_name);
@@ -394,7 +450,7 @@ void PlaylistBackend::RenamePlaylist(int id, const QString& new_name) {
 }
 
 void PlaylistBackend::FavoritePlaylist(int id, bool is_favorite) {
-  QMutexLocker l(db_->Mutex());
+  Database::WriteLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
   QSqlQuery q("UPDATE playlists SET is_favorite=:is_favorite WHERE ROWID=:id",
               db);
@@ -406,7 +462,7 @@ void PlaylistBackend::FavoritePlaylist(int id, bool is_favorite) {
 }
 
 void PlaylistBackend::SetPlaylistOrder(const QList<int>& ids) {
-  QMutexLocker l(db_->Mutex());
+  Database::WriteLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
   ScopedTransaction transaction(&db);
 
@@ -426,7 +482,7 @@ void PlaylistBackend::SetPlaylistOrder(const QList<int>& ids) {
 }
 
 void PlaylistBackend::SetPlaylistUiPath(int id, const QString& path) {
-  QMutexLocker l(db_->Mutex());
+  Database::WriteLocker l(db_, Q_FUNC_INFO);
   QSqlDatabase db(db_->Connect());
   QSqlQuery q("UPDATE playlists SET ui_path=:path WHERE ROWID=:id", db);
 
@@ -23,17 +23,22 @@
 #include <QMutex>
 #include <QObject>
 
+#include "playlistdelta.h"
 #include "playlistitem.h"
 #include "smartplaylists/generator_fwd.h"
 
 class Application;
 class Database;
+class SqliteQuery;
 
 class PlaylistBackend : public QObject {
   Q_OBJECT
 
  public:
   Q_INVOKABLE PlaylistBackend(Application* app, QObject* parent = nullptr);
+  // Used by tests, which don't have an Application.  CUE sheets can't be read
+  // without one.
+  explicit PlaylistBackend(Database* db, QObject* parent = nullptr);
 
   struct Playlist {
     Playlist() : id(-1), favorite(false), last_played(0) {}
@@ -55,19 +60,30 @@ class PlaylistBackend : public QObject {
 
   static const int kSongTableJoins;
 
+  // The space left between the positions of neighbouring items when a
+  // playlist is numbered from scratch, so items can be inserted between them
+  // later without renumbering the rest of the playlist.
+  static const qint64 kPositionGap;
+
   PlaylistList GetAllPlaylists();
   PlaylistList GetAllOpenPlaylists();
   PlaylistList GetAllFavoritePlaylists();
   PlaylistBackend::Playlist GetPlaylist(int id);
 
-  QList<PlaylistItemPtr> GetPlaylistItems(int playlist);
+  // If positions is given it's filled with the position of each item.  A page
+  // of the playlist can be loaded by giving the position of the last item in
+  // the previous page and the number of items to load.
+  QList<PlaylistItemPtr> GetPlaylistItems(int playlist,
+                                          QList<qint64>* positions = nullptr,
+                                          qint64 after_position = -1,
+                                          int limit = -1);
   QList<Song> GetPlaylistSongs(int playlist);
 
   void SetPlaylistOrder(const QList<int>& ids);
   void SetPlaylistUiPath(int id, const QString& path);
 
   int CreatePlaylist(const QString& name, const QString& special_type);
-  void SavePlaylistAsync(int playlist, const PlaylistItemList& items,
+  void SavePlaylistAsync(int playlist, const PlaylistDelta& delta,
                          int last_played,
                          smart_playlists::GeneratorPtr dynamic);
   void RenamePlaylist(int id, const QString& new_name);
@@ -77,8 +93,13 @@ class PlaylistBackend : public QObject {
   Application* app() const { return app_; }
 
  public slots:
+  // Replaces all the items in the playlist.
   void SavePlaylist(int playlist, const PlaylistItemList& items,
                     int last_played, smart_playlists::GeneratorPtr dynamic);
+  // Only writes the rows that are affected by the delta.
+  void SavePlaylistDelta(int playlist, const PlaylistDelta& delta,
+                         int last_played,
+                         smart_playlists::GeneratorPtr dynamic);
 
  private:
   struct NewSongFromQueryState {
@@ -86,12 +107,10 @@ class PlaylistBackend : public QObject {
     QMutex mutex_;
   };
 
-  QSqlQuery GetPlaylistRows(int playlist);
+  // Binds :playlist, and :after_position and :limit if they're not -1.
+  QString GetPlaylistRowsSql(qint64 after_position, int limit) const;
 
-  Song NewSongFromQuery(const SqlRow& row,
-                        std::shared_ptr<NewSongFromQueryState> state);
-  PlaylistItemPtr NewPlaylistItemFromQuery(
-      const SqlRow& row, std::shared_ptr<NewSongFromQueryState> state);
+  PlaylistItemPtr NewPlaylistItemFromQuery(const SqliteQuery& query);
   PlaylistItemPtr RestoreCueData(PlaylistItemPtr item,
                                  std::shared_ptr<NewSongFromQueryState> state);
 
@@ -0,0 +1,51 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PLAYLISTDELTA_H
+#define PLAYLISTDELTA_H
+
+#include <QList>
+#include <QMetaType>
+#include <QPair>
+
+#include "playlistitem.h"
+
+// The changes made to the items of a playlist since it was last saved.
+// Items are identified by their position in the playlist_items table, which
+// is unique within a playlist and increases from the top of the playlist to
+// the bottom.  The backend applies the changes in the order they're listed
+// here: clear, removed, moved and then inserted.
+struct PlaylistDelta {
+  PlaylistDelta() : clear(false) {}
+
+  bool IsEmpty() const {
+    return !clear && removed.isEmpty() && moved.isEmpty() &&
+           inserted.isEmpty();
+  }
+
+  // If set, every existing item is removed before the others are applied.
+  bool clear;
+
+  QList<qint64> removed;
+  // (old position, new position)
+  QList<QPair<qint64, qint64>> moved;
+  // (position, item)
+  QList<QPair<qint64, PlaylistItemPtr>> inserted;
+};
+Q_DECLARE_METATYPE(PlaylistDelta)
+
+#endif  // PLAYLISTDELTA_H
@@ -18,12 +18,42 @@
 #include "playlistfilter.h"
 #include "playlistfilterparser.h"
 
+#include <QtConcurrentMap>
 #include <QtDebug>
 
+namespace {
+
+// Playlists with more rows than this are filtered on several threads.
+const int kParallelRowCount = 2000;
+const int kRowsPerChunk = 500;
+
+}  // namespace
+
+struct PlaylistFilter::FilterChunk {
+  const Playlist* playlist;
+  const FilterTree* tree;
+  const QList<int>* columns;
+  FilterRow* rows;
+  qint8* results;
+  QList<int> row_numbers;
+};
+
+void PlaylistFilter::EvaluateChunk(FilterChunk& chunk) {
+  for (int row : chunk.row_numbers) {
+    FilterRow& filter_row = chunk.rows[row];
+    if (!filter_row.is_valid()) {
+      filter_row = FilterRow(chunk.playlist->item_at(row)->Metadata(),
+                             *chunk.columns);
+    }
+    chunk.results[row] = chunk.tree->accept(filter_row) ? Result_Accepted
+                                                      : Result_Rejected;
+  }
+}
+
 PlaylistFilter::PlaylistFilter(QObject* parent)
     : QSortFilterProxyModel(parent),
-      filter_tree_(new NopFilter),
-      query_hash_(0) {
+      playlist_(nullptr),
+      filter_tree_(new NopFilter) {
   setDynamicSortFilter(true);
 
   column_names_["title"] = Playlist::Column_Title;
@@ -52,6 +82,8 @@ PlaylistFilter::PlaylistFilter(QObject* parent)
                      << Playlist::Column_OriginalYear << Playlist::Column_Score
                      << Playlist::Column_BPM << Playlist::Column_Bitrate
                      << Playlist::Column_Rating;
+
+  filter_columns_ = column_names_.values().toSet().toList();
 }
 
 PlaylistFilter::~PlaylistFilter() {}
@@ -61,19 +93,124 @@ void PlaylistFilter::sort(int column, Qt::SortOrder order) {
   sourceModel()->sort(column, order);
 }
 
+void PlaylistFilter::setSourceModel(QAbstractItemModel* source_model) {
+  if (sourceModel()) sourceModel()->disconnect(this);
+
+  playlist_ = qobject_cast<Playlist*>(source_model);
+  ResetCache();
+
+  // Connect these before QSortFilterProxyModel connects its own slots, so the
+  // cache is up to date by the time it calls filterAcceptsRow().
+  if (source_model) {
+    connect(source_model, SIGNAL(rowsInserted(QModelIndex, int, int)),
+            SLOT(SourceRowsInserted(QModelIndex, int, int)));
+    connect(source_model, SIGNAL(rowsRemoved(QModelIndex, int, int)),
+            SLOT(SourceRowsRemoved(QModelIndex, int, int)));
+    connect(source_model, SIGNAL(dataChanged(QModelIndex, QModelIndex)),
+            SLOT(SourceDataChanged(QModelIndex, QModelIndex)));
+    connect(source_model, SIGNAL(layoutChanged()), SLOT(ResetCache()));
+    connect(source_model, SIGNAL(modelReset()), SLOT(ResetCache()));
+  }
+
+  QSortFilterProxyModel::setSourceModel(source_model);
+}
+
+void PlaylistFilter::ResetCache() {
+  const int count = playlist_ ? playlist_->rowCount() : 0;
+  rows_ = QVector<FilterRow>(count);
+  results_ = QVector<qint8>(count, Result_Unknown);
+}
+
+void PlaylistFilter::SourceRowsInserted(const QModelIndex& parent, int start,
+                                        int end) {
+  if (parent.isValid()) return;
+  if (start > rows_.count()) {
+    ResetCache();
+    return;
+  }
+  const int count = end - start + 1;
+  rows_.insert(start, count, FilterRow());
+  results_.insert(start, count, Result_Unknown);
+}
+
+void PlaylistFilter::SourceRowsRemoved(const QModelIndex& parent, int start,
+                                       int end) {
+  if (parent.isValid()) return;
+  if (end >= rows_.count()) {
+    ResetCache();
+    return;
+  }
+  const int count = end - start + 1;
+  rows_.remove(start, count);
+  results_.remove(start, count);
+}
+
+void PlaylistFilter::SourceDataChanged(const QModelIndex& top_left,
+                                       const QModelIndex& bottom_right) {
+  const int end = qMin(bottom_right.row(), rows_.count() - 1);
+  for (int row = qMax(0, top_left.row()); row <= end; ++row) {
+    rows_[row] = FilterRow();
+    results_[row] = Result_Unknown;
+  }
+}
+
 bool PlaylistFilter::filterAcceptsRow(int row,
                                       const QModelIndex& parent) const {
   QString filter = filterRegExp().pattern();
 
-  uint hash = qHash(filter);
-  if (hash != query_hash_) {
+  if (filter != query_) {
     // Parse the query
     FilterParser p(filter, column_names_, numerical_columns_);
     filter_tree_.reset(p.parse());
 
-    query_hash_ = hash;
+    // If the new query can only match fewer rows than the old one, the rows
+    // that didn't match before don't need to be tested again.
+    const bool narrowing = FilterParser::IsNarrowing(query_, filter);
+    for (qint8& result : results_) {
+      if (!narrowing || result == Result_Accepted) result = Result_Unknown;
+    }
+
+    query_ = filter;
   }
 
-  // Test the row
-  return filter_tree_->accept(row, parent, sourceModel());
+  if (filter_tree_->type() == FilterTree::Nop) return true;
+  if (!playlist_ || parent.isValid()) return false;
+
+  if (results_.count() != playlist_->rowCount()) {
+    // We missed a change to the playlist somewhere.
+    const_cast<PlaylistFilter*>(this)->ResetCache();
+  }
+  if (row < 0 || row >= results_.count()) return false;
+
+  // Test the row, and every other row that will be asked about next
+  if (results_[row] == Result_Unknown) EvaluateRows();
+  return results_[row] == Result_Accepted;
+}
+
+void PlaylistFilter::EvaluateRows() const {
+  QList<FilterChunk> chunks;
+  FilterChunk chunk;
+  chunk.playlist = playlist_;
+  chunk.tree = filter_tree_.data();
+  chunk.columns = &filter_columns_;
+  chunk.rows = rows_.data();
+  chunk.results = results_.data();
+
+  int unknown_count = 0;
+  for (int row = 0; row < results_.count(); ++row) {
+    if (results_[row] != Result_Unknown) continue;
+    chunk.row_numbers << row;
+    ++unknown_count;
+    if (chunk.row_numbers.count() == kRowsPerChunk) {
+      chunks << chunk;
+      chunk.row_numbers.clear();
+    }
+  }
+  if (!chunk.row_numbers.isEmpty()) chunks << chunk;
+
+  if (unknown_count > kParallelRowCount) {
+    QtConcurrent::blockingMap(chunks, &PlaylistFilter::EvaluateChunk);
+  } else {
+    for (FilterChunk& c : chunks) EvaluateChunk(c);
+  }
 }
@@ -20,13 +20,13 @@
 
 #include <QScopedPointer>
 #include <QSortFilterProxyModel>
+#include <QVector>
 
 #include "playlist.h"
+#include "playlistfilterparser.h"
 
 #include <QSet>
 
-class FilterTree;
-
 class PlaylistFilter : public QSortFilterProxyModel {
   Q_OBJECT
 
@@ -37,16 +37,45 @@ class PlaylistFilter : public QSortFilterProxyModel {
   // QAbstractItemModel
   void sort(int column, Qt::SortOrder order = Qt::AscendingOrder);
 
+  // QAbstractProxyModel
+  void setSourceModel(QAbstractItemModel* source_model);
+
   // QSortFilterProxyModel
   // public so Playlist::NextVirtualIndex and friends can get at it
   bool filterAcceptsRow(int source_row, const QModelIndex& source_parent) const;
 
+ private slots:
+  void SourceRowsInserted(const QModelIndex& parent, int start, int end);
+  void SourceRowsRemoved(const QModelIndex& parent, int start, int end);
+  void SourceDataChanged(const QModelIndex& top_left,
+                         const QModelIndex& bottom_right);
+  void ResetCache();
+
  private:
+  enum RowResult { Result_Unknown = 0, Result_Rejected, Result_Accepted };
+
+  // Some of the rows, tested by one thread.
+  struct FilterChunk;
+
+  // Tests every row that doesn't have a result for the current filter yet.
+  void EvaluateRows() const;
+  static void EvaluateChunk(FilterChunk& chunk);
+
+ private:
+  Playlist* playlist_;
+
   // Mutable because they're modified from filterAcceptsRow() const
   mutable QScopedPointer<FilterTree> filter_tree_;
-  mutable uint query_hash_;
+  mutable QString query_;
+
+  // One of each for every row in the playlist.  The rows are only made when
+  // they're first needed and are kept until the song changes, and the results
+  // are kept until the filter changes.
+  mutable QVector<FilterRow> rows_;
+  mutable QVector<qint8> results_;
 
   QMap<QString, int> column_names_;
+  QList<int> filter_columns_;
   QSet<int> numerical_columns_;
 };
 
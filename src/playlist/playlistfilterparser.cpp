@@ -18,31 +18,107 @@
 #include "playlistfilterparser.h"
 #include "playlist.h"
 #include "core/logging.h"
+#include "core/song.h"
+
+#include <QRegExp>
+#include <QStringMatcher>
+#include <QVariant>
+
+const QChar FilterRow::kSeparator(0);
+
+FilterRow::FilterRow(const Song& song, const QList<int>& columns) {
+  QString columns_text[Playlist::ColumnCount];
+  int length = Playlist::ColumnCount;
+  for (int column : columns) {
+    if (column < 0 || column >= Playlist::ColumnCount) continue;
+    if (!columns_text[column].isNull()) continue;
+    columns_text[column] = ColumnText(song, column).toLower();
+    length += columns_text[column].length();
+  }
+
+  text_.reserve(length);
+  for (int i = 0; i < Playlist::ColumnCount; ++i) {
+    starts_[i] = text_.length();
+    text_.append(columns_text[i]);
+    text_.append(kSeparator);
+  }
+  starts_[Playlist::ColumnCount] = text_.length();
+}
 
-#include <QAbstractItemModel>
+// This has to give the same text as Playlist::data() converted to a string.
+QString FilterRow::ColumnText(const Song& song, int column) {
+  switch (column) {
+    case Playlist::Column_Title:
+      return song.PrettyTitle();
+    case Playlist::Column_Artist:
+      return song.artist();
+    case Playlist::Column_Album:
+      return song.album();
+    case Playlist::Column_AlbumArtist:
+      return song.playlist_albumartist();
+    case Playlist::Column_Composer:
+      return song.composer();
+    case Playlist::Column_Performer:
+      return song.performer();
+    case Playlist::Column_Grouping:
+      return song.grouping();
+    case Playlist::Column_Genre:
+      return song.genre();
+    case Playlist::Column_Length:
+      return QString::number(song.length_nanosec());
+    case Playlist::Column_Track:
+      return QString::number(song.track());
+    case Playlist::Column_Disc:
+      return QString::number(song.disc());
+    case Playlist::Column_Year:
+      return QString::number(song.year());
+    case Playlist::Column_OriginalYear:
+      return QString::number(song.effective_originalyear());
+    case Playlist::Column_Score:
+      return QString::number(song.score());
+    case Playlist::Column_Bitrate:
+      return QString::number(song.bitrate());
+    case Playlist::Column_BPM:
+      return QVariant(song.bpm()).toString();
+    case Playlist::Column_Rating:
+      return QVariant(song.rating()).toString();
+    case Playlist::Column_Filename:
+      return song.url().toString();
+    case Playlist::Column_Comment:
+      return song.comment().simplified();
+  }
+  return QString();
+}
 
 class SearchTermComparator {
  public:
   virtual ~SearchTermComparator() {}
-  virtual bool Matches(const QString& element) const = 0;
+  virtual bool Matches(const QStringRef& element) const = 0;
+
+  // True if the comparator gives the same answer when it's run once over all
+  // the columns joined together as when it's run over each column.
+  virtual bool CanMatchJoined() const { return false; }
 };
 
 // "compares" by checking if the field contains the search term
 class DefaultComparator : public SearchTermComparator {
  public:
-  explicit DefaultComparator(const QString& value) : search_term_(value) {}
-  virtual bool Matches(const QString& element) const {
-    return element.contains(search_term_);
+  explicit DefaultComparator(const QString& value) : matcher_(value) {}
+  virtual bool Matches(const QStringRef& element) const {
+    return matcher_.indexIn(element.unicode(), element.length()) != -1;
   }
+  // The search term can't contain the separator, so it can't match across
+  // two columns.
+  virtual bool CanMatchJoined() const { return true; }
 
  private:
-  QString search_term_;
+  QStringMatcher matcher_;
 };
 
 class EqComparator : public SearchTermComparator {
  public:
   explicit EqComparator(const QString& value) : search_term_(value) {}
-  virtual bool Matches(const QString& element) const {
+  virtual bool Matches(const QStringRef& element) const {
     return search_term_ == element;
   }
 
@@ -53,7 +129,7 @@ class EqComparator : public SearchTermComparator {
 class NeComparator : public SearchTermComparator {
  public:
   explicit NeComparator(const QString& value) : search_term_(value) {}
-  virtual bool Matches(const QString& element) const {
+  virtual bool Matches(const QStringRef& element) const {
     return search_term_ != element;
   }
 
@@ -64,8 +140,8 @@ class NeComparator : public SearchTermComparator {
 class LexicalGtComparator : public SearchTermComparator {
  public:
   explicit LexicalGtComparator(const QString& value) : search_term_(value) {}
-  virtual bool Matches(const QString& element) const {
-    return element > search_term_;
+  virtual bool Matches(const QStringRef& element) const {
+    return QStringRef::compare(element, search_term_) > 0;
   }
 
  private:
@@ -75,8 +151,8 @@ class LexicalGtComparator : public SearchTermComparator {
 class LexicalGeComparator : public SearchTermComparator {
  public:
   explicit LexicalGeComparator(const QString& value) : search_term_(value) {}
-  virtual bool Matches(const QString& element) const {
-    return element >= search_term_;
+  virtual bool Matches(const QStringRef& element) const {
+    return QStringRef::compare(element, search_term_) >= 0;
   }
 
  private:
@@ -86,8 +162,8 @@ class LexicalGeComparator : public SearchTermComparator {
 class LexicalLtComparator : public SearchTermComparator {
  public:
   explicit LexicalLtComparator(const QString& value) : search_term_(value) {}
-  virtual bool Matches(const QString& element) const {
-    return element < search_term_;
+  virtual bool Matches(const QStringRef& element) const {
+    return QStringRef::compare(element, search_term_) < 0;
   }
 
  private:
@@ -97,8 +173,8 @@ class LexicalLtComparator : public SearchTermComparator {
 class LexicalLeComparator : public SearchTermComparator {
  public:
   explicit LexicalLeComparator(const QString& value) : search_term_(value) {}
-  virtual bool Matches(const QString& element) const {
-    return element <= search_term_;
+  virtual bool Matches(const QStringRef& element) const {
+    return QStringRef::compare(element, search_term_) <= 0;
   }
 
  private:
@@ -108,8 +184,8 @@ class LexicalLeComparator : public SearchTermComparator {
 class GtComparator : public SearchTermComparator {
  public:
   explicit GtComparator(int value) : search_term_(value) {}
-  virtual bool Matches(const QString& element) const {
-    return element.toInt() > search_term_;
+  virtual bool Matches(const QStringRef& element) const {
+    return element.toString().toInt() > search_term_;
   }
 
  private:
@@ -119,8 +195,8 @@ class GtComparator : public SearchTermComparator {
 class GeComparator : public SearchTermComparator {
  public:
   explicit GeComparator(int value) : search_term_(value) {}
-  virtual bool Matches(const QString& element) const {
-    return element.toInt() >= search_term_;
+  virtual bool Matches(const QStringRef& element) const {
+    return element.toString().toInt() >= search_term_;
   }
 
  private:
@@ -130,8 +206,8 @@ class GeComparator : public SearchTermComparator {
 class LtComparator : public SearchTermComparator {
  public:
   explicit LtComparator(int value) : search_term_(value) {}
-  virtual bool Matches(const QString& element) const {
-    return element.toInt() < search_term_;
+  virtual bool Matches(const QStringRef& element) const {
+    return element.toString().toInt() < search_term_;
   }
 
  private:
@@ -141,8 +217,8 @@ class LtComparator : public SearchTermComparator {
 class LeComparator : public SearchTermComparator {
  public:
   explicit LeComparator(int value) : search_term_(value) {}
-  virtual bool Matches(const QString& element) const {
-    return element.toInt() <= search_term_;
+  virtual bool Matches(const QStringRef& element) const {
+    return element.toString().toInt() <= search_term_;
   }
 
  private:
@@ -158,9 +234,10 @@ class DropTailComparatorDecorator : public SearchTermComparator {
  public:
   explicit DropTailComparatorDecorator(SearchTermComparator* cmp) : cmp_(cmp) {}
 
-  virtual bool Matches(const QString& element) const {
+  virtual bool Matches(const QStringRef& element) const {
     if (element.length() > 9)
-      return cmp_->Matches(element.left(element.length() - 9));
+      return cmp_->Matches(QStringRef(element.string(), element.position(),
+                                      element.length() - 9));
     else
       return cmp_->Matches(element);
   }
@@ -172,9 +249,10 @@ class DropTailComparatorDecorator : public SearchTermComparator {
 class RatingComparatorDecorator : public SearchTermComparator {
  public:
   explicit RatingComparatorDecorator(SearchTermComparator* cmp) : cmp_(cmp) {}
-  virtual bool Matches(const QString& element) const {
-    return cmp_->Matches(
-        QString::number(static_cast<int>(element.toDouble() * 10.0 + 0.5)));
+  virtual bool Matches(const QStringRef& element) const {
+    const QString rating = QString::number(
+        static_cast<int>(element.toString().toDouble() * 10.0 + 0.5));
+    return cmp_->Matches(QStringRef(&rating));
   }
 
  private:
@@ -188,11 +266,12 @@ class FilterTerm : public FilterTree {
                       const QList<int>& columns)
       : cmp_(comparator), columns_(columns) {}
 
-  virtual bool accept(int row, const QModelIndex& parent,
-                      const QAbstractItemModel* const model) const {
+  virtual bool accept(const FilterRow& row) const {
+    if (cmp_->CanMatchJoined()) {
+      return cmp_->Matches(QStringRef(&row.text()));
+    }
     for (int i : columns_) {
-      QModelIndex idx(model->index(row, i, parent));
-      if (cmp_->Matches(idx.data().toString().toLower())) return true;
+      if (cmp_->Matches(row.column(i))) return true;
     }
     return false;
   }
@@ -210,10 +289,8 @@ class FilterColumnTerm : public FilterTree {
   FilterColumnTerm(int column, SearchTermComparator* comparator)
       : col(column), cmp_(comparator) {}
 
-  virtual bool accept(int row, const QModelIndex& parent,
-                      const QAbstractItemModel* const model) const {
-    QModelIndex idx(model->index(row, col, parent));
-    return cmp_->Matches(idx.data().toString().toLower());
+  virtual bool accept(const FilterRow& row) const {
+    return cmp_->Matches(row.column(col));
   }
   virtual FilterType type() { return Column; }
 
@@ -226,9 +303,8 @@ class NotFilter : public FilterTree {
  public:
   explicit NotFilter(const FilterTree* inv) : child_(inv) {}
 
-  virtual bool accept(int row, const QModelIndex& parent,
-                      const QAbstractItemModel* const model) const {
-    return !child_->accept(row, parent, model);
+  virtual bool accept(const FilterRow& row) const {
+    return !child_->accept(row);
   }
   virtual FilterType type() { return Not; }
 
@@ -240,10 +316,9 @@ class OrFilter : public FilterTree {
  public:
   ~OrFilter() { qDeleteAll(children_); }
   virtual void add(FilterTree* child) { children_.append(child); }
-  virtual bool accept(int row, const QModelIndex& parent,
-                      const QAbstractItemModel* const model) const {
+  virtual bool accept(const FilterRow& row) const {
     for (FilterTree* child : children_) {
-      if (child->accept(row, parent, model)) return true;
+      if (child->accept(row)) return true;
     }
     return false;
   }
@@ -257,10 +332,9 @@ class AndFilter : public FilterTree {
  public:
   virtual ~AndFilter() { qDeleteAll(children_); }
   virtual void add(FilterTree* child) { children_.append(child); }
-  virtual bool accept(int row, const QModelIndex& parent,
-                      const QAbstractItemModel* const model) const {
+  virtual bool accept(const FilterRow& row) const {
     for (FilterTree* child : children_) {
-      if (!child->accept(row, parent, model)) return false;
+      if (!child->accept(row)) return false;
     }
     return true;
   }
@@ -283,6 +357,42 @@ FilterTree* FilterParser::parse() {
   return parseOrGroup();
 }
 
+namespace {
+
+// Characters that can change the meaning of a filter rather than just being
+// part of a search term.
+bool IsPlainFilterChar(const QChar& c) {
+  switch (c.unicode()) {
+    case '-': case '(': case ')': case '"': case ':':
+    case '<': case '>': case '=': case '!':
+      return false;
+  }
+  return c != FilterRow::kSeparator;
+}
+
+// True if the filter is only words that are ANDed together.
+bool IsPlainWordList(const QString& filter) {
+  for (const QChar& c : filter) {
+    if (!IsPlainFilterChar(c)) return false;
+  }
+  for (const QString& word : filter.split(QRegExp("\\s+"))) {
+    if (word == "AND" || word == "OR") return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+bool FilterParser::IsNarrowing(const QString& old_filter,
+                               const QString& new_filter) {
+  // Each word in a plain word list has to appear somewhere in the row, and
+  // making a word longer or adding more words can only make that harder.
+  if (old_filter.trimmed().isEmpty() || !new_filter.startsWith(old_filter)) {
+    return false;
+  }
+  return IsPlainWordList(old_filter) && IsPlainWordList(new_filter);
+}
+
 void FilterParser::advance() {
   while (iter_ != end_ && iter_->isSpace()) {
     ++iter_;
@@ -19,18 +19,49 @@
 #define PLAYLISTFILTERPARSER_H
 
 #include <QMap>
-#include <QModelIndex>
 #include <QSet>
 #include <QString>
+#include <QStringRef>
 
-class QAbstractItemModel;
+#include "playlist.h"
+
+class Song;
+
+// The text of the filterable columns of one playlist item, lower cased and
+// joined into one string, so filters can test a row without going through
+// Playlist::data() and QVariant for every column.
+class FilterRow {
+ public:
+  FilterRow() {}
+  // Only the given columns are filled in - the rest are empty.
+  FilterRow(const Song& song, const QList<int>& columns);
+
+  bool is_valid() const { return !text_.isNull(); }
+
+  // All the columns, each followed by kSeparator.
+  const QString& text() const { return text_; }
+  QStringRef column(int column) const {
+    return QStringRef(&text_, starts_[column],
+                      starts_[column + 1] - starts_[column] - 1);
+  }
+
+  // Can never be part of a search term.
+  static const QChar kSeparator;
+
+ private:
+  static QString ColumnText(const Song& song, int column);
+
+  QString text_;
+  int starts_[Playlist::ColumnCount + 1];
+};
 
 // structure for filter parse tree
 class FilterTree {
  public:
   virtual ~FilterTree() {}
-  virtual bool accept(int row, const QModelIndex& parent,
-                      const QAbstractItemModel* const model) const = 0;
+  // Unqualified search terms are tested against every column in the row, so
+  // the row must have been made with the same columns as the FilterParser.
+  virtual bool accept(const FilterRow& row) const = 0;
   enum FilterType { Nop = 0, Or, And, Not, Column, Term };
   virtual FilterType type() = 0;
 };
@@ -38,10 +69,7 @@ class FilterTree {
 // trivial filter that accepts *anything*
 class NopFilter : public FilterTree {
  public:
-  virtual bool accept(int row, const QModelIndex& parent,
-                      const QAbstractItemModel* const model) const {
-    return true;
-  }
+  virtual bool accept(const FilterRow& row) const { return true; }
   virtual FilterType type() { return Nop; }
 };
 
@@ -65,6 +93,12 @@ class FilterParser {
 
   FilterTree* parse();
 
+  // Returns true if every row that matches new_filter is certain to match
+  // old_filter as well, like when another letter is typed at the end of a
+  // search.  Only rows that matched old_filter need to be tested again.
+  static bool IsNarrowing(const QString& old_filter,
+                          const QString& new_filter);
+
  private:
   void advance();
   FilterTree* parseOrGroup();
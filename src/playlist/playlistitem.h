@@ -28,7 +28,7 @@
 #include "core/song.h"
 
 class QAction;
-class SqlRow;
+class SqliteQuery;
 
 class PlaylistItem : public std::enable_shared_from_this<PlaylistItem> {
  public:
@@ -59,7 +59,7 @@ class PlaylistItem : public std::enable_shared_from_this<PlaylistItem> {
 
   virtual QList<QAction*> actions() { return QList<QAction*>(); }
 
-  virtual bool InitFromQuery(const SqlRow& query) = 0;
+  virtual bool InitFromQuery(const SqliteQuery& query) = 0;
   void BindToQuery(QSqlQuery* query) const;
   virtual void Reload() {}
   QFuture<void> BackgroundReload();
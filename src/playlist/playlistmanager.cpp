@@ -49,7 +49,8 @@ PlaylistManager::PlaylistManager(Application* app, QObject* parent)
       parser_(nullptr),
       playlist_container_(nullptr),
       current_(-1),
-      active_(-1) {
+      active_(-1),
+      initializing_(false) {
   connect(app_->player(), SIGNAL(Paused()), SLOT(SetActivePaused()));
   connect(app_->player(), SIGNAL(Playing()), SLOT(SetActivePlaying()));
   connect(app_->player(), SIGNAL(Stopped()), SLOT(SetActiveStopped()));
@@ -78,6 +79,10 @@ void PlaylistManager::Init(LibraryBackend* library_backend,
   connect(library_backend_, SIGNAL(SongsRatingChanged(SongList)),
           SLOT(SongsDiscovered(SongList)));
 
+  // The first playlist becomes the current one while they're being added,
+  // until the tab that was open last time is selected.  Don't restore any of
+  // them until we know which one that is.
+  initializing_ = true;
   for (const PlaylistBackend::Playlist& p :
        playlist_backend->GetAllOpenPlaylists()) {
     AddPlaylist(p.id, p.name, p.special_type, p.ui_path, p.favorite);
@@ -85,6 +90,12 @@ void PlaylistManager::Init(LibraryBackend* library_backend,
 
   // If no playlist exists then make a new one
   if (playlists_.isEmpty()) New(tr("Playlist"));
+  initializing_ = false;
+
+  // Start with the open tab as the active playlist too, so it's the only one
+  // that's loaded.
+  current()->Restore();
+  SetActivePlaylist(current_);
 
   emit PlaylistManagerInitialized();
 }
@@ -177,12 +188,13 @@ void PlaylistManager::Load(const QString& filename) {
 
 void PlaylistManager::Save(int id, const QString& filename,
                            Playlist::Path path_type) {
-  if (playlists_.contains(id)) {
+  if (playlists_.contains(id) && playlist(id)->is_restored()) {
     parser_->Save(playlist(id)->GetAllSongs(), filename, path_type);
   } else {
     // Playlist is not in the playlist manager: probably save action was
     // triggered
-    // from the left side bar and the playlist isn't loaded.
+    // from the left side bar and the playlist isn't loaded.  Or it's open but
+    // hasn't finished loading yet.
     QFuture<QList<Song>> future = QtConcurrent::run(
         playlist_backend_, &PlaylistBackend::GetPlaylistSongs, id);
     QFutureWatcher<SongList>* watcher = new QFutureWatcher<SongList>(this);
@@ -325,6 +337,8 @@ void PlaylistManager::OneOfPlaylistsChanged() {
 void PlaylistManager::SetCurrentPlaylist(int id) {
   Q_ASSERT(playlists_.contains(id));
   current_ = id;
+  // Playlists in the other tabs aren't loaded until they're looked at.
+  if (!initializing_) current()->Restore();
   emit CurrentChanged(current());
   UpdateSummaryText();
 }
@@ -337,6 +351,7 @@ void PlaylistManager::SetActivePlaylist(int id) {
   if (active_ != -1 && active_ != id) active()->set_current_row(-1);
 
   active_ = id;
+  if (!initializing_) active()->Restore();
   emit ActiveChanged(active());
 
   sequence_->SetUsingDynamicPlaylist(active()->is_dynamic());
@@ -264,6 +264,8 @@ class PlaylistManager : public PlaylistManagerInterface {
 
   int current_;
   int active_;
+  // True while the playlists from the last session are being added.
+  bool initializing_;
 };
 
 #endif  // PLAYLISTMANAGER_H
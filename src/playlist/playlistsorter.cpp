@@ -0,0 +1,338 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "playlistsorter.h"
+
+#include <algorithm>
+#include <string.h>
+
+#include <QThread>
+#include <QtConcurrentMap>
+
+#include "playlist.h"
+
+// QString::localeAwareCompare uses strcoll on these platforms, so comparing
+// strxfrm keys gives the same order.  Everywhere else we have to compare the
+// strings themselves.
+#if defined(Q_OS_UNIX) && !defined(Q_OS_MAC)
+#define HAVE_COLLATION_KEYS
+#endif
+
+namespace {
+
+// Lists shorter than this are sorted on the calling thread.
+const int kMinItemsPerThread = 5000;
+
+}  // namespace
+
+struct PlaylistSorter::Range {
+  PlaylistSorter* sorter;
+  int begin;
+  int middle;
+  int end;
+};
+
+class PlaylistSorter::LessThan {
+ public:
+  explicit LessThan(const PlaylistSorter* sorter) : sorter_(sorter) {}
+  bool operator()(int a, int b) const { return sorter_->Less(a, b); }
+
+ private:
+  const PlaylistSorter* sorter_;
+};
+
+PlaylistSorter::PlaylistSorter(const QList<int>& columns, Qt::SortOrder order)
+    : columns_(columns), order_(order) {
+  for (int column : columns_) {
+    types_ << TypeOf(column);
+  }
+}
+
+PlaylistSorter::KeyType PlaylistSorter::TypeOf(int column) {
+  switch (column) {
+    case Playlist::Column_Title:
+    case Playlist::Column_Artist:
+    case Playlist::Column_Album:
+    case Playlist::Column_Genre:
+    case Playlist::Column_AlbumArtist:
+    case Playlist::Column_Composer:
+    case Playlist::Column_Performer:
+    case Playlist::Column_Grouping:
+    case Playlist::Column_Comment:
+#ifdef HAVE_COLLATION_KEYS
+      return Key_Bytes;
+#else
+      return Key_LocaleText;
+#endif
+
+    case Playlist::Column_Length:
+    case Playlist::Column_Track:
+    case Playlist::Column_Disc:
+    case Playlist::Column_Year:
+    case Playlist::Column_OriginalYear:
+    case Playlist::Column_Rating:
+    case Playlist::Column_PlayCount:
+    case Playlist::Column_SkipCount:
+    case Playlist::Column_LastPlayed:
+    case Playlist::Column_Score:
+    case Playlist::Column_BPM:
+    case Playlist::Column_Bitrate:
+    case Playlist::Column_Samplerate:
+    case Playlist::Column_Filesize:
+    case Playlist::Column_Filetype:
+    case Playlist::Column_DateModified:
+    case Playlist::Column_DateCreated:
+      return Key_Number;
+
+    case Playlist::Column_Filename:
+    case Playlist::Column_Source:
+      return Key_Bytes;
+
+    case Playlist::Column_BaseFilename:
+      return Key_Text;
+  }
+  return Key_None;
+}
+
+QByteArray PlaylistSorter::CollationKey(const QString& text) {
+#ifdef HAVE_COLLATION_KEYS
+  const QByteArray local = text.toLocal8Bit();
+  const size_t size = strxfrm(nullptr, local.constData(), 0);
+
+  // QByteArray always has room for the terminating null.
+  QByteArray ret(size, '\0');
+  strxfrm(ret.data(), local.constData(), size + 1);
+  return ret;
+#else
+  Q_UNUSED(text);
+  return QByteArray();
+#endif
+}
+
+// Don't forget to change Playlist::CompareItems when changing this.
+PlaylistSorter::Key PlaylistSorter::MakeKey(const Song& song, int column) {
+  Key ret;
+  QString text;
+
+#define number_key(field) \
+  ret.number = song.field(); \
+  break
+#define text_key(field) \
+  text = song.field();     \
+  break
+
+  switch (column) {
+    case Playlist::Column_Title:
+      text_key(title);
+    case Playlist::Column_Artist:
+      text_key(artist);
+    case Playlist::Column_Album:
+      text_key(album);
+    case Playlist::Column_Genre:
+      text_key(genre);
+    case Playlist::Column_AlbumArtist:
+      text_key(playlist_albumartist);
+    case Playlist::Column_Composer:
+      text_key(composer);
+    case Playlist::Column_Performer:
+      text_key(performer);
+    case Playlist::Column_Grouping:
+      text_key(grouping);
+    case Playlist::Column_Comment:
+      text_key(comment);
+
+    case Playlist::Column_Length:
+      number_key(length_nanosec);
+    case Playlist::Column_Track:
+      number_key(track);
+    case Playlist::Column_Disc:
+      number_key(disc);
+    case Playlist::Column_Year:
+      number_key(year);
+    case Playlist::Column_OriginalYear:
+      number_key(originalyear);
+    case Playlist::Column_Rating:
+      number_key(rating);
+    case Playlist::Column_PlayCount:
+      number_key(playcount);
+    case Playlist::Column_SkipCount:
+      number_key(skipcount);
+    case Playlist::Column_LastPlayed:
+      number_key(lastplayed);
+    case Playlist::Column_Score:
+      number_key(score);
+    case Playlist::Column_BPM:
+      number_key(bpm);
+    case Playlist::Column_Bitrate:
+      number_key(bitrate);
+    case Playlist::Column_Samplerate:
+      number_key(samplerate);
+    case Playlist::Column_Filesize:
+      number_key(filesize);
+    case Playlist::Column_Filetype:
+      number_key(filetype);
+    case Playlist::Column_DateModified:
+      number_key(mtime);
+    case Playlist::Column_DateCreated:
+      number_key(ctime);
+
+    case Playlist::Column_Filename:
+    case Playlist::Column_Source:
+      ret.bytes = song.url().toEncoded();
+      break;
+
+    case Playlist::Column_BaseFilename:
+      ret.text = song.basefilename();
+      break;
+  }
+
+#undef number_key
+#undef text_key
+
+  if (!text.isNull()) {
+    ret.text = text.toLower();
+#ifdef HAVE_COLLATION_KEYS
+    ret.bytes = CollationKey(ret.text);
+#endif
+  }
+
+  return ret;
+}
+
+bool PlaylistSorter::Less(int a, int b) const {
+  const int column_count = columns_.count();
+  const Key* key_a = keys_.constData() + a * column_count;
+  const Key* key_b = keys_.constData() + b * column_count;
+
+  for (int i = 0; i < column_count; ++i) {
+    int result = 0;
+    switch (types_[i]) {
+      case Key_Number:
+        result = key_a[i].number < key_b[i].number
+                     ? -1
+                     : (key_b[i].number < key_a[i].number ? 1 : 0);
+        break;
+      case Key_Text:
+        result = QString::compare(key_a[i].text, key_b[i].text);
+        break;
+      case Key_Bytes:
+        // localeAwareCompare falls back to comparing the strings themselves
+        // when strcoll says they're equal.
+        result = qstrcmp(key_a[i].bytes, key_b[i].bytes);
+        if (result == 0) {
+          result = QString::compare(key_a[i].text, key_b[i].text);
+        }
+        break;
+      case Key_LocaleText:
+        result = QString::localeAwareCompare(key_a[i].text, key_b[i].text);
+        break;
+      case Key_None:
+        break;
+    }
+
+    if (result != 0) {
+      return order_ == Qt::AscendingOrder ? result < 0 : result > 0;
+    }
+  }
+  return false;
+}
+
+void PlaylistSorter::MakeKeys(Range& range) {
+  PlaylistSorter* me = range.sorter;
+  const int column_count = me->columns_.count();
+
+  for (int i = range.begin; i < range.end; ++i) {
+    const Song song = me->items_[i]->Metadata();
+    for (int c = 0; c < column_count; ++c) {
+      me->keys_[i * column_count + c] = MakeKey(song, me->columns_[c]);
+    }
+  }
+}
+
+void PlaylistSorter::SortRange(Range& range) {
+  PlaylistSorter* me = range.sorter;
+  std::stable_sort(me->rows_.begin() + range.begin,
+                   me->rows_.begin() + range.end, LessThan(me));
+}
+
+void PlaylistSorter::MergeRanges(Range& range) {
+  PlaylistSorter* me = range.sorter;
+  std::inplace_merge(me->rows_.begin() + range.begin,
+                     me->rows_.begin() + range.middle,
+                     me->rows_.begin() + range.end, LessThan(me));
+}
+
+void PlaylistSorter::Sort(PlaylistItemList::iterator begin,
+                          PlaylistItemList::iterator end) {
+  const int count = end - begin;
+  if (count < 2 || columns_.isEmpty()) return;
+
+  items_ = begin;
+  keys_ = QVector<Key>(count * columns_.count());
+  rows_.resize(count);
+  for (int i = 0; i < count; ++i) rows_[i] = i;
+
+  // Split the list into one range per thread.  Each range gets its keys made
+  // and is sorted on its own, then neighbouring ranges are merged until only
+  // one is left.  Merging keeps the first range's items first when they
+  // compare equal, so the whole sort is stable.
+  const int range_count =
+      qBound(1, qMin(QThread::idealThreadCount(), count / kMinItemsPerThread),
+             count);
+  QList<Range> ranges;
+  for (int i = 0; i < range_count; ++i) {
+    Range range;
+    range.sorter = this;
+    range.begin = qint64(count) * i / range_count;
+    range.middle = range.begin;
+    range.end = qint64(count) * (i + 1) / range_count;
+    ranges << range;
+  }
+
+  if (range_count == 1) {
+    MakeKeys(ranges[0]);
+    SortRange(ranges[0]);
+  } else {
+    QtConcurrent::blockingMap(ranges, &PlaylistSorter::MakeKeys);
+    QtConcurrent::blockingMap(ranges, &PlaylistSorter::SortRange);
+  }
+
+  while (ranges.count() > 1) {
+    QList<Range> merged;
+    for (int i = 0; i + 1 < ranges.count(); i += 2) {
+      Range range = ranges[i];
+      range.middle = ranges[i].end;
+      range.end = ranges[i + 1].end;
+      merged << range;
+    }
+    QtConcurrent::blockingMap(merged, &PlaylistSorter::MergeRanges);
+
+    if (ranges.count() % 2) merged << ranges.last();
+    ranges = merged;
+  }
+
+  // Put the items in their new order
+  PlaylistItemList items;
+  items.reserve(count);
+  for (PlaylistItemList::iterator it = begin; it != end; ++it) items << *it;
+  for (int i = 0; i < count; ++i) {
+    begin[i] = items[rows_[i]];
+  }
+
+  keys_.clear();
+  rows_.clear();
+}
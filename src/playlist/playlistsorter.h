@@ -0,0 +1,85 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PLAYLIST_PLAYLISTSORTER_H_
+#define PLAYLIST_PLAYLISTSORTER_H_
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+#include "playlistitem.h"
+
+// Sorts playlist items the same way as Playlist::CompareItems, but works out
+// a sort key for every item once up front instead of fetching and lower
+// casing the metadata of both items in every comparison.  Text columns use
+// the C library's collation keys, so comparing two keys gives the same answer
+// as QString::localeAwareCompare.  Large lists are sorted on several threads.
+class PlaylistSorter {
+ public:
+  // Items are sorted by the first column, then by the second column when the
+  // first is equal, and so on.
+  PlaylistSorter(const QList<int>& columns, Qt::SortOrder order);
+
+  // Sorts the items between begin and end in place.  Items that compare equal
+  // are kept in the same order.
+  void Sort(PlaylistItemList::iterator begin,
+            PlaylistItemList::iterator end);
+
+ private:
+  enum KeyType {
+    Key_None,
+    Key_Number,
+    Key_Text,
+    Key_Bytes,
+    Key_LocaleText,
+  };
+
+  struct Key {
+    Key() : number(0) {}
+
+    double number;
+    QString text;
+    QByteArray bytes;
+  };
+
+  struct Range;
+  class LessThan;
+
+  static KeyType TypeOf(int column);
+  static Key MakeKey(const Song& song, int column);
+  static QByteArray CollationKey(const QString& text);
+
+  bool Less(int a, int b) const;
+
+  // Run on a thread for each range.
+  static void MakeKeys(Range& range);
+  static void SortRange(Range& range);
+  static void MergeRanges(Range& range);
+
+ private:
+  QList<int> columns_;
+  QList<KeyType> types_;
+  Qt::SortOrder order_;
+
+  PlaylistItemList::iterator items_;
+  QVector<Key> keys_;
+  QVector<int> rows_;
+};
+
+#endif  // PLAYLIST_PLAYLISTSORTER_H_
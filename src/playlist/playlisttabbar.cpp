@@ -176,8 +176,10 @@ void PlaylistTabBar::Close() {
 
   const bool ask_for_delete = s.value("warn_close_playlist", true).toBool();
 
+  // A playlist that hasn't been loaded yet probably isn't empty either.
+  Playlist* playlist = manager_->playlist(playlist_id);
   if (ask_for_delete && !manager_->IsPlaylistFavorite(playlist_id) &&
-      !manager_->playlist(playlist_id)->GetAllSongs().empty()) {
+      (!playlist->is_restored() || !playlist->GetAllSongs().empty())) {
     QMessageBox confirmation_box;
     confirmation_box.setWindowIcon(QIcon(":/icon.png"));
     confirmation_box.setWindowTitle(tr("Remove playlist"));
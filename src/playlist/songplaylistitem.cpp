@@ -17,10 +17,9 @@
 
 #include "playlistbackend.h"
 #include "songplaylistitem.h"
+#include "core/sqlitequery.h"
 #include "core/tagreaderclient.h"
 
-#include "library/sqlrow.h"
-
 #include <QtDebug>
 #include <QFile>
 #include <QSettings>
@@ -30,7 +29,7 @@ SongPlaylistItem::SongPlaylistItem(const QString& type) : PlaylistItem(type) {}
 SongPlaylistItem::SongPlaylistItem(const Song& song)
     : PlaylistItem(song.is_stream() ? "Stream" : "File"), song_(song) {}
 
-bool SongPlaylistItem::InitFromQuery(const SqlRow& query) {
+bool SongPlaylistItem::InitFromQuery(const SqliteQuery& query) {
   song_.InitFromQuery(query, false, (Song::kColumns.count() + 1) * 3);
 
   if (type() == "Stream") {
@@ -47,6 +47,9 @@ Ripper::Ripper(QObject* parent)
       files_tagged_(0) {
   cdio_ = cdio_open(NULL, DRIVER_UNKNOWN);
 
+  // The rip dialog shows the transcoding progress
+  transcoder_->set_show_job_tasks(false);
+
   connect(this, SIGNAL(RippingComplete()), transcoder_, SLOT(Start()));
   connect(transcoder_, SIGNAL(JobComplete(QString, QString, bool)),
           SLOT(TranscodingJobComplete(QString, QString, bool)));
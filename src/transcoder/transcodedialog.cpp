@@ -109,6 +109,9 @@ TranscodeDialog::TranscodeDialog(QWidget* parent)
   connect(ui_->options, SIGNAL(clicked()), SLOT(Options()));
   connect(ui_->select, SIGNAL(clicked()), SLOT(AddDestination()));
 
+  // The dialog shows the progress itself
+  transcoder_->set_show_job_tasks(false);
+
   connect(transcoder_, SIGNAL(JobComplete(QString, QString, bool)),
           SLOT(JobComplete(QString, QString, bool)));
   connect(transcoder_, SIGNAL(LogLine(QString)), SLOT(LogLine(QString)));
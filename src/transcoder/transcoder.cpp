@@ -22,17 +22,21 @@
 #include <QCoreApplication>
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QSettings>
 #include <QThread>
 #include <QtDebug>
 
 #include "core/logging.h"
 #include "core/signalchecker.h"
+#include "core/taskmanager.h"
+#include "core/timeconstants.h"
 #include "core/utilities.h"
 
 using std::shared_ptr;
 
 int Transcoder::JobFinishedEvent::sEventType = -1;
+const int Transcoder::kTaskUpdateInterval = 1000;  // msec
 
 TranscoderPreset::TranscoderPreset(Song::FileType type, const QString& name,
                                    const QString& extension,
@@ -197,6 +201,8 @@ void Transcoder::JobState::PostFinished(bool success) {
 Transcoder::Transcoder(QObject* parent, const QString& settings_postfix)
     : QObject(parent),
       max_threads_(QThread::idealThreadCount()),
+      priority_(TranscoderScheduler::Priority_Batch),
+      show_job_tasks_(true),
       settings_postfix_(settings_postfix) {
   if (JobFinishedEvent::sEventType == -1)
     JobFinishedEvent::sEventType = QEvent::registerEventType();
@@ -213,6 +219,8 @@ Transcoder::Transcoder(QObject* parent, const QString& settings_postfix)
   }
 }
 
+Transcoder::~Transcoder() { Cancel(); }
+
 QList<TranscoderPreset> Transcoder::GetAllPresets() {
   QList<TranscoderPreset> ret;
   ret << PresetForFileType(Song::Type_Flac);
@@ -318,6 +326,17 @@ void Transcoder::Start() {
                    .arg(queued_jobs_.count())
                    .arg(max_threads()));
 
+  StartJobs();
+}
+
+void Transcoder::SchedulerSlotFree() {
+  // We might have been cancelled since we asked for a slot
+  if (queued_jobs_.isEmpty()) return;
+
+  StartJobs();
+}
+
+void Transcoder::StartJobs() {
   forever {
     StartJobStatus status = MaybeStartNextJob();
     if (status == AllThreadsBusy || status == NoMoreJobs) break;
@@ -325,7 +344,14 @@ void Transcoder::Start() {
 }
 
 Transcoder::StartJobStatus Transcoder::MaybeStartNextJob() {
-  if (current_jobs_.count() >= max_threads()) return AllThreadsBusy;
+  if (current_jobs_.count() >= max_threads()) {
+    // Don't keep a slot reserved that we can't use - another transcoder can
+    // have it.  We ask again when one of our own jobs finishes.
+    if (TranscoderScheduler::Instance()) {
+      TranscoderScheduler::Instance()->Forget(this);
+    }
+    return AllThreadsBusy;
+  }
   if (queued_jobs_.isEmpty()) {
     if (current_jobs_.isEmpty()) {
       emit AllJobsComplete();
@@ -334,11 +360,19 @@ Transcoder::StartJobStatus Transcoder::MaybeStartNextJob() {
     return NoMoreJobs;
   }
 
+  // Wait for a slot if other transcoders are using all the CPUs.  We're told
+  // when one is free.
+  TranscoderScheduler* scheduler = TranscoderScheduler::Instance();
+  if (scheduler && !scheduler->Acquire(this, priority_)) {
+    return AllThreadsBusy;
+  }
+
   Job job = queued_jobs_.takeFirst();
-  if (StartJob(job)) {
+  if (StartJob(job, scheduler != nullptr)) {
     return StartedSuccessfully;
   }
 
+  if (scheduler) scheduler->Release();
   emit JobComplete(job.input, job.output, false);
   return FailedToStart;
 }
@@ -391,7 +425,7 @@ void Transcoder::JobState::ReportError(GstMessage* msg) {
       QDir::toNativeSeparators(job_.input), message));
 }
 
-bool Transcoder::StartJob(const Job& job) {
+bool Transcoder::StartJob(const Job& job, bool has_slot) {
   shared_ptr<JobState> state(new JobState(job, this));
 
   emit LogLine(tr("Starting %1").arg(QDir::toNativeSeparators(job.input)));
@@ -449,6 +483,18 @@ bool Transcoder::StartJob(const Job& job) {
 
   // Start the pipeline
   gst_element_set_state(state->pipeline_, GST_STATE_PLAYING);
+  state->started_.start();
+  state->has_slot_ = has_slot;
+
+  // Show the job in the TaskManager
+  TranscoderScheduler* scheduler = TranscoderScheduler::Instance();
+  if (show_job_tasks_ && scheduler && scheduler->task_manager()) {
+    state->task_id_ = scheduler->task_manager()->StartTask(
+        tr("Transcoding %1").arg(QFileInfo(job.input).fileName()));
+    if (!task_update_timer_.isActive()) {
+      task_update_timer_.start(kTaskUpdateInterval, this);
+    }
+  }
 
   // GStreamer now transcodes in another thread, so we can return now and do
   // something else.  Keep the JobState object around.  It'll post an event
@@ -465,6 +511,70 @@ Transcoder::JobState::~JobState() {
   }
 }
 
+float Transcoder::JobState::Progress() const {
+  if (!pipeline_) return 0.0;
+
+  gint64 position = 0;
+  gint64 duration = 0;
+
+  gst_element_query_position(pipeline_, GST_FORMAT_TIME, &position);
+  gst_element_query_duration(pipeline_, GST_FORMAT_TIME, &duration);
+
+  if (duration <= 0) return 0.0;
+  return float(position) / duration;
+}
+
+float Transcoder::JobState::RealtimeFactor() const {
+  const int elapsed = started_.elapsed();
+  if (!pipeline_ || elapsed <= 0) return 0.0;
+
+  gint64 position = 0;
+  gst_element_query_position(pipeline_, GST_FORMAT_TIME, &position);
+
+  return float(position / kNsecPerMsec) / elapsed;
+}
+
+void Transcoder::ReleaseJob(JobState* state) {
+  TranscoderScheduler* scheduler = TranscoderScheduler::Instance();
+  if (!scheduler) return;
+
+  if (state->has_slot_) {
+    scheduler->Release();
+    state->has_slot_ = false;
+  }
+
+  if (state->task_id_ != -1 && scheduler->task_manager()) {
+    scheduler->task_manager()->SetTaskFinished(state->task_id_);
+    state->task_id_ = -1;
+  }
+}
+
+void Transcoder::UpdateJobTasks() {
+  TranscoderScheduler* scheduler = TranscoderScheduler::Instance();
+  if (!scheduler || !scheduler->task_manager()) return;
+
+  for (const auto& state : current_jobs_) {
+    if (state->task_id_ == -1) continue;
+
+    scheduler->task_manager()->SetTaskName(
+        state->task_id_,
+        tr("Transcoding %1 (%2x realtime)")
+            .arg(QFileInfo(state->job_.input).fileName())
+            .arg(state->RealtimeFactor(), 0, 'f', 1));
+    scheduler->task_manager()->SetTaskProgress(
+        state->task_id_, qBound(0, int(state->Progress() * 100), 100), 100);
+  }
+}
+
+void Transcoder::timerEvent(QTimerEvent* e) {
+  if (e->timerId() == task_update_timer_.timerId()) {
+    UpdateJobTasks();
+    return;
+  }
+
+  QObject::timerEvent(e);
+}
+
 bool Transcoder::event(QEvent* e) {
   if (e->type() == JobFinishedEvent::sEventType) {
     JobFinishedEvent* finished_event = static_cast<JobFinishedEvent*>(e);
@@ -490,8 +600,12 @@ bool Transcoder::event(QEvent* e) {
         gst_pipeline_get_bus(GST_PIPELINE(finished_event->state_->pipeline_)),
         nullptr, nullptr, nullptr);
 
+    // Give its slot to the next job
+    ReleaseJob(it->get());
+
     // Remove it from the list - this will also destroy the GStreamer pipeline
     current_jobs_.erase(it);
+    if (current_jobs_.isEmpty()) task_update_timer_.stop();
 
     // Emit the finished signal
     emit JobComplete(input, output, finished_event->success_);
@@ -508,6 +622,9 @@ bool Transcoder::event(QEvent* e) {
 void Transcoder::Cancel() {
   // Remove all pending jobs
   queued_jobs_.clear();
+  if (TranscoderScheduler::Instance()) {
+    TranscoderScheduler::Instance()->Forget(this);
+  }
 
   // Stop the running ones
   JobStateList::iterator it = current_jobs_.begin();
@@ -528,8 +645,10 @@ void Transcoder::Cancel() {
     }
 
     // Remove the job, this destroys the GStreamer pipeline too
+    ReleaseJob(state.get());
     it = current_jobs_.erase(it);
   }
+  task_update_timer_.stop();
 }
 
 QMap<QString, float> Transcoder::GetProgress() const {
@@ -537,14 +656,7 @@ QMap<QString, float> Transcoder::GetProgress() const {
 
   for (const auto& state : current_jobs_) {
     if (!state->pipeline_) continue;
-
-    gint64 position = 0;
-    gint64 duration = 0;
-
-    gst_element_query_position(state->pipeline_, GST_FORMAT_TIME, &position);
-    gst_element_query_duration(state->pipeline_, GST_FORMAT_TIME, &duration);
-
-    ret[state->job_.input] = float(position) / duration;
+    ret[state->job_.input] = state->Progress();
   }
 
   return ret;
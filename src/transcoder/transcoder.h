@@ -22,12 +22,15 @@
 
 #include <gst/gst.h>
 
+#include <QBasicTimer>
 #include <QObject>
 #include <QStringList>
 #include <QEvent>
 #include <QMetaType>
+#include <QTime>
 
 #include "core/song.h"
+#include "transcoder/transcoderscheduler.h"
 
 struct TranscoderPreset {
   TranscoderPreset() : type_(Song::Type_Unknown) {}
@@ -43,11 +46,14 @@ struct TranscoderPreset {
 };
 Q_DECLARE_METATYPE(TranscoderPreset);
 
+// Jobs are started when the application-wide TranscoderScheduler has a free
+// slot for them, so max_threads is only an upper limit for this instance.
 class Transcoder : public QObject {
   Q_OBJECT
 
  public:
   Transcoder(QObject* parent = nullptr, const QString& settings_postfix = "");
+  ~Transcoder();
 
   static TranscoderPreset PresetForFileType(Song::FileType type);
   static QList<TranscoderPreset> GetAllPresets();
@@ -56,6 +62,17 @@ class Transcoder : public QObject {
   int max_threads() const { return max_threads_; }
   void set_max_threads(int count) { max_threads_ = count; }
 
+  // Jobs for something the user is waiting for get free slots first.
+  TranscoderScheduler::Priority priority() const { return priority_; }
+  void set_priority(TranscoderScheduler::Priority priority) {
+    priority_ = priority;
+  }
+
+  // Whether each running job is shown in the TaskManager.  Turn this off if
+  // the caller shows the progress itself.
+  bool show_job_tasks() const { return show_job_tasks_; }
+  void set_show_job_tasks(bool show) { show_job_tasks_ = show; }
+
   void AddJob(const QString& input, const TranscoderPreset& preset,
               const QString& output = QString());
   void AddTemporaryJob(const QString& input, const TranscoderPreset& preset);
@@ -74,6 +91,11 @@ signals:
 
  protected:
   bool event(QEvent* e);
+  void timerEvent(QTimerEvent* e);
+
+ private slots:
+  // Called by the TranscoderScheduler.
+  void SchedulerSlotFree();
 
  private:
   // The description of a file to transcode - lives in the main thread.
@@ -90,16 +112,27 @@ signals:
         : job_(job),
           parent_(parent),
           pipeline_(nullptr),
-          convert_element_(nullptr) {}
+          convert_element_(nullptr),
+          has_slot_(false),
+          task_id_(-1) {}
     ~JobState();
 
     void PostFinished(bool success);
     void ReportError(GstMessage* msg);
 
+    // How much of the file has been transcoded, and how fast in multiples of
+    // its playback speed.
+    float Progress() const;
+    float RealtimeFactor() const;
+
     Job job_;
     Transcoder* parent_;
     GstElement* pipeline_;
     GstElement* convert_element_;
+
+    bool has_slot_;
+    int task_id_;
+    QTime started_;
   };
 
   // Event passed from a GStreamer callback to the Transcoder when a job
@@ -120,8 +153,15 @@ signals:
     AllThreadsBusy,
   };
 
+  static const int kTaskUpdateInterval;
+
+  void StartJobs();
   StartJobStatus MaybeStartNextJob();
-  bool StartJob(const Job& job);
+  bool StartJob(const Job& job, bool has_slot);
+  // Gives the job's slot back to the scheduler and removes it from the
+  // TaskManager.
+  void ReleaseJob(JobState* state);
+  void UpdateJobTasks();
 
   GstElement* CreateElement(const QString& factory_name,
                             GstElement* bin = nullptr,
@@ -139,6 +179,9 @@ signals:
   typedef QList<std::shared_ptr<JobState>> JobStateList;
 
   int max_threads_;
+  TranscoderScheduler::Priority priority_;
+  bool show_job_tasks_;
+  QBasicTimer task_update_timer_;
   QList<Job> queued_jobs_;
   JobStateList current_jobs_;
   QString settings_postfix_;
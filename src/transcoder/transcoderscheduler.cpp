@@ -0,0 +1,97 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "transcoderscheduler.h"
+
+#include <QMutexLocker>
+#include <QThread>
+
+#include "transcoder/transcoder.h"
+
+TranscoderScheduler* TranscoderScheduler::sInstance = nullptr;
+
+TranscoderScheduler::TranscoderScheduler(TaskManager* task_manager,
+                                         QObject* parent)
+    : QObject(parent),
+      task_manager_(task_manager),
+      slot_count_(qMax(1, QThread::idealThreadCount())),
+      busy_slots_(0) {
+  sInstance = this;
+}
+
+TranscoderScheduler::~TranscoderScheduler() {
+  if (sInstance == this) sInstance = nullptr;
+}
+
+bool TranscoderScheduler::Acquire(Transcoder* transcoder, Priority priority) {
+  QMutexLocker l(&mutex_);
+
+  // Every transcoder ahead of this one in the queue has a free slot reserved
+  // for it.  If this one isn't waiting yet it goes behind all the others with
+  // the same priority.
+  int ahead = 0;
+  bool waiting = false;
+  for (; ahead < waiters_.count(); ++ahead) {
+    const Waiter& waiter = waiters_[ahead];
+    if (waiter.transcoder_ == transcoder) {
+      waiting = true;
+      break;
+    }
+    if (waiter.priority_ > priority) break;
+  }
+
+  if (busy_slots_ + ahead < slot_count_) {
+    busy_slots_++;
+    if (waiting) waiters_.removeAt(ahead);
+    return true;
+  }
+
+  if (!waiting) {
+    Waiter waiter;
+    waiter.transcoder_ = transcoder;
+    waiter.priority_ = priority;
+    waiters_.insert(ahead, waiter);
+  }
+  return false;
+}
+
+void TranscoderScheduler::Release() {
+  QMutexLocker l(&mutex_);
+  busy_slots_ = qMax(0, busy_slots_ - 1);
+  WakeWaiters();
+}
+
+void TranscoderScheduler::Forget(Transcoder* transcoder) {
+  QMutexLocker l(&mutex_);
+  for (int i = 0; i < waiters_.count(); ++i) {
+    if (waiters_[i].transcoder_ == transcoder) {
+      waiters_.removeAt(i);
+      WakeWaiters();
+      return;
+    }
+  }
+}
+
+void TranscoderScheduler::WakeWaiters() {
+  // Each transcoder is woken up in its own thread.  If it's woken up more
+  // than once it just finds it has nothing more to start.
+  const int free_slots = qMin(slot_count_ - busy_slots_, waiters_.count());
+  for (int i = 0; i < free_slots; ++i) {
+    QMetaObject::invokeMethod(waiters_[i].transcoder_, "SchedulerSlotFree",
+                              Qt::QueuedConnection);
+  }
+}
@@ -0,0 +1,88 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRANSCODER_TRANSCODERSCHEDULER_H_
+#define TRANSCODER_TRANSCODERSCHEDULER_H_
+
+#include <QList>
+#include <QMutex>
+#include <QObject>
+
+class TaskManager;
+class Transcoder;
+
+// Shares the CPU between every Transcoder in the application.  Each running
+// job takes one slot, and there is one slot for each core.  When a slot is
+// free it goes to the transcoders waiting with interactive jobs (downloads to
+// the network remote) before those with batch jobs (organising files, ripping),
+// and otherwise to whichever transcoder asked first.
+//
+// Transcoders live in different threads, so this is thread-safe.
+class TranscoderScheduler : public QObject {
+  Q_OBJECT
+
+ public:
+  explicit TranscoderScheduler(TaskManager* task_manager,
+                               QObject* parent = nullptr);
+  ~TranscoderScheduler();
+
+  enum Priority {
+    Priority_Interactive = 0,
+    Priority_Batch = 1,
+  };
+
+  // Returns nullptr if there is no scheduler, in which case each Transcoder
+  // limits itself to its own max_threads.
+  static TranscoderScheduler* Instance() { return sInstance; }
+
+  // Running jobs are shown here.
+  TaskManager* task_manager() const { return task_manager_; }
+  int slot_count() const { return slot_count_; }
+
+  // Takes a slot for a new job.  Returns false if none is free for this
+  // transcoder, and queues it to have its SchedulerSlotFree slot called when
+  // one might be.
+  bool Acquire(Transcoder* transcoder, Priority priority);
+
+  // Gives back a slot taken with Acquire.
+  void Release();
+
+  // Stops the transcoder waiting for a slot, and gives any slot that was
+  // reserved for it to the next one in the queue.  Must be called before it is
+  // destroyed.
+  void Forget(Transcoder* transcoder);
+
+ private:
+  struct Waiter {
+    Transcoder* transcoder_;
+    Priority priority_;
+  };
+
+  // Must be called with mutex_ held.
+  void WakeWaiters();
+
+  static TranscoderScheduler* sInstance;
+
+  TaskManager* task_manager_;
+  const int slot_count_;
+
+  QMutex mutex_;
+  int busy_slots_;
+  QList<Waiter> waiters_;
+};
+
+#endif  // TRANSCODER_TRANSCODERSCHEDULER_H_
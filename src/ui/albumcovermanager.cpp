@@ -27,6 +27,7 @@
 #include "covers/albumcoverloader.h"
 #include "covers/coverproviders.h"
 #include "covers/coversearchstatisticsdialog.h"
+#include "covers/thumbnailstore.h"
 #include "library/librarybackend.h"
 #include "library/libraryquery.h"
 #include "library/sqlrow.h"
@@ -47,6 +48,7 @@
 #include <QMessageBox>
 #include <QPainter>
 #include <QProgressBar>
+#include <QScrollBar>
 #include <QSettings>
 #include <QShortcut>
 #include <QTimer>
@@ -178,6 +180,12 @@ void AlbumCoverManager::Init() {
           SLOT(ArtistChanged(QListWidgetItem*)));
   connect(ui_->filter, SIGNAL(textChanged(QString)), SLOT(UpdateFilter()));
   connect(filter_group, SIGNAL(triggered(QAction*)), SLOT(UpdateFilter()));
+  connect(ui_->filter, SIGNAL(textChanged(QString)),
+          SLOT(PrioritiseVisibleCovers()));
+  connect(filter_group, SIGNAL(triggered(QAction*)),
+          SLOT(PrioritiseVisibleCovers()));
+  connect(ui_->albums->verticalScrollBar(), SIGNAL(valueChanged(int)),
+          SLOT(PrioritiseVisibleCovers()));
   connect(ui_->view, SIGNAL(clicked()), ui_->view, SLOT(showMenu()));
   connect(ui_->fetch, SIGNAL(clicked()), SLOT(FetchAlbumCovers()));
   connect(ui_->export_covers, SIGNAL(clicked()), SLOT(ExportCovers()));
@@ -320,6 +328,11 @@ void AlbumCoverManager::ArtistChanged(QListWidgetItem* current) {
   // case sensitively.
   qStableSort(albums.begin(), albums.end(), CompareAlbumNameNocase);
 
+  // Load covers in the background - the ones that are on screen are moved to
+  // the front of the queue by PrioritiseVisibleCovers.
+  AlbumCoverLoaderOptions options = cover_loader_options_;
+  options.priority_ = AlbumCoverLoaderOptions::Priority_Background;
+
   for (const LibraryBackend::Album& info : albums) {
     // Don't show songs without an album, obviously
     if (info.album_name.isEmpty()) continue;
@@ -336,16 +349,59 @@ void AlbumCoverManager::ArtistChanged(QListWidgetItem* current) {
     item->setToolTip(info.artist + " - " + info.album_name);
 
     if (!info.art_automatic.isEmpty() || !info.art_manual.isEmpty()) {
-      quint64 id = app_->album_cover_loader()->LoadImageAsync(
-          cover_loader_options_, info.art_automatic, info.art_manual,
-          info.first_url.toLocalFile());
       item->setData(Role_PathAutomatic, info.art_automatic);
       item->setData(Role_PathManual, info.art_manual);
+
+      // Use the thumbnail from last time if the art hasn't changed.
+      QImage thumbnail;
+      if (app_->thumbnail_store()->Find(
+              ThumbnailStore::kLargeSize,
+              ThumbnailStore::ArtKey(info.art_automatic, info.art_manual),
+              ThumbnailStore::ArtStamp(info.art_automatic, info.art_manual,
+                                       info.first_url.toLocalFile()),
+              &thumbnail)) {
+        item->setIcon(QPixmap::fromImage(thumbnail));
+        continue;
+      }
+
+      quint64 id = app_->album_cover_loader()->LoadImageAsync(
+          options, info.art_automatic, info.art_manual,
+          info.first_url.toLocalFile());
       cover_loading_tasks_[id] = item;
     }
   }
 
   UpdateFilter();
+  PrioritiseVisibleCovers();
+}
+
+void AlbumCoverManager::PrioritiseVisibleCovers() {
+  const QRect viewport = ui_->albums->viewport()->rect();
+
+  QSet<quint64> visible_ids;
+  QSet<quint64> hidden_ids;
+  for (QMap<quint64, QListWidgetItem*>::const_iterator it =
+           cover_loading_tasks_.constBegin();
+       it != cover_loading_tasks_.constEnd(); ++it) {
+    if (!it.value()->isHidden() &&
+        ui_->albums->visualItemRect(it.value()).intersects(viewport)) {
+      visible_ids.insert(it.key());
+    } else {
+      hidden_ids.insert(it.key());
+    }
+  }
+
+  // Covers that have been scrolled away from go back behind the ones that are
+  // still on screen.
+  AlbumCoverLoader* loader = app_->album_cover_loader();
+  if (!hidden_ids.isEmpty()) {
+    loader->SetTasksPriority(hidden_ids,
+                             AlbumCoverLoaderOptions::Priority_Background);
+  }
+  if (!visible_ids.isEmpty()) {
+    loader->SetTasksPriority(visible_ids,
+                             AlbumCoverLoaderOptions::Priority_Visible);
+  }
 }
 
 void AlbumCoverManager::CoverImageLoaded(quint64 id, const QImage& image) {
@@ -355,6 +411,15 @@ void AlbumCoverManager::CoverImageLoaded(quint64 id, const QImage& image) {
 
   if (image.isNull()) return;
 
+  const QString art_automatic = item->data(Role_PathAutomatic).toString();
+  const QString art_manual = item->data(Role_PathManual).toString();
+  app_->thumbnail_store()->Insert(
+      ThumbnailStore::kLargeSize,
+      ThumbnailStore::ArtKey(art_automatic, art_manual),
+      ThumbnailStore::ArtStamp(art_automatic, art_manual,
+                               item->data(Role_FirstUrl).toUrl().toLocalFile()),
+      image);
+
   item->setIcon(QPixmap::fromImage(image));
   UpdateFilter();
 }
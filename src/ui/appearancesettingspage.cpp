@@ -35,6 +35,7 @@
 #include "ui/albumcoverchoicecontroller.h"
 
 #ifdef HAVE_MOODBAR
+#include "moodbar/moodbarloader.h"
 #include "moodbar/moodbarrenderer.h"
 #endif
 
@@ -78,6 +79,13 @@ AppearanceSettingsPage::AppearanceSettingsPage(SettingsDialog* dialog)
 
   connect(ui_->use_default_background, SIGNAL(toggled(bool)),
           SLOT(DisableBlurAndOpacitySliders(bool)));
+
+  connect(ui_->moodbar_generate_library, SIGNAL(clicked()),
+          SLOT(GenerateLibraryMoodbars()));
+#ifdef HAVE_MOODBAR
+  connect(dialog->app()->moodbar_loader(), SIGNAL(PrecomputeFinished()),
+          SLOT(MoodbarPrecomputeFinished()));
+#endif
   connect(ui_->use_no_background, SIGNAL(toggled(bool)),
           SLOT(DisableBlurAndOpacitySliders(bool)));
 }
@@ -150,6 +158,12 @@ void AppearanceSettingsPage::Load() {
   ui_->moodbar_calculate->setChecked(!s.value("calculate", true).toBool());
   ui_->moodbar_save->setChecked(
       s.value("save_alongside_originals", false).toBool());
+#ifdef HAVE_MOODBAR
+  ui_->moodbar_threads->setValue(
+      s.value("threads", MoodbarLoader::DefaultMaxActiveRequests()).toInt());
+  ui_->moodbar_generate_library->setEnabled(
+      !dialog()->app()->moodbar_loader()->is_precomputing());
+#endif
   s.endGroup();
 
   InitMoodbarPreviews();
@@ -195,6 +209,7 @@ void AppearanceSettingsPage::Save() {
   s.setValue("show", ui_->moodbar_show->isChecked());
   s.setValue("style", ui_->moodbar_style->currentIndex());
   s.setValue("save_alongside_originals", ui_->moodbar_save->isChecked());
+  s.setValue("threads", ui_->moodbar_threads->value());
   s.endGroup();
 }
 
@@ -308,6 +323,20 @@ void AppearanceSettingsPage::InitMoodbarPreviews() {
 #endif
 }
 
+void AppearanceSettingsPage::GenerateLibraryMoodbars() {
+#ifdef HAVE_MOODBAR
+  MoodbarLoader* loader = dialog()->app()->moodbar_loader();
+  loader->PrecomputeLibrary();
+
+  // Nothing is started if moodbar calculation is disabled.
+  ui_->moodbar_generate_library->setEnabled(!loader->is_precomputing());
+#endif
+}
+
+void AppearanceSettingsPage::MoodbarPrecomputeFinished() {
+  ui_->moodbar_generate_library->setEnabled(true);
+}
+
 void AppearanceSettingsPage::DisableBlurAndOpacitySliders(bool checked) {
   // Blur slider
   ui_->blur_slider->setDisabled(checked);
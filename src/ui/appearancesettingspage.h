@@ -45,6 +45,8 @@ class AppearanceSettingsPage : public SettingsPage {
   void BlurLevelChanged(int);
   void OpacityLevelChanged(int);
   void DisableBlurAndOpacitySliders(bool);
+  void GenerateLibraryMoodbars();
+  void MoodbarPrecomputeFinished();
 
  private:
   static const int kMoodbarPreviewWidth;
@@ -62,6 +62,8 @@ EditTagDialog::EditTagDialog(Application* app, QWidget* parent)
       results_dialog_(new TrackSelectionDialog(this)) {
   cover_options_.default_output_image_ =
       AlbumCoverLoader::ScaleAndPad(cover_options_, QImage(":nocover.png"));
+  // The full size image is needed to save the cover to a file.
+  cover_options_.keep_original_image_ = true;
 
   connect(app_->album_cover_loader(),
           SIGNAL(ImageLoaded(quint64, QImage, QImage)),
@@ -360,11 +360,6 @@ MainWindow::MainWindow(Application* app, SystemTrayIcon* tray_icon, OSD* osd,
           SLOT(ToggleScrobbling()));
 #endif
 
-#ifdef HAVE_VK
-  connect(ui_->action_love, SIGNAL(triggered()),
-          InternetModel::Service<VkService>(), SLOT(AddToMyMusicCurrent()));
-#endif
-
   connect(ui_->action_clear_playlist, SIGNAL(triggered()),
           app_->playlist_manager(), SLOT(ClearCurrent()));
   connect(ui_->action_remove_duplicates, SIGNAL(triggered()),
@@ -700,9 +695,14 @@ MainWindow::MainWindow(Application* app, SystemTrayIcon* tray_icon, OSD* osd,
   connect(app_->scrobbler(), SIGNAL(ScrobbledRadioStream()),
           SLOT(ScrobbledRadioStream()));
 #endif
-  connect(app_->internet_model()->Service<MagnatuneService>(),
-          SIGNAL(DownloadFinished(QStringList)), osd_,
-          SLOT(MagnatuneDownloadFinished(QStringList)));
+  // Some services are only created when they're needed, so connect to them
+  // when they are, as well as to the ones that already exist.
+  connect(app_->internet_model(), SIGNAL(ServiceAdded(InternetService*)),
+          SLOT(InternetServiceAdded(InternetService*)));
+  InternetServiceAdded(InternetModel::ExistingService<MagnatuneService>());
+#ifdef HAVE_VK
+  InternetServiceAdded(InternetModel::ExistingService<VkService>());
+#endif
   connect(internet_view_->tree(), SIGNAL(AddToPlaylistSignal(QMimeData*)),
           SLOT(AddToPlaylist(QMimeData*)));
 
@@ -2776,6 +2776,21 @@ void MainWindow::ScrollToInternetIndex(const QModelIndex& index) {
   ui_->tabs->SetCurrentWidget(internet_view_);
 }
 
+void MainWindow::InternetServiceAdded(InternetService* service) {
+  if (!service) return;
+
+  if (qobject_cast<MagnatuneService*>(service)) {
+    connect(service, SIGNAL(DownloadFinished(QStringList)), osd_,
+            SLOT(MagnatuneDownloadFinished(QStringList)));
+  }
+#ifdef HAVE_VK
+  if (qobject_cast<VkService*>(service)) {
+    connect(ui_->action_love, SIGNAL(triggered()), service,
+            SLOT(AddToMyMusicCurrent()));
+  }
+#endif
+}
+
 void MainWindow::AddPodcast() {
   app_->internet_model()->Service<PodcastService>()->AddPodcast();
 }
@@ -66,6 +66,7 @@ class PlaylistManager;
 class QueueManager;
 class InternetItem;
 class InternetModel;
+class InternetService;
 class InternetViewContainer;
 class Remote;
 class RipCDDialog;
@@ -282,6 +283,7 @@ signals:
                                  QString line2);
 
   void ScrollToInternetIndex(const QModelIndex& index);
+  void InternetServiceAdded(InternetService* service);
   void FocusGlobalSearchField();
   void DoGlobalSearch(const QString& query);
 
@@ -0,0 +1,163 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gtest/gtest.h"
+
+#include <math.h>
+
+#include <QList>
+#include <QTime>
+#include <QVector>
+#include <QtDebug>
+
+#include "analyzers/fht.h"
+
+namespace {
+
+// The scope sizes used by BarAnalyzer (8), and BlockAnalyzer and Sonogram (9).
+const int kExponents[] = {8, 9};
+
+QList<FHT::Kernel> SupportedSimdKernels() {
+  QList<FHT::Kernel> ret;
+  if (FHT::IsKernelSupported(FHT::Kernel_SSE2)) ret << FHT::Kernel_SSE2;
+  if (FHT::IsKernelSupported(FHT::Kernel_AVX2)) ret << FHT::Kernel_AVX2;
+  return ret;
+}
+
+// Something that looks a bit like music: a few sines and some noise.
+QVector<float> MakeScope(int size) {
+  QVector<float> ret(size);
+  unsigned int seed = 1;
+  for (int i = 0; i < size; ++i) {
+    seed = seed * 1103515245 + 12345;
+    const float noise = float((seed >> 16) & 0x7fff) / 0x7fff - 0.5;
+    ret[i] = 0.5 * sin(i * 0.05) + 0.3 * sin(i * 0.71) + 0.1 * noise;
+  }
+  return ret;
+}
+
+void ExpectNear(const QVector<float>& expected, const QVector<float>& actual,
+                int count, float tolerance) {
+  for (int i = 0; i < count; ++i) {
+    EXPECT_NEAR(expected[i], actual[i], tolerance) << "at index " << i;
+  }
+}
+
+TEST(FHTTest, ScalarAlwaysSupported) {
+  EXPECT_TRUE(FHT::IsKernelSupported(FHT::Kernel_Scalar));
+  EXPECT_TRUE(FHT::IsKernelSupported(FHT::BestKernel()));
+  EXPECT_EQ(FHT::BestKernel(), FHT(9).kernel());
+  EXPECT_EQ(FHT::Kernel_Scalar, FHT(9, FHT::Kernel_Scalar).kernel());
+}
+
+TEST(FHTTest, TransformMatchesScalar) {
+  for (int exp : kExponents) {
+    FHT scalar(exp, FHT::Kernel_Scalar);
+    QVector<float> expected = MakeScope(scalar.size());
+    scalar.transform(expected.data());
+
+    for (FHT::Kernel kernel : SupportedSimdKernels()) {
+      SCOPED_TRACE(FHT::KernelName(kernel));
+      FHT fht(exp, kernel);
+      QVector<float> actual = MakeScope(fht.size());
+      fht.transform(actual.data());
+      ExpectNear(expected, actual, fht.size(), 1e-3);
+    }
+  }
+}
+
+TEST(FHTTest, PowerMatchesScalar) {
+  for (int exp : kExponents) {
+    FHT scalar(exp, FHT::Kernel_Scalar);
+    QVector<float> expected = MakeScope(scalar.size());
+    scalar.power2(expected.data());
+
+    for (FHT::Kernel kernel : SupportedSimdKernels()) {
+      SCOPED_TRACE(FHT::KernelName(kernel));
+      FHT fht(exp, kernel);
+      QVector<float> actual = MakeScope(fht.size());
+      fht.power2(actual.data());
+      ExpectNear(expected, actual, fht.size() / 2, 1e-3);
+    }
+  }
+}
+
+TEST(FHTTest, SpectrumMatchesScalar) {
+  for (int exp : kExponents) {
+    FHT scalar(exp, FHT::Kernel_Scalar);
+    QVector<float> expected = MakeScope(scalar.size());
+    scalar.power2(expected.data());
+    scalar.spectrum(expected.data());
+
+    for (FHT::Kernel kernel : SupportedSimdKernels()) {
+      SCOPED_TRACE(FHT::KernelName(kernel));
+      FHT fht(exp, kernel);
+      QVector<float> actual = MakeScope(fht.size());
+      fht.power2(actual.data());
+      fht.spectrum(actual.data());
+      ExpectNear(expected, actual, fht.size() / 2, 1e-3);
+    }
+  }
+}
+
+TEST(FHTTest, LogSpectrumMatchesScalar) {
+  for (int exp : kExponents) {
+    FHT scalar(exp, FHT::Kernel_Scalar);
+    QVector<float> input = MakeScope(scalar.size());
+    QVector<float> expected(scalar.size());
+    scalar.logSpectrum(expected.data(), input.data());
+
+    for (FHT::Kernel kernel : SupportedSimdKernels()) {
+      SCOPED_TRACE(FHT::KernelName(kernel));
+      FHT fht(exp, kernel);
+      input = MakeScope(fht.size());
+      QVector<float> actual(fht.size());
+      fht.logSpectrum(actual.data(), input.data());
+      ExpectNear(expected, actual, fht.size() / 2, 1e-3);
+    }
+  }
+}
+
+// Times each kernel.  Run with --gtest_also_run_disabled_tests.
+TEST(FHTTest, DISABLED_Benchmark) {
+  const int kIterations = 20000;
+
+  QList<FHT::Kernel> kernels = SupportedSimdKernels();
+  kernels.prepend(FHT::Kernel_Scalar);
+
+  for (int exp : kExponents) {
+    for (FHT::Kernel kernel : kernels) {
+      FHT fht(exp, kernel);
+      const QVector<float> scope = MakeScope(fht.size());
+      QVector<float> input(fht.size());
+      QVector<float> output(fht.size());
+
+      QTime t;
+      t.start();
+      for (int i = 0; i < kIterations; ++i) {
+        input = scope;
+        fht.logSpectrum(output.data(), input.data());
+      }
+      const int msecs = t.elapsed();
+
+      qDebug() << "2 ^" << exp << FHT::KernelName(kernel) << ":"
+               << (msecs * 1000.0 / kIterations) << "us per logSpectrum";
+    }
+  }
+}
+
+}  // namespace
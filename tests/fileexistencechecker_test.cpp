@@ -0,0 +1,106 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test_utils.h"
+#include "gtest/gtest.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+
+#include "core/fileexistencechecker.h"
+
+namespace {
+
+class FileExistenceCheckerTest : public ::testing::Test {
+ protected:
+  void SetUp() {
+    path_ = QDir::tempPath() +
+            QString("/fileexistencecheckertest-%1")
+                .arg(QCoreApplication::applicationPid());
+    ASSERT_TRUE(QDir().mkpath(path_ + "/many"));
+    ASSERT_TRUE(QDir().mkpath(path_ + "/few"));
+
+    for (int i = 0; i < 10; ++i) {
+      CreateFile(QString("many/%1.mp3").arg(i));
+    }
+    CreateFile("few/0.mp3");
+  }
+
+  void TearDown() {
+    for (const QString& dir : QStringList() << "many" << "few") {
+      QDir d(path_ + "/" + dir);
+      for (const QString& name : d.entryList(QDir::Files)) {
+        d.remove(name);
+      }
+      QDir(path_).rmdir(dir);
+    }
+    QDir::temp().rmdir(path_);
+  }
+
+  void CreateFile(const QString& name) {
+    QFile file(Filename(name));
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+  }
+
+  QString Filename(const QString& name) const { return path_ + "/" + name; }
+
+  QString path_;
+};
+
+TEST_F(FileExistenceCheckerTest, AllExist) {
+  QStringList filenames;
+  for (int i = 0; i < 10; ++i) {
+    filenames << Filename(QString("many/%1.mp3").arg(i));
+  }
+  filenames << Filename("few/0.mp3");
+
+  EXPECT_TRUE(FileExistenceChecker::MissingFiles(filenames).isEmpty());
+}
+
+TEST_F(FileExistenceCheckerTest, FindsMissingFiles) {
+  QStringList filenames;
+  for (int i = 0; i < 12; ++i) {
+    filenames << Filename(QString("many/%1.mp3").arg(i));
+  }
+  filenames << Filename("few/0.mp3") << Filename("few/1.mp3");
+
+  QSet<QString> expected;
+  expected << Filename("many/10.mp3") << Filename("many/11.mp3")
+           << Filename("few/1.mp3");
+  EXPECT_EQ(expected, FileExistenceChecker::MissingFiles(filenames));
+}
+
+TEST_F(FileExistenceCheckerTest, MissingDirectory) {
+  QStringList filenames;
+  for (int i = 0; i < 5; ++i) {
+    filenames << Filename(QString("gone/%1.mp3").arg(i));
+  }
+
+  EXPECT_EQ(filenames.toSet(), FileExistenceChecker::MissingFiles(filenames));
+}
+
+TEST_F(FileExistenceCheckerTest, KeepsFilenamesAsGiven) {
+  const QString filename = path_ + "//many/../many/20.mp3";
+  QSet<QString> expected;
+  expected << QString() << filename;
+
+  EXPECT_EQ(expected, FileExistenceChecker::MissingFiles(
+                          QStringList() << QString() << filename));
+}
+
+}  // namespace
@@ -15,14 +15,19 @@
    along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <limits>
 #include <memory>
 
 #include "test_utils.h"
 #include "gtest/gtest.h"
 
 #include <QFileInfo>
+#include <QMap>
+#include <QSet>
 #include <QSignalSpy>
+#include <QSqlQuery>
 #include <QThread>
+#include <QTime>
 #include <QtDebug>
 
 #include "library/librarybackend.h"
@@ -331,4 +336,285 @@ TEST_F(SingleSong, MarkSongsUnavailable) {
   EXPECT_EQ(0, albums.size());
 }
 
+class BulkInsert : public LibraryBackendTest {
+ protected:
+  void SetUp() {
+    LibraryBackendTest::SetUp();
+    backend_->AddDirectory("/tmp");
+  }
+
+  SongList MakeSongs(int count, int first = 0) {
+    SongList ret;
+    for (int i = first; i < first + count; ++i) {
+      Song song = MakeDummySong(1);
+      song.set_title(QString("Title %1").arg(i));
+      song.set_artist(QString("Artist %1").arg(i % 100));
+      song.set_album(QString("Album %1").arg(i % 1000));
+      song.set_url(QUrl::fromLocalFile(QString("/tmp/%1.mp3").arg(i)));
+      ret << song;
+    }
+    return ret;
+  }
+
+  // Adds the songs and returns the ones that were added, with their IDs.
+  SongList AddSongs(const SongList& songs) {
+    QSignalSpy spy(backend_.get(), SIGNAL(SongsDiscovered(SongList)));
+    backend_->AddOrUpdateSongs(songs);
+    if (spy.count() != 1) return SongList();
+    return spy[0][0].value<SongList>();
+  }
+
+  void SetRowId(qint64 row_id) {
+    QSqlDatabase db(database_->Connect());
+    QSqlQuery q(db);
+    ASSERT_TRUE(q.exec(QString("UPDATE %1 SET ROWID = %2")
+                           .arg(Library::kSongsTable)
+                           .arg(row_id)));
+  }
+
+  // Checks that the song and its FTS row can both be found by its ID.
+  void ExpectSongInDatabase(const Song& song) {
+    Song from_db = backend_->GetSongById(song.id());
+    ASSERT_TRUE(from_db.is_valid());
+    EXPECT_EQ(song.title(), from_db.title());
+    EXPECT_EQ(song.url(), from_db.url());
+
+    QSqlDatabase db(database_->Connect());
+    QSqlQuery q(db);
+    ASSERT_TRUE(q.exec(QString("SELECT ftstitle FROM %1 WHERE ROWID = %2")
+                           .arg(Library::kFtsTable)
+                           .arg(song.id())));
+    ASSERT_TRUE(q.next());
+    EXPECT_EQ(song.title(), q.value(0).toString());
+  }
+
+  // Adds the songs and returns how long it took in milliseconds.
+  int TimeAddOrUpdateSongs(const SongList& songs, bool bulk) {
+    backend_->DeleteAll();
+    backend_->set_bulk_insert_enabled(bulk);
+
+    QTime time;
+    time.start();
+    backend_->AddOrUpdateSongs(songs);
+    return qMax(1, time.elapsed());
+  }
+};
+
+TEST_F(BulkInsert, AddsAllSongs) {
+  // More songs than fit in one statement, and not a multiple of it either.
+  SongList added = AddSongs(MakeSongs(100));
+  ASSERT_EQ(100, added.size());
+
+  QSet<int> ids;
+  for (const Song& song : added) {
+    ExpectSongInDatabase(song);
+    ids << song.id();
+  }
+  EXPECT_EQ(100, ids.count());
+}
+
+TEST_F(BulkInsert, IdsFitInAnIntWhenRowIdsRunOut) {
+  AddSongs(MakeSongs(1));
+
+  // Once the largest ROWID is used SQLite picks new ones at random, which
+  // wouldn't fit in a song's ID.
+  SetRowId(std::numeric_limits<qint64>::max());
+
+  SongList added = AddSongs(MakeSongs(20, 1));
+  ASSERT_EQ(20, added.size());
+
+  for (const Song& song : added) {
+    EXPECT_GT(song.id(), 0);
+    ExpectSongInDatabase(song);
+  }
+}
+
+TEST_F(BulkInsert, IdsFitInAnIntNearTheLargestId) {
+  AddSongs(MakeSongs(1));
+
+  // Only 5 IDs are left after this one, so the rest have to fill the gap
+  // below it.
+  SetRowId(std::numeric_limits<int>::max() - 5);
+
+  SongList added = AddSongs(MakeSongs(20, 1));
+  ASSERT_EQ(20, added.size());
+
+  QSet<int> ids;
+  for (const Song& song : added) {
+    EXPECT_GT(song.id(), 0);
+    EXPECT_NE(std::numeric_limits<int>::max() - 5, song.id());
+    ExpectSongInDatabase(song);
+    ids << song.id();
+  }
+  EXPECT_EQ(20, ids.count());
+}
+
+// Compares the multi-row INSERTs with inserting one song at a time.  Run with
+// --gtest_also_run_disabled_tests.
+TEST_F(BulkInsert, DISABLED_Benchmark) {
+  const int kSongCount = 20000;
+  SongList songs = MakeSongs(kSongCount);
+
+  const int single_msecs = TimeAddOrUpdateSongs(songs, false);
+  const int bulk_msecs = TimeAddOrUpdateSongs(songs, true);
+
+  qDebug() << "One row per statement:" << single_msecs << "ms,"
+           << (kSongCount * 1000 / single_msecs) << "rows/sec";
+  qDebug() << "Many rows per statement:" << bulk_msecs << "ms,"
+           << (kSongCount * 1000 / bulk_msecs) << "rows/sec";
+
+  EXPECT_EQ(kSongCount, backend_->GetAllSongs().count());
+}
+
+class ReplaceSongsInDirectory : public LibraryBackendTest {
+ protected:
+  void SetUp() {
+    LibraryBackendTest::SetUp();
+    backend_->AddDirectory("/tmp");
+
+    for (int i = 0; i < 3; ++i) {
+      songs_ << MakeSong(i);
+    }
+    backend_->AddOrUpdateSongs(songs_);
+    songs_ = backend_->FindSongsInDirectory(1);
+    ASSERT_EQ(3, songs_.count());
+  }
+
+  Song MakeSong(int i) {
+    Song song = MakeDummySong(1);
+    song.set_title(QString("Title %1").arg(i));
+    song.set_url(QUrl(QString("mtp://device/%1").arg(i)));
+    return song;
+  }
+
+  SongList songs_;
+};
+
+TEST_F(ReplaceSongsInDirectory, NothingChanged) {
+  QSignalSpy deleted_spy(backend_.get(), SIGNAL(SongsDeleted(SongList)));
+  QSignalSpy discovered_spy(backend_.get(),
+                            SIGNAL(SongsDiscovered(SongList)));
+
+  SongList songs;
+  for (int i = 0; i < 3; ++i) {
+    songs << MakeSong(i);
+  }
+  backend_->ReplaceSongsInDirectory(1, songs);
+
+  EXPECT_EQ(0, deleted_spy.count());
+  EXPECT_EQ(0, discovered_spy.count());
+  EXPECT_EQ(3, backend_->FindSongsInDirectory(1).count());
+}
+
+TEST_F(ReplaceSongsInDirectory, OnlyWritesChanges) {
+  QSignalSpy deleted_spy(backend_.get(), SIGNAL(SongsDeleted(SongList)));
+  QSignalSpy discovered_spy(backend_.get(),
+                            SIGNAL(SongsDiscovered(SongList)));
+
+  // Song 0 is unchanged, 1 has been retagged, 2 has gone and 3 is new.
+  SongList songs;
+  songs << MakeSong(0) << MakeSong(1) << MakeSong(3);
+  songs[1].set_title("New title");
+  songs[1].set_mtime(2);
+  backend_->ReplaceSongsInDirectory(1, songs);
+
+  ASSERT_EQ(2, deleted_spy.count());
+  SongList deleted = deleted_spy[0][0].value<SongList>();
+  ASSERT_EQ(1, deleted.count());
+  EXPECT_EQ(songs_[2].id(), deleted[0].id());
+
+  // The update of song 1 removes the old version of it.
+  deleted = deleted_spy[1][0].value<SongList>();
+  ASSERT_EQ(1, deleted.count());
+  EXPECT_EQ(songs_[1].id(), deleted[0].id());
+
+  ASSERT_EQ(1, discovered_spy.count());
+  SongList discovered = discovered_spy[0][0].value<SongList>();
+  ASSERT_EQ(2, discovered.count());
+  EXPECT_EQ(songs_[1].id(), discovered[0].id());
+  EXPECT_EQ("New title", discovered[0].title());
+  EXPECT_EQ(QUrl("mtp://device/3"), discovered[1].url());
+
+  EXPECT_EQ(songs_[0].id(), backend_->GetSongById(songs_[0].id()).id());
+  EXPECT_EQ(3, backend_->FindSongsInDirectory(1).count());
+}
+
+class LibraryRevision : public BulkInsert {
+ protected:
+  qint64 Revision() {
+    QString library_id;
+    qint64 revision = -1;
+    backend_->GetRevision(&library_id, &revision);
+    return revision;
+  }
+
+  // Returns the songs changed since the revision, and whether each one was
+  // deleted.
+  QMap<int, bool> ChangesSince(qint64 revision) {
+    QMap<int, bool> ret;
+    QSqlDatabase db(database_->Connect());
+    QSqlQuery q(db);
+    q.prepare("SELECT song_id, deleted FROM library_changes"
+              " WHERE revision > :revision");
+    q.bindValue(":revision", revision);
+    q.exec();
+    while (q.next()) {
+      ret[q.value(0).toInt()] = q.value(1).toBool();
+    }
+    return ret;
+  }
+};
+
+TEST_F(LibraryRevision, NewLibrary) {
+  QString library_id;
+  qint64 revision = -1;
+  backend_->GetRevision(&library_id, &revision);
+
+  EXPECT_EQ(32, library_id.length());
+  EXPECT_EQ(0, revision);
+  EXPECT_TRUE(ChangesSince(0).isEmpty());
+}
+
+TEST_F(LibraryRevision, BulkInsertMakesOneRevision) {
+  backend_->AddOrUpdateSongs(MakeSongs(50));
+
+  EXPECT_EQ(1, Revision());
+  EXPECT_EQ(50, ChangesSince(0).count());
+
+  // Nothing has changed since.
+  EXPECT_EQ(1, Revision());
+  EXPECT_TRUE(ChangesSince(1).isEmpty());
+}
+
+TEST_F(LibraryRevision, StatisticsDontChangeRevision) {
+  backend_->AddOrUpdateSongs(MakeSongs(1));
+  const qint64 revision = Revision();
+  const int id = backend_->FindSongsInDirectory(1)[0].id();
+
+  backend_->IncrementPlayCount(id);
+  backend_->IncrementSkipCount(id, 0.5);
+  backend_->UpdateSongRating(id, 0.5);
+
+  EXPECT_EQ(revision, Revision());
+  EXPECT_TRUE(ChangesSince(revision).isEmpty());
+}
+
+TEST_F(LibraryRevision, ChangedAndDeletedSongs) {
+  backend_->AddOrUpdateSongs(MakeSongs(3));
+  const qint64 revision = Revision();
+  SongList songs = backend_->FindSongsInDirectory(1);
+  ASSERT_EQ(3, songs.count());
+
+  songs[0].set_title("New title");
+  backend_->AddOrUpdateSongs(SongList() << songs[0]);
+  backend_->DeleteSongs(SongList() << songs[1]);
+
+  EXPECT_EQ(revision + 1, Revision());
+
+  const QMap<int, bool> changes = ChangesSince(revision);
+  ASSERT_EQ(2, changes.count());
+  EXPECT_FALSE(changes[songs[0].id()]);
+  EXPECT_TRUE(changes[songs[1].id()]);
+}
+
 } // namespace
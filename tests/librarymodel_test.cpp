@@ -72,6 +72,14 @@ class LibraryModelTest : public ::testing::Test {
     return AddSong(song);
   }
 
+  QModelIndex FindChild(const QModelIndex& parent, const QString& text) {
+    for (int i = 0; i < model_->rowCount(parent); ++i) {
+      QModelIndex index = model_->index(i, 0, parent);
+      if (index.data().toString() == text) return index;
+    }
+    return QModelIndex();
+  }
+
   std::shared_ptr<Database> database_;
   std::unique_ptr<LibraryBackend> backend_;
   std::unique_ptr<LibraryModel> model_;
@@ -304,4 +312,64 @@ TEST_F(LibraryModelTest, RemoveEmptyArtists) {
   ASSERT_EQ(0, model_->rowCount(QModelIndex()));
 }
 
+TEST_F(LibraryModelTest, FilterUpdatesExpandedContainers) {
+  AddSong("Foo", "Artist A", "Album 1", 123);
+  AddSong("Bar", "Artist A", "Album 1", 123);
+  AddSong("Foo 2", "Artist A", "Album 2", 123);
+  AddSong("Baz", "Artist B", "Album 3", 123);
+  model_->Init(false);
+
+  QModelIndex artist_index = FindChild(QModelIndex(), "Artist A");
+  model_->fetchMore(artist_index);
+  ASSERT_EQ(2, model_->rowCount(artist_index));
+  QModelIndex album_index = FindChild(artist_index, "Album 1");
+  model_->fetchMore(album_index);
+  ASSERT_EQ(2, model_->rowCount(album_index));
+
+  QSignalSpy spy_reset(model_.get(), SIGNAL(modelReset()));
+  model_->SetFilterText("Foo", false);
+  EXPECT_EQ(0, spy_reset.count());
+
+  // The tree is updated in place, so the indexes still point at the same items
+  EXPECT_FALSE(FindChild(QModelIndex(), "Artist B").isValid());
+  ASSERT_EQ(artist_index, FindChild(QModelIndex(), "Artist A"));
+  ASSERT_EQ(album_index, FindChild(artist_index, "Album 1"));
+  EXPECT_TRUE(FindChild(artist_index, "Album 2").isValid());
+
+  ASSERT_EQ(1, model_->rowCount(album_index));
+  EXPECT_EQ("Foo", model_->index(0, 0, album_index).data().toString());
+
+  // Clearing the filter brings everything back
+  model_->SetFilterText("", false);
+  EXPECT_EQ(0, spy_reset.count());
+
+  EXPECT_TRUE(FindChild(QModelIndex(), "Artist B").isValid());
+  ASSERT_EQ(album_index, FindChild(artist_index, "Album 1"));
+  EXPECT_EQ(2, model_->rowCount(album_index));
+  EXPECT_TRUE(FindChild(album_index, "Bar").isValid());
+}
+
+TEST_F(LibraryModelTest, FilterDoesNotLoadCollapsedContainers) {
+  AddSong("Foo", "Artist A", "Album 1", 123);
+  AddSong("Bar", "Artist A", "Album 2", 123);
+  model_->Init(false);
+
+  QModelIndex artist_index = FindChild(QModelIndex(), "Artist A");
+  model_->fetchMore(artist_index);
+  ASSERT_EQ(2, model_->rowCount(artist_index));
+
+  model_->SetFilterText("Foo", false);
+
+  // Album 2 doesn't match any more, and Album 1 still hasn't been expanded so
+  // it's only loaded when it is.
+  ASSERT_EQ(1, model_->rowCount(artist_index));
+  QModelIndex album_index = FindChild(artist_index, "Album 1");
+  ASSERT_TRUE(album_index.isValid());
+  EXPECT_TRUE(model_->canFetchMore(album_index));
+
+  model_->fetchMore(album_index);
+  ASSERT_EQ(1, model_->rowCount(album_index));
+  EXPECT_EQ("Foo", model_->index(0, 0, album_index).data().toString());
+}
+
 } // namespace
@@ -0,0 +1,222 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gtest/gtest.h"
+
+#include <string.h>
+
+#include <memory>
+
+#include <QCoreApplication>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QTime>
+
+#include "core/messagehandler.h"
+#include "core/sharedmemorysegment.h"
+#include "tagreadermessages.pb.h"
+
+namespace {
+
+class TestMessageHandler
+    : public AbstractMessageHandler<pb::tagreader::Message> {
+ public:
+  explicit TestMessageHandler(QIODevice* device)
+      : AbstractMessageHandler<pb::tagreader::Message>(device, nullptr) {}
+
+  QList<pb::tagreader::Message> messages_;
+
+ protected:
+  void MessageArrived(const pb::tagreader::Message& message) {
+    messages_ << message;
+  }
+};
+
+class MessageHandlerTest : public ::testing::Test {
+ protected:
+  static const int kThreshold = 1024;
+
+  void SetUp() {
+    const QString name =
+        QString("clementine-messagehandler-test-%1")
+            .arg(QCoreApplication::applicationPid());
+    QLocalServer::removeServer(name);
+    ASSERT_TRUE(server_.listen(name));
+
+    client_socket_.connectToServer(name);
+    ASSERT_TRUE(server_.waitForNewConnection(5000));
+    server_socket_ = server_.nextPendingConnection();
+    ASSERT_TRUE(server_socket_);
+
+    sender_.reset(new TestMessageHandler(server_socket_));
+    sender_->SetSharedMemoryThreshold(kThreshold);
+    receiver_.reset(new TestMessageHandler(&client_socket_));
+  }
+
+  void TearDown() {
+    sender_.reset();
+    receiver_.reset();
+    server_.close();
+  }
+
+  // Processes events until condition returns true or it times out.
+  template <typename F>
+  bool WaitFor(F condition) {
+    QTime timer;
+    timer.start();
+    while (!condition()) {
+      if (timer.elapsed() > 5000) return false;
+      QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 100);
+    }
+    return true;
+  }
+
+  bool WaitForMessages(int count) {
+    return WaitFor([this, count]() {
+      return receiver_->messages_.count() >= count;
+    });
+  }
+
+  static pb::tagreader::Message ArtMessage(int id, int size) {
+    pb::tagreader::Message message;
+    message.set_id(id);
+    message.mutable_load_embedded_art_response()->set_data(
+        std::string(size, char('a' + id % 26)));
+    return message;
+  }
+
+  QLocalServer server_;
+  QLocalSocket client_socket_;
+  QLocalSocket* server_socket_;
+
+  std::unique_ptr<TestMessageHandler> sender_;
+  std::unique_ptr<TestMessageHandler> receiver_;
+};
+
+TEST_F(MessageHandlerTest, SmallMessageUsesSocket) {
+  const pb::tagreader::Message message = ArtMessage(1, 10);
+  sender_->SendMessage(message);
+
+  ASSERT_TRUE(WaitForMessages(1));
+  EXPECT_EQ(message.SerializeAsString(),
+            receiver_->messages_[0].SerializeAsString());
+  EXPECT_EQ(0, sender_->shared_memory_in_use());
+
+  const _MessageHandlerBase::Metrics metrics =
+      receiver_->metrics()["load_embedded_art_response"];
+  EXPECT_EQ(1, metrics.messages_);
+  EXPECT_EQ(0, metrics.shared_memory_messages_);
+  EXPECT_EQ(message.ByteSize(), metrics.bytes_);
+}
+
+TEST_F(MessageHandlerTest, LargeMessageUsesSharedMemory) {
+  const pb::tagreader::Message message = ArtMessage(2, 64 * 1024);
+  sender_->SendMessage(message);
+  EXPECT_EQ(1, sender_->shared_memory_in_use());
+
+  ASSERT_TRUE(WaitForMessages(1));
+  EXPECT_EQ(message.SerializeAsString(),
+            receiver_->messages_[0].SerializeAsString());
+
+  const _MessageHandlerBase::Metrics metrics =
+      receiver_->metrics()["load_embedded_art_response"];
+  EXPECT_EQ(1, metrics.messages_);
+  EXPECT_EQ(1, metrics.shared_memory_messages_);
+
+  // The receiver tells the sender it can free the segment.
+  EXPECT_TRUE(WaitFor([this]() { return !sender_->shared_memory_in_use(); }));
+}
+
+TEST_F(MessageHandlerTest, MessagesArriveInOrder) {
+  sender_->SendMessage(ArtMessage(1, 10));
+  sender_->SendMessage(ArtMessage(2, 2 * kThreshold));
+  sender_->SendMessage(ArtMessage(3, 10));
+
+  ASSERT_TRUE(WaitForMessages(3));
+  EXPECT_EQ(1, receiver_->messages_[0].id());
+  EXPECT_EQ(2, receiver_->messages_[1].id());
+  EXPECT_EQ(2 * kThreshold,
+            receiver_->messages_[1].load_embedded_art_response().data().size());
+  EXPECT_EQ(3, receiver_->messages_[2].id());
+}
+
+TEST_F(MessageHandlerTest, SharedMemoryFreedWhenConnectionCloses) {
+  sender_->SendMessage(ArtMessage(1, 2 * kThreshold));
+  EXPECT_EQ(1, sender_->shared_memory_in_use());
+
+  // The receiver goes away without reading the message.
+  receiver_.reset();
+  client_socket_.abort();
+
+  EXPECT_TRUE(WaitFor([this]() { return sender_->is_device_closed(); }));
+  EXPECT_EQ(0, sender_->shared_memory_in_use());
+}
+
+TEST_F(MessageHandlerTest, MetricsNamedAfterMessageType) {
+  pb::tagreader::Message empty;
+  empty.set_id(1);
+  sender_->SendMessage(empty);
+
+  pb::tagreader::Message request;
+  request.set_id(2);
+  request.mutable_read_file_request()->set_filename("foo.mp3");
+  sender_->SendMessage(request);
+
+  ASSERT_TRUE(WaitForMessages(2));
+
+  const _MessageHandlerBase::MetricsMap metrics = sender_->metrics();
+  EXPECT_EQ(2, metrics.count());
+  EXPECT_EQ(1, metrics["Message"].messages_);
+  EXPECT_EQ(1, metrics["read_file_request"].messages_);
+}
+
+#ifndef Q_OS_WIN32
+TEST(SharedMemorySegmentTest, NameRemovedWhenOpened) {
+  const QString name =
+      QString("/clem-test-%1").arg(QCoreApplication::applicationPid());
+
+  SharedMemorySegment writer;
+  ASSERT_TRUE(writer.Create(name, 100));
+  memset(writer.data(), 'x', 100);
+
+  SharedMemorySegment reader;
+  ASSERT_TRUE(reader.Open(name));
+  EXPECT_EQ(100, reader.size());
+  EXPECT_EQ('x', static_cast<const char*>(reader.constData())[99]);
+
+  // Nothing else can open it now, but the memory is still shared.
+  SharedMemorySegment other;
+  EXPECT_FALSE(other.Open(name));
+
+  static_cast<char*>(writer.data())[0] = 'y';
+  EXPECT_EQ('y', static_cast<const char*>(reader.constData())[0]);
+}
+
+TEST(SharedMemorySegmentTest, UnlinkRemovesName) {
+  const QString name =
+      QString("/clem-test-%1").arg(QCoreApplication::applicationPid());
+
+  SharedMemorySegment writer;
+  ASSERT_TRUE(writer.Create(name, 100));
+  writer.Unlink();
+
+  SharedMemorySegment reader;
+  EXPECT_FALSE(reader.Open(name));
+}
+#endif  // Q_OS_WIN32
+
+}  // namespace
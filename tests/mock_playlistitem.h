@@ -20,7 +20,7 @@
 
 #include "core/song.h"
 #include "core/settingsprovider.h"
-#include "library/sqlrow.h"
+#include "core/sqlitequery.h"
 #include "playlist/playlistitem.h"
 
 #include <gmock/gmock.h>
@@ -32,7 +32,7 @@ class MockPlaylistItem : public PlaylistItem {
   MOCK_CONST_METHOD0(options,
       Options());
   MOCK_METHOD1(InitFromQuery,
-      bool(const SqlRow& settings));
+      bool(const SqliteQuery& query));
   MOCK_METHOD0(Reload,
       void());
   MOCK_CONST_METHOD0(Metadata,
@@ -0,0 +1,71 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gtest/gtest.h"
+
+#include "globalsearch/ngramindex.h"
+
+namespace {
+
+class NGramIndexTest : public ::testing::Test {
+ protected:
+  void SetUp() {
+    index_.Add(0, "Groove Salad");
+    index_.Add(1, "Drone Zone");
+    index_.Add(1, "ambient");
+    index_.Add(2, "Secret Agent");
+    index_.Add(3, "Lush");
+  }
+
+  QVector<int> Candidates(const QStringList& tokens) {
+    QVector<int> ret;
+    EXPECT_TRUE(index_.Candidates(tokens, &ret));
+    return ret;
+  }
+
+  NGramIndex index_;
+};
+
+TEST_F(NGramIndexTest, FindsDocuments) {
+  EXPECT_EQ(QVector<int>() << 0, Candidates(QStringList() << "groove"));
+  EXPECT_EQ(QVector<int>() << 1, Candidates(QStringList() << "ZONE"));
+  EXPECT_EQ(QVector<int>() << 1, Candidates(QStringList() << "bien"));
+  EXPECT_EQ(QVector<int>() << 3, Candidates(QStringList() << "lush"));
+}
+
+TEST_F(NGramIndexTest, MatchesAllTokens) {
+  EXPECT_EQ(QVector<int>() << 1,
+            Candidates(QStringList() << "drone" << "ambient"));
+  EXPECT_EQ(QVector<int>() << 1 << 2, Candidates(QStringList() << "ent"));
+  EXPECT_TRUE(Candidates(QStringList() << "groove" << "drone").isEmpty());
+  EXPECT_TRUE(Candidates(QStringList() << "nothing").isEmpty());
+}
+
+TEST_F(NGramIndexTest, ShortTokens) {
+  QVector<int> candidates;
+  EXPECT_FALSE(index_.Candidates(QStringList() << "gr" << "", &candidates));
+
+  // Short tokens are ignored if there are longer ones.
+  EXPECT_EQ(QVector<int>() << 2, Candidates(QStringList() << "x" << "secret"));
+}
+
+TEST_F(NGramIndexTest, Clear) {
+  index_.Clear();
+  EXPECT_TRUE(Candidates(QStringList() << "groove").isEmpty());
+}
+
+}  // namespace
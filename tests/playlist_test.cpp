@@ -15,16 +15,24 @@
    along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
 #include <memory>
 
 #include "test_utils.h"
 #include "gtest/gtest.h"
 
+#include "core/database.h"
 #include "library/libraryplaylistitem.h"
 #include "playlist/playlist.h"
+#include "playlist/playlistbackend.h"
+#include "playlist/playlistundocommands.h"
+#include "playlist/songplaylistitem.h"
 #include "mock_settingsprovider.h"
 #include "mock_playlistitem.h"
 
+#include <QCoreApplication>
+#include <QSqlQuery>
+#include <QStringList>
 #include <QtDebug>
 #include <QUndoStack>
 
@@ -502,4 +510,176 @@ TEST_F(PlaylistTest, LibraryIdMapMulti) {
 }
 
 
+// Saves playlists to a database and loads them again.
+class PlaylistSaveTest : public ::testing::Test {
+ protected:
+  void SetUp() {
+    database_.reset(new MemoryDatabase(nullptr));
+    backend_.reset(new PlaylistBackend(database_.get()));
+    id_ = backend_->CreatePlaylist("Test", QString());
+  }
+
+  static PlaylistItemPtr MakeItem(const QString& title) {
+    Song song;
+    song.Init(title, "Artist", "Album", 123);
+    song.set_url(QUrl("http://example.com/" + title));
+    song.set_filetype(Song::Type_Stream);
+    return PlaylistItemPtr(new SongPlaylistItem(song));
+  }
+
+  static PlaylistItemList MakeItems(const QStringList& titles) {
+    PlaylistItemList ret;
+    for (const QString& title : titles) ret << MakeItem(title);
+    return ret;
+  }
+
+  static QStringList Titles(const Playlist& playlist) {
+    QStringList ret;
+    for (int i = 0; i < playlist.rowCount(); ++i) {
+      ret << playlist.item_at(i)->Metadata().title();
+    }
+    return ret;
+  }
+
+  // Saves are queued on the backend, so this runs them.
+  void FlushSaves() {
+    QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+  }
+
+  // Loads the playlist from the database into a new Playlist.
+  QStringList SavedTitles() {
+    FlushSaves();
+    Playlist playlist(backend_.get(), nullptr, nullptr, id_);
+    playlist.RestoreNow();
+    return Titles(playlist);
+  }
+
+  std::unique_ptr<Database> database_;
+  std::unique_ptr<PlaylistBackend> backend_;
+  int id_;
+};
+
+TEST_F(PlaylistSaveTest, InsertIntoPlaylistThatWasNeverLoaded) {
+  backend_->SavePlaylist(id_, MakeItems(QStringList() << "One" << "Two"), -1,
+                         smart_playlists::GeneratorPtr());
+
+  Playlist playlist(backend_.get(), nullptr, nullptr, id_);
+  ASSERT_FALSE(playlist.is_restored());
+
+  // Like adding to a tab that hasn't been opened yet.
+  playlist.InsertItems(PlaylistItemList() << MakeItem("Three"));
+  EXPECT_TRUE(playlist.is_restored());
+  EXPECT_EQ(QStringList() << "One" << "Two" << "Three", Titles(playlist));
+
+  EXPECT_EQ(QStringList() << "One" << "Two" << "Three", SavedTitles());
+}
+
+TEST_F(PlaylistSaveTest, RemoveFromPlaylistThatWasNeverLoaded) {
+  backend_->SavePlaylist(id_,
+                         MakeItems(QStringList() << "One" << "Two" << "Three"),
+                         -1, smart_playlists::GeneratorPtr());
+
+  Playlist playlist(backend_.get(), nullptr, nullptr, id_);
+  playlist.RemoveItemsWithoutUndo(QList<int>() << 1);
+  EXPECT_EQ(QStringList() << "One" << "Three", Titles(playlist));
+
+  EXPECT_EQ(QStringList() << "One" << "Three", SavedTitles());
+}
+
+class PlaylistDeltaTest : public PlaylistSaveTest {
+ protected:
+  void SetUp() {
+    PlaylistSaveTest::SetUp();
+    backend_->SavePlaylist(
+        id_, MakeItems(QStringList() << "One" << "Two" << "Three" << "Four"),
+        -1, smart_playlists::GeneratorPtr());
+
+    playlist_.reset(new Playlist(backend_.get(), nullptr, nullptr, id_));
+    playlist_->RestoreNow();
+  }
+
+  int SavedRowCount() {
+    FlushSaves();
+    QSqlDatabase db(database_->Connect());
+    QSqlQuery q(db);
+    q.prepare("SELECT COUNT(*) FROM playlist_items WHERE playlist = :id");
+    q.bindValue(":id", id_);
+    if (!q.exec() || !q.next()) return -1;
+    return q.value(0).toInt();
+  }
+
+  // Checks that what was saved matches the playlist, and that no rows were
+  // left behind.
+  void ExpectSaved() {
+    EXPECT_EQ(Titles(*playlist_), SavedTitles());
+    EXPECT_EQ(playlist_->rowCount(), SavedRowCount());
+  }
+
+  void Push(QUndoCommand* command) {
+    playlist_->undo_stack()->push(command);
+  }
+
+  std::unique_ptr<Playlist> playlist_;
+};
+
+TEST_F(PlaylistDeltaTest, Insert) {
+  playlist_->InsertItems(PlaylistItemList() << MakeItem("Five"), 1);
+  EXPECT_EQ(QStringList() << "One" << "Five" << "Two" << "Three" << "Four",
+            Titles(*playlist_));
+  ExpectSaved();
+
+  playlist_->InsertItems(PlaylistItemList() << MakeItem("Six"));
+  playlist_->InsertItems(PlaylistItemList() << MakeItem("Seven"), 0);
+  ExpectSaved();
+}
+
+TEST_F(PlaylistDeltaTest, Remove) {
+  playlist_->RemoveItemsWithoutUndo(QList<int>() << 0 << 2);
+  EXPECT_EQ(QStringList() << "Two" << "Four", Titles(*playlist_));
+  ExpectSaved();
+
+  // Undoing a remove puts the item back in its old place.
+  Push(new PlaylistUndoCommands::RemoveItems(playlist_.get(), 1, 1));
+  playlist_->undo_stack()->undo();
+  ExpectSaved();
+}
+
+TEST_F(PlaylistDeltaTest, Move) {
+  const QStringList before = Titles(*playlist_);
+
+  Push(new PlaylistUndoCommands::MoveItems(playlist_.get(),
+                                           QList<int>() << 0 << 1, 3));
+  EXPECT_NE(before, Titles(*playlist_));
+  ExpectSaved();
+
+  playlist_->undo_stack()->undo();
+  EXPECT_EQ(before, Titles(*playlist_));
+  ExpectSaved();
+}
+
+TEST_F(PlaylistDeltaTest, ReOrder) {
+  PlaylistItemList items = playlist_->GetAllItems();
+  std::reverse(items.begin(), items.end());
+
+  Push(new PlaylistUndoCommands::ReOrderItems(playlist_.get(), items));
+  EXPECT_EQ(QStringList() << "Four" << "Three" << "Two" << "One",
+            Titles(*playlist_));
+  ExpectSaved();
+}
+
+TEST_F(PlaylistDeltaTest, FullSaveAfterDelta) {
+  // Inserting in the same place over and over runs out of room between the
+  // positions, so the whole playlist is renumbered and written again.  The
+  // inserts before and after that are saved as deltas.
+  for (int i = 0; i < 30; ++i) {
+    playlist_->InsertItems(PlaylistItemList() << MakeItem(QString::number(i)),
+                           1);
+  }
+  EXPECT_EQ(34, playlist_->rowCount());
+  ExpectSaved();
+
+  playlist_->RemoveItemsWithoutUndo(QList<int>() << 2);
+  ExpectSaved();
+}
+
 } // namespace
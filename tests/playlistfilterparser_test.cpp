@@ -0,0 +1,108 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gtest/gtest.h"
+
+#include <memory>
+
+#include "core/song.h"
+#include "core/timeconstants.h"
+#include "playlist/playlist.h"
+#include "playlist/playlistfilterparser.h"
+
+namespace {
+
+class PlaylistFilterParserTest : public ::testing::Test {
+ protected:
+  void SetUp() {
+    columns_["title"] = Playlist::Column_Title;
+    columns_["artist"] = Playlist::Column_Artist;
+    columns_["album"] = Playlist::Column_Album;
+    columns_["length"] = Playlist::Column_Length;
+    columns_["year"] = Playlist::Column_Year;
+    columns_["rating"] = Playlist::Column_Rating;
+
+    numerical_columns_ << Playlist::Column_Length << Playlist::Column_Year
+                       << Playlist::Column_Rating;
+
+    song_.Init("Some Title", "Some Artist", "An Album", 225 * kNsecPerSec);
+    song_.set_year(1999);
+    song_.set_rating(0.8);
+  }
+
+  bool Accepts(const QString& filter) {
+    FilterParser parser(filter, columns_, numerical_columns_);
+    std::unique_ptr<FilterTree> tree(parser.parse());
+    return tree->accept(FilterRow(song_, columns_.values()));
+  }
+
+  QMap<QString, int> columns_;
+  QSet<int> numerical_columns_;
+  Song song_;
+};
+
+TEST_F(PlaylistFilterParserTest, RowColumns) {
+  FilterRow row(song_, columns_.values());
+  EXPECT_TRUE(row.is_valid());
+  EXPECT_EQ("some title", row.column(Playlist::Column_Title).toString());
+  EXPECT_EQ("some artist", row.column(Playlist::Column_Artist).toString());
+  EXPECT_EQ("1999", row.column(Playlist::Column_Year).toString());
+  EXPECT_TRUE(row.column(Playlist::Column_Genre).isEmpty());
+  EXPECT_FALSE(FilterRow().is_valid());
+}
+
+TEST_F(PlaylistFilterParserTest, Terms) {
+  EXPECT_TRUE(Accepts(""));
+  EXPECT_TRUE(Accepts("title"));
+  EXPECT_TRUE(Accepts("some ALBUM"));
+  EXPECT_FALSE(Accepts("other"));
+  EXPECT_TRUE(Accepts("title artist"));
+  EXPECT_FALSE(Accepts("\"title some\""));  // Doesn't match across columns
+  EXPECT_TRUE(Accepts("other OR album"));
+  EXPECT_TRUE(Accepts("-other"));
+  EXPECT_FALSE(Accepts("-album"));
+}
+
+TEST_F(PlaylistFilterParserTest, ColumnTerms) {
+  EXPECT_TRUE(Accepts("artist:some"));
+  EXPECT_FALSE(Accepts("album:some"));
+  EXPECT_TRUE(Accepts("artist:=\"some artist\""));
+  EXPECT_TRUE(Accepts("artist:>r"));
+  EXPECT_FALSE(Accepts("artist:<r"));
+  EXPECT_TRUE(Accepts("year:>1990"));
+  EXPECT_FALSE(Accepts("year:<=1990"));
+  EXPECT_TRUE(Accepts("length:3:45"));
+  EXPECT_TRUE(Accepts("length:<4:00"));
+  EXPECT_TRUE(Accepts("rating:>=4"));
+  EXPECT_FALSE(Accepts("rating:5"));
+}
+
+TEST_F(PlaylistFilterParserTest, Narrowing) {
+  EXPECT_TRUE(FilterParser::IsNarrowing("foo", "foob"));
+  EXPECT_TRUE(FilterParser::IsNarrowing("foo", "foo bar"));
+  EXPECT_TRUE(FilterParser::IsNarrowing("foo ", "foo b"));
+
+  EXPECT_FALSE(FilterParser::IsNarrowing("", "foo"));
+  EXPECT_FALSE(FilterParser::IsNarrowing("foob", "foo"));
+  EXPECT_FALSE(FilterParser::IsNarrowing("foo", "bar"));
+  EXPECT_FALSE(FilterParser::IsNarrowing("foo", "foo OR bar"));
+  EXPECT_FALSE(FilterParser::IsNarrowing("foo", "foo -bar"));
+  EXPECT_FALSE(FilterParser::IsNarrowing("artist", "artist:foo"));
+  EXPECT_FALSE(FilterParser::IsNarrowing("-foo", "-foob"));
+}
+
+}  // namespace
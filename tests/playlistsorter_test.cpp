@@ -0,0 +1,145 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gtest/gtest.h"
+
+#include <functional>
+
+#include <QTime>
+#include <QtDebug>
+
+#include "core/song.h"
+#include "core/timeconstants.h"
+#include "playlist/playlist.h"
+#include "playlist/playlistsorter.h"
+#include "playlist/songplaylistitem.h"
+
+using std::placeholders::_1;
+using std::placeholders::_2;
+
+namespace {
+
+// A playlist of songs by a few artists, with lots of equal values so the
+// stability of the sort matters.
+PlaylistItemList MakeItems(int count) {
+  static const char* kArtists[] = {"Zebra", "abba", "Émile", "beatles",
+                                   "Ñandú", "ABBA"};
+  PlaylistItemList ret;
+  unsigned int seed = 1;
+  for (int i = 0; i < count; ++i) {
+    seed = seed * 1103515245 + 12345;
+    const int n = (seed >> 16) & 0x7fff;
+
+    Song song;
+    song.Init(QString("Title %1").arg(i),
+              QString::fromUtf8(kArtists[n % 6]),
+              QString("Album %1").arg(n % 97), (n % 300) * kNsecPerSec);
+    song.set_disc(n % 3);
+    song.set_track(n % 13);
+    song.set_year(1960 + n % 50);
+    ret << PlaylistItemPtr(new SongPlaylistItem(song));
+  }
+  return ret;
+}
+
+// Sorts the items the old way, with repeated qStableSorts using
+// Playlist::CompareItems.
+PlaylistItemList CompareItemsSort(PlaylistItemList items, int column,
+                                  Qt::SortOrder order) {
+  QList<int> columns;
+  if (column == Playlist::Column_Album) {
+    columns << Playlist::Column_Track << Playlist::Column_Disc;
+  }
+  columns << column;
+
+  for (int c : columns) {
+    qStableSort(items.begin(), items.end(),
+                std::bind(&Playlist::CompareItems, c, order, _1, _2));
+  }
+  return items;
+}
+
+PlaylistItemList SorterSort(PlaylistItemList items, int column,
+                            Qt::SortOrder order) {
+  QList<int> columns;
+  columns << column;
+  if (column == Playlist::Column_Album) {
+    columns << Playlist::Column_Disc << Playlist::Column_Track;
+  }
+  PlaylistSorter(columns, order).Sort(items.begin(), items.end());
+  return items;
+}
+
+void ExpectSameOrder(const PlaylistItemList& expected,
+                     const PlaylistItemList& actual) {
+  ASSERT_EQ(expected.count(), actual.count());
+  for (int i = 0; i < expected.count(); ++i) {
+    ASSERT_EQ(expected[i].get(), actual[i].get()) << "at index " << i;
+  }
+}
+
+TEST(PlaylistSorterTest, MatchesCompareItems) {
+  const int kColumns[] = {Playlist::Column_Title, Playlist::Column_Artist,
+                          Playlist::Column_Album, Playlist::Column_Length,
+                          Playlist::Column_Year};
+  // Big enough to be sorted on several threads
+  const PlaylistItemList items = MakeItems(20000);
+
+  for (int column : kColumns) {
+    SCOPED_TRACE(Playlist::column_name(Playlist::Column(column)).toStdString());
+    ExpectSameOrder(CompareItemsSort(items, column, Qt::AscendingOrder),
+                    SorterSort(items, column, Qt::AscendingOrder));
+    ExpectSameOrder(CompareItemsSort(items, column, Qt::DescendingOrder),
+                    SorterSort(items, column, Qt::DescendingOrder));
+  }
+}
+
+TEST(PlaylistSorterTest, SortsPartOfList) {
+  const PlaylistItemList items = MakeItems(100);
+  PlaylistItemList actual = items;
+  PlaylistSorter(QList<int>() << Playlist::Column_Artist, Qt::AscendingOrder)
+      .Sort(actual.begin() + 50, actual.end());
+
+  for (int i = 0; i < 50; ++i) {
+    EXPECT_EQ(items[i].get(), actual[i].get());
+  }
+  ExpectSameOrder(
+      CompareItemsSort(items.mid(50), Playlist::Column_Artist,
+                       Qt::AscendingOrder),
+      actual.mid(50));
+}
+
+// Times sorting a large playlist.  Run with --gtest_also_run_disabled_tests.
+TEST(PlaylistSorterTest, DISABLED_Benchmark) {
+  const PlaylistItemList items = MakeItems(100000);
+  const int kColumns[] = {Playlist::Column_Artist, Playlist::Column_Album};
+
+  for (int column : kColumns) {
+    const QString name = Playlist::column_name(Playlist::Column(column));
+
+    QTime t;
+    t.start();
+    CompareItemsSort(items, column, Qt::AscendingOrder);
+    qDebug() << "CompareItems by" << name << ":" << t.elapsed() << "ms";
+
+    t.restart();
+    SorterSort(items, column, Qt::AscendingOrder);
+    qDebug() << "PlaylistSorter by" << name << ":" << t.elapsed() << "ms";
+  }
+}
+
+}  // namespace
@@ -0,0 +1,101 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gtest/gtest.h"
+
+#include <QFuture>
+#include <QtConcurrentRun>
+
+#include "core/ringbuffer.h"
+
+namespace {
+
+TEST(RingBufferTest, CapacityIsPowerOfTwo) {
+  EXPECT_EQ(8, RingBuffer<int>(5).capacity());
+  EXPECT_EQ(8, RingBuffer<int>(8).capacity());
+  EXPECT_EQ(1024, RingBuffer<int>(1000).capacity());
+}
+
+TEST(RingBufferTest, ReadsWhatWasWritten) {
+  RingBuffer<int> buffer(8);
+  const int data[] = {1, 2, 3, 4, 5};
+  EXPECT_TRUE(buffer.Write(data, 5));
+  EXPECT_EQ(5, buffer.Available());
+
+  int out[8] = {};
+  EXPECT_EQ(3, buffer.Read(out, 3));
+  EXPECT_EQ(1, out[0]);
+  EXPECT_EQ(3, out[2]);
+  EXPECT_EQ(2, buffer.Available());
+
+  EXPECT_EQ(2, buffer.Read(out, 8));
+  EXPECT_EQ(4, out[0]);
+  EXPECT_EQ(5, out[1]);
+  EXPECT_EQ(0, buffer.Available());
+}
+
+TEST(RingBufferTest, WrapsAround) {
+  RingBuffer<int> buffer(8);
+  const int data[] = {1, 2, 3, 4, 5, 6};
+  EXPECT_TRUE(buffer.Write(data, 6));
+  EXPECT_EQ(4, buffer.Skip(4));
+  EXPECT_TRUE(buffer.Write(data, 6));
+
+  int out[8] = {};
+  EXPECT_EQ(8, buffer.Read(out, 8));
+  EXPECT_EQ(5, out[0]);
+  EXPECT_EQ(6, out[1]);
+  for (int i = 0; i < 6; ++i) {
+    EXPECT_EQ(data[i], out[i + 2]);
+  }
+}
+
+TEST(RingBufferTest, DoesntOverwrite) {
+  RingBuffer<int> buffer(4);
+  const int data[] = {1, 2, 3};
+  EXPECT_TRUE(buffer.Write(data, 3));
+  EXPECT_FALSE(buffer.Write(data, 2));
+  EXPECT_EQ(3, buffer.Available());
+
+  buffer.Clear();
+  EXPECT_EQ(0, buffer.Available());
+  EXPECT_TRUE(buffer.Write(data, 3));
+}
+
+void WriteSequence(RingBuffer<int>* buffer, int count) {
+  for (int i = 0; i < count;) {
+    if (buffer->Write(&i, 1)) ++i;
+  }
+}
+
+TEST(RingBufferTest, SeparateThreads) {
+  const int kCount = 100000;
+  RingBuffer<int> buffer(64);
+  QFuture<void> writer = QtConcurrent::run(&WriteSequence, &buffer, kCount);
+
+  int next = 0;
+  while (next < kCount) {
+    int value;
+    if (buffer.Read(&value, 1)) {
+      ASSERT_EQ(next, value);
+      ++next;
+    }
+  }
+  writer.waitForFinished();
+}
+
+}  // namespace
@@ -0,0 +1,214 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test_utils.h"
+#include "gtest/gtest.h"
+
+#include "core/song.h"
+#include "core/sqlitequery.h"
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QTime>
+#include <QUrl>
+#include <QtDebug>
+
+namespace {
+
+class SqliteQueryTest : public ::testing::Test {
+ protected:
+  void SetUp() {
+    database_ = QSqlDatabase::addDatabase("QSQLITE");
+    database_.setDatabaseName(":memory:");
+    ASSERT_TRUE(database_.open());
+
+    database_.exec("CREATE TABLE songs (" + Song::kColumns.join(", ") + ")");
+  }
+
+  void TearDown() {
+    // Make sure Qt does not re-use the connection.
+    QString name = database_.connectionName();
+    database_ = QSqlDatabase();
+    QSqlDatabase::removeDatabase(name);
+  }
+
+  static Song MakeSong(int i) {
+    Song song;
+    song.Init(QString("Title %1").arg(i), QString("Artist %1").arg(i % 50),
+              QString("Album %1").arg(i % 200), 1000000000ll * (i % 300));
+    song.set_track(i % 20);
+    song.set_year(i % 2 ? 1990 + i % 30 : -1);
+    song.set_compilation(i % 7 == 0);
+    song.set_filetype(Song::Type_Mpeg);
+    song.set_playcount(i % 5);
+    song.set_rating(i % 3 ? 0.5 : -1);
+    song.set_url(QUrl::fromLocalFile(
+        QString::fromUtf8("/music/Artist %1/Ünïcödé %2.mp3")
+            .arg(i % 50)
+            .arg(i)));
+    return song;
+  }
+
+  void InsertSongs(int count) {
+    database_.transaction();
+    QSqlQuery q(database_);
+    q.prepare("INSERT INTO songs (" + Song::kColumnSpec + ") VALUES (" +
+              Song::kBindSpec + ")");
+    for (int i = 0; i < count; ++i) {
+      MakeSong(i).BindToQuery(&q);
+      q.exec();
+    }
+    database_.commit();
+  }
+
+  QString SelectSql() const {
+    return "SELECT ROWID, " + Song::kColumnSpec + " FROM songs ORDER BY ROWID";
+  }
+
+  QSqlDatabase database_;
+};
+
+TEST_F(SqliteQueryTest, ReadsColumns) {
+  database_.exec("CREATE TABLE foo (i INTEGER, d REAL, t TEXT)");
+  database_.exec("INSERT INTO foo VALUES (5000000000, 1.5, 'caf\xc3\xa9')");
+  database_.exec("INSERT INTO foo VALUES (NULL, NULL, NULL)");
+
+  SqliteQuery q("SELECT i, d, t FROM foo WHERE d = :d OR d IS NULL",
+                database_);
+  q.BindValue(":d", 1.5);
+  ASSERT_TRUE(q.Exec());
+
+  ASSERT_TRUE(q.Next());
+  EXPECT_FALSE(q.IsNull(0));
+  EXPECT_EQ(5000000000ll, q.Int64(0));
+  EXPECT_EQ(1.5, q.Double(1));
+  EXPECT_EQ(QString::fromUtf8("caf\xc3\xa9"), q.Text(2));
+  EXPECT_EQ(QByteArray("caf\xc3\xa9"), q.Utf8(2));
+
+  ASSERT_TRUE(q.Next());
+  EXPECT_TRUE(q.IsNull(0));
+  EXPECT_TRUE(q.IsNull(1));
+  EXPECT_TRUE(q.Text(2).isNull());
+
+  EXPECT_FALSE(q.Next());
+}
+
+TEST_F(SqliteQueryTest, BadSqlFails) {
+  SqliteQuery q("SELECT nothing FROM nowhere", database_);
+  EXPECT_FALSE(q.Exec());
+  EXPECT_FALSE(q.Next());
+}
+
+TEST_F(SqliteQueryTest, SongsMatchSqlRow) {
+  const int kCount = 100;
+  InsertSongs(kCount);
+
+  QSqlQuery expected_query(SelectSql(), database_);
+  ASSERT_TRUE(expected_query.exec());
+
+  SqliteQuery actual_query(SelectSql(), database_);
+  ASSERT_TRUE(actual_query.Exec());
+
+  for (int i = 0; i < kCount; ++i) {
+    SCOPED_TRACE(i);
+    ASSERT_TRUE(expected_query.next());
+    ASSERT_TRUE(actual_query.Next());
+
+    Song expected;
+    expected.InitFromQuery(expected_query, true);
+    Song actual;
+    actual.InitFromQuery(actual_query, true);
+
+    EXPECT_EQ(expected.id(), actual.id());
+    EXPECT_EQ(expected.title(), actual.title());
+    EXPECT_EQ(expected.artist(), actual.artist());
+    EXPECT_EQ(expected.album(), actual.album());
+    EXPECT_EQ(expected.track(), actual.track());
+    EXPECT_EQ(expected.year(), actual.year());
+    EXPECT_EQ(expected.compilation(), actual.compilation());
+    EXPECT_EQ(expected.filetype(), actual.filetype());
+    EXPECT_EQ(expected.playcount(), actual.playcount());
+    EXPECT_EQ(expected.rating(), actual.rating());
+    EXPECT_EQ(expected.beginning_nanosec(), actual.beginning_nanosec());
+    EXPECT_EQ(expected.length_nanosec(), actual.length_nanosec());
+    EXPECT_EQ(expected.url(), actual.url());
+    EXPECT_EQ(expected.basefilename(), actual.basefilename());
+    EXPECT_EQ(MakeSong(i).url(), actual.url());
+    EXPECT_EQ(QString::fromUtf8("Ünïcödé %1.mp3").arg(i),
+              actual.basefilename());
+  }
+  EXPECT_FALSE(actual_query.Next());
+}
+
+TEST_F(SqliteQueryTest, SetUrlBeforeDecoding) {
+  InsertSongs(1);
+
+  SqliteQuery q(SelectSql(), database_);
+  ASSERT_TRUE(q.Exec());
+  ASSERT_TRUE(q.Next());
+
+  Song song;
+  song.InitFromQuery(q, true);
+  Song copy(song);
+
+  // The copy keeps the url from the database.
+  song.set_url(QUrl("http://example.com/stream"));
+  EXPECT_EQ(QUrl("http://example.com/stream"), song.url());
+  EXPECT_EQ(QString::fromUtf8("Ünïcödé 0.mp3"), song.basefilename());
+  EXPECT_EQ(MakeSong(0).url(), copy.url());
+}
+
+// Compares SqliteQuery with QSqlQuery.  Run with
+// --gtest_also_run_disabled_tests.
+TEST_F(SqliteQueryTest, DISABLED_Benchmark) {
+  const int kCount = 20000;
+  InsertSongs(kCount);
+
+  QTime t;
+  t.start();
+  {
+    QSqlQuery q(SelectSql(), database_);
+    q.exec();
+    SongList songs;
+    while (q.next()) {
+      Song song;
+      song.InitFromQuery(q, true);
+      songs << song;
+    }
+    ASSERT_EQ(kCount, songs.count());
+  }
+  const int sqlrow_msecs = t.restart();
+
+  {
+    SqliteQuery q(SelectSql(), database_);
+    q.Exec();
+    SongList songs;
+    while (q.Next()) {
+      Song song;
+      song.InitFromQuery(q, true);
+      songs << song;
+    }
+    ASSERT_EQ(kCount, songs.count());
+  }
+  const int sqlite_msecs = t.elapsed();
+
+  qDebug() << "Loading" << kCount << "songs:" << sqlrow_msecs
+           << "ms with SqlRow," << sqlite_msecs << "ms with SqliteQuery";
+}
+
+}  // namespace
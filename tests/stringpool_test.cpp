@@ -0,0 +1,174 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gtest/gtest.h"
+
+#include <QFuture>
+#include <QList>
+#include <QtConcurrentRun>
+#include <QtDebug>
+
+#include "core/stringpool.h"
+
+namespace {
+
+TEST(StringPoolTest, EqualStringsShareData) {
+  StringPool pool;
+  const QString a = pool.Intern(QString("Artist"));
+  const QString b = pool.Intern(QString("Art") + QString("ist"));
+  const QString c = pool.Intern(QString("Album"));
+
+  EXPECT_EQ(QString("Artist"), b);
+  EXPECT_EQ(a.constData(), b.constData());
+  EXPECT_NE(a.constData(), c.constData());
+}
+
+TEST(StringPoolTest, EmptyStringsArentPooled) {
+  StringPool pool;
+  EXPECT_TRUE(pool.Intern(QString()).isNull());
+  EXPECT_TRUE(pool.Intern(QString("")).isEmpty());
+  EXPECT_EQ(0, pool.stats().strings_);
+}
+
+TEST(StringPoolTest, Stats) {
+  StringPool pool;
+  QList<QString> strings;
+  for (int i = 0; i < 10; ++i) {
+    strings << pool.Intern(QString("Artist %1").arg(i % 2));
+  }
+
+  const StringPool::Stats stats = pool.stats();
+  EXPECT_EQ(2, stats.strings_);
+  EXPECT_EQ(10, stats.lookups_);
+  EXPECT_EQ(10, stats.references_);
+  EXPECT_GT(stats.bytes_saved_, 8 * QString("Artist 0").size() * 2);
+}
+
+TEST(StringPoolTest, InterningPooledStringIsntCountedAsShared) {
+  StringPool pool;
+  const QString a = pool.Intern(QString("Artist"));
+  pool.Intern(a);
+
+  EXPECT_EQ(2, pool.stats().lookups_);
+  EXPECT_EQ(1, pool.stats().references_);
+  EXPECT_EQ(0, pool.stats().bytes_saved_);
+}
+
+TEST(StringPoolTest, ReleasedStringsArentCountedAsSaved) {
+  StringPool pool;
+  QList<QString> strings;
+  for (int i = 0; i < 10; ++i) {
+    strings << pool.Intern(QString("Artist"));
+  }
+  EXPECT_GT(pool.stats().bytes_saved_, 0);
+
+  strings.clear();
+  EXPECT_EQ(0, pool.stats().references_);
+  EXPECT_EQ(0, pool.stats().bytes_saved_);
+}
+
+TEST(StringPoolTest, ReloadingIsntCountedTwice) {
+  StringPool pool;
+  QList<QString> strings;
+  for (int i = 0; i < 10; ++i) {
+    strings << pool.Intern(QString("Artist"));
+  }
+  const StringPool::Stats before = pool.stats();
+
+  // Like loading the same songs again and throwing the old ones away.
+  QList<QString> reloaded;
+  for (int i = 0; i < 10; ++i) {
+    reloaded << pool.Intern(QString("Artist"));
+  }
+  strings = reloaded;
+  reloaded.clear();
+
+  const StringPool::Stats after = pool.stats();
+  EXPECT_EQ(20, after.lookups_);
+  EXPECT_EQ(before.references_, after.references_);
+  EXPECT_EQ(before.bytes_saved_, after.bytes_saved_);
+}
+
+TEST(StringPoolTest, OldStringsAreForgotten) {
+  StringPool pool(160);
+  for (int i = 0; i < 10000; ++i) {
+    pool.Intern(QString("Album %1").arg(i));
+  }
+
+  // At most two generations are kept.
+  EXPECT_LE(pool.stats().strings_, 2 * 160);
+}
+
+TEST(StringPoolTest, StringsInUseStayShared) {
+  StringPool pool(160);
+  const QString first = pool.Intern(QString("Artist"));
+
+  for (int i = 0; i < 10000; ++i) {
+    pool.Intern(QString("Album %1").arg(i));
+
+    if (i % 5 == 0) {
+      const QString again = pool.Intern(QString("Art") + QString("ist"));
+      ASSERT_EQ(first.constData(), again.constData());
+    }
+  }
+}
+
+QList<QString> InternMany(StringPool* pool, int count) {
+  QList<QString> ret;
+  for (int i = 0; i < count; ++i) {
+    ret << pool->Intern(QString("Genre %1").arg(i % 100));
+  }
+  return ret;
+}
+
+TEST(StringPoolTest, SeparateThreads) {
+  StringPool pool;
+  QFuture<QList<QString> > other =
+      QtConcurrent::run(&InternMany, &pool, 10000);
+  QList<QString> mine = InternMany(&pool, 10000);
+  QList<QString> theirs = other.result();
+
+  EXPECT_EQ(100, pool.stats().strings_);
+  for (int i = 0; i < mine.count(); ++i) {
+    ASSERT_EQ(mine[i].constData(), theirs[i].constData());
+  }
+}
+
+// Prints how much memory the pool saves.  Run with
+// --gtest_also_run_disabled_tests.
+TEST(StringPoolTest, DISABLED_MemoryReport) {
+  // Roughly the shape of a real library: 300k songs by 3000 artists on 25k
+  // albums in 200 genres.
+  const int kSongs = 300000;
+
+  StringPool pool;
+  QList<QString> fields;
+  for (int i = 0; i < kSongs; ++i) {
+    fields << pool.Intern(QString("Some Artist Name %1").arg(i % 3000))
+           << pool.Intern(QString("An Album Title %1").arg(i / 12))
+           << pool.Intern(QString("Genre %1").arg(i % 200));
+  }
+
+  const StringPool::Stats stats = pool.stats();
+  EXPECT_EQ(kSongs * 3, stats.lookups_);
+
+  qDebug() << kSongs << "songs:" << stats.strings_ << "strings in"
+           << stats.bytes_ << "bytes, saving" << stats.bytes_saved_
+           << "bytes in the strings still in use";
+}
+
+}  // namespace
@@ -0,0 +1,219 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gtest/gtest.h"
+
+#include <memory>
+
+#include <QFileInfo>
+#include <QTemporaryFile>
+
+#include "covers/thumbnailtilefile.h"
+
+namespace {
+
+class ThumbnailTileFileTest : public ::testing::Test {
+ protected:
+  static const int kTileSize = 4;
+
+  void SetUp() {
+    temp_file_.open();
+    filename_ = temp_file_.fileName();
+    Reopen(100);
+  }
+
+  void Reopen(int capacity, int tile_size = kTileSize) {
+    file_.reset();
+    file_.reset(new ThumbnailTileFile(filename_, tile_size, capacity));
+  }
+
+  static QImage Tile(QRgb color, int tile_size = kTileSize) {
+    QImage ret(tile_size, tile_size, QImage::Format_ARGB32);
+    ret.fill(color);
+    return ret;
+  }
+
+  bool Has(quint64 hash, qint64 stamp = 1) {
+    QImage image;
+    return file_->Find(hash, stamp, &image);
+  }
+
+  QTemporaryFile temp_file_;
+  QString filename_;
+  std::unique_ptr<ThumbnailTileFile> file_;
+};
+
+TEST_F(ThumbnailTileFileTest, StartsEmpty) {
+  EXPECT_TRUE(file_->is_valid());
+  EXPECT_EQ(0, file_->allocated_count());
+  EXPECT_EQ(0, file_->count());
+  EXPECT_FALSE(Has(1));
+
+  // Only the header and the entry table are written.
+  EXPECT_EQ(4096, QFileInfo(filename_).size());
+}
+
+TEST_F(ThumbnailTileFileTest, FindsInsertedTiles) {
+  file_->Insert(1, 10, Tile(qRgb(255, 0, 0)));
+  file_->Insert(2, 20, Tile(qRgb(0, 255, 0)));
+
+  QImage image;
+  ASSERT_TRUE(file_->Find(1, 10, &image));
+  EXPECT_EQ(kTileSize, image.width());
+  EXPECT_EQ(kTileSize, image.height());
+  EXPECT_EQ(qRgb(255, 0, 0), image.pixel(0, 0));
+
+  ASSERT_TRUE(file_->Find(2, 20, &image));
+  EXPECT_EQ(qRgb(0, 255, 0), image.pixel(kTileSize - 1, kTileSize - 1));
+
+  EXPECT_FALSE(Has(3));
+}
+
+TEST_F(ThumbnailTileFileTest, ReplacesExistingTile) {
+  file_->Insert(1, 10, Tile(qRgb(255, 0, 0)));
+  file_->Insert(1, 11, Tile(qRgb(0, 0, 255)));
+  EXPECT_EQ(1, file_->count());
+
+  QImage image;
+  ASSERT_TRUE(file_->Find(1, 11, &image));
+  EXPECT_EQ(qRgb(0, 0, 255), image.pixel(0, 0));
+}
+
+TEST_F(ThumbnailTileFileTest, DifferentStampRemovesTile) {
+  file_->Insert(1, 10, Tile(qRgb(255, 0, 0)));
+
+  EXPECT_FALSE(Has(1, 11));
+  EXPECT_FALSE(Has(1, 10));
+  EXPECT_EQ(0, file_->count());
+}
+
+TEST_F(ThumbnailTileFileTest, Remove) {
+  file_->Insert(1, 1, Tile(qRgb(255, 0, 0)));
+  file_->Insert(2, 1, Tile(qRgb(255, 0, 0)));
+  file_->Remove(1);
+
+  EXPECT_FALSE(Has(1));
+  EXPECT_TRUE(Has(2));
+  EXPECT_EQ(1, file_->count());
+}
+
+TEST_F(ThumbnailTileFileTest, GrowsOnDemand) {
+  file_->Insert(1, 1, Tile(qRgb(255, 0, 0)));
+  EXPECT_EQ(ThumbnailTileFile::kGrowTiles, file_->allocated_count());
+
+  for (int i = 2; i <= ThumbnailTileFile::kGrowTiles + 1; ++i) {
+    file_->Insert(i, 1, Tile(qRgb(255, 0, 0)));
+  }
+  EXPECT_EQ(100, file_->allocated_count());
+  EXPECT_EQ(ThumbnailTileFile::kGrowTiles + 1, file_->count());
+
+  // Tiles written before the file was remapped are still there.
+  EXPECT_TRUE(Has(1));
+  EXPECT_TRUE(Has(ThumbnailTileFile::kGrowTiles + 1));
+}
+
+TEST_F(ThumbnailTileFileTest, ReplacesLeastRecentlyUsedTile) {
+  Reopen(3);
+  file_->Insert(1, 1, Tile(qRgb(255, 0, 0)));
+  file_->Insert(2, 1, Tile(qRgb(255, 0, 0)));
+  file_->Insert(3, 1, Tile(qRgb(255, 0, 0)));
+  EXPECT_EQ(3, file_->allocated_count());
+
+  // Use 1 again so 2 is the oldest.
+  EXPECT_TRUE(Has(1));
+  file_->Insert(4, 1, Tile(qRgb(255, 0, 0)));
+
+  EXPECT_EQ(3, file_->count());
+  EXPECT_EQ(3, file_->allocated_count());
+  EXPECT_TRUE(Has(1));
+  EXPECT_FALSE(Has(2));
+  EXPECT_TRUE(Has(3));
+  EXPECT_TRUE(Has(4));
+}
+
+TEST_F(ThumbnailTileFileTest, KeepsTilesWhenReopened) {
+  file_->Insert(1, 10, Tile(qRgb(255, 0, 0)));
+  file_->Insert(2, 20, Tile(qRgb(0, 255, 0)));
+  Reopen(100);
+
+  EXPECT_TRUE(file_->is_valid());
+  EXPECT_EQ(2, file_->count());
+  EXPECT_EQ(ThumbnailTileFile::kGrowTiles, file_->allocated_count());
+
+  QImage image;
+  ASSERT_TRUE(file_->Find(2, 20, &image));
+  EXPECT_EQ(qRgb(0, 255, 0), image.pixel(0, 0));
+}
+
+TEST_F(ThumbnailTileFileTest, KeepsUsageOrderWhenReopened) {
+  Reopen(2);
+  file_->Insert(1, 1, Tile(qRgb(255, 0, 0)));
+  file_->Insert(2, 1, Tile(qRgb(255, 0, 0)));
+  EXPECT_TRUE(Has(1));
+
+  Reopen(2);
+  file_->Insert(3, 1, Tile(qRgb(255, 0, 0)));
+
+  EXPECT_TRUE(Has(1));
+  EXPECT_FALSE(Has(2));
+  EXPECT_TRUE(Has(3));
+}
+
+TEST_F(ThumbnailTileFileTest, DiscardsFileWithDifferentLayout) {
+  file_->Insert(1, 1, Tile(qRgb(255, 0, 0)));
+
+  Reopen(100, kTileSize * 2);
+  EXPECT_TRUE(file_->is_valid());
+  EXPECT_EQ(0, file_->count());
+  EXPECT_EQ(0, file_->allocated_count());
+
+  Reopen(50);
+  EXPECT_EQ(0, file_->count());
+  EXPECT_FALSE(Has(1));
+}
+
+TEST_F(ThumbnailTileFileTest, DiscardsTruncatedFile) {
+  file_->Insert(1, 1, Tile(qRgb(255, 0, 0)));
+  file_.reset();
+
+  QFile file(filename_);
+  ASSERT_TRUE(file.resize(file.size() - 1));
+
+  Reopen(100);
+  EXPECT_TRUE(file_->is_valid());
+  EXPECT_EQ(0, file_->count());
+  EXPECT_FALSE(Has(1));
+}
+
+TEST_F(ThumbnailTileFileTest, ClearShrinksFile) {
+  for (int i = 1; i <= 10; ++i) {
+    file_->Insert(i, 1, Tile(qRgb(255, 0, 0)));
+  }
+  file_->Clear();
+
+  EXPECT_TRUE(file_->is_valid());
+  EXPECT_EQ(0, file_->count());
+  EXPECT_EQ(0, file_->allocated_count());
+  EXPECT_FALSE(Has(1));
+  EXPECT_EQ(4096, QFileInfo(filename_).size());
+
+  // It can be used again afterwards.
+  file_->Insert(1, 1, Tile(qRgb(255, 0, 0)));
+  EXPECT_TRUE(Has(1));
+}
+
+}  // namespace
@@ -0,0 +1,121 @@
+/* This file is part of Clementine.
+   Copyright 2026, agent <agent@local>
+
+   Clementine is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Clementine is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Clementine.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gtest/gtest.h"
+
+#include <memory>
+
+#include "transcoder/transcoder.h"
+#include "transcoder/transcoderscheduler.h"
+
+namespace {
+
+class TranscoderSchedulerTest : public ::testing::Test {
+ protected:
+  void SetUp() {
+    scheduler_.reset(new TranscoderScheduler(nullptr));
+    a_.reset(new Transcoder);
+    b_.reset(new Transcoder);
+    c_.reset(new Transcoder);
+  }
+
+  void TearDown() {
+    a_.reset();
+    b_.reset();
+    c_.reset();
+    scheduler_.reset();
+  }
+
+  // Takes every slot for a_.
+  void FillSlots() {
+    for (int i = 0; i < scheduler_->slot_count(); ++i) {
+      ASSERT_TRUE(scheduler_->Acquire(a_.get(), kBatch));
+    }
+  }
+
+  static const TranscoderScheduler::Priority kBatch =
+      TranscoderScheduler::Priority_Batch;
+  static const TranscoderScheduler::Priority kInteractive =
+      TranscoderScheduler::Priority_Interactive;
+
+  std::unique_ptr<TranscoderScheduler> scheduler_;
+  std::unique_ptr<Transcoder> a_;
+  std::unique_ptr<Transcoder> b_;
+  std::unique_ptr<Transcoder> c_;
+};
+
+TEST_F(TranscoderSchedulerTest, OneSlotPerCore) {
+  EXPECT_EQ(TranscoderScheduler::Instance(), scheduler_.get());
+  EXPECT_GE(scheduler_->slot_count(), 1);
+
+  FillSlots();
+  EXPECT_FALSE(scheduler_->Acquire(b_.get(), kBatch));
+
+  scheduler_->Release();
+  EXPECT_TRUE(scheduler_->Acquire(b_.get(), kBatch));
+}
+
+TEST_F(TranscoderSchedulerTest, FreeSlotIsReservedForWaiter) {
+  FillSlots();
+  EXPECT_FALSE(scheduler_->Acquire(b_.get(), kBatch));
+
+  // c_ asked after b_, so it has to wait for the next slot.
+  scheduler_->Release();
+  EXPECT_FALSE(scheduler_->Acquire(c_.get(), kBatch));
+  EXPECT_TRUE(scheduler_->Acquire(b_.get(), kBatch));
+
+  scheduler_->Release();
+  EXPECT_TRUE(scheduler_->Acquire(c_.get(), kBatch));
+}
+
+TEST_F(TranscoderSchedulerTest, InteractiveGoesFirst) {
+  FillSlots();
+  EXPECT_FALSE(scheduler_->Acquire(b_.get(), kBatch));
+  EXPECT_FALSE(scheduler_->Acquire(c_.get(), kInteractive));
+
+  scheduler_->Release();
+  EXPECT_FALSE(scheduler_->Acquire(b_.get(), kBatch));
+  EXPECT_TRUE(scheduler_->Acquire(c_.get(), kInteractive));
+}
+
+TEST_F(TranscoderSchedulerTest, ForgetGivesUpReservation) {
+  FillSlots();
+  EXPECT_FALSE(scheduler_->Acquire(b_.get(), kBatch));
+
+  scheduler_->Release();
+  scheduler_->Forget(b_.get());
+  EXPECT_TRUE(scheduler_->Acquire(c_.get(), kBatch));
+}
+
+TEST_F(TranscoderSchedulerTest, TranscoderAtMaxThreadsStopsWaiting) {
+  FillSlots();
+
+  // b_ has a job to start, but no slot.
+  b_->AddJob("/tmp/foo.flac",
+             Transcoder::PresetForFileType(Song::Type_OggVorbis),
+             "/tmp/foo.ogg");
+  b_->Start();
+
+  // Now it can't run any more jobs, so a free slot should go to c_.
+  b_->set_max_threads(0);
+  b_->Start();
+
+  scheduler_->Release();
+  EXPECT_TRUE(scheduler_->Acquire(c_.get(), kBatch));
+}
+
+}  // namespace